@@ -6,6 +6,7 @@
 
 #include "vector.hpp"
 #include "sparsematrix.hpp"
+#include "csrmatrix.hpp"
 #include "matrix.hpp"
 #include "sdsolver.hpp"
 #include "cgsolver.hpp"
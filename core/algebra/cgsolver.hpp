@@ -7,10 +7,12 @@
 #include <cmath>
 #include <algorithm>
 #include <limits>
+#include <vector>
 #include <iostream>
 #include "vector.hpp"
 #include "solver.hpp"
 #include "sparsematrix.hpp"
+#include "csrmatrix.hpp"
 
 /** Conjugate gradient solver */
 namespace LunaCore::Algebra::CGSolver
@@ -23,7 +25,9 @@ template<class T>
 class NoPreconditioner
 {
 public:
+    NoPreconditioner() = default;
     NoPreconditioner(const SparseMatrix<T> &mat) {};
+    NoPreconditioner(const CSRMatrix<T> &mat) {};
     
     /** Solve for and return the pre-conditioned A matix.
         Used internally by the conjugate gradient solver.
@@ -32,6 +36,14 @@ public:
     {
         return v;
     }
+
+    /** Solve for the pre-conditioned A matrix without allocating memory.
+        result must have the same size as v.
+    */
+    void apply(const Vector<T> &v, Vector<T> &result) const noexcept
+    {
+        std::copy(v.begin(), v.end(), result.begin());
+    }
 };
 
 /** A Simple Jacobi/diagonal preconditioner.
@@ -42,24 +54,48 @@ class JacobiPreconditioner
 {
 public:
 
+    JacobiPreconditioner() = default;
+
     /** Create a diagonal/Jacobi preconditioner based on the matrix A.
         @param[in] mat the 'A' matrix of the linear system Ax=b.
     */
     JacobiPreconditioner(const SparseMatrix<T> &mat)
+    {
+        update(mat);
+    }
+
+    /** Create a diagonal/Jacobi preconditioner based on the CSR matrix A.
+        Rows without a diagonal entry get a unit preconditioner entry.
+        @param[in] mat the 'A' matrix of the linear system Ax=b.
+    */
+    JacobiPreconditioner(const CSRMatrix<T> &mat)
+    {
+        update(mat);
+    }
+
+    /** Re-calculate the preconditioner for a new matrix A.
+        Re-uses the memory of the preconditioner.
+    */
+    void update(const SparseMatrix<T> &mat)
     {
         auto const N = mat.rowCount();
         m_invdiag.resize(N);
         for(std::size_t row=0; row < N; row++)
         {
-            auto d = mat.at(row, row);
-            if (std::abs(d) < 1.0e-10f )
-            {
-                m_invdiag.at(row) = 1.0f;
-            }
-            else
-            {
-                m_invdiag.at(row) = 1.0f / d;
-            }
+            setInverse(row, mat.at(row, row));
+        }
+    }
+
+    /** Re-calculate the preconditioner for a new CSR matrix A.
+        Re-uses the memory of the preconditioner.
+    */
+    void update(const CSRMatrix<T> &mat)
+    {
+        auto const N = mat.rowCount();
+        m_invdiag.resize(N);
+        for(std::size_t row=0; row < N; row++)
+        {
+            setInverse(row, mat.diagonal(row));
         }
     }
 
@@ -71,88 +107,542 @@ public:
         return m_invdiag*v;
     }
 
+    /** Solve for the pre-conditioned A matrix without allocating memory.
+        result must have the same size as v.
+    */
+    void apply(const Vector<T> &v, Vector<T> &result) const noexcept
+    {
+        multiply(m_invdiag, v, result);
+    }
+
 protected:
+    void setInverse(std::size_t row, T d)
+    {
+        if (std::abs(d) < 1.0e-10f )
+        {
+            m_invdiag.at(row) = 1.0f;
+        }
+        else
+        {
+            m_invdiag.at(row) = 1.0f / d;
+        }
+    }
+
     Vector<T> m_invdiag;    ///< inverted diagonal vector of matrix A.
 };
 
 
-/** Ax = b linear system solver based on conjugate gradient iterations
-    @tparam T the datatype of the matrix and vectors.
-    @param[in] mat the A matrix.
-    @param[in] rhs the b vector.
-    @param[out] x   the solution vector.
-    @param[in] preconditioner callable 'Vector<T> solve(const Vector<T> &v) const'
-    @param[in] tolerance maximum L1 norm of residual / b.
-    @param[in] maxIter maximum iterations the solver may use to arrive at a solution.
-    @return information about the error and the number of iterations.
+/** Incomplete Cholesky IC(0) preconditioner.
+    Factors A ~ L*L^T where L has the sparsity pattern of the lower
+    triangle of A. Much more effective than the Jacobi preconditioner
+    on the Laplacian-like systems of quadratic placement.
 
-    See: https://en.wikipedia.org/wiki/Conjugate_gradient_method
+    The matrix must be symmetric. If the factorization breaks down,
+    it is retried on A + shift*diag(A) with an increasing shift.
+    When that fails MaxShiftRetries times, e.g. because the diagonal
+    is negative or NaN, the preconditioner falls back to Jacobi and
+    the solver reports it in ComputeInfo::m_jacobiFallback.
 */
-template<typename T>
-ComputeInfo solve(const SparseMatrix<T> &mat,
-    const Vector<T> &rhs,
-    Vector<T> &x,
-    auto &preconditioner,
-    const float tolerance = 1.0e-5f,
-    const std::size_t maxIter = 100)
+template<class T>
+class IC0Preconditioner
 {
-    ComputeInfo info;
+public:
+    using IndexType = typename CSRMatrix<T>::IndexType;
 
-    const std::size_t N = mat.rowCount();
+    static constexpr std::size_t MaxShiftRetries = 32;
 
-    assert(rhs.size() == N);
-    assert(x.size() == N);
+    IC0Preconditioner() = default;
 
-    auto residual = rhs - mat*x;
+    /** Create an IC(0) preconditioner based on the matrix A.
+        @param[in] mat the symmetric 'A' matrix of the linear system Ax=b.
+    */
+    IC0Preconditioner(const SparseMatrix<T> &mat)
+    {
+        update(mat);
+    }
 
-    // early out on the trivial solution of x=0
-    auto rhsL2 = norm2(rhs);
-    if (rhsL2 < 1.0e-20f)
+    /** Create an IC(0) preconditioner based on the CSR matrix A.
+        @param[in] mat the symmetric 'A' matrix of the linear system Ax=b.
+    */
+    IC0Preconditioner(const CSRMatrix<T> &mat)
     {
-        x.zero();
-        info.m_error = 0.0f;
-        return info;
+        update(mat);
     }
 
-    auto zeroThreshold = std::numeric_limits<T>::min();
-    const auto threshold = std::max(tolerance*tolerance*rhsL2, zeroThreshold);
-    auto residualL2 = norm2(residual);
-    if (residualL2 < threshold)
+    /** Re-calculate the preconditioner for a new matrix A. */
+    void update(const SparseMatrix<T> &mat)
     {
-        info.m_error = std::sqrt(residualL2 / rhsL2);
-        return info;
+        update(CSRMatrix<T>(mat));
     }
 
-    // preconditioning here..
-    auto p = preconditioner.solve(residual);
+    /** Re-calculate the preconditioner for a new CSR matrix A.
+        Re-uses the memory of the preconditioner.
+    */
+    void update(const CSRMatrix<T> &mat)
+    {
+        auto const N = mat.rowCount();
+        auto const rowPtr = mat.rowPtr();
+        auto const colIdx = mat.colIdx();
+        auto const values = mat.values();
+
+        // copy the strictly lower triangle of A and its diagonal
+        m_rowPtr.clear();
+        m_rowPtr.reserve(N + 1);
+        m_rowPtr.push_back(0);
+        m_colIdx.clear();
+        m_values.clear();
+        m_diag.resize(N);
 
-    // iterate to solve
-    std::size_t iteration = 0;
+        for(std::size_t row = 0; row < N; row++)
+        {
+            m_diag[row] = 0;
+            for(auto index = rowPtr[row]; index < rowPtr[row+1]; index++)
+            {
+                auto const col = colIdx[index];
+                if (col < row)
+                {
+                    m_colIdx.push_back(col);
+                    m_values.push_back(values[index]);
+                }
+                else if (col == row)
+                {
+                    m_diag[row] = values[index];
+                }
+            }
+            m_rowPtr.push_back(static_cast<IndexType>(m_colIdx.size()));
+        }
 
-    float absNew = dot(residual, p);
+        m_lower = m_values;
+        m_shift = 0;
+        m_jacobi = false;
+        std::size_t retries = 0;
+        while(!factorize(m_shift))
+        {
+            if (retries++ == MaxShiftRetries)
+            {
+                useJacobi();
+                return;
+            }
+            m_shift = (m_shift == 0) ? static_cast<T>(1.0e-3) : m_shift * 2;
+        }
+    }
+
+    /** Solve for and return the pre-conditioned A matix.
+        Used internally by the conjugate gradient solver.
+    */
+    [[nodiscard]] Vector<T> solve(const Vector<T> &v) const
+    {
+        Vector<T> result(v.size());
+        apply(v, result);
+        return result;
+    }
 
-    while(iteration < maxIter)
+    /** Solve L*L^T result = v without allocating memory.
+        result must have the same size as v.
+    */
+    void apply(const Vector<T> &v, Vector<T> &result) const noexcept
     {
-        auto const tmp = mat * p;                   // FIXME: allocate tmp outside the loop..
+        const std::size_t N = m_invdiag.size();
+        assert(v.size() == N);
+        assert(result.size() == N);
 
-        auto const alpha = absNew / dot(p, tmp);    // FIXME: possible division by zero
-        x = x + alpha * p;
-        residual = residual - alpha * tmp;
+        const T* vdata = v.data();
+        T* rdata = result.data();
 
-        residualL2 = norm2(residual);
-        if (residualL2 < threshold) break;
+        // forward substitution L*y = v
+        for(std::size_t row = 0; row < N; row++)
+        {
+            T sum = vdata[row];
+            for(auto index = m_rowPtr[row]; index < m_rowPtr[row+1]; index++)
+            {
+                sum -= m_lower[index] * rdata[m_colIdx[index]];
+            }
+            rdata[row] = sum * m_invdiag[row];
+        }
 
-        auto z = preconditioner.solve(residual);
-        const auto absOld = absNew;
-        absNew = dot(residual, z);
-        auto const beta = absNew / absOld;
-        p = z + beta * p;
-        iteration++;
+        // backward substitution L^T*result = y, column by column
+        // because L is stored by row.
+        for(std::size_t row = N; row-- > 0; )
+        {
+            const T value = rdata[row] * m_invdiag[row];
+            rdata[row] = value;
+            for(auto index = m_rowPtr[row]; index < m_rowPtr[row+1]; index++)
+            {
+                rdata[m_colIdx[index]] -= m_lower[index] * value;
+            }
+        }
     }
 
-    info.m_iterations = iteration;
-    info.m_error = std::sqrt(residualL2 / rhsL2);
-    return info;
+    /** return the diagonal shift that was needed to complete the factorization */
+    [[nodiscard]] constexpr T shift() const noexcept
+    {
+        return m_shift;
+    }
+
+    /** return true if the factorization failed and the Jacobi preconditioner is used */
+    [[nodiscard]] constexpr bool isJacobi() const noexcept
+    {
+        return m_jacobi;
+    }
+
+protected:
+    /** replace the factorization by L = sqrt(diag(A)), so apply() divides by the diagonal.
+        Rows with a diagonal that is not positive are left unscaled.
+    */
+    void useJacobi()
+    {
+        const std::size_t N = m_diag.size();
+        std::fill(m_lower.begin(), m_lower.end(), T{0});
+        m_invdiag.resize(N);
+        for(std::size_t row = 0; row < N; row++)
+        {
+            const T diag = m_diag[row];
+            m_invdiag[row] = (diag > std::numeric_limits<T>::min()) ? 1 / std::sqrt(diag) : T{1};
+        }
+        m_shift  = 0;
+        m_jacobi = true;
+    }
+
+    /** factorize A + shift*diag(A) into m_lower and m_invdiag.
+        returns false when a non-positive pivot is encountered.
+    */
+    bool factorize(T shift)
+    {
+        const std::size_t N = m_diag.size();
+        m_invdiag.resize(N);
+
+        for(std::size_t row = 0; row < N; row++)
+        {
+            const auto rowFirst = m_rowPtr[row];
+            const auto rowLast  = m_rowPtr[row+1];
+
+            for(auto index = rowFirst; index < rowLast; index++)
+            {
+                // L(row,col) = (A(row,col) - sum_k L(row,k)*L(col,k)) / L(col,col)
+                // where k runs over the columns < col that both rows have.
+                const auto col = m_colIdx[index];
+                T sum = m_values[index];
+
+                auto i = rowFirst;
+                auto j = m_rowPtr[col];
+                const auto jLast = m_rowPtr[col+1];
+                while((i < index) && (j < jLast))
+                {
+                    if (m_colIdx[i] == m_colIdx[j])
+                    {
+                        sum -= m_lower[i] * m_lower[j];
+                        i++;
+                        j++;
+                    }
+                    else if (m_colIdx[i] < m_colIdx[j])
+                    {
+                        i++;
+                    }
+                    else
+                    {
+                        j++;
+                    }
+                }
+                m_lower[index] = sum * m_invdiag[col];
+            }
+
+            const T diag = m_diag[row];
+            if (diag == 0)
+            {
+                // empty row: keep the unknown decoupled
+                m_invdiag[row] = 1;
+                continue;
+            }
+
+            T pivot = diag * (1 + shift);
+            for(auto index = rowFirst; index < rowLast; index++)
+            {
+                pivot -= m_lower[index] * m_lower[index];
+            }
+
+            if (!(pivot > std::numeric_limits<T>::epsilon() * std::abs(diag)))
+            {
+                m_lower = m_values;
+                return false;
+            }
+
+            m_invdiag[row] = 1 / std::sqrt(pivot);
+        }
+        return true;
+    }
+
+    std::vector<IndexType>  m_rowPtr;   ///< row offsets of the strictly lower triangle
+    std::vector<IndexType>  m_colIdx;   ///< column indices of the strictly lower triangle
+    std::vector<T>          m_values;   ///< strictly lower triangle of A
+    std::vector<T>          m_lower;    ///< strictly lower triangle of L
+    std::vector<T>          m_diag;     ///< diagonal of A
+    std::vector<T>          m_invdiag;  ///< inverted diagonal of L
+    T                       m_shift{0};
+    bool                    m_jacobi{false};
+};
+
+/** Symmetric successive over-relaxation (SSOR) preconditioner.
+    M = w/(2-w) * (D/w + L) * (D/w)^-1 * (D/w + L^T)
+    where D and L are the diagonal and strictly lower part of A.
+    Cheaper to set up than IC(0) but usually needs more iterations.
+    The matrix must be symmetric.
+
+    The preconditioner refers to the CSR matrix given to update(),
+    which must not change or go away until the next update().
+*/
+template<class T>
+class SSORPreconditioner
+{
+public:
+    /** @param[in] omega relaxation factor in the range (0, 2). */
+    explicit SSORPreconditioner(T omega = 1) : m_omega(omega)
+    {
+        assert((omega > 0) && (omega < 2));
+    }
+
+    /** Create an SSOR preconditioner based on the matrix A. */
+    SSORPreconditioner(const SparseMatrix<T> &mat, T omega = 1) : m_omega(omega)
+    {
+        update(mat);
+    }
+
+    /** Create an SSOR preconditioner based on the CSR matrix A. */
+    SSORPreconditioner(const CSRMatrix<T> &mat, T omega = 1) : m_omega(omega)
+    {
+        update(mat);
+    }
+
+    /** Re-calculate the preconditioner for a new matrix A.
+        This keeps a CSR copy of the matrix.
+    */
+    void update(const SparseMatrix<T> &mat)
+    {
+        m_converted = CSRMatrix<T>(mat);
+        setDiagonal(m_converted);
+        m_mat = nullptr;
+    }
+
+    /** Re-calculate the preconditioner for a new CSR matrix A.
+        Re-uses the memory of the preconditioner.
+    */
+    void update(const CSRMatrix<T> &mat)
+    {
+        setDiagonal(mat);
+        m_mat = &mat;
+    }
+
+    /** Solve for and return the pre-conditioned A matix.
+        Used internally by the conjugate gradient solver.
+    */
+    [[nodiscard]] Vector<T> solve(const Vector<T> &v) const
+    {
+        Vector<T> result(v.size());
+        apply(v, result);
+        return result;
+    }
+
+    /** Solve M*result = v without allocating memory.
+        result must have the same size as v.
+    */
+    void apply(const Vector<T> &v, Vector<T> &result) const noexcept
+    {
+        const std::size_t N = m_diag.size();
+        assert(v.size() == N);
+        assert(result.size() == N);
+
+        auto const& mat = (m_mat != nullptr) ? *m_mat : m_converted;
+        auto const rowPtr = mat.rowPtr();
+        auto const colIdx = mat.colIdx();
+        auto const values = mat.values();
+        const T* vdata = v.data();
+        T* rdata = result.data();
+
+        // forward sweep (D/w + L)*y = v
+        for(std::size_t row = 0; row < N; row++)
+        {
+            T sum = vdata[row];
+            for(auto index = rowPtr[row]; (index < rowPtr[row+1]) && (colIdx[index] < row); index++)
+            {
+                sum -= values[index] * rdata[colIdx[index]];
+            }
+            rdata[row] = sum * m_omega / m_diag[row];
+        }
+
+        // backward sweep (D/w + L^T)*result = (D/w)*y
+        const T scale = (2 - m_omega) / m_omega;
+        for(std::size_t row = N; row-- > 0; )
+        {
+            T sum = rdata[row] * m_diag[row] / m_omega;
+            for(auto index = rowPtr[row+1]; (index > rowPtr[row]) && (colIdx[index-1] > row); index--)
+            {
+                sum -= values[index-1] * rdata[colIdx[index-1]];
+            }
+            rdata[row] = sum * m_omega / m_diag[row];
+        }
+
+        for(std::size_t row = 0; row < N; row++)
+        {
+            rdata[row] *= scale;
+        }
+    }
+
+protected:
+    void setDiagonal(const CSRMatrix<T> &mat)
+    {
+        auto const N = mat.rowCount();
+        m_diag.resize(N);
+        for(std::size_t row = 0; row < N; row++)
+        {
+            auto d = mat.diagonal(row);
+            m_diag[row] = (std::abs(d) < static_cast<T>(1.0e-10)) ? 1 : d;
+        }
+    }
+
+    T                   m_omega{1};
+    const CSRMatrix<T>  *m_mat{nullptr};    ///< matrix given to update(), nullptr when m_converted is used
+    CSRMatrix<T>        m_converted;        ///< CSR copy of a SparseMatrix given to update()
+    std::vector<T>      m_diag;
+};
+
+/** Conjugate gradient solver that owns its workspace vectors.
+    The workspace is only ever grown, so once a Solver has solved
+    the largest system, subsequent solves do not allocate memory.
+    Use one Solver per thread.
+*/
+template<typename T>
+class Solver
+{
+public:
+    Solver() = default;
+
+    /** Ax = b linear system solver based on conjugate gradient iterations
+        @tparam MatrixType SparseMatrix<T> or CSRMatrix<T>. CSRMatrix is preferred for speed.
+        @param[in] mat the A matrix.
+        @param[in] rhs the b vector.
+        @param[in,out] x  the initial guess and the solution vector.
+        @param[in] preconditioner with a 'void apply(const Vector<T> &v, Vector<T> &result) const' member.
+        @param[in] tolerance maximum L1 norm of residual / b.
+        @param[in] maxIter maximum iterations the solver may use to arrive at a solution.
+        @return information about the error and the number of iterations.
+
+        See: https://en.wikipedia.org/wiki/Conjugate_gradient_method
+    */
+    template<class MatrixType, class Preconditioner>
+    ComputeInfo solve(const MatrixType &mat,
+        const Vector<T> &rhs,
+        Vector<T> &x,
+        const Preconditioner &preconditioner,
+        const float tolerance = 1.0e-5f,
+        const std::size_t maxIter = 100)
+    {
+        ComputeInfo info;
+
+        if constexpr (requires { preconditioner.isJacobi(); })
+        {
+            info.m_jacobiFallback = preconditioner.isJacobi();
+        }
+
+        const std::size_t N = mat.rowCount();
+
+        assert(rhs.size() == N);
+        assert(x.size() == N);
+
+        m_residual.resize(N);
+        m_p.resize(N);
+        m_z.resize(N);
+        m_tmp.resize(N);
+
+        // early out on the trivial solution of x=0
+        auto rhsL2 = norm2(rhs);
+        if (rhsL2 < 1.0e-20f)
+        {
+            x.zero();
+            info.m_error = 0.0f;
+            return info;
+        }
+
+        // residual = rhs - mat*x
+        multiply(mat, x, m_tmp);
+        std::copy(rhs.begin(), rhs.end(), m_residual.begin());
+        auto residualL2 = axpyNorm2(static_cast<T>(-1), m_tmp, m_residual);
+
+        auto zeroThreshold = std::numeric_limits<T>::min();
+        const auto threshold = std::max(static_cast<T>(tolerance*tolerance*rhsL2), zeroThreshold);
+        if (residualL2 < threshold)
+        {
+            info.m_error = std::sqrt(residualL2 / rhsL2);
+            return info;
+        }
+
+        // preconditioning here..
+        preconditioner.apply(m_residual, m_p);
+
+        // iterate to solve
+        std::size_t iteration = 0;
+
+        T absNew = dot(m_residual, m_p);
+
+        while(iteration < maxIter)
+        {
+            multiply(mat, m_p, m_tmp);
+
+            auto const pAp = dot(m_p, m_tmp);
+            if (std::abs(pAp) <= std::numeric_limits<T>::min())
+            {
+                break;  // search direction has collapsed
+            }
+
+            auto const alpha = absNew / pAp;
+            axpy(alpha, m_p, x);
+            residualL2 = axpyNorm2(-alpha, m_tmp, m_residual);
+            iteration++;
+
+            if (residualL2 < threshold) break;
+
+            preconditioner.apply(m_residual, m_z);
+            const auto absOld = absNew;
+            absNew = dot(m_residual, m_z);
+            auto const beta = absNew / absOld;
+            xpby(m_z, beta, m_p);
+        }
+
+        info.m_iterations = iteration;
+        info.m_error = std::sqrt(residualL2 / rhsL2);
+        info.m_converged = (residualL2 < threshold);
+        return info;
+    }
+
+protected:
+    Vector<T> m_residual;
+    Vector<T> m_p;          ///< search direction
+    Vector<T> m_z;          ///< preconditioned residual
+    Vector<T> m_tmp;        ///< A*p
+};
+
+/** Ax = b linear system solver based on conjugate gradient iterations
+    @tparam T the datatype of the matrix and vectors.
+    @tparam MatrixType SparseMatrix<T> or CSRMatrix<T>. CSRMatrix is preferred for speed.
+    @param[in] mat the A matrix.
+    @param[in] rhs the b vector.
+    @param[in,out] x  the initial guess and the solution vector.
+    @param[in] preconditioner with a 'void apply(const Vector<T> &v, Vector<T> &result) const' member.
+    @param[in] tolerance maximum L1 norm of residual / b.
+    @param[in] maxIter maximum iterations the solver may use to arrive at a solution.
+    @return information about the error and the number of iterations.
+
+    This allocates a new workspace for every call, use a
+    CGSolver::Solver object when solving many systems.
+*/
+template<typename T, class MatrixType>
+ComputeInfo solve(const MatrixType &mat,
+    const Vector<T> &rhs,
+    Vector<T> &x,
+    auto &preconditioner,
+    const float tolerance = 1.0e-5f,
+    const std::size_t maxIter = 100)
+{
+    Solver<T> solver;
+    return solver.solve(mat, rhs, x, preconditioner, tolerance, maxIter);
 };
 
 };
@@ -0,0 +1,357 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <span>
+#include <type_traits>
+#include <iostream>
+#include "vector.hpp"
+#include "sparsematrix.hpp"
+#include "kernels.h"
+
+namespace LunaCore::Algebra
+{
+
+/** A frozen sparse matrix in compressed sparse row (CSR) format.
+    The non-zero entries of row r are stored in m_values/m_colIdx
+    in the range [m_rowPtr[r], m_rowPtr[r+1]), sorted by column.
+
+    A CSRMatrix cannot be modified entry-by-entry; build it
+    with a TripletBuilder or convert it from a SparseMatrix.
+*/
+template<class T>
+class CSRMatrix
+{
+public:
+    using IndexType = uint32_t;
+
+    CSRMatrix() = default;
+
+    /** convert a SparseMatrix into CSR format */
+    explicit CSRMatrix(const SparseMatrix<T> &mat)
+    {
+        m_rowPtr.clear();
+        m_rowPtr.reserve(mat.rowCount() + 1);
+        m_rowPtr.push_back(0);
+        m_values.reserve(mat.nonzeroCount());
+        m_colIdx.reserve(mat.nonzeroCount());
+
+        for(std::size_t row = 0; row < mat.rowCount(); row++)
+        {
+            for(auto const& entry : mat.row(row))
+            {
+                m_values.push_back(entry.m_value);
+                m_colIdx.push_back(static_cast<IndexType>(entry.m_col));
+            }
+            m_rowPtr.push_back(static_cast<IndexType>(m_values.size()));
+        }
+    }
+
+    /** return the number of rows in the matrix. */
+    [[nodiscard]] constexpr std::size_t rowCount() const noexcept
+    {
+        return m_rowPtr.size() - 1;
+    }
+
+    /** return the number of non-zero entries in the matrix. */
+    [[nodiscard]] constexpr std::size_t nonzeroCount() const noexcept
+    {
+        return m_values.size();
+    }
+
+    /** return the number non-zero entries of the specified row.
+        throws std::out_of_range exception when the row does not exist.
+    */
+    [[nodiscard]] std::size_t rowEntryCount(std::size_t row) const
+    {
+        if (row >= rowCount())
+        {
+            throw std::out_of_range("row does not exist");
+        }
+        return m_rowPtr[row+1] - m_rowPtr[row];
+    }
+
+    /** get the matrix entry at (row, column).
+        if it doesn't exist, throw a std::out_of_range exception.
+    */
+    [[nodiscard]] const T& at(std::size_t row, std::size_t col) const
+    {
+        auto index = find(row, col);
+        if (index == NotFound)
+        {
+            throw std::out_of_range("item does not exist");
+        }
+        return m_values[index];
+    }
+
+    [[nodiscard]] const T& operator()(std::size_t row, std::size_t col) const
+    {
+        return at(row, col);
+    }
+
+    /** return the diagonal entry of a row or zero if it does not exist. */
+    [[nodiscard]] T diagonal(std::size_t row) const noexcept
+    {
+        auto index = find(row, row);
+        if (index == NotFound)
+        {
+            return 0;
+        }
+        return m_values[index];
+    }
+
+    [[nodiscard]] constexpr std::span<const T> values() const noexcept
+    {
+        return m_values;
+    }
+
+    [[nodiscard]] constexpr std::span<const IndexType> colIdx() const noexcept
+    {
+        return m_colIdx;
+    }
+
+    [[nodiscard]] constexpr std::span<const IndexType> rowPtr() const noexcept
+    {
+        return m_rowPtr;
+    }
+
+    template<class U> friend class TripletBuilder;
+
+protected:
+    static constexpr std::size_t NotFound = static_cast<std::size_t>(-1);
+
+    /** return the index into m_values of entry (row, col) or NotFound */
+    [[nodiscard]] std::size_t find(std::size_t row, std::size_t col) const noexcept
+    {
+        if (row >= rowCount())
+        {
+            return NotFound;
+        }
+
+        auto first = m_colIdx.begin() + m_rowPtr[row];
+        auto last  = m_colIdx.begin() + m_rowPtr[row+1];
+        auto iter  = std::lower_bound(first, last, static_cast<IndexType>(col));
+
+        if ((iter == last) || (*iter != col))
+        {
+            return NotFound;
+        }
+
+        return static_cast<std::size_t>(iter - m_colIdx.begin());
+    }
+
+    std::vector<T>          m_values;
+    std::vector<IndexType>  m_colIdx;
+    std::vector<IndexType>  m_rowPtr{0};
+};
+
+/** Accumulates (row, col, value) triplets and freezes them into a CSRMatrix.
+    Adding an entry is an O(1) append; duplicate entries are summed
+    when the matrix is frozen.
+*/
+template<class T>
+class TripletBuilder
+{
+public:
+    using IndexType = typename CSRMatrix<T>::IndexType;
+
+    TripletBuilder() = default;
+    explicit TripletBuilder(std::size_t rowCount) : m_rowCount(rowCount) {}
+
+    /** remove all triplets and set the number of rows of the matrix.
+        allocated memory is kept so the builder can be re-used.
+    */
+    void reset(std::size_t rowCount)
+    {
+        m_triplets.clear();
+        m_rowCount = rowCount;
+    }
+
+    /** reserve memory for a number of triplets */
+    void reserve(std::size_t triplets)
+    {
+        m_triplets.reserve(triplets);
+    }
+
+    /** add value to the matrix entry at (row, column) */
+    void add(std::size_t row, std::size_t col, const T &value)
+    {
+        assert(row < m_rowCount);
+        assert(col < m_rowCount);
+        m_triplets.push_back({static_cast<IndexType>(row), static_cast<IndexType>(col), value});
+    }
+
+    /** return the number of rows in the matrix. */
+    [[nodiscard]] constexpr auto rowCount() const noexcept
+    {
+        return m_rowCount;
+    }
+
+    /** return the number of triplets added so far */
+    [[nodiscard]] constexpr auto tripletCount() const noexcept
+    {
+        return m_triplets.size();
+    }
+
+    /** sort the triplets by row and column, sum the duplicates
+        and write the result into a CSRMatrix.
+        The memory of the destination matrix is re-used.
+    */
+    void freeze(CSRMatrix<T> &mat) const
+    {
+        // counting sort by row
+        mat.m_rowPtr.assign(m_rowCount + 1, 0);
+        for(auto const& triplet : m_triplets)
+        {
+            mat.m_rowPtr[triplet.m_row + 1]++;
+        }
+
+        for(std::size_t row = 0; row < m_rowCount; row++)
+        {
+            mat.m_rowPtr[row + 1] += mat.m_rowPtr[row];
+        }
+
+        m_fill.assign(mat.m_rowPtr.begin(), mat.m_rowPtr.end() - 1);
+        mat.m_colIdx.resize(m_triplets.size());
+        mat.m_values.resize(m_triplets.size());
+
+        for(auto const& triplet : m_triplets)
+        {
+            auto index = m_fill[triplet.m_row]++;
+            mat.m_colIdx[index] = triplet.m_col;
+            mat.m_values[index] = triplet.m_value;
+        }
+
+        // sort each row by column and merge duplicates in-place.
+        // rows are short, so an insertion sort is used.
+        IndexType dst = 0;
+        for(std::size_t row = 0; row < m_rowCount; row++)
+        {
+            const IndexType first = mat.m_rowPtr[row];
+            const IndexType last  = mat.m_rowPtr[row + 1];
+
+            for(IndexType i = first + 1; i < last; i++)
+            {
+                const auto col   = mat.m_colIdx[i];
+                const auto value = mat.m_values[i];
+                IndexType j = i;
+                while((j > first) && (mat.m_colIdx[j-1] > col))
+                {
+                    mat.m_colIdx[j] = mat.m_colIdx[j-1];
+                    mat.m_values[j] = mat.m_values[j-1];
+                    j--;
+                }
+                mat.m_colIdx[j] = col;
+                mat.m_values[j] = value;
+            }
+
+            const IndexType rowStart = dst;
+            for(IndexType i = first; i < last; i++)
+            {
+                if ((dst > rowStart) && (mat.m_colIdx[dst-1] == mat.m_colIdx[i]))
+                {
+                    mat.m_values[dst-1] += mat.m_values[i];
+                }
+                else
+                {
+                    mat.m_colIdx[dst] = mat.m_colIdx[i];
+                    mat.m_values[dst] = mat.m_values[i];
+                    dst++;
+                }
+            }
+            mat.m_rowPtr[row] = rowStart;
+        }
+        mat.m_rowPtr[m_rowCount] = dst;
+
+        mat.m_colIdx.resize(dst);
+        mat.m_values.resize(dst);
+    }
+
+    /** return a new CSRMatrix containing the accumulated triplets. */
+    [[nodiscard]] CSRMatrix<T> freeze() const
+    {
+        CSRMatrix<T> mat;
+        freeze(mat);
+        return mat;
+    }
+
+protected:
+    struct Triplet
+    {
+        IndexType m_row{0};
+        IndexType m_col{0};
+        T         m_value{0};
+    };
+
+    std::size_t             m_rowCount{0};
+    std::vector<Triplet>    m_triplets;
+    mutable std::vector<IndexType> m_fill;  ///< scratch space for freeze()
+};
+
+/** sparse matrix-vector product result = mat*x.
+    result must have the same size as x.
+*/
+template<class T>
+void multiply(const CSRMatrix<T> &mat, const Vector<T> &x, Vector<T> &result)
+{
+    assert(mat.rowCount() == x.size());
+    assert(result.size() == x.size());
+
+    auto const rowPtr = mat.rowPtr();
+    auto const colIdx = mat.colIdx();
+    auto const values = mat.values();
+    auto const xdata  = x.data();
+    auto       rdata  = result.data();
+
+    const std::size_t N = mat.rowCount();
+    if constexpr (std::is_same_v<T, float>)
+    {
+        Kernels::spmv(N, rowPtr.data(), colIdx.data(), values.data(), xdata, rdata);
+        return;
+    }
+
+    for(std::size_t row = 0; row < N; row++)
+    {
+        T sum = 0;
+        for(auto index = rowPtr[row]; index < rowPtr[row+1]; index++)
+        {
+            sum += values[index] * xdata[colIdx[index]];
+        }
+        rdata[row] = sum;
+    }
+}
+
+template<class T>
+Vector<T> operator*(const CSRMatrix<T> &matrix, const Vector<T> &x)
+{
+    Vector<T> result(x.size());
+    multiply(matrix, x, result);
+    return result;
+}
+
+};
+
+template<typename T>
+std::ostream& operator<<(std::ostream &os, const LunaCore::Algebra::CSRMatrix<T> &mat)
+{
+    auto const rowPtr = mat.rowPtr();
+    auto const colIdx = mat.colIdx();
+    auto const values = mat.values();
+
+    for(std::size_t row = 0; row < mat.rowCount(); row++)
+    {
+        os << "  ";
+        for(auto index = rowPtr[row]; index < rowPtr[row+1]; index++)
+        {
+            os << "(" << colIdx[index] << ") " << values[index] << "  ";
+        }
+        if ((row + 1) < mat.rowCount()) os << "\n";
+    }
+    return os;
+}
@@ -0,0 +1,559 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <atomic>
+#include "kernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LUNA_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and clang only emit AVX2 instructions in functions that
+// explicitly enable them. MSVC accepts the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define LUNA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define LUNA_TARGET_AVX2
+#endif
+
+using namespace LunaCore::Algebra::Kernels;
+
+namespace
+{
+
+struct KernelTable
+{
+    InstructionSet m_isa;
+    float (*m_dot)(const float *, const float *, std::size_t) noexcept;
+    void  (*m_axpy)(float, const float *, float *, std::size_t) noexcept;
+    void  (*m_xpby)(const float *, float, float *, std::size_t) noexcept;
+    float (*m_axpyNorm2)(float, const float *, float *, std::size_t) noexcept;
+    void  (*m_scale)(float, float *, std::size_t) noexcept;
+    void  (*m_multiply)(const float *, const float *, float *, std::size_t) noexcept;
+    void  (*m_spmv)(std::size_t, const uint32_t *, const uint32_t *, const float *, const float *, float *) noexcept;
+};
+
+// ********************************************************************************
+//   Scalar kernels
+// ********************************************************************************
+
+namespace Scalar
+{
+
+float dot(const float *a, const float *b, std::size_t n) noexcept
+{
+    float sum = 0;
+    for(std::size_t idx = 0; idx < n; idx++)
+    {
+        sum += a[idx] * b[idx];
+    }
+    return sum;
+}
+
+void axpy(float alpha, const float *x, float *y, std::size_t n) noexcept
+{
+    for(std::size_t idx = 0; idx < n; idx++)
+    {
+        y[idx] += alpha * x[idx];
+    }
+}
+
+void xpby(const float *x, float beta, float *y, std::size_t n) noexcept
+{
+    for(std::size_t idx = 0; idx < n; idx++)
+    {
+        y[idx] = x[idx] + beta * y[idx];
+    }
+}
+
+float axpyNorm2(float alpha, const float *x, float *y, std::size_t n) noexcept
+{
+    float sum = 0;
+    for(std::size_t idx = 0; idx < n; idx++)
+    {
+        const float v = y[idx] + alpha * x[idx];
+        y[idx] = v;
+        sum += v*v;
+    }
+    return sum;
+}
+
+void scale(float alpha, float *x, std::size_t n) noexcept
+{
+    for(std::size_t idx = 0; idx < n; idx++)
+    {
+        x[idx] *= alpha;
+    }
+}
+
+void multiply(const float *a, const float *b, float *result, std::size_t n) noexcept
+{
+    for(std::size_t idx = 0; idx < n; idx++)
+    {
+        result[idx] = a[idx] * b[idx];
+    }
+}
+
+void spmv(std::size_t rows, const uint32_t *rowPtr, const uint32_t *colIdx,
+    const float *values, const float *x, float *y) noexcept
+{
+    for(std::size_t row = 0; row < rows; row++)
+    {
+        float sum = 0;
+        for(auto index = rowPtr[row]; index < rowPtr[row+1]; index++)
+        {
+            sum += values[index] * x[colIdx[index]];
+        }
+        y[row] = sum;
+    }
+}
+
+constexpr KernelTable table{InstructionSet::SCALAR, dot, axpy, xpby, axpyNorm2, scale, multiply, spmv};
+
+};
+
+#ifdef LUNA_KERNELS_X86
+
+// ********************************************************************************
+//   SSE kernels, SSE2 is always available on x86-64
+// ********************************************************************************
+
+namespace SSE
+{
+
+inline float hsum(__m128 v) noexcept
+{
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+float dot(const float *a, const float *b, std::size_t n) noexcept
+{
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+
+    std::size_t idx = 0;
+    for(; idx + 8 <= n; idx += 8)
+    {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + idx), _mm_loadu_ps(b + idx)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + idx + 4), _mm_loadu_ps(b + idx + 4)));
+    }
+
+    float sum = hsum(_mm_add_ps(acc0, acc1));
+    for(; idx < n; idx++)
+    {
+        sum += a[idx] * b[idx];
+    }
+    return sum;
+}
+
+void axpy(float alpha, const float *x, float *y, std::size_t n) noexcept
+{
+    const __m128 va = _mm_set1_ps(alpha);
+    std::size_t idx = 0;
+    for(; idx + 4 <= n; idx += 4)
+    {
+        _mm_storeu_ps(y + idx, _mm_add_ps(_mm_loadu_ps(y + idx), _mm_mul_ps(va, _mm_loadu_ps(x + idx))));
+    }
+
+    for(; idx < n; idx++)
+    {
+        y[idx] += alpha * x[idx];
+    }
+}
+
+void xpby(const float *x, float beta, float *y, std::size_t n) noexcept
+{
+    const __m128 vb = _mm_set1_ps(beta);
+    std::size_t idx = 0;
+    for(; idx + 4 <= n; idx += 4)
+    {
+        _mm_storeu_ps(y + idx, _mm_add_ps(_mm_loadu_ps(x + idx), _mm_mul_ps(vb, _mm_loadu_ps(y + idx))));
+    }
+
+    for(; idx < n; idx++)
+    {
+        y[idx] = x[idx] + beta * y[idx];
+    }
+}
+
+float axpyNorm2(float alpha, const float *x, float *y, std::size_t n) noexcept
+{
+    const __m128 va = _mm_set1_ps(alpha);
+    __m128 acc = _mm_setzero_ps();
+    std::size_t idx = 0;
+    for(; idx + 4 <= n; idx += 4)
+    {
+        const __m128 v = _mm_add_ps(_mm_loadu_ps(y + idx), _mm_mul_ps(va, _mm_loadu_ps(x + idx)));
+        _mm_storeu_ps(y + idx, v);
+        acc = _mm_add_ps(acc, _mm_mul_ps(v, v));
+    }
+
+    float sum = hsum(acc);
+    for(; idx < n; idx++)
+    {
+        const float v = y[idx] + alpha * x[idx];
+        y[idx] = v;
+        sum += v*v;
+    }
+    return sum;
+}
+
+void scale(float alpha, float *x, std::size_t n) noexcept
+{
+    const __m128 va = _mm_set1_ps(alpha);
+    std::size_t idx = 0;
+    for(; idx + 4 <= n; idx += 4)
+    {
+        _mm_storeu_ps(x + idx, _mm_mul_ps(va, _mm_loadu_ps(x + idx)));
+    }
+
+    for(; idx < n; idx++)
+    {
+        x[idx] *= alpha;
+    }
+}
+
+void multiply(const float *a, const float *b, float *result, std::size_t n) noexcept
+{
+    std::size_t idx = 0;
+    for(; idx + 4 <= n; idx += 4)
+    {
+        _mm_storeu_ps(result + idx, _mm_mul_ps(_mm_loadu_ps(a + idx), _mm_loadu_ps(b + idx)));
+    }
+
+    for(; idx < n; idx++)
+    {
+        result[idx] = a[idx] * b[idx];
+    }
+}
+
+/** SSE has no gather instruction, so each row is reduced with
+    four independent accumulators to hide the add latency.
+*/
+void spmv(std::size_t rows, const uint32_t *rowPtr, const uint32_t *colIdx,
+    const float *values, const float *x, float *y) noexcept
+{
+    for(std::size_t row = 0; row < rows; row++)
+    {
+        const auto last = rowPtr[row+1];
+        auto index = rowPtr[row];
+
+        float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for(; index + 4 <= last; index += 4)
+        {
+            s0 += values[index]   * x[colIdx[index]];
+            s1 += values[index+1] * x[colIdx[index+1]];
+            s2 += values[index+2] * x[colIdx[index+2]];
+            s3 += values[index+3] * x[colIdx[index+3]];
+        }
+
+        for(; index < last; index++)
+        {
+            s0 += values[index] * x[colIdx[index]];
+        }
+        y[row] = (s0 + s1) + (s2 + s3);
+    }
+}
+
+constexpr KernelTable table{InstructionSet::SSE, dot, axpy, xpby, axpyNorm2, scale, multiply, spmv};
+
+};
+
+// ********************************************************************************
+//   AVX2 + FMA kernels
+// ********************************************************************************
+
+namespace AVX2
+{
+
+LUNA_TARGET_AVX2 inline float hsum(__m256 v) noexcept
+{
+    const __m128 lo = _mm256_castps256_ps128(v);
+    const __m128 hi = _mm256_extractf128_ps(v, 1);
+    return SSE::hsum(_mm_add_ps(lo, hi));
+}
+
+LUNA_TARGET_AVX2 float dot(const float *a, const float *b, std::size_t n) noexcept
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+
+    std::size_t idx = 0;
+    for(; idx + 16 <= n; idx += 16)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + idx), _mm256_loadu_ps(b + idx), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + idx + 8), _mm256_loadu_ps(b + idx + 8), acc1);
+    }
+
+    for(; idx + 8 <= n; idx += 8)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + idx), _mm256_loadu_ps(b + idx), acc0);
+    }
+
+    float sum = hsum(_mm256_add_ps(acc0, acc1));
+    for(; idx < n; idx++)
+    {
+        sum += a[idx] * b[idx];
+    }
+    return sum;
+}
+
+LUNA_TARGET_AVX2 void axpy(float alpha, const float *x, float *y, std::size_t n) noexcept
+{
+    const __m256 va = _mm256_set1_ps(alpha);
+    std::size_t idx = 0;
+    for(; idx + 8 <= n; idx += 8)
+    {
+        _mm256_storeu_ps(y + idx, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + idx), _mm256_loadu_ps(y + idx)));
+    }
+
+    for(; idx < n; idx++)
+    {
+        y[idx] += alpha * x[idx];
+    }
+}
+
+LUNA_TARGET_AVX2 void xpby(const float *x, float beta, float *y, std::size_t n) noexcept
+{
+    const __m256 vb = _mm256_set1_ps(beta);
+    std::size_t idx = 0;
+    for(; idx + 8 <= n; idx += 8)
+    {
+        _mm256_storeu_ps(y + idx, _mm256_fmadd_ps(vb, _mm256_loadu_ps(y + idx), _mm256_loadu_ps(x + idx)));
+    }
+
+    for(; idx < n; idx++)
+    {
+        y[idx] = x[idx] + beta * y[idx];
+    }
+}
+
+LUNA_TARGET_AVX2 float axpyNorm2(float alpha, const float *x, float *y, std::size_t n) noexcept
+{
+    const __m256 va = _mm256_set1_ps(alpha);
+    __m256 acc = _mm256_setzero_ps();
+    std::size_t idx = 0;
+    for(; idx + 8 <= n; idx += 8)
+    {
+        const __m256 v = _mm256_fmadd_ps(va, _mm256_loadu_ps(x + idx), _mm256_loadu_ps(y + idx));
+        _mm256_storeu_ps(y + idx, v);
+        acc = _mm256_fmadd_ps(v, v, acc);
+    }
+
+    float sum = hsum(acc);
+    for(; idx < n; idx++)
+    {
+        const float v = y[idx] + alpha * x[idx];
+        y[idx] = v;
+        sum += v*v;
+    }
+    return sum;
+}
+
+LUNA_TARGET_AVX2 void scale(float alpha, float *x, std::size_t n) noexcept
+{
+    const __m256 va = _mm256_set1_ps(alpha);
+    std::size_t idx = 0;
+    for(; idx + 8 <= n; idx += 8)
+    {
+        _mm256_storeu_ps(x + idx, _mm256_mul_ps(va, _mm256_loadu_ps(x + idx)));
+    }
+
+    for(; idx < n; idx++)
+    {
+        x[idx] *= alpha;
+    }
+}
+
+LUNA_TARGET_AVX2 void multiply(const float *a, const float *b, float *result, std::size_t n) noexcept
+{
+    std::size_t idx = 0;
+    for(; idx + 8 <= n; idx += 8)
+    {
+        _mm256_storeu_ps(result + idx, _mm256_mul_ps(_mm256_loadu_ps(a + idx), _mm256_loadu_ps(b + idx)));
+    }
+
+    for(; idx < n; idx++)
+    {
+        result[idx] = a[idx] * b[idx];
+    }
+}
+
+/** rows with eight or more entries gather x eight at a time,
+    shorter rows and the tail of a row are handled as scalars.
+*/
+LUNA_TARGET_AVX2 void spmv(std::size_t rows, const uint32_t *rowPtr, const uint32_t *colIdx,
+    const float *values, const float *x, float *y) noexcept
+{
+    for(std::size_t row = 0; row < rows; row++)
+    {
+        const auto last = rowPtr[row+1];
+        auto index = rowPtr[row];
+
+        float sum = 0;
+        if (index + 8 <= last)
+        {
+            __m256 acc = _mm256_setzero_ps();
+            for(; index + 8 <= last; index += 8)
+            {
+                const __m256i cols = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(colIdx + index));
+                const __m256  xv   = _mm256_i32gather_ps(x, cols, 4);
+                acc = _mm256_fmadd_ps(_mm256_loadu_ps(values + index), xv, acc);
+            }
+            sum = hsum(acc);
+        }
+
+        for(; index < last; index++)
+        {
+            sum += values[index] * x[colIdx[index]];
+        }
+        y[row] = sum;
+    }
+}
+
+constexpr KernelTable table{InstructionSet::AVX2, dot, axpy, xpby, axpyNorm2, scale, multiply, spmv};
+
+};
+
+bool cpuHasAVX2() noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    const bool fma     = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!fma || !osxsave) return false;
+
+    // the OS must save the YMM registers on a context switch
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif
+
+const KernelTable* tableFor(InstructionSet isa) noexcept
+{
+#ifdef LUNA_KERNELS_X86
+    switch(isa)
+    {
+    case InstructionSet::AVX2:
+        return &AVX2::table;
+    case InstructionSet::SSE:
+        return &SSE::table;
+    default:
+        break;
+    }
+#endif
+    return &Scalar::table;
+}
+
+std::atomic<const KernelTable*> g_kernels{&Scalar::table};
+
+// select the best kernels before main() runs.
+// until then, the scalar kernels are used.
+const bool g_kernelsInitialized = []()
+{
+    g_kernels.store(tableFor(detectInstructionSet()), std::memory_order_relaxed);
+    return true;
+}();
+
+inline const KernelTable& kernels() noexcept
+{
+    return *g_kernels.load(std::memory_order_relaxed);
+}
+
+};
+
+const char* LunaCore::Algebra::Kernels::toString(InstructionSet isa) noexcept
+{
+    switch(isa)
+    {
+    case InstructionSet::SCALAR:
+        return "SCALAR";
+    case InstructionSet::SSE:
+        return "SSE";
+    case InstructionSet::AVX2:
+        return "AVX2";
+    }
+    return "UNKNOWN";
+}
+
+InstructionSet LunaCore::Algebra::Kernels::detectInstructionSet() noexcept
+{
+#ifdef LUNA_KERNELS_X86
+    static const InstructionSet detected = cpuHasAVX2() ? InstructionSet::AVX2 : InstructionSet::SSE;
+    return detected;
+#else
+    return InstructionSet::SCALAR;
+#endif
+}
+
+InstructionSet LunaCore::Algebra::Kernels::instructionSet() noexcept
+{
+    return kernels().m_isa;
+}
+
+InstructionSet LunaCore::Algebra::Kernels::setInstructionSet(InstructionSet isa) noexcept
+{
+    if (static_cast<int>(isa) > static_cast<int>(detectInstructionSet()))
+    {
+        isa = detectInstructionSet();
+    }
+
+    g_kernels.store(tableFor(isa), std::memory_order_relaxed);
+    return isa;
+}
+
+float LunaCore::Algebra::Kernels::dot(const float *a, const float *b, std::size_t n) noexcept
+{
+    return kernels().m_dot(a, b, n);
+}
+
+void LunaCore::Algebra::Kernels::axpy(float alpha, const float *x, float *y, std::size_t n) noexcept
+{
+    kernels().m_axpy(alpha, x, y, n);
+}
+
+void LunaCore::Algebra::Kernels::xpby(const float *x, float beta, float *y, std::size_t n) noexcept
+{
+    kernels().m_xpby(x, beta, y, n);
+}
+
+float LunaCore::Algebra::Kernels::axpyNorm2(float alpha, const float *x, float *y, std::size_t n) noexcept
+{
+    return kernels().m_axpyNorm2(alpha, x, y, n);
+}
+
+void LunaCore::Algebra::Kernels::scale(float alpha, float *x, std::size_t n) noexcept
+{
+    kernels().m_scale(alpha, x, n);
+}
+
+void LunaCore::Algebra::Kernels::multiply(const float *a, const float *b, float *result, std::size_t n) noexcept
+{
+    kernels().m_multiply(a, b, result, n);
+}
+
+void LunaCore::Algebra::Kernels::spmv(std::size_t rows, const uint32_t *rowPtr, const uint32_t *colIdx,
+    const float *values, const float *x, float *y) noexcept
+{
+    kernels().m_spmv(rows, rowPtr, colIdx, values, x, y);
+}
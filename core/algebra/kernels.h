@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/** Vectorized floating-point kernels used by the linear algebra code.
+
+    Each kernel has a scalar, an SSE and an AVX2/FMA implementation.
+    The best implementation supported by the CPU is selected at
+    program start-up. The kernels operate on raw arrays so they can
+    be shared by Vector, CSRMatrix and the solvers.
+*/
+namespace LunaCore::Algebra::Kernels
+{
+
+enum class InstructionSet
+{
+    SCALAR,     ///< portable C++ loops
+    SSE,        ///< 4-wide SSE
+    AVX2        ///< 8-wide AVX2 with fused multiply-add
+};
+
+/** return the name of an instruction set */
+[[nodiscard]] const char* toString(InstructionSet isa) noexcept;
+
+/** return the best instruction set supported by this CPU */
+[[nodiscard]] InstructionSet detectInstructionSet() noexcept;
+
+/** return the instruction set the kernels currently use */
+[[nodiscard]] InstructionSet instructionSet() noexcept;
+
+/** select the instruction set the kernels use.
+    requesting an instruction set that isn't supported by the CPU
+    selects the best supported one instead.
+    returns the instruction set that was selected.
+*/
+InstructionSet setInstructionSet(InstructionSet isa) noexcept;
+
+/** return sum a[i]*b[i] */
+[[nodiscard]] float dot(const float *a, const float *b, std::size_t n) noexcept;
+
+/** y = y + alpha*x */
+void axpy(float alpha, const float *x, float *y, std::size_t n) noexcept;
+
+/** y = x + beta*y */
+void xpby(const float *x, float beta, float *y, std::size_t n) noexcept;
+
+/** y = y + alpha*x and return the squared L2 norm of the updated y */
+[[nodiscard]] float axpyNorm2(float alpha, const float *x, float *y, std::size_t n) noexcept;
+
+/** x = alpha*x */
+void scale(float alpha, float *x, std::size_t n) noexcept;
+
+/** result = a*b element-wise */
+void multiply(const float *a, const float *b, float *result, std::size_t n) noexcept;
+
+/** sparse matrix-vector product y = A*x with A in compressed sparse row format.
+    @param[in] rows number of rows of A and entries in y.
+    @param[in] rowPtr rows+1 offsets into colIdx and values.
+    @param[in] colIdx column index of each non-zero entry.
+    @param[in] values value of each non-zero entry.
+*/
+void spmv(std::size_t rows, const uint32_t *rowPtr, const uint32_t *colIdx,
+    const float *values, const float *x, float *y) noexcept;
+
+};
@@ -4,6 +4,7 @@
 
 #pragma once
 #include <cassert>
+#include <cmath>
 #include <list>
 #include <vector>
 #include <algorithm>
@@ -11,6 +12,7 @@
 #include "vector.hpp"
 #include "solver.hpp"
 #include "sparsematrix.hpp"
+#include "csrmatrix.hpp"
 
 /** Steepest descent solver */
 namespace LunaCore::Algebra::SDSolver
@@ -18,6 +20,7 @@ namespace LunaCore::Algebra::SDSolver
 
 /** Ax = b linear system solver based on steepest descent iterations
     @tparam T the datatype of the matrix and vectors.
+    @tparam MatrixType SparseMatrix<T> or CSRMatrix<T>.
     @param[in] mat the A matrix.
     @param[in] rhs the b vector.
     @param[out] x   the solution vector.
@@ -26,8 +29,8 @@ namespace LunaCore::Algebra::SDSolver
     @return information about the error and the number of iterations.
 */
 
-template<typename T>
-ComputeInfo solve(const SparseMatrix<T> &mat,
+template<typename T, class MatrixType>
+ComputeInfo solve(const MatrixType &mat,
     const Vector<T> &rhs,
     Vector<T> &x,
     const float tolerance = 1.0e-5f,
@@ -35,38 +38,52 @@ ComputeInfo solve(const SparseMatrix<T> &mat,
 {
     ComputeInfo info;
 
-    auto r = rhs - mat*x;   // initial residual
-    auto delta = dot(r,r);
+    const std::size_t N = mat.rowCount();
+    assert(rhs.size() == N);
+    assert(x.size() == N);
+
+    Vector<T> r(N);     // residual
+    Vector<T> q(N);     // A*r
+
+    // initial residual r = rhs - A*x
+    auto const recalcResidual = [&]()
+    {
+        multiply(mat, x, q);
+        std::copy(rhs.begin(), rhs.end(), r.begin());
+        return axpyNorm2(static_cast<T>(-1), q, r);
+    };
+
+    auto delta  = recalcResidual();
     auto delta0 = delta;
-    auto tol2  = tolerance*tolerance;
+    auto tol2   = tolerance*tolerance;
 
     info.m_iterations = 0;
     while(info.m_iterations < maxIter)
     {
         if (delta <= tol2*delta0)
         {
-            info.m_error = sqrt(dot(r,r) / norm2(rhs));
+            info.m_error = std::sqrt(delta / norm2(rhs));
             return info;
         }
 
-        auto q     = mat*r;
+        multiply(mat, r, q);
         auto alpha = delta / dot(r,q);
-        x = x + alpha*r;
-        
+        axpy(alpha, r, x);
+
         if ((info.m_iterations % 50) == 49)
         {
-            r = rhs - mat*x;
+            delta = recalcResidual();
         }
         else
         {
-            r = r - alpha*q;
+            delta = axpyNorm2(-alpha, q, r);
         }
 
-        delta = dot(r,r);
         info.m_iterations++;
     }
 
-    info.m_error = sqrt(dot(r,r) / norm2(rhs));
+    info.m_error = std::sqrt(delta / norm2(rhs));
+    info.m_converged = (delta <= tol2*delta0);
     return info;
 };
 
@@ -14,6 +14,8 @@ struct ComputeInfo
 {
     std::size_t m_iterations{0};    ///< number of iterations used to deliver the solution
     float       m_error{0.0f};      ///< error sqrt(|residual|^2 / |b|^2)
+    bool        m_converged{true};  ///< false if the solver stopped before reaching the tolerance
+    bool        m_jacobiFallback{false};    ///< true if the preconditioner could not be built and divided by the diagonal instead
 };
 
 };
@@ -21,5 +23,13 @@ struct ComputeInfo
 inline std::ostream& operator<<(std::ostream& os, const LunaCore::Algebra::ComputeInfo &info)
 {
     os << "Iterations: " << info.m_iterations << " MSE: " << info.m_error;
+    if (!info.m_converged)
+    {
+        os << " (not converged)";
+    }
+    if (info.m_jacobiFallback)
+    {
+        os << " (Jacobi fallback)";
+    }
     return os;
 }
@@ -144,6 +144,14 @@ public:
         return m_rows.at(row).size();
     }
 
+    /** return the non-zero entries of the specified row, sorted by column.
+        throws std::out_of_range exception when the row does not exist.
+    */
+    [[nodiscard]] constexpr const RowEntries& row(std::size_t row) const
+    {
+        return m_rows.at(row);
+    }
+
     /** A structure used to return matrix entries by the iterators */
     struct RowColValue
     {
@@ -273,31 +281,33 @@ protected:
 };
 
 
+/** sparse matrix-vector product result = matrix*x.
+    result must have the same size as x.
+*/
 template<class T>
-Vector<T> operator*(const SparseMatrix<T> &matrix, const Vector<T> &x)
+void multiply(const SparseMatrix<T> &matrix, const Vector<T> &x, Vector<T> &result)
 {
     assert(matrix.rowCount() == x.size());
+    assert(result.size() == x.size());
 
-    Vector<T> result;
-    result.resize(x.size());
-    result.zero();
-    
-    std::size_t row = 0;
-    float sum = 0.0f;
-    for(auto const& matEntry : matrix)
+    for(std::size_t row = 0; row < matrix.rowCount(); row++)
     {
-        if (matEntry.m_row != row)
+        T sum = 0;
+        for(auto const& entry : matrix.row(row))
         {
-            result.at(row) = sum;
-            sum = 0.0f;
-            row = matEntry.m_row;
+            sum += x[entry.m_col] * entry.m_value;
         }
-        sum += x.at(matEntry.m_col) * matEntry.m_value;
+        result[row] = sum;
     }
-    result.at(row) = sum;
-    return result;
 }
 
+template<class T>
+Vector<T> operator*(const SparseMatrix<T> &matrix, const Vector<T> &x)
+{
+    Vector<T> result(x.size());
+    multiply(matrix, x, result);
+    return result;
+}
 
 };
 
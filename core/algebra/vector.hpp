@@ -4,11 +4,14 @@
 
 #pragma once
 #include <vector>
+#include <cassert>
 #include <cstdlib>
 #include <algorithm>
 #include <span>
 #include <numeric>
+#include <type_traits>
 #include "../common/strutils.hpp"
+#include "kernels.h"
 
 namespace LunaCore::Algebra
 {
@@ -73,11 +76,25 @@ public:
     }
 
 
+    /** direct access to the contiguous entry storage */
+    [[nodiscard]] constexpr T* data() noexcept { return m_vec.data(); }
+    [[nodiscard]] constexpr const T* data() const noexcept { return m_vec.data(); }
+
     [[nodiscard]] constexpr T& at(std::size_t index) { return m_vec.at(index); }
     [[nodiscard]] constexpr const T& at(std::size_t index) const { return m_vec.at(index); }
 
-    [[nodiscard]] constexpr T& operator[](std::size_t index) { return m_vec.at(index); }
-    [[nodiscard]] constexpr const T& operator[](std::size_t index) const { return m_vec.at(index); }
+    /** unchecked element access, use at() for bounds checking */
+    [[nodiscard]] constexpr T& operator[](std::size_t index) noexcept
+    {
+        assert(index < m_vec.size());
+        return m_vec[index];
+    }
+
+    [[nodiscard]] constexpr const T& operator[](std::size_t index) const noexcept
+    {
+        assert(index < m_vec.size());
+        return m_vec[index];
+    }
 
     [[nodiscard]] constexpr T& operator()(std::size_t index) { return m_vec.at(index); }
     [[nodiscard]] constexpr const T& operator()(std::size_t index) const { return m_vec.at(index); }
@@ -115,75 +132,164 @@ protected:
     std::vector<T> m_vec;
 };
 
-template<class T>
-Vector<T> operator-(const Vector<T> &v1, const Vector<T> &v2)
-{
-    const std::size_t N = v1.size();
-    assert(N == v2.size());
 
-    auto result = v1;
+/** in-place y = y + alpha*x */
+template<typename T>
+void axpy(T alpha, const Vector<T> &x, Vector<T> &y) noexcept
+{
+    assert(x.size() == y.size());
+    const std::size_t N = x.size();
+    if constexpr (std::is_same_v<T, float>)
+    {
+        Kernels::axpy(alpha, x.data(), y.data(), N);
+        return;
+    }
 
-    for(std::size_t idx=0; idx<v1.size(); idx++)
+    const T* xdata = x.data();
+    T* ydata = y.data();
+    for(std::size_t idx=0; idx<N; idx++)
     {
-        result.at(idx) -= v2.at(idx);
+        ydata[idx] += alpha * xdata[idx];
     }
-    return result;
 }
 
-template<class T>
-Vector<T> operator+(const Vector<T> &v1, const Vector<T> &v2)
+/** in-place y = x + beta*y */
+template<typename T>
+void xpby(const Vector<T> &x, T beta, Vector<T> &y) noexcept
 {
-    const std::size_t N = v1.size();
-    assert(N == v2.size());
-
-    auto result = v1;
+    assert(x.size() == y.size());
+    const std::size_t N = x.size();
+    if constexpr (std::is_same_v<T, float>)
+    {
+        Kernels::xpby(x.data(), beta, y.data(), N);
+        return;
+    }
 
-    for(std::size_t idx=0; idx<v1.size(); idx++)
+    const T* xdata = x.data();
+    T* ydata = y.data();
+    for(std::size_t idx=0; idx<N; idx++)
     {
-        result.at(idx) += v2.at(idx);
+        ydata[idx] = xdata[idx] + beta * ydata[idx];
     }
-    return result;
 }
 
-template<class T>
-Vector<T> operator*(T factor, const Vector<T> &v2)
+/** in-place y = y + alpha*x, returns the squared L2 norm of the updated y */
+template<typename T>
+T axpyNorm2(T alpha, const Vector<T> &x, Vector<T> &y) noexcept
 {
-    const std::size_t N = v2.size();
-    Vector<T> result = v2;
+    assert(x.size() == y.size());
+    const std::size_t N = x.size();
+    if constexpr (std::is_same_v<T, float>)
+    {
+        return Kernels::axpyNorm2(alpha, x.data(), y.data(), N);
+    }
 
-    for(auto &value : result)
+    const T* xdata = x.data();
+    T* ydata = y.data();
+    T sum = 0;
+    for(std::size_t idx=0; idx<N; idx++)
     {
-        value *= factor;
+        const T v = ydata[idx] + alpha * xdata[idx];
+        ydata[idx] = v;
+        sum += v*v;
     }
-    return result;
+    return sum;
 }
 
-template<class T>
-Vector<T> operator*(const Vector<T> &v1, const Vector<T> &v2)
+/** element-wise product result = v1 * v2 */
+template<typename T>
+void multiply(const Vector<T> &v1, const Vector<T> &v2, Vector<T> &result) noexcept
 {
+    assert(v1.size() == v2.size());
+    assert(v1.size() == result.size());
     const std::size_t N = v1.size();
-    assert(v2.size() == N);
-    Vector<T> result = v1;
+    if constexpr (std::is_same_v<T, float>)
+    {
+        Kernels::multiply(v1.data(), v2.data(), result.data(), N);
+        return;
+    }
 
-    for(std::size_t idx=0; idx<v1.size(); idx++)
+    const T* v1data = v1.data();
+    const T* v2data = v2.data();
+    T* rdata = result.data();
+    for(std::size_t idx=0; idx<N; idx++)
     {
-        result.at(idx) = v1.at(idx) * v2.at(idx);
+        rdata[idx] = v1data[idx] * v2data[idx];
+    }
+}
+
+/** in-place v = alpha*v */
+template<typename T>
+void scale(T alpha, Vector<T> &v) noexcept
+{
+    if constexpr (std::is_same_v<T, float>)
+    {
+        Kernels::scale(alpha, v.data(), v.size());
+        return;
+    }
+
+    for(auto &value : v)
+    {
+        value *= alpha;
     }
-    return result;
 }
 
-/** calculate the L2 norm of a vector. */
+/** calculate the squared L2 norm of a vector. */
 template<typename T>
-constexpr auto norm2(const Vector<T> &vec) noexcept
+T norm2(const Vector<T> &vec) noexcept
 {
-    return std::inner_product(vec.begin(), vec.end(), vec.begin(), 0.0f);
+    if constexpr (std::is_same_v<T, float>)
+    {
+        return Kernels::dot(vec.data(), vec.data(), vec.size());
+    }
+    return std::inner_product(vec.begin(), vec.end(), vec.begin(), static_cast<T>(0));
 }
 
 /** calculate the dot/inner product of two vectors. */
 template<typename T>
-constexpr auto dot(const Vector<T> &vec1, const Vector<T> &vec2) noexcept
+T dot(const Vector<T> &vec1, const Vector<T> &vec2) noexcept
 {
-    return std::inner_product(vec1.begin(), vec1.end(), vec2.begin(), 0.0f);
+    assert(vec1.size() == vec2.size());
+    if constexpr (std::is_same_v<T, float>)
+    {
+        return Kernels::dot(vec1.data(), vec2.data(), vec1.size());
+    }
+    return std::inner_product(vec1.begin(), vec1.end(), vec2.begin(), static_cast<T>(0));
+}
+
+template<class T>
+Vector<T> operator-(const Vector<T> &v1, const Vector<T> &v2)
+{
+    assert(v1.size() == v2.size());
+    auto result = v1;
+    axpy(static_cast<T>(-1), v2, result);
+    return result;
+}
+
+template<class T>
+Vector<T> operator+(const Vector<T> &v1, const Vector<T> &v2)
+{
+    assert(v1.size() == v2.size());
+    auto result = v1;
+    axpy(static_cast<T>(1), v2, result);
+    return result;
+}
+
+template<class T>
+Vector<T> operator*(T factor, const Vector<T> &v2)
+{
+    Vector<T> result = v2;
+    scale(factor, result);
+    return result;
+}
+
+template<class T>
+Vector<T> operator*(const Vector<T> &v1, const Vector<T> &v2)
+{
+    assert(v1.size() == v2.size());
+    Vector<T> result(v1.size());
+    multiply(v1, v2, result);
+    return result;
 }
 
 };
@@ -0,0 +1,894 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include "detailedplacer.h"
+#include "common/logging.h"
+
+using namespace LunaCore;
+
+/** grow a bounding box so it includes point p */
+static void extendBox(std::optional<ChipDB::Rect64> &box, const ChipDB::Coord64 &p)
+{
+    if (!box.has_value())
+    {
+        box = ChipDB::Rect64{p, p};
+        return;
+    }
+
+    box->m_ll.m_x = std::min(box->m_ll.m_x, p.m_x);
+    box->m_ll.m_y = std::min(box->m_ll.m_y, p.m_y);
+    box->m_ur.m_x = std::max(box->m_ur.m_x, p.m_x);
+    box->m_ur.m_y = std::max(box->m_ur.m_y, p.m_y);
+}
+
+static ChipDB::CoordType boxHPWL(const std::optional<ChipDB::Rect64> &box)
+{
+    if (!box.has_value())
+    {
+        return 0;
+    }
+
+    return (box->m_ur.m_x - box->m_ll.m_x) + (box->m_ur.m_y - box->m_ll.m_y);
+}
+
+/** Hungarian method for a square n x n cost matrix stored row by row.
+ *  Returns the column assigned to each row, minimizing the total cost.
+*/
+static std::vector<std::size_t> solveAssignment(const std::vector<ChipDB::CoordType> &cost, const std::size_t n)
+{
+    constexpr auto infinity = std::numeric_limits<ChipDB::CoordType>::max() / 4;
+
+    // 1-based potentials and matching, column 0 is a sentinel
+    std::vector<ChipDB::CoordType> u(n+1, 0);
+    std::vector<ChipDB::CoordType> v(n+1, 0);
+    std::vector<ChipDB::CoordType> minv(n+1);
+    std::vector<std::size_t> p(n+1, 0);
+    std::vector<std::size_t> way(n+1, 0);
+    std::vector<bool> used(n+1);
+
+    for(std::size_t i = 1; i <= n; i++)
+    {
+        p[0] = i;
+        std::size_t j0 = 0;
+        std::fill(minv.begin(), minv.end(), infinity);
+        std::fill(used.begin(), used.end(), false);
+
+        do
+        {
+            used[j0] = true;
+            const auto i0 = p[j0];
+            auto delta = infinity;
+            std::size_t j1 = 0;
+            for(std::size_t j = 1; j <= n; j++)
+            {
+                if (used[j]) continue;
+
+                const auto cur = cost[(i0-1)*n + (j-1)] - u[i0] - v[j];
+                if (cur < minv[j])
+                {
+                    minv[j] = cur;
+                    way[j]  = j0;
+                }
+
+                if (minv[j] < delta)
+                {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+
+            for(std::size_t j = 0; j <= n; j++)
+            {
+                if (used[j])
+                {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                }
+                else
+                {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while(p[j0] != 0);
+
+        do
+        {
+            const auto j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while(j0 != 0);
+    }
+
+    std::vector<std::size_t> assignment(n);
+    for(std::size_t j = 1; j <= n; j++)
+    {
+        assignment[p[j]-1] = j-1;
+    }
+    return assignment;
+}
+
+bool DetailedPlacer::place(const ChipDB::Floorplan &floorplan, ChipDB::Netlist &netlist)
+{
+    return place(floorplan, netlist, Parameters{});
+}
+
+bool DetailedPlacer::place(const ChipDB::Floorplan &floorplan, ChipDB::Netlist &netlist,
+    const Parameters &params)
+{
+    if (!init(floorplan, netlist, params))
+    {
+        return false;
+    }
+
+    const PoolSelection threads(params.m_threads);
+
+    const double initialHPWL = m_boxes.totalHPWL();
+    double hpwl = initialHPWL;
+    for(std::size_t pass = 0; pass < params.m_passes; pass++)
+    {
+        const auto swapped   = globalSwap();
+        const auto reordered = reorderCells(params.m_reorderWindow);
+        const auto matched   = independentSetMatching(params, threads);
+
+        const double newHPWL = m_boxes.totalHPWL();
+        Logging::logVerbose("Detailed placement pass %lu: %lu swapped, %lu reordered, %lu matched, HPWL = %f *1e6 nm\n",
+            pass + 1, swapped, reordered, matched, newHPWL / 1.0e6);
+
+        const bool converged = (hpwl - newHPWL) < (params.m_minGain * hpwl);
+        hpwl = newHPWL;
+        if (converged)
+        {
+            break;
+        }
+    }
+
+    writeBack(netlist);
+
+    Logging::logInfo("Detailed placement: HPWL %f -> %f *1e6 nm\n", initialHPWL / 1.0e6, hpwl / 1.0e6);
+    return true;
+}
+
+bool DetailedPlacer::init(const ChipDB::Floorplan &floorplan, const ChipDB::Netlist &netlist,
+    const Parameters &params)
+{
+    m_siteWidth = floorplan.minimumCellSize().m_x;
+    if (m_siteWidth <= 0)
+    {
+        Logging::logError("DetailedPlacer::place: min cell width has not been defined for core area.\n");
+        return false;
+    }
+
+    auto rows = Legalizer::createRowSegments(floorplan, netlist, m_siteWidth);
+    std::sort(rows.begin(), rows.end(), [](auto const& row1, auto const& row2)
+        {
+            if (row1.m_rect.bottom() != row2.m_rect.bottom())
+            {
+                return row1.m_rect.bottom() < row2.m_rect.bottom();
+            }
+            return row1.m_rect.left() < row2.m_rect.left();
+        }
+    );
+
+    m_segments.clear();
+    m_rowY.clear();
+    m_rowSegments.clear();
+    for(auto &row : rows)
+    {
+        if (m_rowY.empty() || (m_rowY.back() != row.m_rect.bottom()))
+        {
+            m_rowY.push_back(row.m_rect.bottom());
+            m_rowSegments.emplace_back();
+        }
+
+        m_rowSegments.back().push_back(m_segments.size());
+        auto &segment = m_segments.emplace_back();
+        segment.m_row    = std::move(row);
+        segment.m_rowIdx = m_rowY.size() - 1;
+    }
+
+    m_cells.clear();
+    for(auto const insKeyObjPair : netlist.m_instances)
+    {
+        if (insKeyObjPair->m_placementInfo != ChipDB::PlacementInfo::PLACED) continue;
+
+        auto const size = insKeyObjPair->instanceSize();
+        if (size.m_x <= 0) continue;
+
+        // find the segment that holds the instance
+        auto const pos = insKeyObjPair->m_pos;
+        std::optional<std::size_t> cellSegment;
+        auto rowIter = std::lower_bound(m_rowY.begin(), m_rowY.end(), pos.m_y);
+        if ((rowIter != m_rowY.end()) && (*rowIter == pos.m_y))
+        {
+            for(auto segIdx : m_rowSegments.at(rowIter - m_rowY.begin()))
+            {
+                auto const& rect = m_segments[segIdx].m_row.m_rect;
+                if ((pos.m_x >= rect.left()) && ((pos.m_x + size.m_x) <= rect.right()))
+                {
+                    cellSegment = segIdx;
+                    break;
+                }
+            }
+        }
+
+        if (!cellSegment.has_value())
+        {
+            Logging::logError("DetailedPlacer::place: instance %s is not inside a row, run the legalizer first.\n",
+                insKeyObjPair->name().c_str());
+            return false;
+        }
+
+        auto &cell = m_cells.emplace_back();
+        cell.m_insKey  = insKeyObjPair.key();
+        cell.m_size    = size;
+        cell.m_x       = pos.m_x;
+        cell.m_segment = cellSegment.value();
+    }
+
+    rebuildSegmentLists();
+
+    for(auto const& segment : m_segments)
+    {
+        for(std::size_t idx = 1; idx < segment.m_cells.size(); idx++)
+        {
+            auto const& prev = m_cells[segment.m_cells[idx-1]];
+            auto const& cell = m_cells[segment.m_cells[idx]];
+            if ((prev.m_x + prev.m_size.m_x) > cell.m_x)
+            {
+                Logging::logError("DetailedPlacer::place: instances %s and %s overlap, run the legalizer first.\n",
+                    netlist.m_instances.at(prev.m_insKey)->name().c_str(),
+                    netlist.m_instances.at(cell.m_insKey)->name().c_str());
+                return false;
+            }
+        }
+    }
+
+    m_boxes.rebuild(netlist, params.m_threads);
+    return true;
+}
+
+void DetailedPlacer::rebuildSegmentLists()
+{
+    for(auto &segment : m_segments)
+    {
+        segment.m_cells.clear();
+    }
+
+    for(std::size_t cellIdx = 0; cellIdx < m_cells.size(); cellIdx++)
+    {
+        m_segments[m_cells[cellIdx].m_segment].m_cells.push_back(cellIdx);
+    }
+
+    for(auto &segment : m_segments)
+    {
+        std::sort(segment.m_cells.begin(), segment.m_cells.end(), [this](std::size_t cell1, std::size_t cell2)
+            {
+                return m_cells[cell1].m_x < m_cells[cell2].m_x;
+            }
+        );
+    }
+}
+
+ChipDB::CoordType DetailedPlacer::moveCell(std::size_t cellIdx, ChipDB::CoordType x, std::size_t segIdx)
+{
+    auto &cell = m_cells[cellIdx];
+    cell.m_x = x;
+    cell.m_segment = segIdx;
+    return m_boxes.moveInstance(cell.m_insKey, cellCenter(cell, x, segIdx));
+}
+
+std::size_t DetailedPlacer::listPosition(std::size_t cellIdx) const
+{
+    auto const& cells = m_segments[m_cells[cellIdx].m_segment].m_cells;
+    auto iter = std::lower_bound(cells.begin(), cells.end(), m_cells[cellIdx].m_x,
+        [this](std::size_t idx, ChipDB::CoordType x)
+        {
+            return m_cells[idx].m_x < x;
+        }
+    );
+
+    assert((iter != cells.end()) && (*iter == cellIdx));
+    return iter - cells.begin();
+}
+
+std::optional<ChipDB::Coord64> DetailedPlacer::optimalPosition(std::size_t cellIdx) const
+{
+    auto const& cell = m_cells[cellIdx];
+    const ChipDB::InstanceObjectKey self[1] = {cell.m_insKey};
+
+    std::vector<ChipDB::CoordType> xs;
+    std::vector<ChipDB::CoordType> ys;
+    for(auto netKey : m_boxes.instanceNets(cell.m_insKey))
+    {
+        auto box = m_boxes.netBoxWithout(netKey, self);
+        if (!box.has_value()) continue;
+
+        xs.push_back(box->m_ll.m_x);
+        xs.push_back(box->m_ur.m_x);
+        ys.push_back(box->m_ll.m_y);
+        ys.push_back(box->m_ur.m_y);
+    }
+
+    if (xs.empty())
+    {
+        return std::nullopt;
+    }
+
+    // the optimal region lies between the two middle box edges
+    std::sort(xs.begin(), xs.end());
+    std::sort(ys.begin(), ys.end());
+    const auto mid = xs.size() / 2;
+
+    const auto center = m_boxes.instanceCenter(cell.m_insKey);
+    if ((center.m_x >= xs[mid-1]) && (center.m_x <= xs[mid]) &&
+        (center.m_y >= ys[mid-1]) && (center.m_y <= ys[mid]))
+    {
+        return std::nullopt;
+    }
+
+    return ChipDB::Coord64{(xs[mid-1] + xs[mid])/2, (ys[mid-1] + ys[mid])/2};
+}
+
+std::size_t DetailedPlacer::globalSwap()
+{
+    std::size_t moved = 0;
+    for(std::size_t cellIdx = 0; cellIdx < m_cells.size(); cellIdx++)
+    {
+        auto target = optimalPosition(cellIdx);
+        if (!target.has_value()) continue;
+
+        auto const& cell = m_cells[cellIdx];
+
+        // the row closest to the optimal region
+        const auto targetBottom = target->m_y - cell.m_size.m_y/2;
+        std::size_t rowIdx = std::lower_bound(m_rowY.begin(), m_rowY.end(), targetBottom) - m_rowY.begin();
+        if ((rowIdx == m_rowY.size()) ||
+            ((rowIdx > 0) && ((targetBottom - m_rowY[rowIdx-1]) < (m_rowY[rowIdx] - targetBottom))))
+        {
+            rowIdx--;
+        }
+
+        if (tryRelocate(cellIdx, rowIdx, target->m_x - cell.m_size.m_x/2))
+        {
+            moved++;
+            continue;
+        }
+
+        // vertical swap: one row towards the optimal region
+        const auto cellRowIdx = m_segments[cell.m_segment].m_rowIdx;
+        if (rowIdx == cellRowIdx) continue;
+
+        const auto nextRowIdx = (rowIdx > cellRowIdx) ? cellRowIdx + 1 : cellRowIdx - 1;
+        if (tryRelocate(cellIdx, nextRowIdx, cell.m_x))
+        {
+            moved++;
+        }
+    }
+
+    return moved;
+}
+
+bool DetailedPlacer::tryRelocate(std::size_t cellIdx, std::size_t rowIdx, ChipDB::CoordType targetX)
+{
+    // the segment of the row that contains targetX or is closest to it
+    auto const& rowSegments = m_rowSegments.at(rowIdx);
+    auto segIter = std::upper_bound(rowSegments.begin(), rowSegments.end(), targetX,
+        [this](ChipDB::CoordType x, std::size_t segIdx)
+        {
+            return x < m_segments[segIdx].m_row.m_rect.left();
+        }
+    );
+
+    std::size_t segIdx = 0;
+    if (segIter == rowSegments.begin())
+    {
+        segIdx = *segIter;
+    }
+    else
+    {
+        segIdx = *(segIter - 1);
+        if ((targetX >= m_segments[segIdx].m_row.m_rect.right()) && (segIter != rowSegments.end()) &&
+            ((m_segments[*segIter].m_row.m_rect.left() - targetX) < (targetX - m_segments[segIdx].m_row.m_rect.right())))
+        {
+            segIdx = *segIter;
+        }
+    }
+
+    auto &cell = m_cells[cellIdx];
+    const auto oldX   = cell.m_x;
+    const auto oldSeg = cell.m_segment;
+
+    auto const& segment = m_segments[segIdx];
+    auto const& cells   = segment.m_cells;
+    auto const& rect    = segment.m_row.m_rect;
+
+    // the other cells around targetX and the free space next to them
+    const std::size_t pos = std::lower_bound(cells.begin(), cells.end(), targetX,
+        [this](std::size_t idx, ChipDB::CoordType x)
+        {
+            return m_cells[idx].m_x < x;
+        }
+    ) - cells.begin();
+
+    const std::size_t lo = (pos >= 2) ? pos - 2 : 0;
+    const std::size_t hi = std::min(cells.size(), pos + 2);
+
+    std::vector<std::size_t> others;
+    for(std::size_t idx = lo; idx < hi; idx++)
+    {
+        if (cells[idx] != cellIdx) others.push_back(cells[idx]);
+    }
+
+    auto cellEnd = [this](std::size_t idx)
+    {
+        return m_cells[idx].m_x + m_cells[idx].m_size.m_x;
+    };
+
+    ChipDB::CoordType leftBound = rect.left();
+    if ((lo > 0) && (cells[lo-1] != cellIdx))
+    {
+        leftBound = cellEnd(cells[lo-1]);
+    }
+    else if (lo > 1)
+    {
+        leftBound = cellEnd(cells[lo-2]);
+    }
+
+    ChipDB::CoordType rightBound = rect.right();
+    if ((hi < cells.size()) && (cells[hi] != cellIdx))
+    {
+        rightBound = m_cells[cells[hi]].m_x;
+    }
+    else if ((hi + 1) < cells.size())
+    {
+        rightBound = m_cells[cells[hi+1]].m_x;
+    }
+
+    ChipDB::CoordType bestDelta = 0;
+    std::optional<ChipDB::CoordType> bestX;
+    std::optional<std::size_t> bestSwap;
+
+    auto evaluateGap = [&](ChipDB::CoordType gapLeft, ChipDB::CoordType gapRight)
+    {
+        const auto width = cell.m_size.m_x;
+        if ((gapRight - gapLeft) < width) return;
+
+        // the site closest to the target inside the gap
+        const auto origin = segment.m_row.m_gridOrigin;
+        auto x = std::clamp(targetX, gapLeft, gapRight - width);
+        x = origin + ((x - origin + m_siteWidth/2) / m_siteWidth) * m_siteWidth;
+        if (x < gapLeft) x += m_siteWidth;
+        if ((x + width) > gapRight) x -= m_siteWidth;
+        if ((x < gapLeft) || ((x + width) > gapRight)) return;
+        if ((x == oldX) && (segIdx == oldSeg)) return;
+
+        const auto delta = moveCell(cellIdx, x, segIdx);
+        moveCell(cellIdx, oldX, oldSeg);
+        if (delta < bestDelta)
+        {
+            bestDelta = delta;
+            bestX     = x;
+            bestSwap.reset();
+        }
+    };
+
+    auto evaluateSwap = [&](std::size_t otherIdx)
+    {
+        auto const& other = m_cells[otherIdx];
+        if ((other.m_size.m_x != cell.m_size.m_x) || (other.m_size.m_y != cell.m_size.m_y)) return;
+
+        const auto otherX   = other.m_x;
+        const auto otherSeg = other.m_segment;
+        const auto delta = moveCell(cellIdx, otherX, otherSeg) + moveCell(otherIdx, oldX, oldSeg);
+        moveCell(otherIdx, otherX, otherSeg);
+        moveCell(cellIdx, oldX, oldSeg);
+        if (delta < bestDelta)
+        {
+            bestDelta = delta;
+            bestSwap  = otherIdx;
+            bestX.reset();
+        }
+    };
+
+    auto gapLeft = leftBound;
+    for(auto otherIdx : others)
+    {
+        evaluateGap(gapLeft, m_cells[otherIdx].m_x);
+        evaluateSwap(otherIdx);
+        gapLeft = cellEnd(otherIdx);
+    }
+    evaluateGap(gapLeft, rightBound);
+
+    if (bestSwap.has_value())
+    {
+        const auto otherIdx = bestSwap.value();
+        const auto otherPos = listPosition(otherIdx);
+        const auto cellPos  = listPosition(cellIdx);
+        const auto otherX   = m_cells[otherIdx].m_x;
+
+        moveCell(cellIdx, otherX, segIdx);
+        moveCell(otherIdx, oldX, oldSeg);
+        m_segments[oldSeg].m_cells[cellPos] = otherIdx;
+        m_segments[segIdx].m_cells[otherPos] = cellIdx;
+        return true;
+    }
+
+    if (bestX.has_value())
+    {
+        auto &oldCells = m_segments[oldSeg].m_cells;
+        oldCells.erase(oldCells.begin() + listPosition(cellIdx));
+
+        moveCell(cellIdx, bestX.value(), segIdx);
+
+        auto &newCells = m_segments[segIdx].m_cells;
+        auto iter = std::lower_bound(newCells.begin(), newCells.end(), bestX.value(),
+            [this](std::size_t idx, ChipDB::CoordType x)
+            {
+                return m_cells[idx].m_x < x;
+            }
+        );
+        newCells.insert(iter, cellIdx);
+        return true;
+    }
+
+    return false;
+}
+
+std::size_t DetailedPlacer::reorderCells(std::size_t windowSize)
+{
+    windowSize = std::clamp<std::size_t>(windowSize, 2, 4);
+
+    // the nets of the window cells, their boxes without the window
+    // and a bit for each window cell that is on the net.
+    struct WindowNet
+    {
+        ChipDB::NetObjectKey            m_netKey;
+        std::optional<ChipDB::Rect64>   m_box;
+        uint32_t                        m_cells{0};
+    };
+
+    std::vector<WindowNet> nets;
+    std::vector<std::size_t> window(windowSize);
+    std::vector<ChipDB::InstanceObjectKey> insKeys(windowSize);
+    std::vector<ChipDB::CoordType> gaps(windowSize);
+    std::vector<ChipDB::CoordType> xpos(windowSize);
+    std::vector<ChipDB::CoordType> bestXpos(windowSize);
+    std::vector<std::size_t> order(windowSize);
+    std::vector<std::size_t> bestOrder(windowSize);
+
+    std::size_t changed = 0;
+    for(std::size_t segIdx = 0; segIdx < m_segments.size(); segIdx++)
+    {
+        auto &segment = m_segments[segIdx];
+        auto &cells   = segment.m_cells;
+        const auto origin = segment.m_row.m_gridOrigin;
+
+        for(std::size_t start = 0; (start + windowSize) <= cells.size(); start++)
+        {
+            for(std::size_t idx = 0; idx < windowSize; idx++)
+            {
+                window[idx]  = cells[start + idx];
+                insKeys[idx] = m_cells[window[idx]].m_insKey;
+            }
+
+            // the free space between the cells is kept in place
+            for(std::size_t idx = 0; idx + 1 < windowSize; idx++)
+            {
+                auto const& cell = m_cells[window[idx]];
+                gaps[idx] = m_cells[window[idx+1]].m_x - (cell.m_x + cell.m_size.m_x);
+            }
+            gaps[windowSize-1] = 0;
+
+            const auto windowLeft  = m_cells[window.front()].m_x;
+            const auto windowRight = m_cells[window.back()].m_x + m_cells[window.back()].m_size.m_x;
+
+            nets.clear();
+            for(std::size_t idx = 0; idx < windowSize; idx++)
+            {
+                for(auto netKey : m_boxes.instanceNets(insKeys[idx]))
+                {
+                    auto iter = std::find_if(nets.begin(), nets.end(), [netKey](auto const& net)
+                        {
+                            return net.m_netKey == netKey;
+                        }
+                    );
+
+                    if (iter == nets.end())
+                    {
+                        iter = nets.insert(nets.end(), WindowNet{netKey, std::nullopt, 0});
+                    }
+                    iter->m_cells |= (1u << idx);
+                }
+            }
+
+            for(auto &net : nets)
+            {
+                net.m_box = m_boxes.netBoxWithout(net.m_netKey, insKeys);
+            }
+
+            // HPWL of the window nets with the cells in the given order,
+            // or std::nullopt if the cells don't fit on the site grid.
+            auto evaluate = [&]() -> std::optional<ChipDB::CoordType>
+            {
+                auto x = windowLeft;
+                for(std::size_t slot = 0; slot < windowSize; slot++)
+                {
+                    auto const& cell = m_cells[window[order[slot]]];
+                    x = origin + ((x - origin + m_siteWidth - 1) / m_siteWidth) * m_siteWidth;
+                    xpos[order[slot]] = x;
+                    x += cell.m_size.m_x + gaps[slot];
+                }
+
+                auto const& last = m_cells[window[order.back()]];
+                if ((xpos[order.back()] + last.m_size.m_x) > windowRight)
+                {
+                    return std::nullopt;
+                }
+
+                ChipDB::CoordType hpwl = 0;
+                for(auto const& net : nets)
+                {
+                    auto box = net.m_box;
+                    for(std::size_t idx = 0; idx < windowSize; idx++)
+                    {
+                        if ((net.m_cells & (1u << idx)) == 0) continue;
+                        extendBox(box, cellCenter(m_cells[window[idx]], xpos[idx], segIdx));
+                    }
+                    hpwl += boxHPWL(box);
+                }
+                return hpwl;
+            };
+
+            std::iota(order.begin(), order.end(), 0);
+            auto bestCost = evaluate();
+            if (!bestCost.has_value()) continue;
+
+            const auto currentCost = bestCost.value();
+            bool improved = false;
+            while(std::next_permutation(order.begin(), order.end()))
+            {
+                auto cost = evaluate();
+                if (cost.has_value() && (cost.value() < bestCost.value()))
+                {
+                    bestCost  = cost;
+                    bestOrder = order;
+                    bestXpos  = xpos;
+                    improved  = true;
+                }
+            }
+
+            if (!improved || (bestCost.value() >= currentCost)) continue;
+
+            for(std::size_t slot = 0; slot < windowSize; slot++)
+            {
+                const auto idx = bestOrder[slot];
+                moveCell(window[idx], bestXpos[idx], segIdx);
+                cells[start + slot] = window[idx];
+            }
+            changed++;
+        }
+    }
+
+    return changed;
+}
+
+std::size_t DetailedPlacer::independentSetMatching(const Parameters &params, const PoolSelection &threads)
+{
+    const auto rowsPerWindow  = std::max<std::size_t>(1, params.m_matchingRows);
+    const auto cellsPerWindow = std::max<std::size_t>(2, params.m_matchingWindowCells);
+
+    // windows of a few rows, the cells in order of x
+    std::vector<MatchingWindow> windows;
+    std::vector<std::size_t> bandCells;
+    for(std::size_t rowStart = 0; rowStart < m_rowY.size(); rowStart += rowsPerWindow)
+    {
+        bandCells.clear();
+        const auto rowEnd = std::min(m_rowY.size(), rowStart + rowsPerWindow);
+        for(auto rowIdx = rowStart; rowIdx < rowEnd; rowIdx++)
+        {
+            for(auto segIdx : m_rowSegments[rowIdx])
+            {
+                auto const& cells = m_segments[segIdx].m_cells;
+                bandCells.insert(bandCells.end(), cells.begin(), cells.end());
+            }
+        }
+
+        std::stable_sort(bandCells.begin(), bandCells.end(), [this](std::size_t cell1, std::size_t cell2)
+            {
+                return m_cells[cell1].m_x < m_cells[cell2].m_x;
+            }
+        );
+
+        for(std::size_t first = 0; first < bandCells.size(); first += cellsPerWindow)
+        {
+            const auto last = std::min(bandCells.size(), first + cellsPerWindow);
+            windows.emplace_back().m_cells.assign(bandCells.begin() + first, bandCells.begin() + last);
+        }
+    }
+
+    // the windows only read the placement
+    threads.forEach(0, windows.size(), [this, &windows, &params](std::size_t idx)
+        {
+            solveMatchingWindow(windows[idx], params);
+        }
+    );
+
+    // windows that share nets were solved against the same placement,
+    // undo a window if the moves of the windows before it cancel its gain.
+    std::size_t moved = 0;
+    std::vector<Move> undo;
+    for(auto const& window : windows)
+    {
+        if (window.m_moves.empty()) continue;
+
+        undo.clear();
+        ChipDB::CoordType delta = 0;
+        for(auto const& move : window.m_moves)
+        {
+            auto const& cell = m_cells[move.m_cell];
+            undo.push_back(Move{move.m_cell, cell.m_x, cell.m_segment});
+            delta += moveCell(move.m_cell, move.m_x, move.m_segment);
+        }
+
+        if (delta >= 0)
+        {
+            for(auto iter = undo.rbegin(); iter != undo.rend(); ++iter)
+            {
+                moveCell(iter->m_cell, iter->m_x, iter->m_segment);
+            }
+            continue;
+        }
+
+        moved += window.m_moves.size();
+    }
+
+    if (moved > 0)
+    {
+        rebuildSegmentLists();
+    }
+
+    return moved;
+}
+
+void DetailedPlacer::solveMatchingWindow(MatchingWindow &window, const Parameters &params) const
+{
+    const auto maxSetSize = std::max<std::size_t>(2, params.m_matchingSetSize);
+
+    // cells of the same size can take each other's position
+    auto cells = window.m_cells;
+    std::stable_sort(cells.begin(), cells.end(), [this](std::size_t cell1, std::size_t cell2)
+        {
+            auto const& size1 = m_cells[cell1].m_size;
+            auto const& size2 = m_cells[cell2].m_size;
+            if (size1.m_x != size2.m_x) return size1.m_x < size2.m_x;
+            return size1.m_y < size2.m_y;
+        }
+    );
+
+    std::vector<std::size_t> pending;
+    std::vector<std::size_t> remaining;
+    std::vector<std::size_t> set;
+    std::vector<ChipDB::NetObjectKey> setNets;
+    std::vector<std::vector<std::optional<ChipDB::Rect64>>> boxes;
+    std::vector<ChipDB::CoordType> cost;
+
+    std::size_t groupStart = 0;
+    while(groupStart < cells.size())
+    {
+        auto const& groupSize = m_cells[cells[groupStart]].m_size;
+        auto groupEnd = groupStart;
+        while((groupEnd < cells.size()) &&
+            (m_cells[cells[groupEnd]].m_size.m_x == groupSize.m_x) &&
+            (m_cells[cells[groupEnd]].m_size.m_y == groupSize.m_y))
+        {
+            groupEnd++;
+        }
+
+        pending.assign(cells.begin() + groupStart, cells.begin() + groupEnd);
+        groupStart = groupEnd;
+
+        while(pending.size() >= 2)
+        {
+            // pick cells that share no nets, so their costs are independent
+            set.clear();
+            setNets.clear();
+            remaining.clear();
+            for(auto cellIdx : pending)
+            {
+                if (set.size() == maxSetSize)
+                {
+                    remaining.push_back(cellIdx);
+                    continue;
+                }
+
+                auto nets = m_boxes.instanceNets(m_cells[cellIdx].m_insKey);
+                if (nets.empty()) continue;
+
+                const bool shared = std::any_of(nets.begin(), nets.end(), [&setNets](auto netKey)
+                    {
+                        return std::find(setNets.begin(), setNets.end(), netKey) != setNets.end();
+                    }
+                );
+
+                if (shared)
+                {
+                    remaining.push_back(cellIdx);
+                    continue;
+                }
+
+                set.push_back(cellIdx);
+                setNets.insert(setNets.end(), nets.begin(), nets.end());
+            }
+            pending.swap(remaining);
+
+            const auto n = set.size();
+            if (n < 2) continue;
+
+            boxes.resize(n);
+            for(std::size_t i = 0; i < n; i++)
+            {
+                const ChipDB::InstanceObjectKey self[1] = {m_cells[set[i]].m_insKey};
+                boxes[i].clear();
+                for(auto netKey : m_boxes.instanceNets(self[0]))
+                {
+                    boxes[i].push_back(m_boxes.netBoxWithout(netKey, self));
+                }
+            }
+
+            // cost of cell i at the position of cell j
+            cost.resize(n*n);
+            for(std::size_t i = 0; i < n; i++)
+            {
+                auto const& cell = m_cells[set[i]];
+                for(std::size_t j = 0; j < n; j++)
+                {
+                    auto const& target = m_cells[set[j]];
+                    const auto center = cellCenter(cell, target.m_x, target.m_segment);
+
+                    ChipDB::CoordType hpwl = 0;
+                    for(auto box : boxes[i])
+                    {
+                        extendBox(box, center);
+                        hpwl += boxHPWL(box);
+                    }
+                    cost[i*n + j] = hpwl;
+                }
+            }
+
+            const auto assignment = solveAssignment(cost, n);
+
+            ChipDB::CoordType gain = 0;
+            for(std::size_t i = 0; i < n; i++)
+            {
+                gain += cost[i*n + i] - cost[i*n + assignment[i]];
+            }
+
+            if (gain <= 0) continue;
+
+            for(std::size_t i = 0; i < n; i++)
+            {
+                if (assignment[i] == i) continue;
+
+                auto const& target = m_cells[set[assignment[i]]];
+                window.m_moves.push_back(Move{set[i], target.m_x, target.m_segment});
+            }
+        }
+    }
+}
+
+void DetailedPlacer::writeBack(ChipDB::Netlist &netlist) const
+{
+    for(auto const& cell : m_cells)
+    {
+        auto const& row = m_segments[cell.m_segment].m_row;
+        auto ins = netlist.m_instances.at(cell.m_insKey);
+        ins->m_pos = ChipDB::Coord64{cell.m_x, row.m_rect.bottom()};
+        ins->m_orientation = (row.m_rowType == ChipDB::RowType::FLIPY) ?
+            ChipDB::Orientation::MX : ChipDB::Orientation::R0;
+    }
+}
@@ -0,0 +1,143 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+#include <vector>
+#include <optional>
+
+#include "database/database.h"
+#include "database/netlisttools.h"
+#include "common/threadpool.h"
+#include "rowlegalizer.h"
+
+namespace LunaCore
+{
+
+/** Wire length driven detailed placement of legalized cells.
+ *
+ *  The cells stay on the site grid of the row segments made by
+ *  Legalizer::createRowSegments and get the orientation of their row.
+ *  Each pass runs the following moves:
+ *
+ *  - global swap: a cell moves to a gap, or swaps with a cell of the same size,
+ *    near the median of the bounding boxes of its nets (its optimal region).
+ *  - vertical swap: the same, in the adjacent row towards the optimal region.
+ *  - local reordering: all orders of windows of 3 or 4 neighbouring cells in a row.
+ *  - independent-set matching: cells of the same size that share no nets are
+ *    assigned to each other's positions by solving an assignment problem.
+ *    The windows are solved concurrently and applied in order, a window that
+ *    increases the wire length because of its neighbours is undone.
+ *
+ *  The wire length is the HPWL of the instance centers, see NetlistTools::calcHPWL.
+*/
+class DetailedPlacer
+{
+public:
+
+    struct Parameters
+    {
+        std::size_t m_passes{3};                ///< maximum number of passes
+        double      m_minGain{0.001};           ///< stop when a pass reduces the HPWL by less than this fraction
+        std::size_t m_reorderWindow{3};         ///< cells in a local reordering window, 2 to 4
+        std::size_t m_matchingSetSize{12};      ///< maximum number of cells in an independent set
+        std::size_t m_matchingWindowCells{64};  ///< cells in an independent-set matching window
+        std::size_t m_matchingRows{2};          ///< rows in an independent-set matching window
+
+        std::size_t m_threads{0};               ///< thread count, see PoolSelection
+    };
+
+    /** improve the placement of the legalized, movable instances.
+     *  Returns false if an instance is not on a legal position.
+    */
+    [[nodiscard]] bool place(const ChipDB::Floorplan &floorplan, ChipDB::Netlist &netlist);
+
+    [[nodiscard]] bool place(const ChipDB::Floorplan &floorplan, ChipDB::Netlist &netlist,
+        const Parameters &params);
+
+protected:
+    struct Cell
+    {
+        ChipDB::InstanceObjectKey m_insKey{ChipDB::ObjectNotFound};
+        ChipDB::Coord64     m_size;         ///< instance size
+        ChipDB::CoordType   m_x{0};         ///< left edge
+        std::size_t         m_segment{0};   ///< index into m_segments
+    };
+
+    struct Segment
+    {
+        Legalizer::Row              m_row;
+        std::size_t                 m_rowIdx{0};    ///< index into m_rowY
+        std::vector<std::size_t>    m_cells;        ///< cell indices in order of x
+    };
+
+    struct Move
+    {
+        std::size_t         m_cell;
+        ChipDB::CoordType   m_x;
+        std::size_t         m_segment;
+    };
+
+    /** the cells of an independent-set matching window and the moves that improve them */
+    struct MatchingWindow
+    {
+        std::vector<std::size_t>    m_cells;
+        std::vector<Move>           m_moves;
+    };
+
+    [[nodiscard]] bool init(const ChipDB::Floorplan &floorplan, const ChipDB::Netlist &netlist,
+        const Parameters &params);
+
+    /** center of a cell at position x in a segment */
+    [[nodiscard]] ChipDB::Coord64 cellCenter(const Cell &cell, ChipDB::CoordType x, std::size_t segIdx) const noexcept
+    {
+        return ChipDB::Coord64{x + cell.m_size.m_x/2, m_segments[segIdx].m_row.m_rect.bottom() + cell.m_size.m_y/2};
+    }
+
+    /** move a cell and update the net boxes, returns the change of the HPWL.
+     *  The cell lists of the segments are not changed.
+    */
+    ChipDB::CoordType moveCell(std::size_t cellIdx, ChipDB::CoordType x, std::size_t segIdx);
+
+    /** position of a cell in the cell list of its segment */
+    [[nodiscard]] std::size_t listPosition(std::size_t cellIdx) const;
+
+    /** the center of the optimal region of a cell, or std::nullopt if the cell
+     *  already is inside it or has no nets.
+    */
+    [[nodiscard]] std::optional<ChipDB::Coord64> optimalPosition(std::size_t cellIdx) const;
+
+    /** global and vertical swap, returns the number of moved cells */
+    std::size_t globalSwap();
+
+    /** move a cell to a gap or swap it with a cell of the same size near
+     *  targetX in a row, if this reduces the HPWL.
+    */
+    bool tryRelocate(std::size_t cellIdx, std::size_t rowIdx, ChipDB::CoordType targetX);
+
+    /** try all orders of windows of neighbouring cells, returns the number of changed windows */
+    std::size_t reorderCells(std::size_t windowSize);
+
+    /** independent-set matching, returns the number of moved cells */
+    std::size_t independentSetMatching(const Parameters &params, const PoolSelection &threads);
+
+    /** find the best assignment of the independent sets of a window.
+     *  Only reads the placement, so windows can be solved concurrently.
+    */
+    void solveMatchingWindow(MatchingWindow &window, const Parameters &params) const;
+
+    /** sort the cells into the lists of their segments */
+    void rebuildSegmentLists();
+
+    void writeBack(ChipDB::Netlist &netlist) const;
+
+    std::vector<Cell>       m_cells;
+    std::vector<Segment>    m_segments;
+    std::vector<ChipDB::CoordType>          m_rowY;         ///< bottom of the rows, ascending
+    std::vector<std::vector<std::size_t>>   m_rowSegments;  ///< segments of each row in order of x
+
+    NetlistTools::NetBoxCache m_boxes;
+    ChipDB::CoordType       m_siteWidth{0};
+};
+
+};
@@ -0,0 +1,486 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <cmath>
+#include <random>
+#include <sstream>
+#include "common/logging.h"
+#include "eplacer.h"
+#include "qlaplacer.h"
+#include "rowlegalizer.h"
+#include "detailedplacer.h"
+
+using namespace LunaCore::EPlacer;
+
+namespace
+{
+
+/** initial weight of the density energy relative to the wire length, based on their gradients */
+constexpr double InitialDensityWeight = 0.1;
+
+/** relative change of the HPWL per iteration at which the density weight stays the same */
+constexpr double ReferenceHpwlChange = 0.01;
+
+/** positions and preconditioned gradients of the charges */
+struct Solution
+{
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<double> m_gradX;
+    std::vector<double> m_gradY;
+};
+
+/** the objective: wire length + lambda * density energy.
+ *  The first charges are the movable nodes, the rest are fillers.
+*/
+class Objective
+{
+public:
+    Objective(const LunaCore::QPlacer::PlacerNetlist &netlist,
+        const std::vector<LunaCore::QPlacer::PlacerNodeId> &cells,
+        Private::DensityGrid &grid, const ChipDB::Rect64 &region,
+        double targetDensity, LunaCore::ThreadPool *pool)
+        : m_cells(cells), m_grid(grid), m_region(region),
+          m_wirelength(netlist), m_targetDensity(targetDensity), m_pool(pool)
+    {
+        m_nodeX.resize(netlist.numberOfNodes());
+        m_nodeY.resize(netlist.numberOfNodes());
+        m_nodeGradX.resize(netlist.numberOfNodes());
+        m_nodeGradY.resize(netlist.numberOfNodes());
+        for(std::size_t nodeId = 0; nodeId < netlist.numberOfNodes(); nodeId++)
+        {
+            auto const pos = netlist.m_nodes[nodeId].getCenterPos();
+            m_nodeX[nodeId] = static_cast<double>(pos.m_x);
+            m_nodeY[nodeId] = static_cast<double>(pos.m_y);
+        }
+    }
+
+    /** add a charge with the given size, the cells must be added first */
+    void addCharge(double width, double height)
+    {
+        const bool filler = m_halfWidth.size() >= m_cells.size();
+        m_grid.addCharge(width, height, filler);
+        m_halfWidth.push_back(0.5*width);
+        m_halfHeight.push_back(0.5*height);
+    }
+
+    [[nodiscard]] std::size_t charges() const noexcept
+    {
+        return m_halfWidth.size();
+    }
+
+    /** keep the charges inside the region */
+    void clamp(Solution &s) const
+    {
+        for(std::size_t idx = 0; idx < charges(); idx++)
+        {
+            s.m_x[idx] = std::clamp(s.m_x[idx], m_region.left() + m_halfWidth[idx], m_region.right() - m_halfWidth[idx]);
+            s.m_y[idx] = std::clamp(s.m_y[idx], m_region.bottom() + m_halfHeight[idx], m_region.top() - m_halfHeight[idx]);
+        }
+    }
+
+    /** calculate the preconditioned gradient at the positions of the solution */
+    void evaluate(Solution &s)
+    {
+        const auto count = charges();
+        s.m_gradX.assign(count, 0.0);
+        s.m_gradY.assign(count, 0.0);
+        m_densityGradX.assign(count, 0.0);
+        m_densityGradY.assign(count, 0.0);
+
+        for(std::size_t idx = 0; idx < m_cells.size(); idx++)
+        {
+            m_nodeX[m_cells[idx]] = s.m_x[idx];
+            m_nodeY[m_cells[idx]] = s.m_y[idx];
+        }
+
+        m_wirelength.evaluate(m_nodeX, m_nodeY, m_gamma, m_nodeGradX, m_nodeGradY, m_pool);
+
+        m_grid.update(s.m_x, s.m_y, m_targetDensity, m_pool);
+        m_grid.addGradient(s.m_x, s.m_y, 1.0, m_densityGradX, m_densityGradY, m_pool);
+
+        m_wirelengthNorm = 0.0;
+        m_densityNorm = 0.0;
+        for(std::size_t idx = 0; idx < count; idx++)
+        {
+            double degree = 0.0;
+            if (idx < m_cells.size())
+            {
+                s.m_gradX[idx] = m_nodeGradX[m_cells[idx]];
+                s.m_gradY[idx] = m_nodeGradY[m_cells[idx]];
+                degree = static_cast<double>(m_wirelength.degree(m_cells[idx]));
+            }
+
+            m_wirelengthNorm += std::abs(s.m_gradX[idx]) + std::abs(s.m_gradY[idx]);
+            m_densityNorm    += std::abs(m_densityGradX[idx]) + std::abs(m_densityGradY[idx]);
+
+            // diagonal preconditioner: the number of nets and the charge
+            const double precond = std::max(1.0, degree + m_lambda*m_grid.charge(idx));
+            s.m_gradX[idx] = (s.m_gradX[idx] + m_lambda*m_densityGradX[idx]) / precond;
+            s.m_gradY[idx] = (s.m_gradY[idx] + m_lambda*m_densityGradY[idx]) / precond;
+        }
+    }
+
+    [[nodiscard]] double hpwl() const noexcept
+    {
+        return m_wirelength.hpwl();
+    }
+
+    double m_gamma{1.0};            ///< smoothing of the wire length model in nm
+    double m_lambda{0.0};           ///< weight of the density energy
+    double m_wirelengthNorm{0.0};   ///< L1 norm of the wire length gradient at the last evaluation
+    double m_densityNorm{0.0};      ///< L1 norm of the density gradient at the last evaluation
+
+protected:
+    const std::vector<LunaCore::QPlacer::PlacerNodeId> &m_cells;
+    Private::DensityGrid    &m_grid;
+    ChipDB::Rect64          m_region;
+    Private::WirelengthModel m_wirelength;
+    double                  m_targetDensity;
+    LunaCore::ThreadPool    *m_pool;
+
+    std::vector<double> m_halfWidth;
+    std::vector<double> m_halfHeight;
+    std::vector<double> m_nodeX;
+    std::vector<double> m_nodeY;
+    std::vector<double> m_nodeGradX;
+    std::vector<double> m_nodeGradY;
+    std::vector<double> m_densityGradX;
+    std::vector<double> m_densityGradY;
+};
+
+/** estimate of the inverse Lipschitz constant of the gradient between two solutions */
+double stepLength(const Solution &s, const Solution &prev, double fallback)
+{
+    double distance = 0.0;
+    double gradDistance = 0.0;
+    for(std::size_t idx = 0; idx < s.m_x.size(); idx++)
+    {
+        const double dx  = s.m_x[idx] - prev.m_x[idx];
+        const double dy  = s.m_y[idx] - prev.m_y[idx];
+        const double dgx = s.m_gradX[idx] - prev.m_gradX[idx];
+        const double dgy = s.m_gradY[idx] - prev.m_gradY[idx];
+        distance     += dx*dx + dy*dy;
+        gradDistance += dgx*dgx + dgy*dgy;
+    }
+
+    if ((gradDistance <= 0.0) || (distance <= 0.0))
+    {
+        return fallback;
+    }
+
+    return std::sqrt(distance / gradDistance);
+}
+
+/** the smoothing of the wire length follows the overflow:
+ *  80 bins at overflow 1 down to 0.8 bins at overflow 0.1
+*/
+double wirelengthGamma(double binWidth, double overflow)
+{
+    const double tau = std::clamp(overflow, 0.1, 1.0);
+    return 8.0 * binWidth * std::pow(10.0, (20.0*tau - 11.0) / 9.0);
+}
+
+};
+
+bool LunaCore::EPlacer::place(
+    const ChipDB::Floorplan &floorplan,
+    ChipDB::Netlist &netlist,
+    const Parameters &params,
+    std::function<void(const LunaCore::QPlacer::PlacerNetlist &)> callback)
+{
+    double area = 0.0;
+
+    if (floorplan.minimumCellSize().isNullSize())
+    {
+        Logging::logError("Cannot place: minimum cell size is 0.\n");
+        return false;
+    }
+
+    const auto regionRect = floorplan.coreRect();
+
+    if (floorplan.rows().empty())
+    {
+        Logging::logError("Cannot place: core has no rows\n");
+        return false;
+    }
+
+    if ((params.m_bins != 0) && ((params.m_bins < 2) || ((params.m_bins & (params.m_bins-1)) != 0)))
+    {
+        Logging::logError("Cannot place: the number of bins must be a power of two.\n");
+        return false;
+    }
+
+    if ((params.m_targetDensity <= 0.0) || (params.m_targetDensity > 1.0))
+    {
+        Logging::logError("Cannot place: the target density must be between 0 and 1.\n");
+        return false;
+    }
+
+    Logging::logInfo("Placing netlist in rectangle (%d,%d)-(%d,%d).\n",
+        regionRect.left(), regionRect.bottom(),
+        regionRect.right(), regionRect.top());
+
+    // check if pins have been fixed
+    for(auto ins : netlist.m_instances)
+    {
+        if (ins->isPin() && (ins->m_placementInfo != ChipDB::PlacementInfo::PLACEDANDFIXED))
+        {
+            std::stringstream ss;
+            ss << "Not all pins have been placed and fixed - for example: " << ins->name() << "\n";
+            Logging::logError(ss.str());
+            return false;
+        }
+    }
+
+    auto placerNetlist = QLAPlacer::Private::createPlacerNetlist(netlist);
+
+    std::vector<QPlacer::PlacerNodeId> cells;
+    double cellWidth  = 0.0;
+    double cellHeight = 0.0;
+    for(std::size_t nodeId = 0; nodeId < placerNetlist.numberOfNodes(); nodeId++)
+    {
+        auto const& node = placerNetlist.getNode(nodeId);
+        if (node.m_type == QPlacer::PlacerNodeType::MovableNode)
+        {
+            cells.push_back(nodeId);
+            area       += static_cast<double>(node.width()) * static_cast<double>(node.height());
+            cellWidth  += static_cast<double>(node.width());
+            cellHeight += static_cast<double>(node.height());
+        }
+    }
+
+    if (cells.empty())
+    {
+        Logging::logWarning("Nothing to place: there are no movable instances.\n");
+        return true;
+    }
+
+    cellWidth  /= static_cast<double>(cells.size());
+    cellHeight /= static_cast<double>(cells.size());
+
+    std::size_t bins = params.m_bins;
+    if (bins == 0)
+    {
+        bins = 16;
+        while((bins < 1024) && (bins*bins < cells.size()))
+        {
+            bins *= 2;
+        }
+    }
+
+    Private::DensityGrid grid(regionRect, bins);
+    double fixedArea = 0.0;
+    for(auto const& node : placerNetlist.m_nodes)
+    {
+        if (node.isFixed())
+        {
+            fixedArea += grid.addFixed(ChipDB::Rect64{node.getLLPos(), node.getLLPos() + ChipDB::Coord64{node.width(), node.height()}});
+        }
+    }
+
+    const double regionArea = static_cast<double>(regionRect.width()) * static_cast<double>(regionRect.height());
+    const double freeArea   = regionArea - fixedArea;
+    if (freeArea*params.m_targetDensity < area)
+    {
+        std::stringstream ss;
+        ss << "The free region area (" << freeArea << ") at the target density is smaller than the total instance area (" << area << ")\n";
+        Logging::logError(ss.str());
+        return false;
+    }
+
+    Logging::logInfo("Utilization = %3.1f percent\n", 100.0*area / freeArea);
+
+    const PoolSelection threads(params.m_threads);
+    auto *pool = threads.pool();
+
+    Objective objective(placerNetlist, cells, grid, regionRect, params.m_targetDensity, pool);
+    for(auto const nodeId : cells)
+    {
+        auto const& node = placerNetlist.getNode(nodeId);
+        objective.addCharge(static_cast<double>(node.width()), static_cast<double>(node.height()));
+    }
+
+    // fillers of the average cell size take up the whitespace the target density allows,
+    // so the cells don't spread further than needed.
+    const auto fillers = static_cast<std::size_t>((freeArea*params.m_targetDensity - area) / (cellWidth*cellHeight));
+    for(std::size_t idx = 0; idx < fillers; idx++)
+    {
+        objective.addCharge(cellWidth, cellHeight);
+    }
+
+    Logging::logInfo("Electrostatic placement: %lu cells, %lu fillers, %lu x %lu bins\n",
+        cells.size(), fillers, bins, bins);
+
+    // the cells start near the center of the region, the fillers
+    // throughout the region. The seed is fixed so runs are repeatable.
+    const auto center = regionRect.center();
+    std::mt19937 gen(1);
+    std::normal_distribution<double> xCenterDistribution(center.m_x, 0.001*regionRect.width());
+    std::normal_distribution<double> yCenterDistribution(center.m_y, 0.001*regionRect.height());
+    std::uniform_real_distribution<double> xDistribution(regionRect.left(), regionRect.right());
+    std::uniform_real_distribution<double> yDistribution(regionRect.bottom(), regionRect.top());
+
+    const auto charges = objective.charges();
+    Solution v;
+    v.m_x.resize(charges);
+    v.m_y.resize(charges);
+    for(std::size_t idx = 0; idx < charges; idx++)
+    {
+        if (idx < cells.size())
+        {
+            v.m_x[idx] = xCenterDistribution(gen);
+            v.m_y[idx] = yCenterDistribution(gen);
+        }
+        else
+        {
+            v.m_x[idx] = xDistribution(gen);
+            v.m_y[idx] = yDistribution(gen);
+        }
+    }
+    objective.clamp(v);
+
+    // the initial density weight balances the gradients of
+    // the wire length and the density.
+    objective.m_gamma = wirelengthGamma(grid.binWidth(), 1.0);
+    objective.evaluate(v);
+    if (objective.m_densityNorm > 0.0)
+    {
+        objective.m_lambda = InitialDensityWeight * objective.m_wirelengthNorm / objective.m_densityNorm;
+    }
+    objective.evaluate(v);
+
+    // a small step along the gradient gives the first step length estimate
+    double maxGrad = 0.0;
+    for(std::size_t idx = 0; idx < charges; idx++)
+    {
+        maxGrad = std::max({maxGrad, std::abs(v.m_gradX[idx]), std::abs(v.m_gradY[idx])});
+    }
+
+    Solution prev = v;
+    if (maxGrad > 0.0)
+    {
+        const double scale = 0.01*grid.binWidth() / maxGrad;
+        for(std::size_t idx = 0; idx < charges; idx++)
+        {
+            prev.m_x[idx] -= scale*v.m_gradX[idx];
+            prev.m_y[idx] -= scale*v.m_gradY[idx];
+        }
+        objective.clamp(prev);
+        objective.evaluate(prev);
+        objective.evaluate(v);
+    }
+
+    // Nesterov's method with the step length from the Lipschitz constant
+    // estimate and backtracking when the estimate shrinks.
+    Solution u = v;
+    Solution next;
+    Solution major;
+    double a = 1.0;
+    double step = 0.01*grid.binWidth() / std::max(maxGrad, 1.0e-12);
+    double hpwl = objective.hpwl();
+    double overflow = grid.overflow();
+    std::size_t iteration = 0;
+    while((iteration < params.m_maxIterations) && (overflow > params.m_targetOverflow))
+    {
+        step = stepLength(v, prev, step);
+        const double aNext = 0.5*(1.0 + std::sqrt(4.0*a*a + 1.0));
+
+        for(std::size_t attempt = 0; attempt < 10; attempt++)
+        {
+            major.m_x.resize(charges);
+            major.m_y.resize(charges);
+            next.m_x.resize(charges);
+            next.m_y.resize(charges);
+            for(std::size_t idx = 0; idx < charges; idx++)
+            {
+                major.m_x[idx] = v.m_x[idx] - step*v.m_gradX[idx];
+                major.m_y[idx] = v.m_y[idx] - step*v.m_gradY[idx];
+            }
+            objective.clamp(major);
+
+            const double momentum = (a - 1.0) / aNext;
+            for(std::size_t idx = 0; idx < charges; idx++)
+            {
+                next.m_x[idx] = major.m_x[idx] + momentum*(major.m_x[idx] - u.m_x[idx]);
+                next.m_y[idx] = major.m_y[idx] + momentum*(major.m_y[idx] - u.m_y[idx]);
+            }
+            objective.clamp(next);
+            objective.evaluate(next);
+
+            const double nextStep = stepLength(next, v, step);
+            if (nextStep > 0.95*step)
+            {
+                break;
+            }
+            step = nextStep;
+        }
+
+        std::swap(prev, v);
+        std::swap(v, next);
+        std::swap(u, major);
+        a = aNext;
+        iteration++;
+
+        // increase the density weight more slowly when the wire length grows quickly
+        const double newHpwl = objective.hpwl();
+        const double deltaHpwl = (hpwl > 0.0) ? (newHpwl - hpwl) / (ReferenceHpwlChange*hpwl) : 0.0;
+        objective.m_lambda *= std::clamp(std::pow(1.1, 1.0 - deltaHpwl), 0.95, 1.1);
+        hpwl = newHpwl;
+
+        overflow = grid.overflow();
+        objective.m_gamma = wirelengthGamma(grid.binWidth(), overflow);
+
+        if ((iteration % 20) == 0)
+        {
+            Logging::logVerbose("  iteration %lu  HPWL %g  overflow %f  lambda %g\n", iteration, hpwl, overflow, objective.m_lambda);
+        }
+
+        if (callback)
+        {
+            for(std::size_t idx = 0; idx < cells.size(); idx++)
+            {
+                placerNetlist.getNode(cells[idx]).setCenterPos(ChipDB::Coord64{
+                    static_cast<ChipDB::CoordType>(std::lround(u.m_x[idx])),
+                    static_cast<ChipDB::CoordType>(std::lround(u.m_y[idx]))});
+            }
+            callback(placerNetlist);
+        }
+    }
+
+    Logging::logInfo("Global placement: %lu iterations, HPWL %g, overflow %f\n", iteration, hpwl, overflow);
+
+    for(std::size_t idx = 0; idx < cells.size(); idx++)
+    {
+        placerNetlist.getNode(cells[idx]).setCenterPos(ChipDB::Coord64{
+            static_cast<ChipDB::CoordType>(std::lround(u.m_x[idx])),
+            static_cast<ChipDB::CoordType>(std::lround(u.m_y[idx]))});
+    }
+
+    QLAPlacer::Private::updatePositions(placerNetlist, netlist);
+
+    Logging::logVerbose("Running final legalization.\n");
+    LunaCore::Legalizer legalizer;
+    LunaCore::Legalizer::Parameters legalizerParams;
+    legalizerParams.m_threads = params.m_threads;
+    if (!legalizer.legalize(floorplan, netlist, legalizerParams))
+    {
+        return false;
+    }
+
+    if (params.m_detailedPlacement)
+    {
+        LunaCore::DetailedPlacer detailedPlacer;
+        LunaCore::DetailedPlacer::Parameters detailedParams;
+        detailedParams.m_threads = params.m_threads;
+        if (!detailedPlacer.place(floorplan, netlist, detailedParams))
+        {
+            return false;
+        }
+    }
+
+    Logging::logInfo("Placement done.\n");
+
+    return true;
+}
@@ -0,0 +1,274 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+/*
+
+    Electrostatic (ePlace style) global placer
+
+*/
+
+#pragma once
+
+#include <complex>
+#include <functional>
+#include <vector>
+
+#include "database/database.h"
+#include "common/threadpool.h"
+#include "qplacertypes.h"
+
+namespace LunaCore::EPlacer
+{
+
+    struct Parameters
+    {
+        std::size_t m_bins{0};              ///< bins along each axis, a power of two. 0 derives it from the number of cells
+        double      m_targetDensity{1.0};   ///< maximum fraction of the free area of a bin the cells may use
+        double      m_targetOverflow{0.1};  ///< global placement stops when the overflow drops below this fraction
+        std::size_t m_maxIterations{1000};  ///< maximum number of Nesterov iterations
+        bool        m_detailedPlacement{true};  ///< run the DetailedPlacer after legalization
+
+        std::size_t m_threads{0};           ///< thread count, see PoolSelection
+    };
+
+    /** place the module in the core of the floorplan and legalize it.
+     *
+     *  The cells are modelled as positive charges. The density penalty is
+     *  the energy of the electrostatic system, the potential is solved with
+     *  a spectral (DCT) Poisson solver on a grid of bins. It is minimized
+     *  together with the weighted-average wire length by Nesterov's method.
+     *
+     *  the callback is called each iteration when the positions have been updated
+    */
+    bool place(
+        const ChipDB::Floorplan &floorplan,
+        ChipDB::Netlist &netlist,
+        const Parameters &params,
+        std::function<void(const LunaCore::QPlacer::PlacerNetlist &)> callback);
+
+};
+
+namespace LunaCore::EPlacer::Private
+{
+
+    /** call func(index) for each index in [0, count), using the pool if there is one */
+    template<typename Func>
+    void forEach(ThreadPool *pool, std::size_t count, Func &&func, std::size_t grain = 1)
+    {
+        if (pool != nullptr)
+        {
+            parallelFor(*pool, 0, count, std::forward<Func>(func), grain);
+            return;
+        }
+
+        for(std::size_t index = 0; index < count; index++)
+        {
+            func(index);
+        }
+    }
+
+    /** Cosine and sine transforms of length N, a power of two.
+     *  Each transform is a complex FFT of length 2N.
+    */
+    class Transform
+    {
+    public:
+        explicit Transform(std::size_t n);
+
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        using Scratch = std::vector<std::complex<double>>;
+
+        /** X_k = sum_n x_n cos(pi k (2n+1) / 2N), the unnormalized DCT-II */
+        void dct(const double *in, double *out, Scratch &scratch) const;
+
+        /** y_n = sum_k c_k cos(pi k (2n+1) / 2N) */
+        void cosSeries(const double *in, double *out, Scratch &scratch) const;
+
+        /** y_n = sum_k c_k sin(pi k (2n+1) / 2N) */
+        void sinSeries(const double *in, double *out, Scratch &scratch) const;
+
+    protected:
+        /** in-place radix-2 FFT of length 2N, inverse is unnormalized */
+        void fft(Scratch &data, bool inverse) const;
+
+        /** evaluate the series of coefficients, the result is in scratch */
+        void series(const double *in, Scratch &scratch) const;
+
+        std::size_t m_size{0};
+        std::vector<std::complex<double>>   m_twiddles;     ///< exp(-2 pi i k / 2N)
+        std::vector<std::complex<double>>   m_shift;        ///< exp(-i pi k / 2N)
+        std::vector<std::size_t>            m_bitReverse;
+    };
+
+    /** The charges on a grid of bins and their electric field.
+     *
+     *  Charges are rectangles given by their center. Charges smaller
+     *  than a bin are stretched to the size of a bin with a lower
+     *  density, so the density changes smoothly when they move.
+     *  Fixed instances are static charges at the target density.
+    */
+    class DensityGrid
+    {
+    public:
+        DensityGrid(const ChipDB::Rect64 &region, std::size_t bins);
+
+        /** add the part of a fixed instance that is inside the region,
+         *  returns the area of that part.
+        */
+        double addFixed(const ChipDB::Rect64 &rect);
+
+        /** add a movable charge, returns its index.
+         *  Fillers only count for the density, not for the overflow.
+        */
+        std::size_t addCharge(double width, double height, bool filler);
+
+        /** spread the charges over the bins and solve the potential.
+         *  Positions are the centers of the charges in nm.
+        */
+        void update(const std::vector<double> &x, const std::vector<double> &y,
+            double targetDensity, ThreadPool *pool);
+
+        /** add lambda times the gradient of the energy to the gradients of the charges */
+        void addGradient(const std::vector<double> &x, const std::vector<double> &y,
+            double lambda, std::vector<double> &gradX, std::vector<double> &gradY, ThreadPool *pool) const;
+
+        /** the area of the cells above the target density divided by the cell area */
+        [[nodiscard]] double overflow() const noexcept
+        {
+            return m_overflow;
+        }
+
+        /** the energy of the charges in the potential */
+        [[nodiscard]] double energy() const noexcept
+        {
+            return m_energy;
+        }
+
+        /** charge of a movable charge, its area in bins */
+        [[nodiscard]] double charge(std::size_t idx) const noexcept
+        {
+            return m_chargeWidth[idx] * m_chargeHeight[idx] * m_chargeScale[idx] / m_binArea;
+        }
+
+        [[nodiscard]] std::size_t bins() const noexcept
+        {
+            return m_bins;
+        }
+
+        [[nodiscard]] double binWidth() const noexcept
+        {
+            return m_binWidth;
+        }
+
+        [[nodiscard]] double binHeight() const noexcept
+        {
+            return m_binHeight;
+        }
+
+        /** potential and field of a bin, the field is in units per nm */
+        [[nodiscard]] double potential(std::size_t binX, std::size_t binY) const noexcept
+        {
+            return m_potential[binY*m_bins + binX];
+        }
+
+        [[nodiscard]] double fieldX(std::size_t binX, std::size_t binY) const noexcept
+        {
+            return m_fieldX[binY*m_bins + binX];
+        }
+
+        [[nodiscard]] double fieldY(std::size_t binX, std::size_t binY) const noexcept
+        {
+            return m_fieldY[binY*m_bins + binX];
+        }
+
+    protected:
+        /** call func(bin, overlap) for each bin in row binY covered by a charge,
+         *  the overlap is scaled to the density of the charge.
+        */
+        template<typename Func>
+        void forEachOverlap(std::size_t chargeIdx, double x, double y, std::size_t binY, Func &&func) const;
+
+        /** first and last bin row covered by a charge */
+        [[nodiscard]] std::pair<std::size_t, std::size_t> binRows(std::size_t chargeIdx, double y) const noexcept;
+
+        /** solve the potential and the field of m_density */
+        void solvePoisson(ThreadPool *pool);
+
+        /** apply a transform to each row, then to each column of a grid */
+        using Transform1D = void (Transform::*)(const double *, double *, Transform::Scratch &) const;
+        void transform2D(std::vector<double> &grid, Transform1D alongX, Transform1D alongY, ThreadPool *pool) const;
+
+        ChipDB::Rect64  m_region;
+        std::size_t     m_bins{0};
+        double          m_binWidth{0};
+        double          m_binHeight{0};
+        double          m_binArea{0};
+        Transform       m_transform;
+
+        std::vector<double> m_chargeWidth;      ///< stretched width of the charges
+        std::vector<double> m_chargeHeight;     ///< stretched height of the charges
+        std::vector<double> m_chargeScale;      ///< density of the stretched charges
+        std::vector<uint8_t> m_filler;
+
+        std::vector<double> m_fixedArea;        ///< area of the fixed instances in each bin
+        std::vector<double> m_cellArea;         ///< area of the movable cells in each bin, without fillers
+        std::vector<double> m_density;
+        std::vector<double> m_potential;
+        std::vector<double> m_fieldX;
+        std::vector<double> m_fieldY;
+        std::vector<std::vector<std::size_t>> m_rowCharges;   ///< charges that cover each bin row
+
+        double m_totalCellArea{0};
+        double m_overflow{0};
+        double m_energy{0};
+    };
+
+    /** The weighted-average wire length model of a PlacerNetlist.
+     *
+     *  Per axis and net: sum x_i exp(x_i/gamma) / sum exp(x_i/gamma)
+     *                  - sum x_i exp(-x_i/gamma) / sum exp(-x_i/gamma)
+     *  which approaches the HPWL for small gamma.
+    */
+    class WirelengthModel
+    {
+    public:
+        explicit WirelengthModel(const LunaCore::QPlacer::PlacerNetlist &netlist);
+
+        /** return the wire length of the node centers and write its gradient.
+         *  Also updates the HPWL.
+        */
+        double evaluate(const std::vector<double> &x, const std::vector<double> &y, double gamma,
+            std::vector<double> &gradX, std::vector<double> &gradY, ThreadPool *pool);
+
+        /** the HPWL at the last call to evaluate */
+        [[nodiscard]] double hpwl() const noexcept
+        {
+            return m_hpwl;
+        }
+
+        /** number of nets of a node */
+        [[nodiscard]] std::size_t degree(LunaCore::QPlacer::PlacerNodeId nodeId) const noexcept
+        {
+            return m_nodeStart[nodeId+1] - m_nodeStart[nodeId];
+        }
+
+    protected:
+        std::vector<std::size_t>    m_netStart;     ///< first pin of each net, plus the end
+        std::vector<LunaCore::QPlacer::PlacerNodeId> m_pinNode;
+        std::vector<double>         m_netWeight;
+        std::vector<std::size_t>    m_nodeStart;    ///< first entry in m_nodePins of each node, plus the end
+        std::vector<std::size_t>    m_nodePins;
+
+        std::vector<double> m_pinGradX;
+        std::vector<double> m_pinGradY;
+        std::vector<double> m_netLength;
+        std::vector<double> m_netHPWL;
+        double m_hpwl{0};
+    };
+
+};
@@ -0,0 +1,533 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+#include "eplacer.h"
+
+using namespace LunaCore::EPlacer::Private;
+
+// ********************************************************************************
+//   Transform
+// ********************************************************************************
+
+Transform::Transform(std::size_t n) : m_size(n)
+{
+    assert((n > 0) && ((n & (n-1)) == 0));
+
+    const std::size_t length = 2*n;
+    m_twiddles.resize(n);
+    for(std::size_t k = 0; k < n; k++)
+    {
+        m_twiddles[k] = std::polar(1.0, -2.0*std::numbers::pi*static_cast<double>(k)/static_cast<double>(length));
+    }
+
+    m_shift.resize(n);
+    for(std::size_t k = 0; k < n; k++)
+    {
+        m_shift[k] = std::polar(1.0, -std::numbers::pi*static_cast<double>(k)/static_cast<double>(length));
+    }
+
+    std::size_t bits = 0;
+    while((std::size_t{1} << bits) < length) bits++;
+
+    m_bitReverse.resize(length);
+    for(std::size_t idx = 0; idx < length; idx++)
+    {
+        std::size_t rev = 0;
+        for(std::size_t bit = 0; bit < bits; bit++)
+        {
+            if ((idx & (std::size_t{1} << bit)) != 0)
+            {
+                rev |= std::size_t{1} << (bits - 1 - bit);
+            }
+        }
+        m_bitReverse[idx] = rev;
+    }
+}
+
+void Transform::fft(Scratch &data, bool inverse) const
+{
+    const std::size_t length = data.size();
+
+    for(std::size_t idx = 0; idx < length; idx++)
+    {
+        const auto rev = m_bitReverse[idx];
+        if (idx < rev)
+        {
+            std::swap(data[idx], data[rev]);
+        }
+    }
+
+    for(std::size_t span = 2; span <= length; span *= 2)
+    {
+        const std::size_t half = span / 2;
+        const std::size_t step = length / span;
+        for(std::size_t first = 0; first < length; first += span)
+        {
+            for(std::size_t k = 0; k < half; k++)
+            {
+                const auto w = inverse ? std::conj(m_twiddles[k*step]) : m_twiddles[k*step];
+                const auto u = data[first + k];
+                const auto v = data[first + k + half] * w;
+                data[first + k]        = u + v;
+                data[first + k + half] = u - v;
+            }
+        }
+    }
+}
+
+void Transform::dct(const double *in, double *out, Scratch &scratch) const
+{
+    // X_k = Re(exp(-i pi k / 2N) * sum_n x_n exp(-2 pi i k n / 2N))
+    scratch.assign(2*m_size, 0.0);
+    for(std::size_t n = 0; n < m_size; n++)
+    {
+        scratch[n] = in[n];
+    }
+
+    fft(scratch, false);
+
+    for(std::size_t k = 0; k < m_size; k++)
+    {
+        out[k] = (m_shift[k] * scratch[k]).real();
+    }
+}
+
+void Transform::series(const double *in, Scratch &scratch) const
+{
+    // sum_k c_k exp(i pi k (2n+1) / 2N) = sum_k (c_k exp(i pi k / 2N)) exp(2 pi i k n / 2N)
+    scratch.assign(2*m_size, 0.0);
+    for(std::size_t k = 0; k < m_size; k++)
+    {
+        scratch[k] = in[k] * std::conj(m_shift[k]);
+    }
+
+    fft(scratch, true);
+}
+
+void Transform::cosSeries(const double *in, double *out, Scratch &scratch) const
+{
+    series(in, scratch);
+    for(std::size_t n = 0; n < m_size; n++)
+    {
+        out[n] = scratch[n].real();
+    }
+}
+
+void Transform::sinSeries(const double *in, double *out, Scratch &scratch) const
+{
+    series(in, scratch);
+    for(std::size_t n = 0; n < m_size; n++)
+    {
+        out[n] = scratch[n].imag();
+    }
+}
+
+// ********************************************************************************
+//   DensityGrid
+// ********************************************************************************
+
+DensityGrid::DensityGrid(const ChipDB::Rect64 &region, std::size_t bins)
+    : m_region(region), m_bins(bins), m_transform(bins)
+{
+    m_binWidth  = static_cast<double>(region.width()) / static_cast<double>(bins);
+    m_binHeight = static_cast<double>(region.height()) / static_cast<double>(bins);
+    m_binArea   = m_binWidth * m_binHeight;
+
+    const auto binCount = bins*bins;
+    m_fixedArea.resize(binCount, 0.0);
+    m_cellArea.resize(binCount, 0.0);
+    m_density.resize(binCount, 0.0);
+    m_potential.resize(binCount, 0.0);
+    m_fieldX.resize(binCount, 0.0);
+    m_fieldY.resize(binCount, 0.0);
+    m_rowCharges.resize(bins);
+}
+
+double DensityGrid::addFixed(const ChipDB::Rect64 &rect)
+{
+    const double left   = std::max(rect.left(), m_region.left()) - m_region.left();
+    const double right  = std::min(rect.right(), m_region.right()) - m_region.left();
+    const double bottom = std::max(rect.bottom(), m_region.bottom()) - m_region.bottom();
+    const double top    = std::min(rect.top(), m_region.top()) - m_region.bottom();
+
+    if ((left >= right) || (bottom >= top))
+    {
+        return 0.0;
+    }
+
+    const auto firstX = std::min(m_bins-1, static_cast<std::size_t>(left / m_binWidth));
+    const auto lastX  = std::min(m_bins-1, static_cast<std::size_t>(right / m_binWidth));
+    const auto firstY = std::min(m_bins-1, static_cast<std::size_t>(bottom / m_binHeight));
+    const auto lastY  = std::min(m_bins-1, static_cast<std::size_t>(top / m_binHeight));
+
+    for(auto binY = firstY; binY <= lastY; binY++)
+    {
+        const double binBottom = static_cast<double>(binY)*m_binHeight;
+        const double dy = std::min(top, binBottom + m_binHeight) - std::max(bottom, binBottom);
+        if (dy <= 0.0) continue;
+
+        for(auto binX = firstX; binX <= lastX; binX++)
+        {
+            const double binLeft = static_cast<double>(binX)*m_binWidth;
+            const double dx = std::min(right, binLeft + m_binWidth) - std::max(left, binLeft);
+            if (dx <= 0.0) continue;
+
+            auto &area = m_fixedArea[binY*m_bins + binX];
+            area = std::min(m_binArea, area + dx*dy);
+        }
+    }
+
+    return (right - left)*(top - bottom);
+}
+
+std::size_t DensityGrid::addCharge(double width, double height, bool filler)
+{
+    // local smoothing: stretch small charges to the size of a bin
+    // and lower their density so the charge stays the same.
+    const double stretchedWidth  = std::max(width, std::numbers::sqrt2*m_binWidth);
+    const double stretchedHeight = std::max(height, std::numbers::sqrt2*m_binHeight);
+
+    m_chargeWidth.push_back(stretchedWidth);
+    m_chargeHeight.push_back(stretchedHeight);
+    m_chargeScale.push_back(width*height / (stretchedWidth*stretchedHeight));
+    m_filler.push_back(filler ? 1 : 0);
+
+    if (!filler)
+    {
+        m_totalCellArea += width*height;
+    }
+
+    return m_chargeWidth.size() - 1;
+}
+
+std::pair<std::size_t, std::size_t> DensityGrid::binRows(std::size_t chargeIdx, double y) const noexcept
+{
+    const double bottom = y - 0.5*m_chargeHeight[chargeIdx] - static_cast<double>(m_region.bottom());
+    const double top    = bottom + m_chargeHeight[chargeIdx];
+    const double last   = static_cast<double>(m_bins-1);
+
+    const auto firstRow = static_cast<std::size_t>(std::clamp(std::floor(bottom / m_binHeight), 0.0, last));
+    const auto lastRow  = static_cast<std::size_t>(std::clamp(std::ceil(top / m_binHeight) - 1.0, 0.0, last));
+    return {firstRow, std::max(firstRow, lastRow)};
+}
+
+template<typename Func>
+void DensityGrid::forEachOverlap(std::size_t chargeIdx, double x, double y, std::size_t binY, Func &&func) const
+{
+    const double halfWidth  = 0.5*m_chargeWidth[chargeIdx];
+    const double halfHeight = 0.5*m_chargeHeight[chargeIdx];
+
+    const double rowBottom = static_cast<double>(binY)*m_binHeight;
+    const double bottom    = y - halfHeight - static_cast<double>(m_region.bottom());
+    const double dy = std::min(bottom + 2.0*halfHeight, rowBottom + m_binHeight) - std::max(bottom, rowBottom);
+    if (dy <= 0.0) return;
+
+    const double left  = x - halfWidth - static_cast<double>(m_region.left());
+    const double right = left + 2.0*halfWidth;
+    const double last  = static_cast<double>(m_bins-1);
+
+    const auto firstX = static_cast<std::size_t>(std::clamp(std::floor(left / m_binWidth), 0.0, last));
+    const auto lastX  = static_cast<std::size_t>(std::clamp(std::ceil(right / m_binWidth) - 1.0, 0.0, last));
+
+    const double scale = dy * m_chargeScale[chargeIdx];
+    for(auto binX = firstX; binX <= lastX; binX++)
+    {
+        const double binLeft = static_cast<double>(binX)*m_binWidth;
+        const double dx = std::min(right, binLeft + m_binWidth) - std::max(left, binLeft);
+        if (dx > 0.0)
+        {
+            func(binY*m_bins + binX, dx*scale);
+        }
+    }
+}
+
+void DensityGrid::update(const std::vector<double> &x, const std::vector<double> &y,
+    double targetDensity, ThreadPool *pool)
+{
+    for(auto &charges : m_rowCharges)
+    {
+        charges.clear();
+    }
+
+    for(std::size_t idx = 0; idx < m_chargeWidth.size(); idx++)
+    {
+        const auto [firstRow, lastRow] = binRows(idx, y[idx]);
+        for(auto row = firstRow; row <= lastRow; row++)
+        {
+            m_rowCharges[row].push_back(idx);
+        }
+    }
+
+    // each task owns a row of bins, so the sums don't depend on the threads
+    forEach(pool, m_bins, [this, &x, &y, targetDensity](std::size_t binY)
+        {
+            for(std::size_t bin = binY*m_bins; bin < (binY+1)*m_bins; bin++)
+            {
+                m_density[bin]  = targetDensity * m_fixedArea[bin];
+                m_cellArea[bin] = 0.0;
+            }
+
+            for(auto const idx : m_rowCharges[binY])
+            {
+                const bool filler = m_filler[idx] != 0;
+                forEachOverlap(idx, x[idx], y[idx], binY, [this, filler](std::size_t bin, double area)
+                    {
+                        m_density[bin] += area;
+                        if (!filler)
+                        {
+                            m_cellArea[bin] += area;
+                        }
+                    }
+                );
+            }
+
+            for(std::size_t bin = binY*m_bins; bin < (binY+1)*m_bins; bin++)
+            {
+                m_density[bin] /= m_binArea;
+            }
+        }
+    );
+
+    solvePoisson(pool);
+
+    double overflowArea = 0.0;
+    m_energy = 0.0;
+    for(std::size_t bin = 0; bin < m_density.size(); bin++)
+    {
+        overflowArea += std::max(0.0, m_cellArea[bin] - targetDensity*(m_binArea - m_fixedArea[bin]));
+        m_energy += m_density[bin] * m_potential[bin];
+    }
+
+    m_overflow = (m_totalCellArea > 0.0) ? overflowArea / m_totalCellArea : 0.0;
+}
+
+void DensityGrid::transform2D(std::vector<double> &grid, Transform1D alongX, Transform1D alongY, ThreadPool *pool) const
+{
+    forEach(pool, m_bins, [this, &grid, alongX](std::size_t row)
+        {
+            Transform::Scratch scratch;
+            auto data = &grid[row*m_bins];
+            (m_transform.*alongX)(data, data, scratch);
+        }
+    );
+
+    forEach(pool, m_bins, [this, &grid, alongY](std::size_t column)
+        {
+            Transform::Scratch scratch;
+            std::vector<double> data(m_bins);
+            for(std::size_t row = 0; row < m_bins; row++)
+            {
+                data[row] = grid[row*m_bins + column];
+            }
+
+            (m_transform.*alongY)(data.data(), data.data(), scratch);
+
+            for(std::size_t row = 0; row < m_bins; row++)
+            {
+                grid[row*m_bins + column] = data[row];
+            }
+        }
+    );
+}
+
+void DensityGrid::solvePoisson(ThreadPool *pool)
+{
+    // the density is a cosine series a_uv cos(w_u x) cos(w_v y), x and y
+    // in units of the bin width. The solution of the Poisson equation
+    // laplacian(psi) = -density is psi = sum a_uv / (w_u^2 + w_v^2) cos(w_u x) cos(w_v y)
+    // and the field -grad(psi) has sine series in x or y.
+
+    auto &coefficients = m_potential;
+    coefficients = m_density;
+    transform2D(coefficients, &Transform::dct, &Transform::dct, pool);
+
+    const double norm   = 1.0 / static_cast<double>(m_bins*m_bins);
+    const double aspect = m_binWidth / m_binHeight;
+    for(std::size_t v = 0; v < m_bins; v++)
+    {
+        const double wv = std::numbers::pi * static_cast<double>(v) * aspect / static_cast<double>(m_bins);
+        for(std::size_t u = 0; u < m_bins; u++)
+        {
+            const auto bin = v*m_bins + u;
+            if ((u == 0) && (v == 0))
+            {
+                m_potential[bin] = 0.0;
+                m_fieldX[bin] = 0.0;
+                m_fieldY[bin] = 0.0;
+                continue;
+            }
+
+            const double wu = std::numbers::pi * static_cast<double>(u) / static_cast<double>(m_bins);
+            const double a  = norm * coefficients[bin] / (wu*wu + wv*wv);
+            m_potential[bin] = a;
+            m_fieldX[bin] = a * wu / m_binWidth;
+            m_fieldY[bin] = a * wv / m_binWidth;
+        }
+    }
+
+    transform2D(m_potential, &Transform::cosSeries, &Transform::cosSeries, pool);
+    transform2D(m_fieldX, &Transform::sinSeries, &Transform::cosSeries, pool);
+    transform2D(m_fieldY, &Transform::cosSeries, &Transform::sinSeries, pool);
+}
+
+void DensityGrid::addGradient(const std::vector<double> &x, const std::vector<double> &y,
+    double lambda, std::vector<double> &gradX, std::vector<double> &gradY, ThreadPool *pool) const
+{
+    // the energy of a charge is its charge times the potential,
+    // its gradient is minus the charge times the field.
+    forEach(pool, m_chargeWidth.size(), [&](std::size_t idx)
+        {
+            double fx = 0.0;
+            double fy = 0.0;
+            const auto [firstRow, lastRow] = binRows(idx, y[idx]);
+            for(auto row = firstRow; row <= lastRow; row++)
+            {
+                forEachOverlap(idx, x[idx], y[idx], row, [this, &fx, &fy](std::size_t bin, double area)
+                    {
+                        fx += area * m_fieldX[bin];
+                        fy += area * m_fieldY[bin];
+                    }
+                );
+            }
+
+            gradX[idx] -= lambda * fx / m_binArea;
+            gradY[idx] -= lambda * fy / m_binArea;
+        }, 64
+    );
+}
+
+// ********************************************************************************
+//   WirelengthModel
+// ********************************************************************************
+
+WirelengthModel::WirelengthModel(const LunaCore::QPlacer::PlacerNetlist &netlist)
+{
+    m_netStart.push_back(0);
+    for(auto const& net : netlist.m_nets)
+    {
+        if (net.m_nodes.size() < 2)
+        {
+            continue;
+        }
+
+        m_pinNode.insert(m_pinNode.end(), net.m_nodes.begin(), net.m_nodes.end());
+        m_netStart.push_back(m_pinNode.size());
+        m_netWeight.push_back(net.m_weight);
+    }
+
+    // the pins of each node, in order of the pins
+    m_nodeStart.assign(netlist.numberOfNodes()+1, 0);
+    for(auto const nodeId : m_pinNode)
+    {
+        m_nodeStart[nodeId+1]++;
+    }
+
+    for(std::size_t idx = 1; idx < m_nodeStart.size(); idx++)
+    {
+        m_nodeStart[idx] += m_nodeStart[idx-1];
+    }
+
+    m_nodePins.resize(m_pinNode.size());
+    auto fill = m_nodeStart;
+    for(std::size_t pin = 0; pin < m_pinNode.size(); pin++)
+    {
+        m_nodePins[fill[m_pinNode[pin]]++] = pin;
+    }
+
+    m_pinGradX.resize(m_pinNode.size());
+    m_pinGradY.resize(m_pinNode.size());
+    m_netLength.resize(m_netWeight.size());
+    m_netHPWL.resize(m_netWeight.size());
+}
+
+/** weighted-average length of a net along one axis and the gradient of each pin */
+static double waLength(const double *coords, const LunaCore::QPlacer::PlacerNodeId *nodes, std::size_t pins,
+    double gamma, double weight, double *grad, double &span)
+{
+    double minPos = coords[nodes[0]];
+    double maxPos = minPos;
+    for(std::size_t pin = 1; pin < pins; pin++)
+    {
+        minPos = std::min(minPos, coords[nodes[pin]]);
+        maxPos = std::max(maxPos, coords[nodes[pin]]);
+    }
+
+    span = maxPos - minPos;
+
+    // shift the exponents by the extremes so they don't overflow
+    double sumMax = 0.0;
+    double sumMaxPos = 0.0;
+    double sumMin = 0.0;
+    double sumMinPos = 0.0;
+    for(std::size_t pin = 0; pin < pins; pin++)
+    {
+        const double pos = coords[nodes[pin]];
+        const double a = std::exp((pos - maxPos) / gamma);
+        const double b = std::exp((minPos - pos) / gamma);
+        sumMax    += a;
+        sumMaxPos += a*pos;
+        sumMin    += b;
+        sumMinPos += b*pos;
+    }
+
+    const double meanMax = sumMaxPos / sumMax;
+    const double meanMin = sumMinPos / sumMin;
+
+    for(std::size_t pin = 0; pin < pins; pin++)
+    {
+        const double pos = coords[nodes[pin]];
+        const double a = std::exp((pos - maxPos) / gamma);
+        const double b = std::exp((minPos - pos) / gamma);
+        grad[pin] = weight * (a / sumMax * (1.0 + (pos - meanMax) / gamma)
+                            - b / sumMin * (1.0 - (pos - meanMin) / gamma));
+    }
+
+    return weight * (meanMax - meanMin);
+}
+
+double WirelengthModel::evaluate(const std::vector<double> &x, const std::vector<double> &y, double gamma,
+    std::vector<double> &gradX, std::vector<double> &gradY, ThreadPool *pool)
+{
+    forEach(pool, m_netWeight.size(), [&](std::size_t netIdx)
+        {
+            const auto first = m_netStart[netIdx];
+            const auto pins  = m_netStart[netIdx+1] - first;
+
+            double spanX = 0.0;
+            double spanY = 0.0;
+            m_netLength[netIdx] =
+                waLength(x.data(), &m_pinNode[first], pins, gamma, m_netWeight[netIdx], &m_pinGradX[first], spanX)
+              + waLength(y.data(), &m_pinNode[first], pins, gamma, m_netWeight[netIdx], &m_pinGradY[first], spanY);
+            m_netHPWL[netIdx] = spanX + spanY;
+        }, 256
+    );
+
+    forEach(pool, m_nodeStart.size()-1, [&](std::size_t nodeId)
+        {
+            double gx = 0.0;
+            double gy = 0.0;
+            for(auto idx = m_nodeStart[nodeId]; idx < m_nodeStart[nodeId+1]; idx++)
+            {
+                gx += m_pinGradX[m_nodePins[idx]];
+                gy += m_pinGradY[m_nodePins[idx]];
+            }
+            gradX[nodeId] = gx;
+            gradY[nodeId] = gy;
+        }, 256
+    );
+
+    double length = 0.0;
+    m_hpwl = 0.0;
+    for(std::size_t netIdx = 0; netIdx < m_netLength.size(); netIdx++)
+    {
+        length += m_netLength[netIdx];
+        m_hpwl += m_netHPWL[netIdx];
+    }
+
+    return length;
+}
@@ -20,7 +20,7 @@ namespace LunaCore::QLAPlacer::Private
 {
     struct SolverData
     {
-        Algebra::SparseMatrix<float> m_Amat;
+        Algebra::TripletBuilder<float> m_Amat;
         Algebra::Vector<float>       m_Bvec;
     };
 
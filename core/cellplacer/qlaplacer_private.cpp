@@ -198,12 +198,12 @@ void updateWeights(
         // one of the two nodes is fixed
         if (node1.isFixed())
         {
-            solverData.m_Amat(node2Id, node2Id)  += fixedWeight;
+            solverData.m_Amat.add(node2Id, node2Id, fixedWeight);
             solverData.m_Bvec[node2Id] += fixedWeight * AxisAccessor::get(node1.getCenterPos());
         }
         else
         {
-            solverData.m_Amat(node1Id, node1Id)  += fixedWeight;
+            solverData.m_Amat.add(node1Id, node1Id, fixedWeight);
             solverData.m_Bvec[node1Id] += fixedWeight * AxisAccessor::get(node2.getCenterPos());
 
         }
@@ -211,10 +211,10 @@ void updateWeights(
     else
     {
         // both nodes are movable
-        solverData.m_Amat(node1Id, node1Id)  += weight;
-        solverData.m_Amat(node2Id, node2Id)  += weight;
-        solverData.m_Amat(node1Id, node2Id)  -= weight;
-        solverData.m_Amat(node2Id, node1Id)  -= weight;
+        solverData.m_Amat.add(node1Id, node1Id, weight);
+        solverData.m_Amat.add(node2Id, node2Id, weight);
+        solverData.m_Amat.add(node1Id, node2Id, -weight);
+        solverData.m_Amat.add(node2Id, node1Id, -weight);
     }
 }
 
@@ -281,11 +281,11 @@ bool LunaCore::QLAPlacer::Private::doQuadraticB2B(LunaCore::QPlacer::PlacerNetli
     LunaCore::QLAPlacer::Private::SolverData XSolverData;
     LunaCore::QLAPlacer::Private::SolverData YSolverData;
 
-    XSolverData.m_Amat.resize(netlist.numberOfNodes());    // rough estimate of rows
+    XSolverData.m_Amat.reset(netlist.numberOfNodes());
     XSolverData.m_Bvec.resize(netlist.numberOfNodes());
     XSolverData.m_Bvec.zero();
 
-    YSolverData.m_Amat.resize(netlist.numberOfNodes());    // rough estimate of rows
+    YSolverData.m_Amat.reset(netlist.numberOfNodes());
     YSolverData.m_Bvec.resize(netlist.numberOfNodes());
     YSolverData.m_Bvec.zero();
 
@@ -417,21 +417,24 @@ bool LunaCore::QLAPlacer::Private::doQuadraticB2B(LunaCore::QPlacer::PlacerNetli
     //EigenMatX.makeCompressed();
     //solver.compute(EigenMatX);
 
-    Algebra::CGSolver::JacobiPreconditioner preconX(XSolverData.m_Amat);
-    Algebra::CGSolver::JacobiPreconditioner preconY(YSolverData.m_Amat);
+    const auto XAmat = XSolverData.m_Amat.freeze();
+    const auto YAmat = YSolverData.m_Amat.freeze();
 
-    Algebra::Vector<float> xpos;
-    Algebra::Vector<float> ypos;
+    Algebra::CGSolver::IC0Preconditioner preconX(XAmat);
+    Algebra::CGSolver::IC0Preconditioner preconY(YAmat);
+
+    Algebra::Vector<float> xpos(netlist.numberOfNodes());
+    Algebra::Vector<float> ypos(netlist.numberOfNodes());
 
     Algebra::ComputeInfo info_x = Algebra::CGSolver::solve(
-        XSolverData.m_Amat, 
+        XAmat,
         XSolverData.m_Bvec,
         xpos,
         preconX
         );
 
     Algebra::ComputeInfo info_y = Algebra::CGSolver::solve(
-        YSolverData.m_Amat,
+        YAmat,
         YSolverData.m_Bvec,
         ypos,
         preconY
@@ -4,9 +4,12 @@
 
 #include "rowlegalizer.h"
 #include "common/logging.h"
+#include "common/threadpool.h"
 
 #include <list>
 #include <cmath>
+#include <numeric>
+#include <algorithm>
 
 using namespace LunaCore;
 
@@ -22,7 +25,38 @@ static ChipDB::CoordType roundToLowestValidPosition(ChipDB::CoordType pos, const
     return v * minCellWidth;
 }
 
-void Legalizer::Cluster::addCell(const ChipDB::CoordType cellXPos, const Cell &cell, CellIndex cellIdx)
+/** legal grid position of a single cell in a row, before clustering.
+ *  The site grid starts at origin.
+*/
+static ChipDB::CoordType initialCellPosition(const Legalizer::Cell &cell, const Legalizer::Row &row,
+    const ChipDB::CoordType origin, const ChipDB::CoordType minCellWidth)
+{
+    auto cellXPos = origin +
+        roundToNearestValidPosition(cell.m_globalPos.m_x - origin, minCellWidth);
+
+    // Is the cell outside the row? if so, round down.
+    if (cellXPos >= row.m_rect.right())
+    {
+        cellXPos = origin +
+            roundToLowestValidPosition(cell.m_globalPos.m_x - origin, minCellWidth);
+    }
+
+    return cellXPos;
+}
+
+/** legal grid position of a cluster closest to its optimal position, kept inside the row */
+static ChipDB::CoordType clusterPosition(const Legalizer::Cluster &cluster, const Legalizer::Row &row,
+    const ChipDB::CoordType minCellWidth)
+{
+    auto xc = row.m_gridOrigin +
+        roundToNearestValidPosition(cluster.optimalPosition() - row.m_gridOrigin, minCellWidth);
+
+    xc = std::min(row.m_rect.right() - cluster.m_totalWidth, xc);
+    xc = std::max(row.m_rect.left(), xc);
+    return xc;
+}
+
+void Legalizer::Cluster::addCell(const ChipDB::CoordType cellXPos, const Cell &cell, std::size_t cellIdx)
 {
     m_lastCellIndex = cellIdx;
     m_totalWeight   += cell.m_weight;
@@ -52,6 +86,7 @@ void Collapse(const Legalizer::Row &row, std::list<Legalizer::Cluster> &clusters
 
     xc = std::max(xmin, xc);
     xc = std::min(xmax - cluster.m_totalWidth, xc);
+    cluster.m_xleft = xc;
 
     if (clusterIter != clusters.begin())
     {
@@ -76,7 +111,7 @@ void Legalizer::placeRow(std::vector<Cell> &cells, const Row &row, const ChipDB:
     std::list<Cluster> clusters;
 
     bool firstCell = true;
-    for(CellIndex cellIdx = 0; cellIdx < row.m_cellIdxs.size(); cellIdx++)
+    for(std::size_t cellIdx = 0; cellIdx < row.m_cellIdxs.size(); cellIdx++)
     {
         auto &cell = cells.at(row.m_cellIdxs.at(cellIdx));
 
@@ -93,15 +128,7 @@ void Legalizer::placeRow(std::vector<Cell> &cells, const Row &row, const ChipDB:
         // If the left cell edge is outside the row, we round xpos down to the lower
         // grid position and try again.
 
-        auto cellXPos = row.m_rect.left() +
-            roundToNearestValidPosition(cell.m_globalPos.m_x - row.m_rect.left(), minCellWidth);
-
-        // Is the cell outside the row? if so, round down.
-        if (cellXPos >= row.m_rect.right())
-        {
-            cellXPos = row.m_rect.left() +
-                roundToLowestValidPosition(cell.m_globalPos.m_x - row.m_rect.left(), minCellWidth);
-        }
+        auto cellXPos = initialCellPosition(cell, row, row.m_rect.left(), minCellWidth);
 
         if (firstCell)
         {
@@ -195,67 +222,446 @@ double LunaCore::Legalizer::calcRowCost(const std::vector<Cell> &cells, const Ro
     return cost;
 }
 
-bool LunaCore::Legalizer::legalize(const ChipDB::Floorplan &floorplan, ChipDB::Netlist &netlist)
+std::optional<ChipDB::CoordType> LunaCore::Legalizer::trialRow(const Row &row, const Cell &cell,
+    const ChipDB::CoordType minCellWidth) const
 {
-    const auto minCellWidth  = floorplan.minimumCellSize().m_x;
+    if ((row.m_usedWidth + cell.m_size.m_x) > row.m_rect.width())
+    {
+        return std::nullopt;
+    }
 
-    if (minCellWidth == 0)
+    Cluster trial;
+    trial.init();
+    trial.addCell(initialCellPosition(cell, row, row.m_gridOrigin, minCellWidth), cell, 0);
+    auto x = clusterPosition(trial, row, minCellWidth);
+
+    // merge with the clusters to the left as long as they overlap,
+    // without changing the row.
+    for(auto iter = row.m_clusters.rbegin(); iter != row.m_clusters.rend(); ++iter)
     {
-        Logging::logError("Legalizer::legalize: min cell width has not been defined for core area.\n");
-        return false;
+        if ((iter->m_xleft + iter->m_totalWidth) <= x)
+        {
+            break;
+        }
+
+        Cluster merged = *iter;
+        merged.addCluster(trial);
+        trial = merged;
+        x = clusterPosition(trial, row, minCellWidth);
     }
 
-    // create a vector consisting of all placed but movable instances
-    std::vector<Cell> cells;
-    for(auto ins : netlist.m_instances)
+    // the cell is the last one of the cluster
+    return x + trial.m_totalWidth - cell.m_size.m_x;
+}
+
+void LunaCore::Legalizer::appendCell(const std::vector<Cell> &cells, Row &row, CellIndex cellIdx,
+    const ChipDB::CoordType minCellWidth)
+{
+    auto const& cell = cells.at(cellIdx);
+    const auto rowCellIdx = row.m_cellIdxs.size();
+
+    row.m_cellIdxs.push_back(cellIdx);
+    row.m_usedWidth += cell.m_size.m_x;
+
+    auto &cluster = row.m_clusters.emplace_back();
+    cluster.init();
+    cluster.m_firstCellIndex = rowCellIdx;
+    cluster.addCell(initialCellPosition(cell, row, row.m_gridOrigin, minCellWidth), cell, rowCellIdx);
+    cluster.m_xleft = clusterPosition(cluster, row, minCellWidth);
+
+    while(row.m_clusters.size() > 1)
     {
-        if (!ins.isValid())
+        auto &last = row.m_clusters.back();
+        auto &prev = row.m_clusters.at(row.m_clusters.size() - 2);
+        if ((prev.m_xleft + prev.m_totalWidth) <= last.m_xleft)
         {
-            continue;
+            break;
         }
 
-        if (ins->m_placementInfo == ChipDB::PlacementInfo::PLACED)
+        prev.addCluster(last);
+        prev.m_xleft = clusterPosition(prev, row, minCellWidth);
+        row.m_clusters.pop_back();
+    }
+}
+
+void LunaCore::Legalizer::writeRowPositions(std::vector<Cell> &cells, const Row &row)
+{
+    for(auto const& cluster : row.m_clusters)
+    {
+        auto x = cluster.m_xleft;
+        for(size_t idx = cluster.m_firstCellIndex; idx <= cluster.m_lastCellIndex; idx++)
         {
-            auto &cell = cells.emplace_back();
+            auto &cell = cells.at(row.m_cellIdxs.at(idx));
+            cell.m_legalPos = ChipDB::Coord64{x, row.m_rect.bottom()};
+            cell.m_orientation = (row.m_rowType == ChipDB::RowType::FLIPY) ?
+                ChipDB::Orientation::MX : ChipDB::Orientation::R0;
 
-            cell.m_size = ins->instanceSize();
-            cell.m_globalPos = ins->m_pos;
-            cell.m_weight = 1.0f;   // FIXME: what should this be??!
-            cell.m_instanceKey = ins.key();
+            x += cell.m_size.m_x;
         }
     }
+}
 
-    // sort cells according to x-position
-    std::sort(cells.begin(), cells.end(), [&cells](auto const & cell1, auto const & cell2)
+/** search the rows outward from the y position of the cell, see Legalizer::legalizeBounded.
+ *  rowY holds the bottom of the rows in order of y. rowCost returns the horizontal
+ *  displacement of the cell in a row or std::nullopt if the cell does not fit.
+ *  Returns the index into rowY of the best row, or rowY.size() if the cell fits nowhere.
+*/
+template<class RowCostFunc>
+static std::size_t findBestRow(const std::vector<ChipDB::CoordType> &rowY, const Legalizer::Cell &cell,
+    RowCostFunc &&rowCost, double &bestCost)
+{
+    std::size_t bestIdx = rowY.size();
+
+    // returns false when the vertical displacement alone exceeds
+    // the best cost, the rows further away can't do better.
+    auto tryRow = [&](std::size_t orderIdx)
+    {
+        const double yCost = cell.m_weight*std::abs(rowY[orderIdx] - cell.m_globalPos.m_y);
+        if (yCost >= bestCost)
         {
-            if (cell1.m_globalPos.m_x < cell2.m_globalPos.m_x)
+            return false;
+        }
+
+        const std::optional<double> xCost = rowCost(orderIdx);
+        if (xCost.has_value())
+        {
+            const double cost = yCost + cell.m_weight*xCost.value();
+            if (cost < bestCost)
             {
-                return true;
+                bestCost = cost;
+                bestIdx  = orderIdx;
             }
+        }
+        return true;
+    };
+
+    const std::size_t startIdx = std::lower_bound(rowY.begin(), rowY.end(), cell.m_globalPos.m_y) - rowY.begin();
+    for(std::size_t orderIdx = startIdx; orderIdx < rowY.size(); orderIdx++)
+    {
+        if (!tryRow(orderIdx)) break;
+    }
+
+    for(std::size_t orderIdx = startIdx; orderIdx > 0; orderIdx--)
+    {
+        if (!tryRow(orderIdx-1)) break;
+    }
+
+    return bestIdx;
+}
+
+std::optional<ChipDB::CoordType> LunaCore::Legalizer::gapPosition(const Row &row, const Cell &cell,
+    const ChipDB::CoordType minCellWidth) const
+{
+    const auto width   = cell.m_size.m_x;
+    const auto desired = initialCellPosition(cell, row, row.m_gridOrigin, minCellWidth);
+
+    std::optional<ChipDB::CoordType> best;
+    auto tryGap = [&](ChipDB::CoordType gapLeft, ChipDB::CoordType gapRight)
+    {
+        if ((gapRight - gapLeft) < width) return;
+
+        // the grid position closest to the cell that is inside the gap
+        auto x = std::clamp(desired, gapLeft, gapRight - width);
+        x = row.m_gridOrigin + roundToLowestValidPosition(x - row.m_gridOrigin, minCellWidth);
+        if (x < gapLeft) x += minCellWidth;
+        if ((x + width) > gapRight) return;
+
+        if (!best.has_value() || (std::abs(x - cell.m_globalPos.m_x) < std::abs(best.value() - cell.m_globalPos.m_x)))
+        {
+            best = x;
+        }
+    };
+
+    auto gapLeft = row.m_rect.left();
+    for(auto const& cluster : row.m_clusters)
+    {
+        tryGap(gapLeft, cluster.m_xleft);
+        gapLeft = cluster.m_xleft + cluster.m_totalWidth;
+    }
+    tryGap(gapLeft, row.m_rect.right());
+
+    return best;
+}
+
+void LunaCore::Legalizer::rebuildRow(const std::vector<Cell> &cells, Row &row, const ChipDB::CoordType minCellWidth)
+{
+    auto cellIdxs = std::move(row.m_cellIdxs);
+    std::sort(cellIdxs.begin(), cellIdxs.end());     // the cells are in order of x
+
+    row.m_cellIdxs.clear();
+    row.m_clusters.clear();
+    row.m_usedWidth = 0;
+    for(auto cellIdx : cellIdxs)
+    {
+        appendCell(cells, row, cellIdx, minCellWidth);
+    }
+}
 
+void LunaCore::Legalizer::legalizeBand(const std::vector<Cell> &cells, std::vector<Row> &rows, Band &band,
+    const ChipDB::CoordType minCellWidth)
+{
+    for(auto cellIdx : band.m_cells)
+    {
+        auto const& cell = cells.at(cellIdx);
+
+        double bestCost = std::numeric_limits<double>::max();
+        auto bestIdx = findBestRow(band.m_rowY, cell,
+            [&](std::size_t orderIdx) -> std::optional<double>
+            {
+                auto x = trialRow(rows[band.m_rows[orderIdx]], cell, minCellWidth);
+                if (!x.has_value()) return std::nullopt;
+                return std::abs(x.value() - cell.m_globalPos.m_x);
+            },
+            bestCost
+        );
+
+        // leave the cell to the final pass if a row outside the band might be better
+        auto outsideIsCloser = [&cell, bestCost](const std::optional<ChipDB::CoordType> &y)
+        {
+            return y.has_value() && ((cell.m_weight*std::abs(y.value() - cell.m_globalPos.m_y)) < bestCost);
+        };
+
+        if ((bestIdx == band.m_rows.size()) || outsideIsCloser(band.m_yBelow) || outsideIsCloser(band.m_yAbove))
+        {
+            band.m_deferred.push_back(cellIdx);
+            continue;
+        }
+
+        appendCell(cells, rows[band.m_rows[bestIdx]], cellIdx, minCellWidth);
+    }
+}
+
+bool LunaCore::Legalizer::legalizeBounded(std::vector<Cell> &cells, std::vector<Row> &rows,
+    const ChipDB::CoordType minCellWidth, const Parameters &params)
+{
+    if (rows.empty())
+    {
+        Logging::logError("Legalizer::legalize: there are no rows\n");
+        return false;
+    }
+
+    // rows in order of their y position
+    std::vector<std::size_t> rowOrder(rows.size());
+    std::iota(rowOrder.begin(), rowOrder.end(), 0);
+    std::stable_sort(rowOrder.begin(), rowOrder.end(), [&rows](auto const row1, auto const row2)
+        {
+            return rows.at(row1).m_rect.bottom() < rows.at(row2).m_rect.bottom();
+        }
+    );
+
+    std::vector<ChipDB::CoordType> rowY;
+    rowY.reserve(rows.size());
+    for(auto rowIdx : rowOrder)
+    {
+        rowY.push_back(rows.at(rowIdx).m_rect.bottom());
+    }
+
+    // a band holds the segments of m_rowsPerBand floorplan rows
+    std::vector<ChipDB::CoordType> bandRowY = rowY;
+    bandRowY.erase(std::unique(bandRowY.begin(), bandRowY.end()), bandRowY.end());
+
+    const std::size_t rowsPerBand = std::max<std::size_t>(1, params.m_rowsPerBand);
+    const std::size_t numBands = (bandRowY.size() + rowsPerBand - 1) / rowsPerBand;
+
+    // band of the floorplan row closest to y
+    auto bandOf = [&](ChipDB::CoordType y) -> std::size_t
+    {
+        std::size_t idx = std::lower_bound(bandRowY.begin(), bandRowY.end(), y) - bandRowY.begin();
+        if ((idx == bandRowY.size()) ||
+            ((idx > 0) && ((y - bandRowY[idx-1]) < (bandRowY[idx] - y))))
+        {
+            idx--;
+        }
+        return idx / rowsPerBand;
+    };
+
+    std::vector<Band> bands(numBands);
+    for(std::size_t orderIdx = 0; orderIdx < rowOrder.size(); orderIdx++)
+    {
+        auto &band = bands.at(bandOf(rowY[orderIdx]));
+        band.m_rows.push_back(rowOrder[orderIdx]);
+        band.m_rowY.push_back(rowY[orderIdx]);
+    }
+
+    for(std::size_t bandIdx = 0; bandIdx < numBands; bandIdx++)
+    {
+        if (bandIdx > 0)
+        {
+            bands[bandIdx].m_yBelow = bandRowY.at(bandIdx*rowsPerBand - 1);
+        }
+
+        if ((bandIdx + 1) < numBands)
+        {
+            bands[bandIdx].m_yAbove = bandRowY.at((bandIdx + 1)*rowsPerBand);
+        }
+    }
+
+    for(std::size_t cellIdx = 0; cellIdx < cells.size(); cellIdx++)
+    {
+        bands.at(bandOf(cells[cellIdx].m_globalPos.m_y)).m_cells.push_back(static_cast<CellIndex>(cellIdx));
+    }
+
+    const PoolSelection threads(params.m_threads);
+
+    // the bands only change their own rows
+    threads.forEach(0, bands.size(), [&](std::size_t bandIdx)
+        {
+            legalizeBand(cells, rows, bands[bandIdx], minCellWidth);
+        }
+    );
+
+    // place the deferred cells in any row. Cells that fit in a gap
+    // are put there for the cost estimate of the next cells,
+    // the rows that receive a cell are placed again afterwards.
+    std::vector<CellIndex> deferred;
+    for(auto const& band : bands)
+    {
+        deferred.insert(deferred.end(), band.m_deferred.begin(), band.m_deferred.end());
+    }
+    std::sort(deferred.begin(), deferred.end());
+
+    std::vector<std::size_t> dirtyRows;
+    std::vector<bool> isDirty(rows.size(), false);
+    for(auto cellIdx : deferred)
+    {
+        auto const& cell = cells.at(cellIdx);
+
+        double bestCost = std::numeric_limits<double>::max();
+        auto bestIdx = findBestRow(rowY, cell,
+            [&](std::size_t orderIdx) -> std::optional<double>
+            {
+                auto const& row = rows[rowOrder[orderIdx]];
+                if ((row.m_usedWidth + cell.m_size.m_x) > row.m_rect.width())
+                {
+                    return std::nullopt;
+                }
+
+                auto x = gapPosition(row, cell, minCellWidth);
+                if (x.has_value())
+                {
+                    return std::abs(x.value() - cell.m_globalPos.m_x);
+                }
+
+                // there is room but the other cells have to move
+                const auto xc = std::clamp(cell.m_globalPos.m_x, row.m_rect.left(), row.m_rect.right() - cell.m_size.m_x);
+                return std::abs(xc - cell.m_globalPos.m_x) + cell.m_size.m_x;
+            },
+            bestCost
+        );
+
+        if (bestIdx == rowY.size())
+        {
+            Logging::logError("Legalizer::legalize: there is no room left in any row for instance with key %d\n",
+                cell.m_instanceKey);
             return false;
         }
+
+        const auto rowIdx = rowOrder[bestIdx];
+        auto &row = rows[rowIdx];
+
+        auto x = gapPosition(row, cell, minCellWidth);
+        if (x.has_value())
+        {
+            Cluster occupied;
+            occupied.init();
+            occupied.addCell(x.value(), cell, 0);
+            occupied.m_xleft = x.value();
+
+            auto iter = std::lower_bound(row.m_clusters.begin(), row.m_clusters.end(), x.value(),
+                [](const Cluster &cluster, ChipDB::CoordType xpos)
+                {
+                    return cluster.m_xleft < xpos;
+                }
+            );
+            row.m_clusters.insert(iter, occupied);
+        }
+
+        row.m_cellIdxs.push_back(cellIdx);
+        row.m_usedWidth += cell.m_size.m_x;
+
+        if (!isDirty[rowIdx])
+        {
+            isDirty[rowIdx] = true;
+            dirtyRows.push_back(rowIdx);
+        }
+    }
+
+    threads.forEach(0, dirtyRows.size(), [&](std::size_t idx)
+        {
+            rebuildRow(cells, rows[dirtyRows[idx]], minCellWidth);
+        }
     );
 
-    // create custom row legalizer Row objects that mirror the Rows in the region.
-    // FIXME: insert fixed objects into the row legalizer Rows.
-    //        things like fixed end-caps
-    //        we also need some kind of provision for density constraints
-    //        w.r.t. decap and filler cells.
+    threads.forEach(0, rows.size(), [&](std::size_t rowIdx)
+        {
+            writeRowPositions(cells, rows[rowIdx]);
+        }
+    );
 
-    std::vector<Row> rows;
-    rows.resize(floorplan.rows().size());
+    return true;
+}
 
-    std::size_t Nrows = floorplan.rows().size();
-    for(size_t rowIdx=0; rowIdx < Nrows; rowIdx++)
+std::vector<LunaCore::Legalizer::Row> LunaCore::Legalizer::createRowSegments(const ChipDB::Floorplan &floorplan,
+    const ChipDB::Netlist &netlist, const ChipDB::CoordType minCellWidth)
+{
+    std::vector<ChipDB::Rect64> blockages;
+    for(auto const insKeyObjPair : netlist.m_instances)
     {
-        rows.at(rowIdx).m_rect    = floorplan.rows().at(rowIdx).m_rect;
-        rows.at(rowIdx).m_rowType = floorplan.rows().at(rowIdx).m_rowType;
+        if (!insKeyObjPair->isFixed()) continue;
+
+        auto const rect = insKeyObjPair->rect();
+        if ((rect.width() <= 0) || (rect.height() <= 0)) continue;
+
+        blockages.push_back(rect);
     }
 
+    std::vector<Row> segments;
+    segments.reserve(floorplan.rows().size());
+    for(auto const& floorplanRow : floorplan.rows())
+    {
+        auto const& rowRect = floorplanRow.m_rect;
+
+        ChipDB::IntervalList blocked;
+        for(auto const& blockage : blockages)
+        {
+            if ((blockage.bottom() >= rowRect.top()) || (blockage.top() <= rowRect.bottom())) continue;
+            if ((blockage.left() >= rowRect.right()) || (blockage.right() <= rowRect.left())) continue;
+
+            blocked.addInterval({std::max(blockage.left(), rowRect.left()), std::min(blockage.right(), rowRect.right())});
+        }
+
+        auto addSegment = [&](ChipDB::CoordType left, ChipDB::CoordType right)
+        {
+            // the cell widths are a multiple of the site width,
+            // so both edges of a segment are snapped to the site grid.
+            left  = rowRect.left() + ((left - rowRect.left() + minCellWidth - 1) / minCellWidth)*minCellWidth;
+            right = rowRect.left() + ((right - rowRect.left()) / minCellWidth)*minCellWidth;
+            if ((right - left) < minCellWidth) return;
+
+            auto &segment = segments.emplace_back();
+            segment.m_rowType    = floorplanRow.m_rowType;
+            segment.m_rect       = ChipDB::Rect64{{left, rowRect.bottom()}, {right, rowRect.top()}};
+            segment.m_gridOrigin = rowRect.left();
+        };
+
+        auto freeLeft = rowRect.left();
+        for(auto const& interval : blocked)
+        {
+            addSegment(freeLeft, interval.x1);
+            freeLeft = std::max(freeLeft, interval.x2);
+        }
+        addSegment(freeLeft, rowRect.right());
+    }
+
+    return segments;
+}
+
+void LunaCore::Legalizer::legalizeExhaustive(std::vector<Cell> &cells, std::vector<Row> &rows,
+    const ChipDB::CoordType minCellWidth)
+{
     // try the sorted cells in each row and see which row has the lowest
     // placement cost
-    for(CellIndex cellIdx=0; cellIdx < cells.size(); cellIdx++)
+    for(std::size_t cellIdx = 0; cellIdx < cells.size(); cellIdx++)
     {
         double bestCost = std::numeric_limits<double>::max();
 
@@ -263,7 +669,7 @@ bool LunaCore::Legalizer::legalize(const ChipDB::Floorplan &floorplan, ChipDB::N
         size_t rowIndex = 0;
         for(auto &row : rows)
         {
-            row.insertCell(cellIdx);
+            row.insertCell(static_cast<CellIndex>(cellIdx));
             placeRow(cells, row, minCellWidth);
             auto cost = calcRowCost(cells, row);
             if (cost < bestCost)
@@ -276,9 +682,90 @@ bool LunaCore::Legalizer::legalize(const ChipDB::Floorplan &floorplan, ChipDB::N
         }
 
         auto &bestRow = rows.at(bestRowIdx);
-        bestRow.insertCell(cellIdx);
+        bestRow.insertCell(static_cast<CellIndex>(cellIdx));
         placeRow(cells, bestRow, minCellWidth);
     }
+}
+
+bool LunaCore::Legalizer::legalize(const ChipDB::Floorplan &floorplan, ChipDB::Netlist &netlist)
+{
+    return legalize(floorplan, netlist, Parameters{});
+}
+
+bool LunaCore::Legalizer::legalize(const ChipDB::Floorplan &floorplan, ChipDB::Netlist &netlist,
+    const Parameters &params)
+{
+    const auto minCellWidth  = floorplan.minimumCellSize().m_x;
+
+    if (minCellWidth == 0)
+    {
+        Logging::logError("Legalizer::legalize: min cell width has not been defined for core area.\n");
+        return false;
+    }
+
+    // create a vector consisting of all placed but movable instances
+    std::vector<Cell> cells;
+    for(auto ins : netlist.m_instances)
+    {
+        if (!ins.isValid())
+        {
+            continue;
+        }
+
+        if (ins->m_placementInfo == ChipDB::PlacementInfo::PLACED)
+        {
+            auto &cell = cells.emplace_back();
+
+            cell.m_size = ins->instanceSize();
+            cell.m_globalPos = ins->m_pos;
+            cell.m_weight = 1.0f;   // FIXME: what should this be??!
+            cell.m_instanceKey = ins.key();
+        }
+    }
+
+    // sort cells according to x-position
+    std::sort(cells.begin(), cells.end(), [&cells](auto const & cell1, auto const & cell2)
+        {
+            if (cell1.m_globalPos.m_x < cell2.m_globalPos.m_x)
+            {
+                return true;
+            }
+
+            return false;
+        }
+    );
+
+    if (params.m_mode == Mode::EXHAUSTIVE)
+    {
+        // create custom row legalizer Row objects that mirror the Rows in the region.
+        // FIXME: insert fixed objects into the row legalizer Rows.
+        //        things like fixed end-caps
+        //        we also need some kind of provision for density constraints
+        //        w.r.t. decap and filler cells.
+
+        std::vector<Row> rows;
+        rows.resize(floorplan.rows().size());
+
+        std::size_t Nrows = floorplan.rows().size();
+        for(size_t rowIdx=0; rowIdx < Nrows; rowIdx++)
+        {
+            rows.at(rowIdx).m_rect    = floorplan.rows().at(rowIdx).m_rect;
+            rows.at(rowIdx).m_rowType = floorplan.rows().at(rowIdx).m_rowType;
+        }
+
+        legalizeExhaustive(cells, rows, minCellWidth);
+    }
+    else
+    {
+        // the fixed instances are cut out of the rows.
+        // FIXME: we need some kind of provision for density constraints
+        //        w.r.t. decap and filler cells.
+        auto rows = createRowSegments(floorplan, netlist, minCellWidth);
+        if (!legalizeBounded(cells, rows, minCellWidth, params))
+        {
+            return false;
+        }
+    }
 
     // write back the legal positions of the cells
     for(auto const& cell : cells)
@@ -5,6 +5,7 @@
 #pragma once
 #include <list>
 #include <vector>
+#include <optional>
 #include <cassert>
 
 #include "database/database.h"
@@ -12,10 +13,37 @@
 namespace LunaCore
 {
 
+/** Abacus row legalizer.
+ *
+ *  The cells are processed in order of their global x position and each
+ *  cell is appended to the row where it moves the least. Overlapping
+ *  cells in a row are merged into clusters that are placed at the
+ *  position minimizing the total displacement of their cells.
+ *
+ *  In the bounded mode, fixed instances split the floorplan rows into
+ *  segments and the rows are grouped into horizontal bands that are
+ *  legalized concurrently. Cells that might be better off in another
+ *  band are placed afterwards and the rows they end up in are placed
+ *  again.
+*/
 class Legalizer
 {
 public:
 
+    enum class Mode
+    {
+        BOUNDED,    ///< search the rows outward from the cell and evaluate each row against its last cluster only
+        EXHAUSTIVE  ///< re-place every row for every cell, slow: O(cells * rows * cells per row)
+    };
+
+    struct Parameters
+    {
+        Mode m_mode{Mode::BOUNDED};
+
+        std::size_t m_rowsPerBand{16};  ///< number of floorplan rows in a band of the bounded mode
+        std::size_t m_threads{0};       ///< thread count for the bands, see PoolSelection
+    };
+
     struct Cell
     {
         ChipDB::ObjectKey   m_instanceKey;  ///< key to the instance in the netlist
@@ -52,7 +80,7 @@ public:
             return m_q / m_totalWeight;
         }
 
-        void addCell(const ChipDB::CoordType cellPos, const Cell &cell, CellIndex cellIdx);
+        void addCell(const ChipDB::CoordType cellPos, const Cell &cell, std::size_t cellIdx);
         void addCluster(Cluster &cluster);
     };
 
@@ -62,6 +90,10 @@ public:
         ChipDB::Rect64  m_rect;
         std::vector<CellIndex> m_cellIdxs;
 
+        std::vector<Cluster> m_clusters;    ///< clusters of the bounded mode, in order of x
+        ChipDB::CoordType    m_usedWidth{0};///< total width of the cells in the row
+        ChipDB::CoordType    m_gridOrigin{0};   ///< x position of the site grid, the left edge of the floorplan row
+
         void insertCell(CellIndex idx)
         {
             m_cellIdxs.push_back(idx);
@@ -77,8 +109,69 @@ public:
         const ChipDB::Floorplan &floorplan,
         ChipDB::Netlist &netlist);
 
+    [[nodiscard]] bool legalize(
+        const ChipDB::Floorplan &floorplan,
+        ChipDB::Netlist &netlist,
+        const Parameters &params);
+
+    /** split the floorplan rows into segments that don't overlap fixed instances.
+     *  The segment edges are on the site grid of the floorplan row.
+    */
+    [[nodiscard]] static std::vector<Row> createRowSegments(const ChipDB::Floorplan &floorplan,
+        const ChipDB::Netlist &netlist, const ChipDB::CoordType cellMinWidth);
+
 protected:
 
+    /** place each cell in the row where it is displaced the least, re-placing every row for every cell */
+    void legalizeExhaustive(std::vector<Cell> &cells, std::vector<Row> &rows, const ChipDB::CoordType cellMinWidth);
+
+    /** place each cell in the row where it is displaced the least. The rows are searched
+     *  outward from the global y position of the cell. The search in a direction stops
+     *  as soon as the vertical displacement alone exceeds the best cost found.
+     *  Returns false if a cell doesn't fit in any row.
+    */
+    [[nodiscard]] bool legalizeBounded(std::vector<Cell> &cells, std::vector<Row> &rows,
+        const ChipDB::CoordType cellMinWidth, const Parameters &params);
+
+    /** rows of a band, the cells that start in it and the cells that have to be placed
+     *  by the final pass.
+    */
+    struct Band
+    {
+        std::vector<std::size_t>        m_rows;     ///< row indices in order of y
+        std::vector<ChipDB::CoordType>  m_rowY;     ///< bottom of the rows in m_rows
+        std::vector<CellIndex>          m_cells;    ///< in order of x
+        std::vector<CellIndex>          m_deferred; ///< cells that might be better off in another band
+        std::optional<ChipDB::CoordType> m_yBelow;  ///< bottom of the nearest row below the band
+        std::optional<ChipDB::CoordType> m_yAbove;  ///< bottom of the nearest row above the band
+    };
+
+    /** legalize the cells of a band into the rows of the band */
+    void legalizeBand(const std::vector<Cell> &cells, std::vector<Row> &rows, Band &band,
+        const ChipDB::CoordType cellMinWidth);
+
+    /** returns the position of a cell in the free space of a row closest to its
+     *  global position, without moving the other cells, or std::nullopt if there
+     *  is no gap wide enough.
+    */
+    [[nodiscard]] std::optional<ChipDB::CoordType> gapPosition(const Row &row, const Cell &cell,
+        const ChipDB::CoordType cellMinWidth) const;
+
+    /** place all cells of a row again, in order of x */
+    void rebuildRow(const std::vector<Cell> &cells, Row &row, const ChipDB::CoordType cellMinWidth);
+
+    /** returns the legal x position of a cell if it were appended to the row,
+     *  or std::nullopt if the cell does not fit. The row is not changed.
+    */
+    [[nodiscard]] std::optional<ChipDB::CoordType> trialRow(const Row &row, const Cell &cell,
+        const ChipDB::CoordType cellMinWidth) const;
+
+    /** append a cell to the row and merge the clusters it overlaps */
+    void appendCell(const std::vector<Cell> &cells, Row &row, CellIndex cellIdx, const ChipDB::CoordType cellMinWidth);
+
+    /** set the legal positions of the cells from the clusters of the row */
+    void writeRowPositions(std::vector<Cell> &cells, const Row &row);
+
     /** layout all the cells in a row and update the cell vector accordingly */
     void placeRow(std::vector<Cell> &cells, const Row &row, const ChipDB::CoordType cellMinWidth);
 
@@ -0,0 +1,143 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <cmath>
+#include <algorithm>
+#include "capacitymap.h"
+
+using namespace LunaCore::CellPlacer2;
+
+void CapacityMap::build(const ChipDB::Floorplan &floorplan, const ChipDB::Netlist &netlist)
+{
+    // bins are roughly square and one row high,
+    // but never more than maxBins in each direction.
+    const std::size_t maxBins = 512;
+
+    m_extent = floorplan.coreRect();
+
+    auto binSize = static_cast<double>(std::max<ChipDB::CoordType>(floorplan.minimumCellSize().m_y, 1));
+    binSize = std::max(binSize, static_cast<double>(m_extent.width()) / maxBins);
+    binSize = std::max(binSize, static_cast<double>(m_extent.height()) / maxBins);
+
+    m_nx = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(m_extent.width() / binSize)));
+    m_ny = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(m_extent.height() / binSize)));
+    m_binWidth  = std::max(1.0, static_cast<double>(m_extent.width()) / m_nx);
+    m_binHeight = std::max(1.0, static_cast<double>(m_extent.height()) / m_ny);
+
+    m_bins.assign(m_nx*m_ny, 0.0);
+
+    // the row rectangles use the same absolute
+    // coordinates as the row legalizer.
+    for(auto const& row : floorplan.rows())
+    {
+        addRect(row.m_rect, 1.0);
+    }
+
+    // remove the parts of the rows covered by fixed cells
+    for(auto const& insKeyObjPair : netlist.m_instances)
+    {
+        if (!insKeyObjPair->isFixed()) continue;
+
+        auto const size = insKeyObjPair->instanceSize();
+        if ((size.m_x <= 0) || (size.m_y <= 0)) continue;
+
+        auto const ll = insKeyObjPair->m_pos;
+        const ChipDB::Rect64 insRect{ll, ll + size};
+
+        for(auto const& row : floorplan.rows())
+        {
+            auto const& rowRect = row.m_rect;
+            ChipDB::Rect64 overlap{
+                {std::max(insRect.left(), rowRect.left()), std::max(insRect.bottom(), rowRect.bottom())},
+                {std::min(insRect.right(), rowRect.right()), std::min(insRect.top(), rowRect.top())}
+            };
+
+            if ((overlap.width() > 0) && (overlap.height() > 0))
+            {
+                addRect(overlap, -1.0);
+            }
+        }
+    }
+
+    // overlapping fixed cells can remove the same area twice
+    for(auto &value : m_bins)
+    {
+        value = std::max(value, 0.0);
+    }
+
+    m_prefix.assign((m_nx+1)*(m_ny+1), 0.0);
+    for(std::size_t iy = 0; iy < m_ny; iy++)
+    {
+        double rowSum = 0.0;
+        for(std::size_t ix = 0; ix < m_nx; ix++)
+        {
+            rowSum += bin(ix, iy);
+            m_prefix[(iy+1)*(m_nx+1) + ix + 1] = m_prefix[iy*(m_nx+1) + ix + 1] + rowSum;
+        }
+    }
+}
+
+void CapacityMap::addRect(const ChipDB::Rect64 &rect, double sign)
+{
+    const double x0 = std::max(0.0, static_cast<double>(rect.left()   - m_extent.left()));
+    const double x1 = std::min(static_cast<double>(m_extent.width()),  static_cast<double>(rect.right() - m_extent.left()));
+    const double y0 = std::max(0.0, static_cast<double>(rect.bottom() - m_extent.bottom()));
+    const double y1 = std::min(static_cast<double>(m_extent.height()), static_cast<double>(rect.top()   - m_extent.bottom()));
+
+    if ((x1 <= x0) || (y1 <= y0)) return;
+
+    const auto ix0 = std::min(m_nx-1, static_cast<std::size_t>(x0 / m_binWidth));
+    const auto ix1 = std::min(m_nx-1, static_cast<std::size_t>(x1 / m_binWidth));
+    const auto iy0 = std::min(m_ny-1, static_cast<std::size_t>(y0 / m_binHeight));
+    const auto iy1 = std::min(m_ny-1, static_cast<std::size_t>(y1 / m_binHeight));
+
+    for(auto iy = iy0; iy <= iy1; iy++)
+    {
+        const double by0 = std::max(y0, iy*m_binHeight);
+        const double by1 = (iy == m_ny-1) ? y1 : std::min(y1, (iy+1)*m_binHeight);
+        if (by1 <= by0) continue;
+
+        for(auto ix = ix0; ix <= ix1; ix++)
+        {
+            const double bx0 = std::max(x0, ix*m_binWidth);
+            const double bx1 = (ix == m_nx-1) ? x1 : std::min(x1, (ix+1)*m_binWidth);
+            if (bx1 <= bx0) continue;
+
+            bin(ix, iy) += sign * (bx1 - bx0) * (by1 - by0);
+        }
+    }
+}
+
+double CapacityMap::cumulative(double x, double y) const noexcept
+{
+    // position in bin units, clamped to the map
+    const double fx = std::clamp((x - m_extent.left())   / m_binWidth,  0.0, static_cast<double>(m_nx));
+    const double fy = std::clamp((y - m_extent.bottom()) / m_binHeight, 0.0, static_cast<double>(m_ny));
+
+    const auto ix = std::min(m_nx-1, static_cast<std::size_t>(fx));
+    const auto iy = std::min(m_ny-1, static_cast<std::size_t>(fy));
+    const double tx = fx - ix;
+    const double ty = fy - iy;
+
+    // the summed-area table is bilinear within a bin
+    const auto stride = m_nx + 1;
+    const double p00 = m_prefix[iy*stride + ix];
+    const double p10 = m_prefix[iy*stride + ix + 1];
+    const double p01 = m_prefix[(iy+1)*stride + ix];
+    const double p11 = m_prefix[(iy+1)*stride + ix + 1];
+
+    return p00 + tx*(p10 - p00) + ty*(p01 - p00) + tx*ty*(p11 - p10 - p01 + p00);
+}
+
+double CapacityMap::capacity(const ChipDB::Rect64 &rect) const noexcept
+{
+    if (m_prefix.empty()) return 0.0;
+
+    const auto x0 = static_cast<double>(rect.left());
+    const auto x1 = static_cast<double>(rect.right());
+    const auto y0 = static_cast<double>(rect.bottom());
+    const auto y1 = static_cast<double>(rect.top());
+
+    return std::max(0.0, cumulative(x1, y1) - cumulative(x0, y1) - cumulative(x1, y0) + cumulative(x0, y0));
+}
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+#include <vector>
+
+#include "database/database.h"
+
+namespace LunaCore::CellPlacer2
+{
+
+/** Map of the area available for movable cells.
+ *
+ *  The core is divided into bins. Each bin holds the row area inside
+ *  the bin minus the area taken by fixed cells on those rows. The
+ *  capacity of an arbitrary rectangle is found in constant time from
+ *  a summed-area table, assuming the capacity is spread evenly
+ *  within each bin.
+ *
+ *  All areas are in nm².
+*/
+class CapacityMap
+{
+public:
+    /** build the map from the rows of the floorplan and
+     *  the fixed instances of the netlist.
+    */
+    void build(const ChipDB::Floorplan &floorplan, const ChipDB::Netlist &netlist);
+
+    /** return the area available to movable cells within a rectangle */
+    [[nodiscard]] double capacity(const ChipDB::Rect64 &rect) const noexcept;
+
+    /** return the total available area */
+    [[nodiscard]] double totalCapacity() const noexcept
+    {
+        return capacity(m_extent);
+    }
+
+protected:
+    /** distribute area*sign of a rectangle over the bins */
+    void addRect(const ChipDB::Rect64 &rect, double sign);
+
+    /** return the capacity of the area between the lower left
+     *  of the map and (x,y).
+    */
+    [[nodiscard]] double cumulative(double x, double y) const noexcept;
+
+    [[nodiscard]] double& bin(std::size_t ix, std::size_t iy) noexcept
+    {
+        return m_bins[iy*m_nx + ix];
+    }
+
+    ChipDB::Rect64      m_extent;
+    double              m_binWidth{1};
+    double              m_binHeight{1};
+    std::size_t         m_nx{0};
+    std::size_t         m_ny{0};
+    std::vector<double> m_bins;     ///< capacity of each bin
+    std::vector<double> m_prefix;   ///< (m_nx+1)*(m_ny+1) summed-area table of m_bins
+};
+
+};
@@ -3,113 +3,73 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include <cassert>
+#include <cmath>
+#include <limits>
+#include <iterator>
+#include <algorithm>
 
-#include <thread>
 #include <fstream>
 #include "common/logging.h"
 #include "database/database.h"
 #include "cellplacer2.h"
 #include "../cellplacer/rowlegalizer.h"
+#include "../cellplacer/detailedplacer.h"
 
 using namespace LunaCore::CellPlacer2;
 
 /** assign each instance/gate a row in the quadratic placement matrix */
-void Placer::mapGatesToMatrixRows(const ChipDB::Netlist &netlist,
-    const PlacementRegion &r,
-    GateToRowContainer &gate2Row)
+void Placer::mapGatesToMatrixRows(const PlacementRegion &r, SolverWorkspace &ws) const
 {
-    RowIndex rowCounter = 0;
-    gate2Row.clear();
-
-    for(auto gateId : r.m_gatesInRegion)
-    {
-        auto gate = netlist.m_instances.atRaw(gateId);
-        if (!gate->isFixed())
-        {
-            gate2Row[gateId] = rowCounter++;
-        }
-    }
-}
+    ws.m_gateToRow.resize(m_netlist.gateCount(), InvalidRow);
 
-Placer::RowIndex Placer::findRowOfGate(const GateToRowContainer &gate2Row,
-    const GateId gateId) const noexcept
-{
-    auto iter = gate2Row.find(gateId);
-    if (iter == gate2Row.end())
+    RowIndex rowCounter = 0;
+    for(auto gate : r.m_gatesInRegion)
     {
-        return -1;
+        assert(!m_netlist.isFixed(gate));
+        ws.m_gateToRow[gate] = rowCounter++;
     }
-    return iter->second;
 }
 
-void Placer::placeRegion(ChipDB::Netlist &netlist, PlacementRegion &region)
+void Placer::placeRegion(PlacementRegion &region, SolverWorkspace &ws, ThreadPool *pool)
 {
-    GateToRowContainer gates2Row;
-
-    auto &gates = netlist.m_instances;
-    auto &nets  = netlist.m_nets;
+    mapGatesToMatrixRows(region, ws);
 
-    mapGatesToMatrixRows(netlist, region, gates2Row);
+    auto const& gateToRow = ws.m_gateToRow;
+    auto const& xpos = m_netlist.m_x;
+    auto const& ypos = m_netlist.m_y;
 
-    auto Nrows = gates2Row.size();
+    auto Nrows = region.m_gatesInRegion.size();
 
-    Algebra::SparseMatrix<float> Amat(Nrows);
+    // assemble the A matrix as triplets and freeze it into
+    // CSR format once all the net contributions are known.
+    auto &Abuilder = ws.m_Abuilder;
+    Abuilder.reset(Nrows);
 
-    Algebra::Vector<float> Bvec_x(Nrows);
-    Algebra::Vector<float> Bvec_y(Nrows);
+    auto &Bvec_x = ws.m_Bvec_x;
+    auto &Bvec_y = ws.m_Bvec_y;
 
+    Bvec_x.resize(Nrows);
+    Bvec_y.resize(Nrows);
     Bvec_x.zero();
     Bvec_y.zero();
 
     std::size_t fixups = 0;
-    for(auto row : gates2Row)
+    for(RowIndex rowIndex = 0; rowIndex < Nrows; rowIndex++)
     {
-        auto srcGateId = row.first;
-        auto rowIndex  = row.second;
+        auto const srcGate = region.m_gatesInRegion[rowIndex];
 
-        auto &srcGate = gates.atRef(srcGateId);
-
-        std::size_t pinIndex = 0;
-        for(auto netId : srcGate.connections())
+        for(auto net : m_netlist.gateNets(srcGate))
         {
-            // skip power and ground pins
-            auto const pin = srcGate.getPin(pinIndex);
-            if ((pin.m_pinInfo) && (pin.m_pinInfo->isPGPin()))
-            {
-                pinIndex++;
-                continue;
-            }
+            float weight = m_netlist.netWeight(net);
 
-            if (netId == ChipDB::ObjectNotFound)
+            for(auto dstGate : m_netlist.netGates(net))
             {
-                Logging::logWarning("Net left unconnected on instance %s\n", srcGate.name().c_str());
-                continue;
-            }
-
-            auto const& net = netlist.m_nets.atRef(netId);
+                if (dstGate == srcGate) continue;   // skip self references.
 
-            if (net.numberOfConnections() <= 1)
-            {
-                Logging::logWarning("Net %s has 1 or fewer connections!\n", net.name().c_str());
-                continue;
-            }
-
-            float weight = 1.0f/(net.numberOfConnections() - 1.0);
-            if (net.m_isPortNet)
-            {
-                //weight *= 4.0f;
-            }
+                Abuilder.add(rowIndex, rowIndex, weight);   // A(row,row) += net weight
 
-            for(auto const& netConnect : net)
-            {
-                auto dstGateId = netConnect.m_instanceKey;
-                if (dstGateId == srcGateId) continue;   // skip self references.
-
-                Amat.at(rowIndex,rowIndex) += weight;   // A(row,row) += net weight
-
-                auto const& dstGate = netlist.m_instances.atRef(dstGateId);
-                auto const dstGatePos = m_gatePositions.at(dstGateId);
-                if (dstGate.isFixed())
+                auto const dstGatePos = PointF{xpos[dstGate], ypos[dstGate]};
+                if (m_netlist.isFixed(dstGate))
                 {
                     // destination gate isn't movable -> change bvector only
                     // if the gate isn't inside the region, propagate it to
@@ -125,13 +85,13 @@ void Placer::placeRegion(ChipDB::Netlist &netlist, PlacementRegion &region)
                     // gate
                     if (region.contains(dstGatePos))
                     {
-                        auto const colIndex = findRowOfGate(gates2Row, dstGateId);
+                        auto const colIndex = gateToRow[dstGate];
 
                         // due to round-off errors, region.contains might return 'true'
                         // even if the gate isn't actually in the region.
-                        // then, colIndex will be -1 and we should treat the
+                        // then, colIndex will be invalid and we should treat the
                         // gate as external.
-                        if (colIndex == -1)
+                        if (colIndex == InvalidRow)
                         {
                             auto newLocation = propagate(region, dstGatePos);
                             Bvec_x[rowIndex] += weight*newLocation.m_x;
@@ -140,7 +100,7 @@ void Placer::placeRegion(ChipDB::Netlist &netlist, PlacementRegion &region)
                         else
                         {
                             // destination gate is movable -> change row
-                            Amat(rowIndex, colIndex) -= weight;
+                            Abuilder.add(rowIndex, colIndex, -weight);
                         }
                     }
                     else
@@ -153,11 +113,14 @@ void Placer::placeRegion(ChipDB::Netlist &netlist, PlacementRegion &region)
                     }
                 }
             }
-            pinIndex++;
         }
     }
 
-    
+    // the row map is shared by all regions placed with this workspace
+    for(auto gate : region.m_gatesInRegion)
+    {
+        ws.m_gateToRow[gate] = InvalidRow;
+    }
 
     //Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Upper | Eigen::Lower> solver;
     //Eigen::SparseMatrix<double> eigenAmat(Nrows, Nrows);
@@ -165,83 +128,89 @@ void Placer::placeRegion(ChipDB::Netlist &netlist, PlacementRegion &region)
     //eigenAmat.makeCompressed();
     //solver.compute(eigenAmat);
 
-    Algebra::Vector<float> xvec;
-    Algebra::Vector<float> yvec;
+    auto &Amat = ws.m_Amat;
+    Abuilder.freeze(Amat);
 
-    // if we have a small number of rows, don't use multi-threading
-    // as the thread startup time will become dominant --> assumption..
-    // ibm18, always multi-threading -> 30s
-    // ibm18, limit 20 rows -> 25s
-    // ibm18, limit 50 rows -> 25s
-    //if (Nrows < 20)
-    
-    Algebra::CGSolver::JacobiPreconditioner<float> precond(Amat);
+    // use the current gate positions as the initial guess
+    auto &xvec = ws.m_xvec;
+    auto &yvec = ws.m_yvec;
+    xvec.resize(Nrows);
+    yvec.resize(Nrows);
+    for(RowIndex rowIndex = 0; rowIndex < Nrows; rowIndex++)
+    {
+        auto const gate = region.m_gatesInRegion[rowIndex];
+        xvec[rowIndex] = xpos[gate];
+        yvec[rowIndex] = ypos[gate];
+    }
+
+    auto &precond = ws.m_precond;
+    precond.update(Amat);
 
     Algebra::ComputeInfo info_x;
     Algebra::ComputeInfo info_y;
 
-    if (true)
+    // the IC(0) preconditioner keeps the iteration count low
+    // even for the large regions of the first levels, so
+    // the iteration limit is only a safety net.
+    const float solverTolerance = 1.0e-5f;
+    const std::size_t solverMaxIterations = 1000;
+
+    // for a small number of rows, the task overhead becomes
+    // dominant so the x and y systems are solved one after the other.
+    // ibm18, always multi-threading -> 30s
+    // ibm18, limit 20 rows -> 25s
+    // ibm18, limit 50 rows -> 25s
+    const std::size_t minRowsForParallelSolve = 50;
+
+    if ((pool == nullptr) || (Nrows < minRowsForParallelSolve))
     {
-        info_x = Algebra::CGSolver::solve(Amat, Bvec_x, xvec, precond);
-        info_y = Algebra::CGSolver::solve(Amat, Bvec_y, yvec, precond);
+        info_x = ws.m_solverX.solve(Amat, Bvec_x, xvec, precond, solverTolerance, solverMaxIterations);
+        info_y = ws.m_solverY.solve(Amat, Bvec_y, yvec, precond, solverTolerance, solverMaxIterations);
     }
     else
     {
-#if 0        
-        std::thread worker1(
-            [&solver, &Bvec_x, &xvec]()
-            {
-                xvec = solver.solve(Bvec_x);
-            }
-        );
-        std::thread worker2(
-            [&solver, &Bvec_y, &yvec]()
+        // the x and y systems share the A matrix and the preconditioner
+        // but each has its own solver workspace.
+        TaskGroup group(*pool);
+        group.run([&]()
             {
-                yvec = solver.solve(Bvec_y);
+                info_x = ws.m_solverX.solve(Amat, Bvec_x, xvec, precond, solverTolerance, solverMaxIterations);
             }
         );
-        worker1.join();
-        worker2.join();
-#endif
+        info_y = ws.m_solverY.solve(Amat, Bvec_y, yvec, precond, solverTolerance, solverMaxIterations);
+        group.wait();
     }
 
+    m_solverStats.add(info_x);
+    m_solverStats.add(info_y);
+
     // check if all gates are within the region
     const float absTol = 0.1f;
-    for(auto row : gates2Row)
+    for(RowIndex rowIndex = 0; rowIndex < Nrows; rowIndex++)
     {
-        auto gateId = row.first;
-        auto rowId  = row.second;
-        auto const& Gate = netlist.m_instances.atRef(gateId);
-
-        auto const oldGateLocation = m_gatePositions.at(gateId);
-
-        auto const newGateLocation = PointF{static_cast<float>(xvec[rowId]), static_cast<float>(yvec[rowId])};
+        auto const gate = region.m_gatesInRegion[rowIndex];
+        auto const oldGateLocation = PointF{xpos[gate], ypos[gate]};
+        auto const newGateLocation = PointF{static_cast<float>(xvec[rowIndex]), static_cast<float>(yvec[rowIndex])};
 
         if (!region.contains(newGateLocation, absTol))
         {
-            std::cout << "Gate: (id=" << gateId << ") old pos: " << oldGateLocation << " new pos: " << newGateLocation << " Region: " << region << "\n";
-            //std::cout << "A matrix row: " << Amat.at(rowId);
-            std::cout << "B vec x     : " << Bvec_x[rowId] << "\n";
-            std::cout << "B vec y     : " << Bvec_y[rowId] << "\n";
-            std::cout << "rowId       : " << rowId << "\n";
+            std::cout << "Gate: (id=" << m_netlist.gateId(gate) << ") old pos: " << oldGateLocation << " new pos: " << newGateLocation << " Region: " << region << "\n";
+            std::cout << "B vec x     : " << Bvec_x[rowIndex] << "\n";
+            std::cout << "B vec y     : " << Bvec_y[rowIndex] << "\n";
+            std::cout << "rowId       : " << rowIndex << "\n";
 #if 0
             std::cout << "Amat        : " << Amat << "\n";
             std::cout << "B vec x :     " << Bvec_x << "\n";
             std::cout << "B vec y :     " << Bvec_y << "\n";
 #endif
         }
-        assert(!Gate.isFixed());
     }
 
-    // update gate/instance locations
-    for(auto row : gates2Row)
+    // store the new gate/instance locations
+    region.m_solution.resize(Nrows);
+    for(RowIndex rowIndex = 0; rowIndex < Nrows; rowIndex++)
     {
-        auto gateId = row.first;
-        auto rowId  = row.second;
-        auto const& Gate = netlist.m_instances.atRef(gateId);
-
-        auto newGateLocation = PointF{static_cast<float>(xvec[rowId]), static_cast<float>(yvec[rowId])};
-        //assert(region.contains(newGateLocation, absTol));
+        auto newGateLocation = PointF{static_cast<float>(xvec[rowIndex]), static_cast<float>(yvec[rowIndex])};
 
         if (!region.contains(newGateLocation))
         {
@@ -249,16 +218,15 @@ void Placer::placeRegion(ChipDB::Netlist &netlist, PlacementRegion &region)
             newGateLocation = propagate(region, newGateLocation);
         }
 
-        m_gatePositions.at(gateId) = newGateLocation;
-        //Gate.setCenter(newGateLocation.toCoord64());
+        region.m_solution[rowIndex] = newGateLocation;
     }
 
 #if 0
     std::ofstream ofile("cellplacer2_pos.txt");
     std::size_t index = 0;
-    for(auto gateId : region.m_gatesInRegion)
+    for(auto gate : region.m_gatesInRegion)
     {
-        ofile << "Gate " << gateId << " pos: " << m_gatePositions.at(gateId) << "\n";
+        ofile << "Gate " << m_netlist.gateId(gate) << " pos: " << PointF{xpos[gate], ypos[gate]} << "\n";
     }
     ofile.close();
 #endif
@@ -268,28 +236,68 @@ void Placer::placeRegion(ChipDB::Netlist &netlist, PlacementRegion &region)
     //if (fixups != 0) std::cout << "  Number of gate fixups: " << fixups << "\n";
 }
 
+void Placer::applySolution(PlacementRegion &region)
+{
+    assert(region.m_solution.size() == region.m_gatesInRegion.size());
+    for(std::size_t index = 0; index < region.m_solution.size(); index++)
+    {
+        auto const gate = region.m_gatesInRegion[index];
+        m_netlist.m_x[gate] = region.m_solution[index].m_x;
+        m_netlist.m_y[gate] = region.m_solution[index].m_y;
+    }
+    region.m_solution.clear();
+}
+
+std::unique_ptr<Placer::SolverWorkspace> Placer::acquireWorkspace()
+{
+    std::lock_guard<std::mutex> guard(m_workspaceMutex);
+    if (m_workspaces.empty())
+    {
+        return std::make_unique<SolverWorkspace>();
+    }
+
+    auto ws = std::move(m_workspaces.back());
+    m_workspaces.pop_back();
+    return ws;
+}
+
+void Placer::releaseWorkspace(std::unique_ptr<SolverWorkspace> ws)
+{
+    std::lock_guard<std::mutex> guard(m_workspaceMutex);
+    m_workspaces.push_back(std::move(ws));
+}
+
 void Placer::populateGatePositions(const ChipDB::Netlist &netlist, ChipDB::Floorplan &floorplan)
 {
-    m_gatePositions.clear();
-    m_gatePositions.reserve(netlist.m_instances.size());
+    // the compact netlist starts with all gates at their current position
+    m_netlist.build(netlist);
+    m_capacityMap.build(floorplan, netlist);
 
-    for(auto const& insKeyPair : netlist.m_instances)
+    m_rowBoundaries.clear();
+    for(auto const& row : floorplan.rows())
     {
-        // We have to make sure the unplaced gates/instances are
-        // within the region so the placer doesn't flag them
-        // as pseud0 terminals.
-        // The placed gates/instances should remain where they are.
-        assert(insKeyPair.isValid());
-        if (insKeyPair->isFixed())
-        {
-            // keep fixed gates/instances where they are
-            m_gatePositions[insKeyPair.key()] = insKeyPair->getCenter();
-        }
-        else
+        m_rowBoundaries.push_back(row.m_rect.bottom());
+        m_rowBoundaries.push_back(row.m_rect.top());
+    }
+    std::sort(m_rowBoundaries.begin(), m_rowBoundaries.end());
+    m_rowBoundaries.erase(std::unique(m_rowBoundaries.begin(), m_rowBoundaries.end()), m_rowBoundaries.end());
+
+    m_siteOrigin = floorplan.coreRect().m_ll;
+    m_siteWidth  = floorplan.minimumCellSize().m_x;
+
+    // We have to make sure the unplaced gates/instances are
+    // within the region so the placer doesn't flag them
+    // as pseud0 terminals.
+    // The placed gates/instances should remain where they are.
+    const PointF coreCenter = floorplan.coreRect().center();
+    for(GateIndex gate = 0; gate < m_netlist.gateCount(); gate++)
+    {
+        if (!m_netlist.isFixed(gate))
         {
             // move all placable gates/instances to the center of the
             // region
-            m_gatePositions[insKeyPair.key()] = floorplan.coreRect().center();
+            m_netlist.m_x[gate] = coreCenter.m_x;
+            m_netlist.m_y[gate] = coreCenter.m_y;
         }
     }
 }
@@ -331,28 +339,54 @@ bool Placer::place(ChipDB::Netlist &netlist,
     auto &placementRegion = placementRegions.emplace_back(std::make_unique<PlacementRegion>());
 
     placementRegion->m_rect = floorplan.coreRect();
-    for(auto insKeyObjPair : netlist.m_instances)
+    placementRegion->m_capacity = m_capacityMap.capacity(placementRegion->m_rect);
+    for(GateIndex gate = 0; gate < m_netlist.gateCount(); gate++)
     {
-        if (!insKeyObjPair->isFixed())
+        if (!m_netlist.isFixed(gate))
         {
-            placementRegion->m_gatesInRegion.push_back(insKeyObjPair.key());
+            placementRegion->m_gatesInRegion.push_back(gate);
         }
     }
 
-    cycle(netlist, placementRegions);
+    m_solverStats.reset();
+
+    if (m_schedule == Schedule::REGION)
+    {
+        cycle(placementRegions);
+    }
+    else
+    {
+        cycleByLevel(placementRegions);
+    }
+
+    const std::size_t solves = m_solverStats.m_solves;
+    const std::size_t iterations = m_solverStats.m_iterations;
+    Logging::logInfo("CG solver: %lu solves, %lu iterations, %.1f iterations per solve\n",
+        solves, iterations, (solves > 0) ? static_cast<double>(iterations) / solves : 0.0);
+
+    if (m_solverStats.m_unconverged > 0)
+    {
+        Logging::logWarning("CG solver: %lu solves did not converge\n",
+            static_cast<std::size_t>(m_solverStats.m_unconverged));
+    }
+
+    if (m_solverStats.m_jacobiFallbacks > 0)
+    {
+        Logging::logWarning("CG solver: the IC(0) factorization failed for %lu solves, used the Jacobi preconditioner\n",
+            static_cast<std::size_t>(m_solverStats.m_jacobiFallbacks));
+    }
 
     // write back the new positions of placed gates
-    for(auto gateIdAndPos : m_gatePositions)
+    for(GateIndex gate = 0; gate < m_netlist.gateCount(); gate++)
     {
-        const auto gateId = gateIdAndPos.first;
-        const auto gateCenterPos = gateIdAndPos.second;
-        if (!netlist.m_instances.at(gateId)->isFixed())
+        if (!m_netlist.isFixed(gate))
         {
-            auto newLocation = gateCenterPos.toCoord64();
-            Logging::logVerbose("Ins %s -> pos %d,%d\n", netlist.m_instances.at(gateId)->name().c_str(),
+            auto &ins = netlist.m_instances.atRef(m_netlist.gateId(gate));
+            auto newLocation = PointF{m_netlist.m_x[gate], m_netlist.m_y[gate]}.toCoord64();
+            Logging::logVerbose("Ins %s -> pos %d,%d\n", ins.name().c_str(),
                 newLocation.m_x, newLocation.m_y);
-            netlist.m_instances.at(gateId)->setCenter(newLocation);
-            netlist.m_instances.at(gateId)->m_placementInfo = ChipDB::PlacementInfo::PLACED;
+            ins.setCenter(newLocation);
+            ins.m_placementInfo = ChipDB::PlacementInfo::PLACED;
         }
     }
 
@@ -365,150 +399,348 @@ bool Placer::place(ChipDB::Netlist &netlist,
         return false;
     }
 
+    Logging::logInfo("Running detailed placement\n");
+
+    LunaCore::DetailedPlacer detailedPlacer;
+    LunaCore::DetailedPlacer::Parameters detailedParams;
+    detailedParams.m_threads = m_threads;
+    if (!detailedPlacer.place(floorplan, netlist, detailedParams))
+    {
+        return false;
+    }
+
     auto hpwl = LunaCore::NetlistTools::calcHPWL(netlist);
     Logging::logInfo("HPWL = %f *1e6 nm\n", hpwl / 1.0e6);
 
     Logging::logInfo("Placement done\n");
-    //TODO: end-case placement
 
     return true;
 }
 
-void Placer::cycle(ChipDB::Netlist &netlist, std::deque<std::unique_ptr<PlacementRegion>> &regions)
+void Placer::cycle(std::deque<std::unique_ptr<PlacementRegion>> &regions)
 {
+    auto ws = acquireWorkspace();
+
     while(!regions.empty())
     {
         assert(regions.front());
 
-        //TODO: change this, it's ugly.
-        auto region = *regions.front().get();
+        // take ownership of the region so adding
+        // sub-regions to the deque doesn't affect it.
+        auto region = std::move(regions.front());
+        regions.pop_front();
 
-        placeRegion(netlist, region);
+        placeRegion(*region, *ws);
+        applySolution(*region);
 
         // see if we can sub-divide the region
-        if ((region.m_level < m_maxLevels) && (region.m_gatesInRegion.size() >= (m_minInstancesInRegion)))
+        if (canSubdivide(*region))
         {
-            // code to determine whether we do a vertical or horizontal cut
-            Direction cutDir = ((region.m_level % 2) == 0) ? Direction::VERTICAL : Direction::HORIZONTAL;
-
             // create new regions
-            regions.emplace_back(std::make_unique<PlacementRegion>());
-            auto &r1 = *(regions.back().get());
-            regions.emplace_back(std::make_unique<PlacementRegion>());
-            auto &r2 = *(regions.back().get());
+            auto &r1 = *regions.emplace_back(std::make_unique<PlacementRegion>());
+            auto &r2 = *regions.emplace_back(std::make_unique<PlacementRegion>());
 
-            r1.m_level = region.m_level + 1;
-            r2.m_level = region.m_level + 1;
+            subdivide(*region, r1, r2);
+        }
+    }
 
-            cutRegion(region, cutDir, r1, r2);
-            sortGates(region, cutDir);
+    releaseWorkspace(std::move(ws));
+}
 
-            const std::size_t threshold = region.m_gatesInRegion.size() / 2;
-            std::size_t counter = 0;
+void Placer::cycleByLevel(std::deque<std::unique_ptr<PlacementRegion>> &regions)
+{
+    const PoolSelection threads(m_threads);
+    auto *pool = threads.pool();
 
-#if 0
-            std::ofstream ofile("placer_pos.txt");
-            std::size_t index = 0;
-            for(auto gateId : region.m_gatesInRegion)
-            {
-                index++;
-                if (index == threshold)
-                {
-                    ofile << "**THRESHOLD**\n";
-                }
-                ofile << "Gate " << gateId << " pos: " << m_gatePositions.at(gateId) << "\n";
-            }
-            ofile.close();
-#endif
+    Logging::logInfo("Placing regions using %d threads\n", (pool != nullptr) ? static_cast<int>(pool->threadCount()) : 1);
 
-            // figure out where the cut line is
-            double cutPosition = 0.0f;
-            auto cutGateId = region.m_gatesInRegion.at(threshold);
-            auto const& cutPos = m_gatePositions.at(cutGateId);
+    // the regions of one level only read the gate positions while they are placed,
+    // their solutions are applied and the regions are subdivided in-order
+    // afterwards. This makes the result independent of the number of threads.
+    std::vector<std::unique_ptr<PlacementRegion> > level;
+    while(!regions.empty())
+    {
+        level.emplace_back(std::move(regions.front()));
+        regions.pop_front();
+    }
 
-            if (cutDir == Direction::HORIZONTAL)
-            {
-                Logging::logInfo("  cut position at x=%f\n", cutPos.m_x);
-                cutPosition = cutPos.m_x;
-            }
-            else
+    while(!level.empty())
+    {
+        threads.forEach(0, level.size(), [this, pool, &level](std::size_t index)
             {
-                Logging::logInfo("  cut position at y=%f\n", cutPos.m_y);
-                cutPosition = cutPos.m_y;
+                auto ws = acquireWorkspace();
+                placeRegion(*level[index], *ws, pool);
+                releaseWorkspace(std::move(ws));
             }
+        );
 
-            // FIXME: distribute according to r1 and r2 capacities
+        std::vector<std::unique_ptr<PlacementRegion> > nextLevel;
+        for(auto &region : level)
+        {
+            applySolution(*region);
 
-            for(auto gateId : region.m_gatesInRegion)
+            if (canSubdivide(*region))
             {
-                assert(!netlist.m_instances.at(gateId)->isFixed()); // cppcheck-suppress[assertWithSideEffect]
+                auto &r1 = *nextLevel.emplace_back(std::make_unique<PlacementRegion>());
+                auto &r2 = *nextLevel.emplace_back(std::make_unique<PlacementRegion>());
 
-                if (counter < threshold)
-                {
-                    r2.m_gatesInRegion.push_back(gateId);
-                    m_gatePositions.at(gateId) = r2.center();
-                }
-                else
-                {
-                    r1.m_gatesInRegion.push_back(gateId);
-                    m_gatePositions.at(gateId) = r1.center();
-                }
-                counter++;
+                subdivide(*region, r1, r2);
             }
-            assert(r1.m_gatesInRegion.size() > 0);
-            assert(r2.m_gatesInRegion.size() > 0);
         }
 
-        regions.pop_front();
+        level = std::move(nextLevel);
     }
 }
 
+bool Placer::canSubdivide(const PlacementRegion &region) const noexcept
+{
+    // each sub-region must receive at least one gate
+    return (region.m_level < m_maxLevels) && (region.m_gatesInRegion.size() >= m_minInstancesInRegion)
+        && (region.m_gatesInRegion.size() >= 2);
+}
+
+void Placer::subdivide(PlacementRegion &region, PlacementRegion &r1, PlacementRegion &r2)
+{
+    // code to determine whether we do a vertical or horizontal cut
+    Direction cutDir = ((region.m_level % 2) == 0) ? Direction::VERTICAL : Direction::HORIZONTAL;
+
+    r1.m_level = region.m_level + 1;
+    r2.m_level = region.m_level + 1;
+
+    cutRegion(region, cutDir, r1, r2);
+    sortGates(region, cutDir);
+
+    // r2 is the left/lower part of the region, it receives the gates
+    // with the lowest coordinates.
+    std::size_t threshold = region.m_gatesInRegion.size() / 2;
+    if (m_cutMode == CutMode::DENSITY)
+    {
+        threshold = splitByArea(region, r2.m_capacity, r1.m_capacity);
+    }
+
+    std::size_t counter = 0;
+
+#if 0
+    std::ofstream ofile("placer_pos.txt");
+    std::size_t index = 0;
+    for(auto gate : region.m_gatesInRegion)
+    {
+        index++;
+        if (index == threshold)
+        {
+            ofile << "**THRESHOLD**\n";
+        }
+        ofile << "Gate " << m_netlist.gateId(gate) << " pos: " << PointF{m_netlist.m_x[gate], m_netlist.m_y[gate]} << "\n";
+    }
+    ofile.close();
+#endif
+
+    const PointF r1Center = r1.center();
+    const PointF r2Center = r2.center();
+
+    for(auto gate : region.m_gatesInRegion)
+    {
+        assert(!m_netlist.isFixed(gate));
+
+        if (counter < threshold)
+        {
+            r2.m_gatesInRegion.push_back(gate);
+            m_netlist.m_x[gate] = r2Center.m_x;
+            m_netlist.m_y[gate] = r2Center.m_y;
+        }
+        else
+        {
+            r1.m_gatesInRegion.push_back(gate);
+            m_netlist.m_x[gate] = r1Center.m_x;
+            m_netlist.m_y[gate] = r1Center.m_y;
+        }
+        counter++;
+    }
+
+    assert(r1.m_gatesInRegion.size() > 0);
+    assert(r2.m_gatesInRegion.size() > 0);
+}
+
+std::size_t Placer::splitByArea(const PlacementRegion &region,
+    double lowerCapacity, double upperCapacity) const
+{
+    auto const& gates = region.m_gatesInRegion;
+    const double totalCapacity = lowerCapacity + upperCapacity;
+    if (totalCapacity <= 0.0)
+    {
+        return gates.size() / 2;
+    }
+
+    const double fraction = lowerCapacity / totalCapacity;
+
+    double totalArea = 0.0;
+    for(auto gate : gates)
+    {
+        totalArea += m_netlist.m_area[gate];
+    }
+
+    // a gate goes to the lower region when the middle of
+    // its area lies below the target area. Gates without
+    // area are divided by count.
+    const bool byCount = (totalArea <= 0.0);
+    const double targetArea = byCount ? fraction * gates.size() : fraction * totalArea;
+    double cumulativeArea = 0.0;
+    std::size_t count = 0;
+    while(count < gates.size())
+    {
+        const double area = byCount ? 1.0 : m_netlist.m_area[gates[count]];
+        if ((cumulativeArea + 0.5*area) > targetArea)
+        {
+            break;
+        }
+        cumulativeArea += area;
+        count++;
+    }
+
+    // don't leave a sub-region empty
+    if (gates.size() >= 2)
+    {
+        count = std::clamp<std::size_t>(count, 1, gates.size() - 1);
+    }
+
+    return count;
+}
+
 void Placer::sortGates(PlacementRegion &region, Direction dir)
 {
-    // sort gates according to y
-    if (dir == Direction::VERTICAL)
+    // a vertical cut line separates the gates by x
+    if (dir == Direction::HORIZONTAL)
     {
+        auto const& ypos = m_netlist.m_y;
         std::sort(region.m_gatesInRegion.begin(), region.m_gatesInRegion.end(),
-            [this](GateId gateId1, GateId gateId2)
+            [&ypos](GateIndex gate1, GateIndex gate2)
             {
-                return m_gatePositions.at(gateId1).m_y < m_gatePositions.at(gateId2).m_y;
+                return ypos[gate1] < ypos[gate2];
             }
         );
     }
     else
     {
         // sort gates according to x
+        auto const& xpos = m_netlist.m_x;
         std::sort(region.m_gatesInRegion.begin(), region.m_gatesInRegion.end(),
-            [this](GateId gateId1, GateId gateId2)
+            [&xpos](GateIndex gate1, GateIndex gate2)
             {
-                return m_gatePositions.at(gateId1).m_x < m_gatePositions.at(gateId2).m_x;
+                return xpos[gate1] < xpos[gate2];
             }
         );
     }
 }
 
+ChipDB::CoordType Placer::findCutPosition(const PlacementRegion &region, Direction dir) const
+{
+    const bool vertical = (dir == Direction::VERTICAL);
+    auto const& rect = region.m_rect;
+
+    const ChipDB::CoordType lo = vertical ? rect.left()  : rect.bottom();
+    const ChipDB::CoordType hi = vertical ? rect.right() : rect.top();
+    const ChipDB::CoordType center = vertical ? region.center().m_x : region.center().m_y;
+
+    const double capacity = m_capacityMap.capacity(rect);
+    if ((capacity <= 0.0) || ((hi - lo) < 2))
+    {
+        return center;
+    }
+
+    auto lowerCapacity = [&](ChipDB::CoordType cut)
+    {
+        auto lowerRect = rect;
+        if (vertical)
+        {
+            lowerRect.m_ur.m_x = cut;
+        }
+        else
+        {
+            lowerRect.m_ur.m_y = cut;
+        }
+        return m_capacityMap.capacity(lowerRect);
+    };
+
+    // find the smallest cut that has half the capacity on the lower side
+    ChipDB::CoordType a = lo;
+    ChipDB::CoordType b = hi;
+    while((b - a) > 1)
+    {
+        auto const mid = a + (b - a) / 2;
+        if (lowerCapacity(mid) < 0.5*capacity)
+        {
+            a = mid;
+        }
+        else
+        {
+            b = mid;
+        }
+    }
+
+    ChipDB::CoordType cut = b;
+
+    // snap horizontal cuts to the nearest row boundary
+    // and vertical cuts to the site grid.
+    if (!vertical)
+    {
+        auto iter = std::lower_bound(m_rowBoundaries.begin(), m_rowBoundaries.end(), cut);
+        ChipDB::CoordType best = cut;
+        ChipDB::CoordType bestDistance = std::numeric_limits<ChipDB::CoordType>::max();
+        if ((iter != m_rowBoundaries.end()) && (*iter < hi))
+        {
+            best = *iter;
+            bestDistance = *iter - cut;
+        }
+        if ((iter != m_rowBoundaries.begin()) && (*std::prev(iter) > lo) && ((cut - *std::prev(iter)) < bestDistance))
+        {
+            best = *std::prev(iter);
+        }
+        cut = best;
+    }
+    else if (m_siteWidth > 0)
+    {
+        auto const sites = std::llround(static_cast<double>(cut - m_siteOrigin.m_x) / m_siteWidth);
+        auto const snapped = m_siteOrigin.m_x + sites * m_siteWidth;
+        if ((snapped > lo) && (snapped < hi))
+        {
+            cut = snapped;
+        }
+    }
+
+    return cut;
+}
+
 void Placer::cutRegion(const PlacementRegion &region, Direction dir,
     PlacementRegion &region1, PlacementRegion &region2) const
 {
     region1.m_rect = region.m_rect;
     region2.m_rect = region.m_rect;
 
+    ChipDB::CoordType cut = 0;
+    if (m_cutMode == CutMode::DENSITY)
+    {
+        cut = findCutPosition(region, dir);
+    }
+    else
+    {
+        cut = (dir == Direction::VERTICAL) ? region.center().m_x : region.center().m_y;
+    }
+
     if (dir == Direction::VERTICAL)
     {
-        region1.m_rect.m_ll.m_x = region.center().m_x;
-        region2.m_rect.m_ur.m_x = region1.m_rect.m_ll.m_x;
-        std::cout << "Cut along vertical axis\n";
+        region1.m_rect.m_ll.m_x = cut;
+        region2.m_rect.m_ur.m_x = cut;
+        Logging::logVerbose("Cut along vertical axis at x=%ld\n", cut);
     }
     else
     {
-        region1.m_rect.m_ll.m_y = region.center().m_y;
-        region2.m_rect.m_ur.m_y = region1.m_rect.m_ll.m_y;
-        std::cout << "Cut along horizontal axis\n";
+        region1.m_rect.m_ll.m_y = cut;
+        region2.m_rect.m_ur.m_y = cut;
+        Logging::logVerbose("Cut along horizontal axis at y=%ld\n", cut);
     }
-    std::cout << "  P1: (" << region1.m_rect.m_ll.m_x << "," << region1.m_rect.m_ll.m_y << ") ";
-    std::cout << " W " << region1.width() << "  H " << region1.height() << "\n";
-    std::cout << "  P2: (" << region2.m_rect.m_ll.m_x << "," << region2.m_rect.m_ll.m_y << ") ";
-    std::cout << " W " << region2.width() << "  H " << region2.height() << "\n";
+
+    region1.m_capacity = m_capacityMap.capacity(region1.m_rect);
+    region2.m_capacity = m_capacityMap.capacity(region2.m_rect);
 }
 
 PointF Placer::propagate(const PlacementRegion &r, const PointF &p) const
@@ -3,18 +3,21 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #pragma once
-#include <unordered_map>
 #include <deque>
 #include <memory>
+#include <mutex>
+#include <atomic>
 
 #include "database/database.h"
 #include "algebra/algebra.hpp"
+#include "common/threadpool.h"
+#include "compactnetlist.h"
+#include "capacitymap.h"
 
 namespace LunaCore::CellPlacer2
 {
 
 using NetId  = ChipDB::NetObjectKey;
-using GateId = ChipDB::InstanceObjectKey;
 
 struct PointF
 {
@@ -40,7 +43,7 @@ struct PointF
 struct PlacementRegion
 {
     ChipDB::Rect64 m_rect;
-    double         m_capacity;
+    double         m_capacity{0};   ///< area available to movable cells in nm²
 
     constexpr ChipDB::CoordType width() const noexcept
     {
@@ -82,7 +85,12 @@ struct PlacementRegion
 
     int m_level{0}; ///< subdivision level
 
-    std::vector<GateId> m_gatesInRegion;
+    std::vector<GateIndex> m_gatesInRegion;    ///< gates in the compact netlist
+
+    /** new gate positions calculated by Placer::placeRegion, in the same
+     *  order as m_gatesInRegion. These are written back by Placer::applySolution.
+    */
+    std::vector<PointF> m_solution;
 };
 
 class Placer
@@ -101,29 +109,103 @@ public:
     [[nodiscard]] bool place(ChipDB::Netlist &netlist, ChipDB::Floorplan &floorplan,
         std::size_t maxLevels, std::size_t minInstances);
 
+    enum class Schedule
+    {
+        REGION, ///< place the regions one after the other, each region sees the solutions of the regions before it
+        LEVEL   ///< place all regions of a subdivision level using the positions from the previous level
+    };
+
+    /** select the order in which the regions are placed.
+     *
+     *  REGION is the default. In LEVEL mode the regions of a level don't
+     *  depend on each other, so they are placed concurrently and the
+     *  x and y systems of a region are solved at the same time when
+     *  the thread count allows it.
+    */
+    void setSchedule(Schedule schedule) noexcept
+    {
+        m_schedule = schedule;
+    }
+
+    [[nodiscard]] constexpr Schedule schedule() const noexcept
+    {
+        return m_schedule;
+    }
+
+    /** set the number of threads used by the LEVEL schedule and by the
+     *  detailed placer, see PoolSelection. The placement does not
+     *  depend on the thread count.
+    */
+    void setThreadCount(std::size_t threads) noexcept
+    {
+        m_threads = threads;
+    }
+
+    [[nodiscard]] constexpr std::size_t threadCount() const noexcept
+    {
+        return m_threads;
+    }
+
+    enum class CutMode
+    {
+        GEOMETRIC,  ///< cut regions in half and split the gates by count
+        DENSITY     ///< cut regions where the available row area is balanced and split the gates by area
+    };
+
+    /** select how regions are subdivided.
+     *
+     *  GEOMETRIC is the default. In DENSITY mode the cut line is placed so both
+     *  sub-regions have the same area available for movable cells,
+     *  taking into account the rows and the fixed cells. The gates are
+     *  then divided so the cell area of each sub-region is proportional
+     *  to its available area.
+    */
+    void setCutMode(CutMode mode) noexcept
+    {
+        m_cutMode = mode;
+    }
+
+    [[nodiscard]] constexpr CutMode cutMode() const noexcept
+    {
+        return m_cutMode;
+    }
+
 protected:
     using RowIndex = uint32_t;
-    using GateToRowContainer = std::unordered_map<GateId, RowIndex>;
-    using GatePosContainer   = std::unordered_map<GateId, PointF>;
+    static constexpr RowIndex InvalidRow = static_cast<RowIndex>(-1);
+
+    struct SolverWorkspace;
 
     /** place the cells/gates/instances in the PlacementRegion using
-     *  quadratic placement and update the location of them in the netlist instances.
-     *  cells/gates/instances outside the PlacementRegion are not affected.
+     *  quadratic placement and store their new locations in region.m_solution.
+     *  The gate positions are only read, so regions can be placed concurrently.
+     *  When a pool is given, the x and y systems are solved in parallel.
     */
-    void placeRegion(ChipDB::Netlist &netlist, PlacementRegion &region);
+    void placeRegion(PlacementRegion &region, SolverWorkspace &ws, ThreadPool *pool = nullptr);
+
+    /** write the solution of placeRegion into the gate positions */
+    void applySolution(PlacementRegion &region);
 
-    void cycle(ChipDB::Netlist &netlist, std::deque<std::unique_ptr<PlacementRegion>> &regions);
+    /** place the regions one by one, subdividing them as we go */
+    void cycle(std::deque<std::unique_ptr<PlacementRegion>> &regions);
 
-    [[nodiscard]] RowIndex findRowOfGate(const GateToRowContainer &gate2Row,
-        const GateId gateId) const noexcept;
+    /** place all regions of a subdivision level, concurrently if a pool is selected */
+    void cycleByLevel(std::deque<std::unique_ptr<PlacementRegion>> &regions);
+
+    /** returns true if the region should be subdivided further */
+    [[nodiscard]] bool canSubdivide(const PlacementRegion &region) const noexcept;
+
+    /** cut the region in two and distribute its gates over r1 and r2 */
+    void subdivide(PlacementRegion &region, PlacementRegion &r1, PlacementRegion &r2);
 
     [[nodiscard]] PointF propagate(const PlacementRegion &region, const PointF &p) const;
 
     /** assign each instance/gate a row in the quadratic placement matrix */
-    void mapGatesToMatrixRows(const ChipDB::Netlist &netlist,
-        const PlacementRegion &r,
-        GateToRowContainer &gate2Row);
+    void mapGatesToMatrixRows(const PlacementRegion &r, SolverWorkspace &ws) const;
 
+    /** build the compact netlist and the capacity map,
+     *  and move the movable gates to the core center.
+    */
     void populateGatePositions(const ChipDB::Netlist &netlist, ChipDB::Floorplan &floorplan);
 
     enum class Direction
@@ -136,7 +218,81 @@ protected:
     void cutRegion(const PlacementRegion &region, Direction dir,
         PlacementRegion &region1, PlacementRegion &region2) const;
 
-    GatePosContainer m_gatePositions;
+    /** return the cut coordinate that divides the available area of
+     *  the region in half, snapped to a row boundary or the site grid.
+    */
+    [[nodiscard]] ChipDB::CoordType findCutPosition(const PlacementRegion &region, Direction dir) const;
+
+    /** return the number of sorted gates that go to the lower/left sub-region
+     *  so the cell area is divided in proportion to the capacities.
+     *  A region with two or more gates leaves at least one gate on each side.
+    */
+    [[nodiscard]] std::size_t splitByArea(const PlacementRegion &region,
+        double lowerCapacity, double upperCapacity) const;
+
+    /** matrices, vectors and solver state that are re-used by
+     *  every region so the region solves don't allocate memory
+     *  once the first (and largest) region has been solved.
+    */
+    struct SolverWorkspace
+    {
+        std::vector<RowIndex>           m_gateToRow;    ///< gate index -> matrix row or InvalidRow
+        Algebra::TripletBuilder<float>  m_Abuilder;
+        Algebra::CSRMatrix<float>       m_Amat;
+        Algebra::Vector<float>          m_Bvec_x;
+        Algebra::Vector<float>          m_Bvec_y;
+        Algebra::Vector<float>          m_xvec;
+        Algebra::Vector<float>          m_yvec;
+        Algebra::CGSolver::IC0Preconditioner<float> m_precond;
+        Algebra::CGSolver::Solver<float> m_solverX;
+        Algebra::CGSolver::Solver<float> m_solverY;
+    };
+
+    /** hand out workspaces to concurrently placed regions.
+     *  the number of workspaces grows to the maximum concurrency.
+    */
+    [[nodiscard]] std::unique_ptr<SolverWorkspace> acquireWorkspace();
+    void releaseWorkspace(std::unique_ptr<SolverWorkspace> ws);
+
+    /** conjugate gradient statistics of a place() run */
+    struct SolverStats
+    {
+        std::atomic<std::size_t> m_solves{0};
+        std::atomic<std::size_t> m_iterations{0};
+        std::atomic<std::size_t> m_unconverged{0};
+        std::atomic<std::size_t> m_jacobiFallbacks{0};
+
+        void reset() noexcept
+        {
+            m_solves = 0;
+            m_iterations = 0;
+            m_unconverged = 0;
+            m_jacobiFallbacks = 0;
+        }
+
+        void add(const Algebra::ComputeInfo &info) noexcept
+        {
+            m_solves++;
+            m_iterations += info.m_iterations;
+            if (!info.m_converged) m_unconverged++;
+            if (info.m_jacobiFallback) m_jacobiFallbacks++;
+        }
+    };
+
+    SolverStats      m_solverStats;
+    std::mutex       m_workspaceMutex;
+    std::vector<std::unique_ptr<SolverWorkspace> > m_workspaces;
+
+    CompactNetlist   m_netlist;     ///< connectivity and positions of the gates
+    CapacityMap      m_capacityMap;
+
+    std::vector<ChipDB::CoordType> m_rowBoundaries; ///< sorted y coordinates of the row edges
+    ChipDB::Coord64   m_siteOrigin;
+    ChipDB::CoordType m_siteWidth{0};
+
+    CutMode     m_cutMode{CutMode::GEOMETRIC};
+    Schedule    m_schedule{Schedule::REGION};
+    std::size_t m_threads{1};
     std::size_t m_maxLevels{0};
     std::size_t m_minInstancesInRegion{0};
 };
@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+#include "common/logging.h"
+#include "compactnetlist.h"
+
+using namespace LunaCore::CellPlacer2;
+
+void CompactNetlist::build(const ChipDB::Netlist &netlist)
+{
+    // number the gates
+    m_gateIds.clear();
+    m_fixed.clear();
+    m_keyToGate.clear();
+    m_x.clear();
+    m_y.clear();
+    m_area.clear();
+
+    m_gateIds.reserve(netlist.m_instances.size());
+    for(auto const& insKeyObjPair : netlist.m_instances)
+    {
+        auto const key = insKeyObjPair.key();
+        if (static_cast<std::size_t>(key) >= m_keyToGate.size())
+        {
+            m_keyToGate.resize(key + 1, InvalidGate);
+        }
+        m_keyToGate[key] = static_cast<GateIndex>(m_gateIds.size());
+
+        auto const center = insKeyObjPair->getCenter();
+        m_gateIds.push_back(key);
+        m_fixed.push_back(insKeyObjPair->isFixed() ? 1 : 0);
+        m_x.push_back(static_cast<float>(center.m_x));
+        m_y.push_back(static_cast<float>(center.m_y));
+
+        auto const size = insKeyObjPair->instanceSize();
+        m_area.push_back(static_cast<double>(size.m_x) * static_cast<double>(size.m_y));
+    }
+
+    // number the nets that have two or more connections
+    // and build the net -> gate adjacency
+    std::vector<NetIndex> netKeyToIndex;
+    m_netGatePtr.assign(1, 0);
+    m_netGates.clear();
+    m_netWeight.clear();
+
+    for(auto const& netKeyObjPair : netlist.m_nets)
+    {
+        auto const key = netKeyObjPair.key();
+        if (static_cast<std::size_t>(key) >= netKeyToIndex.size())
+        {
+            netKeyToIndex.resize(key + 1, static_cast<NetIndex>(-1));
+        }
+
+        auto const& net = *netKeyObjPair;
+        auto const first = m_netGates.size();
+        for(auto const& netConnect : net)
+        {
+            auto const gate = gateIndex(netConnect.m_instanceKey);
+            if (gate == InvalidGate)
+            {
+                continue;
+            }
+
+            // skip power and ground pins, like the gate -> net adjacency
+            auto const pin = netlist.m_instances.atRef(netConnect.m_instanceKey).getPin(netConnect.m_pinKey);
+            if ((pin.m_pinInfo) && (pin.m_pinInfo->isPGPin()))
+            {
+                continue;
+            }
+
+            m_netGates.push_back(gate);
+        }
+
+        auto const connections = m_netGates.size() - first;
+        if (connections <= 1)
+        {
+            m_netGates.resize(first);
+            continue;
+        }
+
+        netKeyToIndex[key] = static_cast<NetIndex>(m_netWeight.size());
+        m_netWeight.push_back(1.0f/(static_cast<float>(connections) - 1.0f));
+        m_netGatePtr.push_back(static_cast<uint32_t>(m_netGates.size()));
+    }
+
+    // build the gate -> net adjacency
+    m_gateNetPtr.assign(1, 0);
+    m_gateNets.clear();
+
+    for(auto const gateId : m_gateIds)
+    {
+        auto const& gate = netlist.m_instances.atRef(gateId);
+
+        std::size_t pinIndex = 0;
+        for(auto netId : gate.connections())
+        {
+            // skip power and ground pins
+            auto const pin = gate.getPin(pinIndex++);
+            if ((pin.m_pinInfo) && (pin.m_pinInfo->isPGPin()))
+            {
+                continue;
+            }
+
+            if (netId == ChipDB::ObjectNotFound)
+            {
+                if (!isFixed(gateIndex(gateId)))
+                {
+                    Logging::logWarning("Net left unconnected on instance %s\n", gate.name().c_str());
+                }
+                continue;
+            }
+
+            auto const netIndex = (static_cast<std::size_t>(netId) < netKeyToIndex.size()) ?
+                netKeyToIndex[netId] : static_cast<NetIndex>(-1);
+
+            if (netIndex == static_cast<NetIndex>(-1))
+            {
+                if (!isFixed(gateIndex(gateId)))
+                {
+                    Logging::logWarning("Net %s has 1 or fewer connections!\n",
+                        netlist.m_nets.atRef(netId).name().c_str());
+                }
+                continue;
+            }
+
+            m_gateNets.push_back(netIndex);
+        }
+        m_gateNetPtr.push_back(static_cast<uint32_t>(m_gateNets.size()));
+    }
+}
@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <span>
+
+#include "database/database.h"
+
+namespace LunaCore::CellPlacer2
+{
+
+using GateId    = ChipDB::InstanceObjectKey;
+using GateIndex = uint32_t;
+using NetIndex  = uint32_t;
+
+/** A read-mostly copy of a ChipDB::Netlist for the placer.
+ *
+ *  Gates and nets are numbered densely from 0, the connectivity is
+ *  stored in CSR form and the gate positions are stored as separate
+ *  x and y arrays. It is built once per placement so the inner loops
+ *  of the placer don't need any hash lookups.
+ *
+ *  Only signal connections are kept: power/ground pins, unconnected
+ *  pins and nets with fewer than two connections are skipped.
+*/
+class CompactNetlist
+{
+public:
+    static constexpr GateIndex InvalidGate = static_cast<GateIndex>(-1);
+
+    /** build the compact netlist from a ChipDB::Netlist.
+     *  all gate positions are set to the center of the gates.
+    */
+    void build(const ChipDB::Netlist &netlist);
+
+    /** return the number of gates, fixed and movable */
+    [[nodiscard]] std::size_t gateCount() const noexcept
+    {
+        return m_gateIds.size();
+    }
+
+    /** return the number of nets */
+    [[nodiscard]] std::size_t netCount() const noexcept
+    {
+        return m_netWeight.size();
+    }
+
+    /** return the ChipDB instance key of a gate */
+    [[nodiscard]] GateId gateId(GateIndex gate) const noexcept
+    {
+        return m_gateIds[gate];
+    }
+
+    /** return the gate index of a ChipDB instance key or InvalidGate */
+    [[nodiscard]] GateIndex gateIndex(GateId gateId) const noexcept
+    {
+        if ((gateId < 0) || (static_cast<std::size_t>(gateId) >= m_keyToGate.size()))
+        {
+            return InvalidGate;
+        }
+        return m_keyToGate[gateId];
+    }
+
+    [[nodiscard]] bool isFixed(GateIndex gate) const noexcept
+    {
+        return m_fixed[gate] != 0;
+    }
+
+    /** return the nets connected to a gate, one entry per signal pin */
+    [[nodiscard]] std::span<const NetIndex> gateNets(GateIndex gate) const noexcept
+    {
+        return {m_gateNets.data() + m_gateNetPtr[gate], m_gateNets.data() + m_gateNetPtr[gate+1]};
+    }
+
+    /** return the gates connected to a net, one entry per connection */
+    [[nodiscard]] std::span<const GateIndex> netGates(NetIndex net) const noexcept
+    {
+        return {m_netGates.data() + m_netGatePtr[net], m_netGates.data() + m_netGatePtr[net+1]};
+    }
+
+    /** return the clique model weight 1/(connections-1) of a net */
+    [[nodiscard]] float netWeight(NetIndex net) const noexcept
+    {
+        return m_netWeight[net];
+    }
+
+    std::vector<float>  m_x;        ///< x position of the gate centers
+    std::vector<float>  m_y;        ///< y position of the gate centers
+    std::vector<double> m_area;     ///< area of the gates in nm²
+
+protected:
+    std::vector<GateId>     m_gateIds;      ///< gate index -> instance key
+    std::vector<GateIndex>  m_keyToGate;    ///< instance key -> gate index
+    std::vector<uint8_t>    m_fixed;
+
+    std::vector<uint32_t>   m_gateNetPtr;   ///< CSR row offsets of m_gateNets
+    std::vector<NetIndex>   m_gateNets;
+
+    std::vector<uint32_t>   m_netGatePtr;   ///< CSR row offsets of m_netGates
+    std::vector<GateIndex>  m_netGates;
+    std::vector<float>      m_netWeight;
+};
+
+};
@@ -184,14 +184,19 @@ bool FillerHandler::fillSpaceWithFillers(const ChipDB::Design &design,
             std::stringstream ss;
             ss << "_filler_" << m_fillerID++;
 
-            auto fillerInstance = std::make_shared<ChipDB::Instance>(ss.str(),
+            auto fillerInstance = netlist.createInstance(ss.str(),
                 ChipDB::InstanceType::CELL,
                 cellPtr);
 
+            if (!fillerInstance.isValid())
+            {
+                Logging::logError("FillerHandler cannot create filler %s\n", ss.str().c_str());
+                return false;
+            }
+
             fillerInstance->m_pos = currentPos;
             fillerInstance->m_placementInfo = ChipDB::PlacementInfo::PLACED;
 
-            netlist.m_instances.add(fillerInstance);
             const auto x_delta = fillerInstance->instanceSize().m_x;
             spaceRemaining -= x_delta;
             currentPos.m_x += x_delta;
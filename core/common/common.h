@@ -13,3 +13,5 @@
 #include "tomlhelpers.h"
 #include "objectptr.hpp"
 #include "gds2defs.hpp"
+#include "threadpool.h"
+#include "mappedfile.h"
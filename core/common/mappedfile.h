@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace LunaCore
+{
+
+/** Read-only view of the contents of a file.
+ *  The file is memory mapped where the platform supports it,
+ *  otherwise it is read into memory. The view stays valid for
+ *  the lifetime of the MappedFile.
+*/
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /** returns true if the file could be opened and read */
+    [[nodiscard]] bool good() const noexcept
+    {
+        return m_good;
+    }
+
+    [[nodiscard]] std::string_view view() const noexcept
+    {
+        return {m_data, m_size};
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+protected:
+    const char  *m_data{nullptr};
+    std::size_t  m_size{0};
+    bool         m_good{false};
+    bool         m_mapped{false};
+    std::string  m_buffer;  ///< file contents when the file is not mapped
+};
+
+};
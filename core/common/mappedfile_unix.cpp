@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "mappedfile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+LunaCore::MappedFile::MappedFile(const std::string &filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat info{};
+    if ((::fstat(fd, &info) != 0) || !S_ISREG(info.st_mode))
+    {
+        ::close(fd);
+        return;
+    }
+
+    m_size = static_cast<std::size_t>(info.st_size);
+    if (m_size == 0)
+    {
+        // an empty file cannot be mapped
+        ::close(fd);
+        m_good = true;
+        return;
+    }
+
+    void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        m_size = 0;
+        return;
+    }
+
+    // the parsers read the file from start to end
+    ::madvise(data, m_size, MADV_SEQUENTIAL);
+
+    m_data   = static_cast<const char*>(data);
+    m_mapped = true;
+    m_good   = true;
+}
+
+LunaCore::MappedFile::~MappedFile()
+{
+    if (m_mapped)
+    {
+        ::munmap(const_cast<char*>(m_data), m_size);
+    }
+}
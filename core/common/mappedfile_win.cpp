@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "mappedfile.h"
+
+#include <fstream>
+#include <iterator>
+
+LunaCore::MappedFile::MappedFile(const std::string &filename)
+{
+    std::ifstream ifile(filename, std::ios::binary);
+    if (!ifile.good()) return;
+
+    m_buffer.assign(std::istreambuf_iterator<char>(ifile), std::istreambuf_iterator<char>());
+    if (ifile.bad()) return;
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    m_good = true;
+}
+
+LunaCore::MappedFile::~MappedFile() = default;
@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+#include <charconv>
+#include <concepts>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace LunaCore
+{
+
+/** Append-only text buffer for writers of large files.
+ *
+ *  Numbers are formatted with std::to_chars, which doesn't use the
+ *  locale or allocate. Floating point numbers are written like
+ *  std::ostream does by default: 6 significant digits, in fixed or
+ *  scientific notation, whichever is shorter.
+*/
+class TextBuffer
+{
+public:
+    TextBuffer() = default;
+
+    void reserve(std::size_t bytes)
+    {
+        m_text.reserve(bytes);
+    }
+
+    void clear() noexcept
+    {
+        m_text.clear();
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return m_text.size();
+    }
+
+    [[nodiscard]] std::string_view view() const noexcept
+    {
+        return m_text;
+    }
+
+    TextBuffer& operator<<(std::string_view text)
+    {
+        m_text.append(text);
+        return *this;
+    }
+
+    TextBuffer& operator<<(const char *text)
+    {
+        m_text.append(text);
+        return *this;
+    }
+
+    TextBuffer& operator<<(char c)
+    {
+        m_text.push_back(c);
+        return *this;
+    }
+
+    template<std::integral T>
+    TextBuffer& operator<<(T value)
+    {
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        m_text.append(buffer, result.ptr);
+        return *this;
+    }
+
+    template<std::floating_point T>
+    TextBuffer& operator<<(T value)
+    {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+        m_text.append(buffer, result.ptr);
+        return *this;
+    }
+
+    /** write the contents to a stream and clear the buffer */
+    bool flush(std::ostream &os)
+    {
+        os.write(m_text.data(), static_cast<std::streamsize>(m_text.size()));
+        m_text.clear();
+        return os.good();
+    }
+
+protected:
+    std::string m_text;
+};
+
+};
@@ -0,0 +1,358 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <stdexcept>
+#include "logging.h"
+#include "threadpool.h"
+
+using namespace LunaCore;
+
+namespace
+{
+    // the pool and worker index of the calling thread
+    thread_local const ThreadPool *tl_pool = nullptr;
+    thread_local std::ptrdiff_t    tl_workerIndex = -1;
+
+    // the pool shared by all core engines
+    std::mutex                              g_globalMutex;
+    std::unique_ptr<LunaCore::ThreadPool>   g_globalPool;
+    std::size_t                             g_globalThreads = 0;
+};
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+    if (threads == 0)
+    {
+        threads = hardwareThreads();
+    }
+
+    m_workers.reserve(threads);
+    for(std::size_t idx = 0; idx < threads; idx++)
+    {
+        m_workers.emplace_back(std::make_unique<Worker>());
+    }
+
+    // start the threads only after all workers exist
+    // so stealing never sees a partially built pool.
+    for(std::size_t idx = 0; idx < threads; idx++)
+    {
+        m_workers.at(idx)->m_thread = std::thread(&ThreadPool::workerLoop, this, idx);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wakeup.notify_all();
+
+    for(auto &worker : m_workers)
+    {
+        if (worker->m_thread.joinable())
+        {
+            worker->m_thread.join();
+        }
+    }
+}
+
+std::size_t ThreadPool::hardwareThreads() noexcept
+{
+    auto threads = std::thread::hardware_concurrency();
+    return (threads == 0) ? 1 : threads;
+}
+
+/** call with g_globalMutex held: destroy the shared pool if it is idle
+ *  and its thread count differs from the requested one.
+*/
+static void resetIdleGlobalPool()
+{
+    const auto threads = (g_globalThreads == 0) ? ThreadPool::hardwareThreads() : g_globalThreads;
+    if (g_globalPool && (g_globalPool->threadCount() != threads) && !g_globalPool->isBusy())
+    {
+        g_globalPool.reset();
+    }
+}
+
+ThreadPool& ThreadPool::global()
+{
+    std::lock_guard<std::mutex> guard(g_globalMutex);
+    resetIdleGlobalPool();
+    if (!g_globalPool)
+    {
+        g_globalPool = std::make_unique<ThreadPool>(g_globalThreads);
+        Logging::logVerbose("Created shared thread pool with %d threads\n",
+            static_cast<int>(g_globalPool->threadCount()));
+    }
+    return *g_globalPool;
+}
+
+void ThreadPool::setGlobalThreadCount(std::size_t threads)
+{
+    std::lock_guard<std::mutex> guard(g_globalMutex);
+    g_globalThreads = threads;
+    resetIdleGlobalPool();
+
+    if (g_globalPool && g_globalPool->isBusy())
+    {
+        Logging::logWarning("The shared thread pool is busy, the new thread count is used when it is idle.\n");
+    }
+}
+
+bool ThreadPool::isBusy() const
+{
+    std::lock_guard<std::mutex> guard(m_sleepMutex);
+    return (m_pendingTasks > 0) || (m_activeTasks > 0);
+}
+
+std::size_t ThreadPool::globalThreadCount()
+{
+    std::lock_guard<std::mutex> guard(g_globalMutex);
+    return (g_globalThreads == 0) ? hardwareThreads() : g_globalThreads;
+}
+
+std::ptrdiff_t ThreadPool::currentWorkerIndex() const noexcept
+{
+    if (tl_pool == this)
+    {
+        return tl_workerIndex;
+    }
+    return -1;
+}
+
+void ThreadPool::submit(Task task)
+{
+    auto workerIndex = currentWorkerIndex();
+    if (workerIndex < 0)
+    {
+        workerIndex = static_cast<std::ptrdiff_t>(m_nextWorker++ % m_workers.size());
+    }
+
+    // count the task before it can be taken, so the count never drops below zero
+    {
+        std::lock_guard<std::mutex> guard(m_sleepMutex);
+        m_pendingTasks++;
+    }
+
+    auto &worker = *m_workers.at(workerIndex);
+    {
+        std::lock_guard<std::mutex> guard(worker.m_mutex);
+        worker.m_tasks.push_back(std::move(task));
+    }
+    m_wakeup.notify_one();
+}
+
+bool ThreadPool::popTask(std::size_t workerIndex, Task &task)
+{
+    auto &worker = *m_workers.at(workerIndex);
+    std::lock_guard<std::mutex> guard(worker.m_mutex);
+    if (worker.m_tasks.empty())
+    {
+        return false;
+    }
+
+    task = std::move(worker.m_tasks.back());
+    worker.m_tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::stealTask(std::size_t thiefIndex, Task &task)
+{
+    const auto N = m_workers.size();
+    for(std::size_t offset = 1; offset <= N; offset++)
+    {
+        auto &victim = *m_workers.at((thiefIndex + offset) % N);
+        std::lock_guard<std::mutex> guard(victim.m_mutex);
+        if (!victim.m_tasks.empty())
+        {
+            task = std::move(victim.m_tasks.front());
+            victim.m_tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(Task &task) noexcept
+{
+    try
+    {
+        task();
+    }
+    catch(const std::exception &e)
+    {
+        Logging::logError("ThreadPool: task threw an exception: %s\n", e.what());
+    }
+    catch(...)
+    {
+        Logging::logError("ThreadPool: task threw an unknown exception\n");
+    }
+}
+
+bool ThreadPool::runPendingTask()
+{
+    Task task;
+    auto workerIndex = currentWorkerIndex();
+
+    bool found = false;
+    if (workerIndex >= 0)
+    {
+        found = popTask(workerIndex, task) || stealTask(workerIndex, task);
+    }
+    else
+    {
+        found = stealTask(m_nextWorker % m_workers.size(), task);
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_sleepMutex);
+        if (m_pendingTasks > 0)
+        {
+            m_pendingTasks--;
+        }
+        else
+        {
+            Logging::logError("ThreadPool: pending task count underflow\n");
+        }
+        m_activeTasks++;
+    }
+
+    execute(task);
+
+    {
+        std::lock_guard<std::mutex> guard(m_sleepMutex);
+        m_activeTasks--;
+    }
+    return true;
+}
+
+void ThreadPool::workerLoop(std::size_t workerIndex)
+{
+    tl_pool = this;
+    tl_workerIndex = static_cast<std::ptrdiff_t>(workerIndex);
+
+    while(true)
+    {
+        if (runPendingTask())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeup.wait(lock, [this]()
+            {
+                return m_stop || (m_pendingTasks > 0);
+            }
+        );
+
+        if (m_stop)
+        {
+            break;
+        }
+    }
+
+    tl_pool = nullptr;
+    tl_workerIndex = -1;
+}
+
+TaskGroup::~TaskGroup()
+{
+    // make sure no task refers to this group after it is gone.
+    waitForTasks();
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_pending++;
+    }
+
+    m_pool.submit([this, task = std::move(task)]()
+        {
+            std::exception_ptr exception;
+            try
+            {
+                task();
+            }
+            catch(...)
+            {
+                exception = std::current_exception();
+            }
+
+            // notify while holding the lock, the group may be destroyed
+            // as soon as the waiting thread sees the count drop to zero.
+            std::lock_guard<std::mutex> guard(m_mutex);
+            if (exception && !m_exception)
+            {
+                m_exception = exception;
+            }
+
+            m_pending--;
+            if (m_pending == 0)
+            {
+                m_done.notify_all();
+            }
+        }
+    );
+}
+
+void TaskGroup::waitForTasks()
+{
+    while(true)
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            if (m_pending == 0)
+            {
+                return;
+            }
+        }
+
+        if (m_pool.runPendingTask())
+        {
+            continue;
+        }
+
+        // nothing to execute: the remaining tasks are running on other threads
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_pending == 0; });
+        return;
+    }
+}
+
+void TaskGroup::wait()
+{
+    waitForTasks();
+
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        std::swap(exception, m_exception);
+    }
+
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+PoolSelection::PoolSelection(std::size_t threads)
+{
+    if (threads == 0)
+    {
+        m_pool = &ThreadPool::global();
+    }
+    else if (threads > 1)
+    {
+        m_privatePool = std::make_unique<ThreadPool>(threads);
+        m_pool = m_privatePool.get();
+    }
+}
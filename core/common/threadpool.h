@@ -0,0 +1,260 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+
+namespace LunaCore
+{
+
+/** A pool of worker threads that execute tasks.
+ *
+ *  Each worker owns a task deque. A worker takes tasks from the back
+ *  of its own deque and, when that runs dry, steals tasks from the
+ *  front of the other workers' deques. Tasks submitted from inside
+ *  a worker go to that worker's deque, tasks submitted from other
+ *  threads are distributed round-robin.
+*/
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    /** create a pool with the given number of worker threads.
+     *  a thread count of 0 creates one worker per hardware thread.
+    */
+    explicit ThreadPool(std::size_t threads = 0);
+
+    /** waits for the running tasks to finish. pending tasks are discarded. */
+    virtual ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool& operator=(const ThreadPool &) = delete;
+
+    /** return the number of worker threads */
+    [[nodiscard]] std::size_t threadCount() const noexcept
+    {
+        return m_workers.size();
+    }
+
+    /** submit a task for execution.
+     *  exceptions escaping from the task are logged and discarded,
+     *  use a TaskGroup to propagate them.
+    */
+    void submit(Task task);
+
+    /** execute one pending task on the calling thread.
+     *  returns false if there was no task to execute.
+    */
+    bool runPendingTask();
+
+    /** return true if tasks are pending or executing */
+    [[nodiscard]] bool isBusy() const;
+
+    /** return the number of hardware threads, at least 1 */
+    [[nodiscard]] static std::size_t hardwareThreads() noexcept;
+
+    /** return the pool shared by all core engines.
+     *  the pool is created on first use with the number of
+     *  threads set by setGlobalThreadCount.
+    */
+    [[nodiscard]] static ThreadPool& global();
+
+    /** set the number of worker threads of the shared pool.
+     *  0 (the default) creates one worker per hardware thread.
+     *
+     *  An idle shared pool with a different thread count is destroyed
+     *  and re-created on next use. A busy shared pool is kept until
+     *  global() is called while it is idle, so the tasks it is
+     *  executing never lose their pool. References returned by
+     *  global() must not be kept beyond the work they were used for.
+    */
+    static void setGlobalThreadCount(std::size_t threads);
+
+    /** return the number of worker threads the shared pool has or will have */
+    [[nodiscard]] static std::size_t globalThreadCount();
+
+protected:
+    struct Worker
+    {
+        std::mutex          m_mutex;
+        std::deque<Task>    m_tasks;
+        std::thread         m_thread;
+    };
+
+    void workerLoop(std::size_t workerIndex);
+
+    /** take a task from the back of a worker's own deque */
+    bool popTask(std::size_t workerIndex, Task &task);
+
+    /** take a task from the front of another worker's deque */
+    bool stealTask(std::size_t thiefIndex, Task &task);
+
+    /** return the index of the calling worker or -1 if the caller isn't a worker of this pool */
+    [[nodiscard]] std::ptrdiff_t currentWorkerIndex() const noexcept;
+
+    static void execute(Task &task) noexcept;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    mutable std::mutex      m_sleepMutex;
+    std::condition_variable m_wakeup;
+    std::size_t             m_pendingTasks{0};  ///< protected by m_sleepMutex
+    std::size_t             m_activeTasks{0};   ///< protected by m_sleepMutex
+    bool                    m_stop{false};      ///< protected by m_sleepMutex
+
+    std::atomic<std::size_t> m_nextWorker{0};   ///< round-robin index for external submissions
+};
+
+/** A set of tasks that can be waited on as a whole.
+ *
+ *  wait() executes pending pool tasks on the calling thread until all
+ *  tasks of the group have finished, so a task may itself create and
+ *  wait on a TaskGroup without deadlocking the pool. When there is
+ *  nothing left to execute it sleeps until the last task finishes.
+ *
+ *  The first exception thrown by a task is re-thrown by wait().
+*/
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool &pool) : m_pool(pool) {}
+
+    /** waits for all the tasks in the group */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup& operator=(const TaskGroup &) = delete;
+
+    /** submit a task to the pool as part of this group */
+    void run(std::function<void()> task);
+
+    /** wait for all tasks of the group to finish */
+    void wait();
+
+protected:
+    /** run pool tasks or sleep until the tasks of the group have finished */
+    void waitForTasks();
+
+    ThreadPool              &m_pool;
+    std::mutex              m_mutex;
+    std::condition_variable m_done;
+    std::size_t             m_pending{0};   ///< protected by m_mutex
+    std::exception_ptr      m_exception;    ///< protected by m_mutex
+};
+
+/** call func(index) for each index in [begin, end) using the tasks of a pool.
+ *
+ *  The range is split into chunks of at least 'grain' indices, a few chunks
+ *  per worker so idle workers can steal the remainder. The calling thread
+ *  executes tasks while waiting, so parallelFor may be nested.
+ *
+ *  The first exception thrown by func is re-thrown.
+*/
+template<typename Func>
+void parallelFor(ThreadPool &pool, std::size_t begin, std::size_t end, Func &&func, std::size_t grain = 1)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+
+    const std::size_t count = end - begin;
+    grain = std::max<std::size_t>(grain, 1);
+
+    const std::size_t chunks = std::min(count / grain, pool.threadCount() * 4);
+    if (chunks <= 1)
+    {
+        for(auto index = begin; index < end; index++)
+        {
+            func(index);
+        }
+        return;
+    }
+
+    const std::size_t chunkSize = (count + chunks - 1) / chunks;
+
+    TaskGroup group(pool);
+    for(auto first = begin; first < end; first += chunkSize)
+    {
+        const auto last = std::min(end, first + chunkSize);
+        group.run([&func, first, last]()
+            {
+                for(auto index = first; index < last; index++)
+                {
+                    func(index);
+                }
+            }
+        );
+    }
+    group.wait();
+}
+
+/** call func(index) for each index in [begin, end) using the shared pool */
+template<typename Func>
+void parallelFor(std::size_t begin, std::size_t end, Func &&func, std::size_t grain = 1)
+{
+    parallelFor(ThreadPool::global(), begin, end, std::forward<Func>(func), grain);
+}
+
+/** The pool selected by the thread count parameter of a core engine.
+ *
+ *  All core engines that take a thread count use this convention:
+ *  1 runs the work on the calling thread, 0 uses the shared pool, see
+ *  ThreadPool::global and ThreadPool::setGlobalThreadCount, and any other
+ *  value creates a private pool with that many threads for the lifetime
+ *  of the selection.
+ *
+ *  Unless an engine documents otherwise, its result does not depend on
+ *  the thread count.
+*/
+class PoolSelection
+{
+public:
+    explicit PoolSelection(std::size_t threads);
+
+    PoolSelection(const PoolSelection &) = delete;
+    PoolSelection& operator=(const PoolSelection &) = delete;
+
+    /** return the selected pool or nullptr when running on the calling thread */
+    [[nodiscard]] ThreadPool* pool() const noexcept
+    {
+        return m_pool;
+    }
+
+    /** call func(index) for each index in [begin, end), using parallelFor
+     *  when a pool was selected.
+    */
+    template<typename Func>
+    void forEach(std::size_t begin, std::size_t end, Func &&func, std::size_t grain = 1) const
+    {
+        if (m_pool != nullptr)
+        {
+            parallelFor(*m_pool, begin, end, std::forward<Func>(func), grain);
+            return;
+        }
+
+        for(auto index = begin; index < end; index++)
+        {
+            func(index);
+        }
+    }
+
+protected:
+    std::unique_ptr<ThreadPool> m_privatePool;
+    ThreadPool                  *m_pool{nullptr};
+};
+
+};
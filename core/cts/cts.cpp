@@ -338,14 +338,9 @@ MeanAndMedianCTS::BufferResult MeanAndMedianCTS::insertBuffers(SegmentList &segm
     {
         std::stringstream ss;
         ss << "ctsbuffer_L" << seg.m_level << "_" << netlist.createUniqueID();
-        auto bufferIns = std::make_shared<ChipDB::Instance>(ss.str(),
+        auto bufInsKeyPtr = netlist.createInstance(ss.str(),
             ChipDB::InstanceType::CELL, ctsInfo.m_bufferCell);
-        auto bufInsKeyPtrOpt = netlist.m_instances.add(bufferIns);
-        if (!bufInsKeyPtrOpt)
-        {
-            throw std::runtime_error("cts cannot create buffer");
-        }
-        auto bufInsKeyPtr = bufInsKeyPtrOpt.value();
+        auto bufferIns = bufInsKeyPtr.ptr();
 
         if (!bufInsKeyPtr.isValid())
         {
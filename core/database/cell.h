@@ -27,7 +27,7 @@ public:
     {
     }
 
-    std::string name() const noexcept
+    const Name& name() const noexcept
     {
         return m_name;
     }
@@ -72,7 +72,7 @@ public:
     std::unordered_map<std::string /* layer name */, GeometryObjects> m_obstructions;
 
 protected:
-    std::string     m_name;         ///< name of the cell
+    Name            m_name;         ///< name of the cell
 };
 
 }; // namespace
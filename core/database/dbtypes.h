@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "enums.h"
+#include "nametable.h"
 
 #ifdef NO_SSIZE_T
 #include <type_traits>
@@ -31,6 +32,18 @@ namespace ChipDB
 
     using LayerID   = int32_t;
 
+    enum class InstanceType
+    {
+        UNKNOWN = 0,
+        ABSTRACT,
+        CELL,
+        MODULE,
+        PIN,
+        NETCON
+    };
+
+    std::string toString(const InstanceType &t);
+
     /** base object that provides a getName() function */
     class NamedObject
     {
@@ -24,6 +24,10 @@ void Design::clear()
 
     m_topModule = nullptr;
     m_uniqueIDCounter = 0;
+
+    // free the interned names, unless objects of another
+    // design or elsewhere still hold them.
+    NameTable::global().clear();
 }
 
 bool Design::setTopModule(const std::string &moduleName)
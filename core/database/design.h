@@ -19,7 +19,9 @@ class Design
 public:
     Design();
 
-    /** clear netlist, celllib, modules and technology information */
+    /** clear netlist, celllib, modules and technology information.
+     *  the global NameTable is cleared too when no names are in use.
+    */
     void clear();
 
     std::shared_ptr<CellLib>    m_cellLib;
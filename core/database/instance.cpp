@@ -58,7 +58,7 @@ Instance::Pin Instance::getPin(PinObjectKey key) const
         return Instance::Pin{};
     }
 
-    pin.m_pinInfo = m_cell->m_pins[key];
+    pin.m_pinInfo = m_cell->m_pins.rawPtr(key);
 
     if (m_pinToNet.size() > key)
     {
@@ -85,7 +85,7 @@ Instance::Pin Instance::getPin(const std::string &pinName) const
     auto pinKeyObjPair = m_cell->m_pins[pinName];
     if (pinKeyObjPair.isValid())
     {
-        pin.m_pinInfo = pinKeyObjPair.ptr();
+        pin.m_pinInfo = pinKeyObjPair.rawPtr();
         pin.m_pinKey = pinKeyObjPair.key();
 
         auto key = pinKeyObjPair.key();
@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <memory_resource>
 #include <array>
 #include <stdexcept>
 #include "visitor.h"
@@ -17,25 +18,17 @@
 namespace ChipDB
 {
 
-enum class InstanceType
-{
-    UNKNOWN = 0,
-    ABSTRACT,
-    CELL,
-    MODULE,
-    PIN,
-    NETCON
-};
-
-std::string toString(const InstanceType &t);
-
 class Instance
 {
 public:
     Instance() : m_cell(nullptr) {}
 
-    Instance(const std::string &name, InstanceType instype, const std::shared_ptr<Cell> cell)
-        : m_name(name), m_insType(instype), m_cell(cell)
+    /** the pin to net table is allocated from the memory resource, a netlist
+     *  passes its own arena so the tables of all its instances share memory.
+    */
+    Instance(const std::string &name, InstanceType instype, const std::shared_ptr<Cell> cell,
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_cell(cell), m_pinToNet(resource), m_name(name), m_insType(instype)
     {
         m_pinToNet.resize(cell->getNumberOfPins(), ChipDB::ObjectNotFound);
     }
@@ -138,7 +131,7 @@ public:
     }
 
     /** get the name of the instance */
-    [[nodiscard]] std::string name() const noexcept
+    [[nodiscard]] const Name& name() const noexcept
     {
         return m_name;
     }
@@ -160,7 +153,7 @@ public:
             return ((m_pinKey != ObjectNotFound) && m_pinInfo);
         }
 
-        std::string name() const
+        std::string_view name() const
         {
             if (m_pinInfo)
             {
@@ -171,7 +164,7 @@ public:
 
         NetObjectKey    m_netKey = ObjectNotFound;  ///< key of connected net
         PinObjectKey    m_pinKey = ObjectNotFound;  ///< key of this pin
-        std::shared_ptr<PinInfo> m_pinInfo;         ///< information about the pin
+        const PinInfo  *m_pinInfo = nullptr;        ///< information about the pin, not owned: the cell of the instance owns it
 
         constexpr PinObjectKey pinKey() const
         {
@@ -243,8 +236,8 @@ public:
 
 protected:
     const std::shared_ptr<Cell> m_cell;                 ///< access to pins of cell
-    std::vector<NetObjectKey>   m_pinToNet;             ///< connections from pin to net
-    std::string     m_name;                             ///< name of the instance
+    std::pmr::vector<NetObjectKey> m_pinToNet;          ///< connections from pin to net
+    Name            m_name;                             ///< name of the instance
     InstanceType    m_insType{InstanceType::UNKNOWN};
 };
 
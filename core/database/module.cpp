@@ -36,6 +36,16 @@ KeyObjPair<Instance> Module::addInstance(std::shared_ptr<Instance> insPtr)
     return KeyObjPair<Instance>{};   // cannot add instances to a black box
 }
 
+KeyObjPair<Instance> Module::createInstance(const std::string &name, InstanceType insType, std::shared_ptr<Cell> cell)
+{
+    if (!m_netlist)
+    {
+        return KeyObjPair<Instance>{};   // cannot add instances to a black box
+    }
+
+    return m_netlist->createInstance(name, insType, cell);
+}
+
 KeyObjPair<Net> Module::createNet(const std::string &netName)
 {
     if (!m_netlist)
@@ -22,6 +22,12 @@ public:
     }
 
     KeyObjPair<Instance> addInstance(std::shared_ptr<Instance> insPtr);
+
+    /** create an instance owned by the netlist of the module.
+     *  returns an invalid KeyObjPair for black boxes, empty names and existing names.
+    */
+    KeyObjPair<Instance> createInstance(const std::string &name, InstanceType insType, std::shared_ptr<Cell> cell);
+
     KeyObjPair<Net> createNet(const std::string &netName);
 
     bool connect(const std::string &insName, const std::string &pinName, const std::string &netName);
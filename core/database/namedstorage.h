@@ -9,14 +9,19 @@
 #include <sstream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <atomic>
 #include <algorithm>
 #include <memory>
 #include <unordered_map>
 #include <iterator>
 #include <optional>
+#include <limits>
+#include <cassert>
+#include <stdexcept>
 
 #include "dbtypes.h"
+#include "sharedpool.h"
 
 #ifdef NO_SSIZE_T
 #include <type_traits>
@@ -106,6 +111,33 @@ struct INamedStorageListener
 };
 
 /** container to store object pointers and provides fast named lookup.
+ *
+ *  The objects are kept in a dense array in insertion order, so iteration
+ *  walks contiguous memory. A key-indexed slot table maps each ObjectKey
+ *  to its position in the dense array, so lookup by key is a plain array
+ *  index instead of a hash lookup.
+ *
+ *  Keys are generated monotonically and are never re-used until clear()
+ *  is called. Removing an object leaves a tombstone in the dense array
+ *  and in the slot table; stale keys therefore always resolve to
+ *  'not found'. When the number of tombstones exceeds the number of live
+ *  objects, the dense array is compacted. Compaction does not change
+ *  the keys but does invalidate any outstanding iterators.
+ *
+ *  The name index refers to the names interned in the global NameTable
+ *  so it doesn't store a second copy of every name. Each entry holds a
+ *  Name handle, which keeps its name in the table.
+ *
+ *  Objects made by create() are allocated, together with their
+ *  reference count, from a memory arena of the container. Like objects
+ *  passed to add(), they are shared: removing them or clearing the
+ *  container only drops the reference of the container. Each object
+ *  keeps the arena alive, so pointers handed out stay valid. The memory
+ *  of removed objects is not re-used, it is returned when the container
+ *  is cleared and the last object of the arena is released.
+ *
+ *  Iterating yields ObjectRef handles, which refer to the entries
+ *  of the container and don't share ownership of the objects.
  *
  *  TODO: when updating to C++20, use concepts to contrain the type to INamedObject
  *
@@ -116,9 +148,74 @@ class NamedStorage
 {
 public:
 
-    using ContainerType = std::unordered_map<ObjectKey, std::shared_ptr<T> >;
+    /** an entry of the dense object array. A tombstone has a nullptr m_objPtr */
+    struct Entry
+    {
+        ObjectKey           m_key{ObjectNotFound};
+        std::shared_ptr<T>  m_objPtr;
+        Name                m_name;             ///< the name in the index
+
+        [[nodiscard]] constexpr bool isTombstone() const noexcept
+        {
+            return !m_objPtr;
+        }
+    };
+
+    using ContainerType = std::vector<Entry>;
+
+    /** a key and object handle that doesn't share ownership of the object.
+     *  It has the interface of KeyObjPair and converts to one. ptr() copies
+     *  the shared pointer, use it only to keep the object.
+     *  Valid as long as the iterator that returned it.
+    */
+    class ObjectRef
+    {
+    public:
+        constexpr ObjectRef() = default;
+        constexpr explicit ObjectRef(const Entry *entry) noexcept : m_entry(entry) {}
+
+        constexpr T* operator->() const noexcept
+        {
+            return m_entry->m_objPtr.get();
+        }
+
+        constexpr T& operator*() const noexcept
+        {
+            return *m_entry->m_objPtr;
+        }
+
+        constexpr ObjectKey key() const noexcept
+        {
+            return m_entry ? m_entry->m_key : ObjectNotFound;
+        }
+
+        std::shared_ptr<T> ptr() const noexcept
+        {
+            return m_entry ? m_entry->m_objPtr : nullptr;
+        }
+
+        constexpr T* rawPtr() const noexcept
+        {
+            return m_entry ? m_entry->m_objPtr.get() : nullptr;
+        }
+
+        constexpr bool isValid() const noexcept
+        {
+            return (m_entry != nullptr) && (m_entry->m_key >= 0) && m_entry->m_objPtr;
+        }
+
+        operator KeyObjPair<T>() const
+        {
+            return KeyObjPair<T>(key(), ptr());
+        }
+
+    protected:
+        const Entry *m_entry = nullptr;
+    };
 
     NamedStorage() = default;
+    NamedStorage(const NamedStorage &) = delete;
+    NamedStorage& operator=(const NamedStorage &) = delete;
 
     virtual ~NamedStorage()
     {
@@ -126,8 +223,12 @@ public:
 
     void clear()
     {
+        // objects still referenced elsewhere keep the old arena alive
+        m_pool.reset();
         m_objects.clear();
+        m_keyToIndex.clear();
         m_nameToKey.clear();
+        m_tombstones = 0;
         m_uniqueObjectKey = 0;
         notifyAll(-1, INamedStorageListener::NotificationType::CLEARALL);
     }
@@ -135,7 +236,15 @@ public:
     /** return the number of objects in the storage container */
     size_t size() const
     {
-        return m_objects.size();
+        return m_objects.size() - m_tombstones;
+    }
+
+    /** reserve space for a number of objects */
+    void reserve(size_t objects)
+    {
+        m_objects.reserve(objects);
+        m_keyToIndex.reserve(objects);
+        m_nameToKey.reserve(objects);
     }
 
     /** adds an named object to the container.
@@ -148,8 +257,14 @@ public:
         {
             // no such named object, okay to add!
             auto key = generateUniqueObjectKey();
-            m_objects[key] = objectPtr;
-            m_nameToKey[objectPtr->name()] = key;
+
+            assert(static_cast<size_t>(key) == m_keyToIndex.size());
+            m_keyToIndex.push_back(m_objects.size());
+            auto const& entry = m_objects.emplace_back(Entry{key, objectPtr, Name(objectPtr->name())});
+
+            // the database objects already hold an interned name,
+            // so this does not copy the name
+            m_nameToKey[entry.m_name.view()] = key;
             notifyAll(key, INamedStorageListener::NotificationType::ADD);
             return KeyObjPair(key, objectPtr);
         }
@@ -157,8 +272,43 @@ public:
         return std::nullopt;
     }
 
+    /** construct a named object in the memory arena of the container.
+     *  returns std::nullopt if an object with the same name already exists.
+    */
+    template<class... Args>
+    std::optional<KeyObjPair<T> > create(Args&&... args)
+    {
+        auto objectPtr = std::allocate_shared<T>(PoolAllocator<T>(pool()), std::forward<Args>(args)...);
+        if (m_nameToKey.contains(objectPtr->name()))
+        {
+            return std::nullopt;
+        }
+
+        auto key = generateUniqueObjectKey();
+
+        assert(static_cast<size_t>(key) == m_keyToIndex.size());
+        m_keyToIndex.push_back(m_objects.size());
+        auto const& entry = m_objects.emplace_back(Entry{key, objectPtr, Name(objectPtr->name())});
+
+        m_nameToKey[entry.m_name.view()] = key;
+        notifyAll(key, INamedStorageListener::NotificationType::ADD);
+        return KeyObjPair(key, objectPtr);
+    }
+
+    /** the memory arena used by create(). Objects can use it
+     *  for their own allocations, see PoolAllocator.
+    */
+    const SharedPool& pool()
+    {
+        if (!m_pool)
+        {
+            m_pool = makeSharedPool();
+        }
+        return m_pool;
+    }
+
     /** remove an object by name. returns true if successful */
-    bool remove(const std::string &name)
+    bool remove(std::string_view name)
     {
         auto iter = m_nameToKey.find(name);
         if (iter == m_nameToKey.end())
@@ -170,10 +320,8 @@ public:
             auto key = iter->second;
             m_nameToKey.erase(iter);
 
-            auto objIter = m_objects.find(key);
-            if (objIter != m_objects.end())
+            if (removeEntry(key))
             {
-                m_objects.erase(objIter);
                 notifyAll(key, INamedStorageListener::NotificationType::REMOVE);
             }
             return true;
@@ -184,22 +332,21 @@ public:
     /** remove an object by key. returns true if successful */
     bool remove(ObjectKey key)
     {
-        auto iter = m_objects.find(key);
-        if (iter == m_objects.end())
+        auto objPtr = findObject(key);
+        if (!objPtr)
         {
             return false;   // no such object
         }
         else
         {
-            auto obj = iter->second;
-            auto nameToKeyIter = m_nameToKey.find(obj->name());
+            auto nameToKeyIter = m_nameToKey.find(objPtr->name());
 
             if (nameToKeyIter != m_nameToKey.end())
             {
                 m_nameToKey.erase(nameToKeyIter);
             }
 
-            m_objects.erase(iter);
+            removeEntry(key);
 
             notifyAll(key, INamedStorageListener::NotificationType::REMOVE);
             return true;
@@ -207,80 +354,88 @@ public:
         return false;
     }
 
+    /** remove all tombstones from the dense object array.
+     *  Keys remain valid, iterators are invalidated.
+    */
+    void compact()
+    {
+        if (m_tombstones == 0)
+        {
+            return;
+        }
+
+        std::size_t dst = 0;
+        for(std::size_t src = 0; src < m_objects.size(); src++)
+        {
+            if (m_objects[src].isTombstone())
+            {
+                continue;
+            }
+
+            if (dst != src)
+            {
+                m_objects[dst] = std::move(m_objects[src]);
+            }
+            m_keyToIndex[m_objects[dst].m_key] = dst;
+            dst++;
+        }
+
+        m_objects.resize(dst);
+        m_tombstones = 0;
+    }
+
     /** access an object by name. Will throw std::out_of_range exception when the object does not exist */
-    KeyObjPair<T> at(const std::string &name)
+    KeyObjPair<T> at(std::string_view name)
     {
         auto objKey = m_nameToKey.at(name);
-        return KeyObjPair<T>(objKey, m_objects.at(objKey));
+        return KeyObjPair<T>(objKey, entryAt(objKey).m_objPtr);
     }
 
     /** access an object by name. Will throw std::out_of_range exception when the object does not exist */
-    KeyObjPair<T> at(const std::string &name) const
+    KeyObjPair<T> at(std::string_view name) const
     {
         auto objKey = m_nameToKey.at(name);
-        return m_objects.at(objKey);
+        return KeyObjPair<T>(objKey, entryAt(objKey).m_objPtr);
     }
 
     /** access an object by key. Will throw std::out_of_range exception when the object does not exist */
     constexpr std::shared_ptr<T> at(ObjectKey key)
     {
-        return m_objects.at(key);
+        return entryAt(key).m_objPtr;
     }
 
     /** access an object by key. Will throw std::out_of_range exception when the object does not exist */
     constexpr const std::shared_ptr<T> at(ObjectKey key) const
     {
-        return m_objects.at(key);
+        return entryAt(key).m_objPtr;
     }
 
     /** access an object by key. Returns an object reference. Will throw std::out_of_range exception when the object does not exist */
     constexpr T& atRef(ObjectKey key)
     {
-        auto objPtr = m_objects.at(key);
-        if (!objPtr)
-        {
-            throw(std::runtime_error("NamedStorage::atRef retrieved a null pointer"));
-        }
-        return static_cast<T&>(*objPtr.get());
+        return *entryAt(key).m_objPtr;
     }
 
     /** access an object by key. Returns an object reference. Will throw std::out_of_range exception when the object does not exist */
     constexpr const T& atRef(ObjectKey key) const
     {
-        auto objPtr = m_objects.at(key);
-        if (!objPtr)
-        {
-            throw(std::runtime_error("NamedStorage::atRef retrieved a null pointer"));
-        }
-        return static_cast<const T&>(*objPtr.get());
+        return *entryAt(key).m_objPtr;
     }
 
     /** access an object by key. Returns an object pointer.
      *  Will throw std::out_of_range exception when the object does not exist.
-     *  Will throw std::runtime_error when the object is nullptr.
     */
     constexpr T* atRaw(ObjectKey key)
     {
-        auto objPtr = m_objects.at(key);
-        if (!objPtr)
-        {
-            throw(std::runtime_error("NamedStorage::atRef retrieved a null pointer"));
-        }
-        return objPtr.get();
+        return entryAt(key).m_objPtr.get();
     }
 
     /** access an object by key. Returns an object pointer.
      *  Will throw std::out_of_range exception when the object does not exist.
-     *  Will throw std::runtime_error when the object is nullptr.
     */
     constexpr const T* atRaw(ObjectKey key) const
     {
-        auto objPtr = m_objects.at(key);
-        if (!objPtr)
-        {
-            throw(std::runtime_error("NamedStorage::atRef retrieved a null pointer"));
-        }
-        return objPtr.get();
+        return entryAt(key).m_objPtr.get();
     }
 
     /** access an object by key. Will return a nullptr when the object does not exist */
@@ -296,143 +451,111 @@ public:
     }
 
     /** access an object by name. Will return a nullptr when the object does not exist */
-    constexpr KeyObjPair<T> operator[](const std::string &name)
+    constexpr KeyObjPair<T> operator[](std::string_view name)
     {
         return findObject(name);
     }
 
     /** access an object by name. Will return a nullptr when the object does not exist */
-    constexpr KeyObjPair<T> operator[](const std::string &name) const
+    constexpr KeyObjPair<T> operator[](std::string_view name) const
     {
         return findObject(name);
     }
 
-    class Iterator
+    /** returns true if the key refers to a live object */
+    [[nodiscard]] constexpr bool contains(ObjectKey key) const noexcept
+    {
+        return indexOf(key) != TombstoneIndex;
+    }
+
+    /** iterator over the dense object array that skips tombstones */
+    template<class BaseIteratorType>
+    class DenseIterator
     {
     public:
         using iterator_category = std::forward_iterator_tag;
         using difference_type   = std::ptrdiff_t;
-        using value_type        = KeyObjPair<T>;
+        using value_type        = ObjectRef;
 
-        using BaseIteratorType  = typename ContainerType::iterator;
+        DenseIterator() = default;
+        DenseIterator(const DenseIterator &) = default;
 
-        Iterator() = default;
-        Iterator(const Iterator &) = default;
-
-        Iterator(BaseIteratorType baseIterator)
-            : m_baseIterator(baseIterator) {}
+        DenseIterator(BaseIteratorType baseIterator, BaseIteratorType endIterator)
+            : m_baseIterator(baseIterator), m_endIterator(endIterator)
+        {
+            skipTombstones();
+        }
 
-        constexpr value_type operator*()
+        constexpr value_type operator*() const noexcept
         {
-            return KeyObjPair(m_baseIterator->first, m_baseIterator->second);
+            return ObjectRef(&(*m_baseIterator));
         }
 
-        constexpr value_type operator->()
+        constexpr value_type operator->() const noexcept
         {
-            return KeyObjPair(m_baseIterator->first, m_baseIterator->second);
+            return ObjectRef(&(*m_baseIterator));
         }
 
         // prefix increment
-        Iterator& operator++()
+        DenseIterator& operator++()
         {
             m_baseIterator++;
+            skipTombstones();
             return *this;
         }
 
         // postfix increment
-        Iterator operator++(int)
+        DenseIterator operator++(int)
         {
-            Iterator tmp = *this;
-            m_baseIterator++;
+            DenseIterator tmp = *this;
+            ++(*this);
             return tmp;
         }
 
-        friend bool operator==(const Iterator &lhs, const Iterator &rhs)
+        friend bool operator==(const DenseIterator &lhs, const DenseIterator &rhs)
         {
             return lhs.m_baseIterator == rhs.m_baseIterator;
         }
 
-        friend bool operator!=(const Iterator &lhs, const Iterator &rhs)
+        friend bool operator!=(const DenseIterator &lhs, const DenseIterator &rhs)
         {
             return lhs.m_baseIterator != rhs.m_baseIterator;
         }
 
     private:
-        BaseIteratorType m_baseIterator;
-    };
-
-    class ConstIterator
-    {
-    public:
-        using iterator_category = std::forward_iterator_tag;
-        using difference_type   = std::ptrdiff_t;
-        using value_type        = KeyObjPair<T>;
-
-        using BaseIteratorType  = typename ContainerType::const_iterator;
-
-        ConstIterator() = default;
-        ConstIterator(const ConstIterator &) = default;
-
-        ConstIterator(BaseIteratorType baseIterator)
-            : m_baseIterator(baseIterator) {}
-
-        constexpr value_type operator*()
+        void skipTombstones()
         {
-            return KeyObjPair(m_baseIterator->first, m_baseIterator->second);
-        }
-
-        constexpr value_type operator->()
-        {
-            return KeyObjPair(m_baseIterator->first, m_baseIterator->second);
-        }
-
-        // prefix increment
-        ConstIterator& operator++()
-        {
-            m_baseIterator++;
-            return *this;
-        }
-
-        // postfix increment
-        ConstIterator operator++(int)
-        {
-            ConstIterator tmp = *this;
-            m_baseIterator++;
-            return tmp;
-        }
-
-        friend bool operator==(const ConstIterator &lhs, const ConstIterator &rhs)
-        {
-            return lhs.m_baseIterator == rhs.m_baseIterator;
-        }
-
-        friend bool operator!=(const ConstIterator &lhs, const ConstIterator &rhs)
-        {
-            return lhs.m_baseIterator != rhs.m_baseIterator;
+            while((m_baseIterator != m_endIterator) && m_baseIterator->isTombstone())
+            {
+                m_baseIterator++;
+            }
         }
 
-    private:
         BaseIteratorType m_baseIterator;
+        BaseIteratorType m_endIterator;
     };
 
+    using Iterator      = DenseIterator<typename ContainerType::iterator>;
+    using ConstIterator = DenseIterator<typename ContainerType::const_iterator>;
+
     Iterator begin()
     {
-        return Iterator(m_objects.begin());
+        return Iterator(m_objects.begin(), m_objects.end());
     }
 
     ConstIterator begin() const
     {
-        return ConstIterator(m_objects.begin());
+        return ConstIterator(m_objects.begin(), m_objects.end());
     }
 
     Iterator end()
     {
-        return Iterator(m_objects.end());
+        return Iterator(m_objects.end(), m_objects.end());
     }
 
     ConstIterator end() const
     {
-        return ConstIterator(m_objects.end());
+        return ConstIterator(m_objects.end(), m_objects.end());
     }
 
     void addListener(INamedStorageListener *listener)
@@ -479,6 +602,8 @@ public:
 
 protected:
 
+    static constexpr std::size_t TombstoneIndex = std::numeric_limits<std::size_t>::max();
+
     void notifyAll(ObjectKey key = ObjectUnspecified, INamedStorageListener::NotificationType t =
         INamedStorageListener::NotificationType::UNSPECIFIED) const
     {
@@ -501,27 +626,68 @@ protected:
         return m_uniqueObjectKey++;
     }
 
+    /** return the index into the dense object array or TombstoneIndex if the key does not exist */
+    [[nodiscard]] constexpr std::size_t indexOf(ObjectKey key) const noexcept
+    {
+        if ((key < 0) || (static_cast<std::size_t>(key) >= m_keyToIndex.size()))
+        {
+            return TombstoneIndex;
+        }
+        return m_keyToIndex[key];
+    }
+
+    /** return the dense array entry of a key. Will throw std::out_of_range exception when the object does not exist */
+    [[nodiscard]] constexpr const Entry& entryAt(ObjectKey key) const
+    {
+        auto index = indexOf(key);
+        if (index == TombstoneIndex)
+        {
+            throw std::out_of_range("NamedStorage: object key does not exist");
+        }
+        return m_objects[index];
+    }
+
+    /** turn the object into a tombstone. returns true if an object was removed */
+    bool removeEntry(ObjectKey key)
+    {
+        auto index = indexOf(key);
+        if (index == TombstoneIndex)
+        {
+            return false;
+        }
+
+        m_objects[index] = Entry{};
+        m_keyToIndex[key] = TombstoneIndex;
+        m_tombstones++;
+
+        if (m_tombstones > size())
+        {
+            compact();
+        }
+        return true;
+    }
+
     std::shared_ptr<T> findObject(ObjectKey key)
     {
-        auto objIter = m_objects.find(key);
-        if (objIter == m_objects.end())
+        auto index = indexOf(key);
+        if (index == TombstoneIndex)
         {
             return nullptr;
         }
-        return objIter->second;
+        return m_objects[index].m_objPtr;
     }
 
     const std::shared_ptr<T> findObject(ObjectKey key) const
     {
-        auto objIter = m_objects.find(key);
-        if (objIter == m_objects.end())
+        auto index = indexOf(key);
+        if (index == TombstoneIndex)
         {
             return nullptr;
         }
-        return objIter->second;
+        return m_objects[index].m_objPtr;
     }
 
-    KeyObjPair<T> findObject(const std::string &name)
+    KeyObjPair<T> findObject(std::string_view name)
     {
         auto objKeyIter = m_nameToKey.find(name);
         if (objKeyIter == m_nameToKey.end())
@@ -529,16 +695,16 @@ protected:
             return KeyObjPair<T>();
         }
 
-        auto objIter = m_objects.find(objKeyIter->second);
-        if (objIter == m_objects.end())
+        auto index = indexOf(objKeyIter->second);
+        if (index == TombstoneIndex)
         {
             return KeyObjPair<T>();
         }
 
-        return KeyObjPair<T>(objIter->first, objIter->second);
+        return KeyObjPair<T>(objKeyIter->second, m_objects[index].m_objPtr);
     }
 
-    KeyObjPair<T> findObject(const std::string &name) const
+    KeyObjPair<T> findObject(std::string_view name) const
     {
         auto objKeyIter = m_nameToKey.find(name);
         if (objKeyIter == m_nameToKey.end())
@@ -546,19 +712,22 @@ protected:
             return KeyObjPair<T>();
         }
 
-        auto objIter = m_objects.find(objKeyIter->second);
-        if (objIter == m_objects.end())
+        auto index = indexOf(objKeyIter->second);
+        if (index == TombstoneIndex)
         {
             return KeyObjPair<T>();
         }
 
-        return KeyObjPair<T>(objIter->first, objIter->second);
+        return KeyObjPair<T>(objKeyIter->second, m_objects[index].m_objPtr);
     }
 
     mutable ObjectKey m_uniqueObjectKey = 0;
     std::vector<ListenerData> m_listeners;
-    ContainerType m_objects;
-    std::unordered_map<std::string, ObjectKey> m_nameToKey;
+    ContainerType m_objects;                    ///< dense object array in insertion order, may contain tombstones
+    std::vector<std::size_t> m_keyToIndex;      ///< slot table: ObjectKey -> index into m_objects
+    std::size_t m_tombstones{0};                ///< number of tombstones in m_objects
+    std::unordered_map<std::string_view, ObjectKey> m_nameToKey;   ///< keys are views of the Entry names
+    SharedPool m_pool;                          ///< arena of the objects made by create()
 };
 
 
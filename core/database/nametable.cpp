@@ -0,0 +1,128 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+#include <mutex>
+#include "nametable.h"
+
+using namespace ChipDB;
+
+NameTable& NameTable::global()
+{
+    static NameTable table;
+    return table;
+}
+
+std::string_view NameTable::intern(std::string_view name)
+{
+    {
+        std::shared_lock lock(m_mutex);
+        auto iter = m_index.find(name);
+        if (iter != m_index.end())
+        {
+            return iter->first;
+        }
+    }
+
+    std::unique_lock lock(m_mutex);
+    return insert(name);
+}
+
+const char* NameTable::acquire(std::string_view name)
+{
+    // the reference is added while holding the lock so
+    // clear() cannot free the name before it is counted.
+    {
+        std::shared_lock lock(m_mutex);
+        auto iter = m_index.find(name);
+        if (iter != m_index.end())
+        {
+            addRef();
+            return iter->second;
+        }
+    }
+
+    std::unique_lock lock(m_mutex);
+    auto const str = insert(name).data();
+    addRef();
+    return str;
+}
+
+std::string_view NameTable::insert(std::string_view name)
+{
+    // another thread may have added the name in the meantime
+    auto iter = m_index.find(name);
+    if (iter != m_index.end())
+    {
+        return iter->first;
+    }
+
+    const auto size = static_cast<uint32_t>(name.size());
+    const auto bytes = sizeof(size) + name.size() + 1;
+    if (m_chunkUsed + bytes > ChunkSize)
+    {
+        // names longer than a chunk get a chunk of their own
+        const auto chunkBytes = std::max(bytes, ChunkSize);
+        m_chunks.emplace_back(new char[chunkBytes]);
+        m_chunkUsed = 0;
+        m_arenaBytes += chunkBytes;
+    }
+
+    char *dest = m_chunks.back().get() + m_chunkUsed;
+    std::memcpy(dest, &size, sizeof(size));
+    dest += sizeof(size);
+    std::memcpy(dest, name.data(), name.size());
+    dest[name.size()] = 0;
+    m_chunkUsed += bytes;
+
+    const std::string_view str(dest, name.size());
+    m_index.emplace(str, dest);
+    m_characters += name.size();
+    return str;
+}
+
+std::string_view NameTable::find(std::string_view name) const
+{
+    std::shared_lock lock(m_mutex);
+    auto iter = m_index.find(name);
+    if (iter != m_index.end())
+    {
+        return iter->first;
+    }
+    return {};
+}
+
+bool NameTable::clear()
+{
+    std::unique_lock lock(m_mutex);
+    if (m_refs.load(std::memory_order_acquire) != 0)
+    {
+        return false;
+    }
+
+    m_index.clear();
+    m_chunks.clear();
+    m_chunkUsed  = ChunkSize;
+    m_arenaBytes = 0;
+    m_characters = 0;
+    return true;
+}
+
+std::size_t NameTable::size() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_index.size();
+}
+
+std::size_t NameTable::characters() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_characters;
+}
+
+std::size_t NameTable::arenaBytes() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_arenaBytes;
+}
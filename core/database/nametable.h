@@ -0,0 +1,209 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ChipDB
+{
+
+/** Table of interned names.
+ *
+ *  Every distinct name is stored exactly once in a chunked character
+ *  arena. Each name is preceded by its length and followed by a
+ *  terminator, so a pointer to its first character is enough to get
+ *  its size and a C string. The characters never move, so views into
+ *  the table stay valid until the table is cleared.
+ *
+ *  The table counts the Name handles that refer to it and can only be
+ *  cleared when there are none left. Interning is thread-safe; lookups
+ *  of names that already exist only take a shared lock.
+*/
+class NameTable
+{
+public:
+    NameTable() = default;
+    NameTable(const NameTable &) = delete;
+    NameTable& operator=(const NameTable &) = delete;
+
+    /** the table used by all database objects */
+    static NameTable& global();
+
+    /** return the interned copy of a name, adding it if needed.
+     *  The view is terminated and stays valid until the table is cleared.
+    */
+    [[nodiscard]] std::string_view intern(std::string_view name);
+
+    /** return the interned copy of a name or an empty view with
+     *  a nullptr data() if it was never interned.
+    */
+    [[nodiscard]] std::string_view find(std::string_view name) const;
+
+    /** free all names if no Name handle refers to the table.
+     *  returns true if the table was cleared.
+    */
+    bool clear();
+
+    /** number of distinct names */
+    [[nodiscard]] std::size_t size() const;
+
+    /** number of characters stored, excluding lengths and terminators */
+    [[nodiscard]] std::size_t characters() const;
+
+    /** number of bytes allocated for the arena */
+    [[nodiscard]] std::size_t arenaBytes() const;
+
+protected:
+    friend class Name;
+
+    /** intern a non-empty name and add a reference to the table */
+    [[nodiscard]] const char* acquire(std::string_view name);
+
+    void addRef() noexcept
+    {
+        m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() noexcept
+    {
+        m_refs.fetch_sub(1, std::memory_order_release);
+    }
+
+    /** look up or add a name, the caller holds the unique lock */
+    [[nodiscard]] std::string_view insert(std::string_view name);
+
+    /** length of an interned name from a pointer to its first character */
+    [[nodiscard]] static std::size_t storedSize(const char *str) noexcept
+    {
+        uint32_t size = 0;
+        std::memcpy(&size, str - sizeof(size), sizeof(size));
+        return size;
+    }
+
+    static constexpr std::size_t ChunkSize = 64*1024;
+
+    mutable std::shared_mutex   m_mutex;
+    std::vector<std::unique_ptr<char[]>> m_chunks;  ///< the arena, chunks never move
+    std::size_t                 m_chunkUsed{ChunkSize};   ///< bytes used in the last chunk
+    std::size_t                 m_arenaBytes{0};
+    std::unordered_map<std::string_view, const char*> m_index;  ///< keys are views into m_chunks
+    std::size_t                 m_characters{0};
+    std::atomic<std::size_t>    m_refs{0};          ///< number of Name handles referring to the table
+};
+
+/** Handle to a name interned in the global NameTable.
+ *
+ *  A name is one pointer wide and compares by pointer. While a handle
+ *  exists the table cannot be cleared. Database objects return their
+ *  name as a reference to their handle; it converts to a view and to
+ *  a std::string, and .c_str() keeps working.
+*/
+class Name
+{
+public:
+    Name() noexcept = default;
+
+    /** the empty name is not interned so default constructed names compare equal to it */
+    explicit Name(std::string_view name) : m_str(name.empty() ? nullptr : NameTable::global().acquire(name)) {}
+
+    Name(const Name &other) noexcept : m_str(other.m_str)
+    {
+        if (m_str != nullptr) NameTable::global().addRef();
+    }
+
+    Name(Name &&other) noexcept : m_str(other.m_str)
+    {
+        other.m_str = nullptr;
+    }
+
+    ~Name()
+    {
+        if (m_str != nullptr) NameTable::global().release();
+    }
+
+    Name& operator=(const Name &other) noexcept
+    {
+        Name copy(other);
+        std::swap(m_str, copy.m_str);
+        return *this;
+    }
+
+    Name& operator=(Name &&other) noexcept
+    {
+        std::swap(m_str, other.m_str);
+        return *this;
+    }
+
+    Name& operator=(std::string_view name)
+    {
+        return *this = Name(name);
+    }
+
+    [[nodiscard]] std::string_view view() const noexcept
+    {
+        return (m_str != nullptr) ? std::string_view(m_str, NameTable::storedSize(m_str)) : std::string_view();
+    }
+
+    [[nodiscard]] const char* c_str() const noexcept
+    {
+        return (m_str != nullptr) ? m_str : "";
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return (m_str != nullptr) ? NameTable::storedSize(m_str) : 0;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_str == nullptr;
+    }
+
+    /** a copy of the name */
+    [[nodiscard]] std::string str() const
+    {
+        return std::string(view());
+    }
+
+    operator std::string_view() const noexcept
+    {
+        return view();
+    }
+
+    operator std::string() const
+    {
+        return str();
+    }
+
+    friend bool operator==(const Name &lhs, const Name &rhs) noexcept
+    {
+        return lhs.m_str == rhs.m_str;
+    }
+
+    friend bool operator==(const Name &lhs, std::string_view rhs) noexcept
+    {
+        return lhs.view() == rhs;
+    }
+
+    friend std::ostream& operator<<(std::ostream &os, const Name &name)
+    {
+        return os << name.view();
+    }
+
+protected:
+    const char *m_str{nullptr};     ///< first character of the interned name
+};
+
+};
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include "dbtypes.h"
+#include "route.h"
 #include "visitor.h"
 
 namespace ChipDB
@@ -25,7 +26,7 @@ public:
 
     IMPLEMENT_ACCEPT;
 
-    std::string name() const noexcept
+    const Name& name() const noexcept
     {
         return m_name;
     }
@@ -34,6 +35,7 @@ public:
     uint32_t    m_flags;        ///< non-persistent flags that can be used by algorithms
     bool        m_isPortNet;    ///< when true, this net connects to a module port
     bool        m_isClockNet;   ///< when true, this net is a clock net
+    NetRoute    m_route;        ///< global route of the net, empty if the net has not been routed
 
     void setPortNet(bool isPortNet)
     {
@@ -109,7 +111,7 @@ public:
     }
 
 protected:
-    std::string m_name;         ///< net name
+    Name        m_name;         ///< net name
     std::vector<NetConnect> m_connections;
 };
 
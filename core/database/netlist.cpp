@@ -33,7 +33,7 @@ KeyObjPair<Net> Netlist::createNet(const std::string &netName)
         return netObjPair;
     }
 
-    auto result = m_nets.add(std::make_shared<Net>(netName));
+    auto result = m_nets.create(netName);
     if (result)
     {
         return result.value();
@@ -42,6 +42,24 @@ KeyObjPair<Net> Netlist::createNet(const std::string &netName)
     return KeyObjPair<Net>{};
 }
 
+KeyObjPair<Instance> Netlist::createInstance(const std::string &name, InstanceType insType, std::shared_ptr<Cell> cell)
+{
+    if (name.empty() || !cell)
+    {
+        return KeyObjPair<Instance>{};
+    }
+
+    // the pin to net table shares the arena of the instance, which
+    // the instance keeps alive through its reference count
+    auto result = m_instances.create(name, insType, cell, m_instances.pool().get());
+    if (result)
+    {
+        return result.value();
+    }
+
+    return KeyObjPair<Instance>{};
+}
+
 std::shared_ptr<Instance> Netlist::lookupInstance(InstanceObjectKey key)
 {
     return m_instances[key];
@@ -7,6 +7,7 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <memory_resource>
 
 #include "visitor.h"
 #include "namedstorage.h"
@@ -16,6 +17,10 @@
 namespace ChipDB
 {
 
+/** The instances and nets made by createInstance() and createNet() are
+ *  allocated from the memory arenas of m_instances and m_nets. The pin to
+ *  net tables of the instances come from the instance arena too.
+*/
 class Netlist
 {
 public:
@@ -28,6 +33,11 @@ public:
     NamedStorage<Instance>  m_instances;
     NamedStorage<Net>       m_nets;
 
+    /** create an instance in the netlist.
+     *  returns an invalid KeyObjPair if the name is empty or already exists.
+    */
+    KeyObjPair<Instance> createInstance(const std::string &name, InstanceType insType, std::shared_ptr<Cell> cell);
+
     std::shared_ptr<Instance> lookupInstance(InstanceObjectKey key);
     KeyObjPair<Instance> lookupInstance(const std::string &name);
 
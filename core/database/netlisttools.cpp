@@ -3,8 +3,10 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 
+#include <algorithm>
 #include "netlisttools.h"
 #include "common/logging.h"
+#include "common/threadpool.h"
 
 
 bool LunaCore::NetlistTools::writePlacementFile(std::ostream &os, const ChipDB::Netlist *netlist)
@@ -97,52 +99,330 @@ bool LunaCore::NetlistTools::removeNetconInstances(ChipDB::Netlist &netlist)
     return true;
 }
 
-double LunaCore::NetlistTools::calcHPWL(const ChipDB::Netlist &netlist)
+double LunaCore::NetlistTools::calcHPWL(const ChipDB::Netlist &netlist, std::size_t threads)
 {
-    double hpwl = 0;
-    for(auto const netPtr : netlist.m_nets)
+    return NetBoxCache(netlist, threads).totalHPWL();
+}
+
+double LunaCore::NetlistTools::calcTotalCellArea(const ChipDB::Netlist &netlist)
+{
+    double um2 = 0.0;
+    for(auto const ins : netlist.m_instances)
     {
-        auto iter = netPtr->begin();
+        auto csize = ins->instanceSize();
+        double sx = static_cast<double>(csize.m_x) / 1000.0;
+        double sy = static_cast<double>(csize.m_y) / 1000.0;
+        um2 += sx*sy;
+    }
 
-        // skip if there are no connection on this net.
-        if (iter == netPtr->end())
-            continue;
+    return um2;
+}
+
+LunaCore::NetlistTools::NetBoxCache::NetBoxCache(const ChipDB::Netlist &netlist, std::size_t threads)
+{
+    rebuild(netlist, threads);
+}
+
+void LunaCore::NetlistTools::NetBoxCache::rebuild(const ChipDB::Netlist &netlist, std::size_t threads)
+{
+    ChipDB::InstanceObjectKey maxInsKey = -1;
+    for(auto const insKeyObjPair : netlist.m_instances)
+    {
+        maxInsKey = std::max(maxInsKey, insKeyObjPair.key());
+    }
+
+    m_centers.assign(maxInsKey + 1, ChipDB::Coord64{0,0});
+    for(auto const insKeyObjPair : netlist.m_instances)
+    {
+        m_centers[insKeyObjPair.key()] = insKeyObjPair->getCenter();
+    }
+
+    ChipDB::NetObjectKey maxNetKey = -1;
+    for(auto const netKeyObjPair : netlist.m_nets)
+    {
+        maxNetKey = std::max(maxNetKey, netKeyObjPair.key());
+    }
+
+    auto isKnownInstance = [this](ChipDB::InstanceObjectKey insKey)
+    {
+        return (insKey >= 0) && (static_cast<std::size_t>(insKey) < m_centers.size());
+    };
+
+    // the instance of each net connection, in order of net key.
+    m_netPinStart.assign(maxNetKey + 2, 0);
+    m_netPins.clear();
+    std::vector<std::size_t> insNetCount(m_centers.size() + 1, 0);
+    for(ChipDB::NetObjectKey netKey = 0; netKey <= maxNetKey; netKey++)
+    {
+        auto netPtr = netlist.m_nets[netKey];
+        if (netPtr)
+        {
+            for(auto const& conn : *netPtr)
+            {
+                if (!isKnownInstance(conn.m_instanceKey)) continue;
+
+                m_netPins.push_back(conn.m_instanceKey);
+                insNetCount[conn.m_instanceKey + 1]++;
+            }
+        }
+        m_netPinStart[netKey + 1] = m_netPins.size();
+    }
 
-        // get first cell
-        auto center = netlist.m_instances.at(iter->m_instanceKey)->getCenter();
-        ChipDB::Coord64 minCoord{center.m_x, center.m_y};
-        ChipDB::Coord64 maxCoord{center.m_x, center.m_y};
-        ++iter;
+    // the nets of each instance. An instance with several pins on a net
+    // appears once per pin, in order of net key, so the duplicates are adjacent.
+    std::vector<std::size_t> insPinStart(m_centers.size() + 1, 0);
+    for(std::size_t insIdx = 0; insIdx < m_centers.size(); insIdx++)
+    {
+        insPinStart[insIdx + 1] = insPinStart[insIdx] + insNetCount[insIdx + 1];
+    }
 
-        // process next cells
-        while(iter != netPtr->end())
+    std::vector<ChipDB::NetObjectKey> insPinNets(m_netPins.size());
+    auto fillPos = insPinStart;
+    for(ChipDB::NetObjectKey netKey = 0; netKey <= maxNetKey; netKey++)
+    {
+        for(auto pinIdx = m_netPinStart[netKey]; pinIdx < m_netPinStart[netKey + 1]; pinIdx++)
         {
-            center = netlist.m_instances.at(iter->m_instanceKey)->getCenter();
-            minCoord.m_x = std::min(minCoord.m_x, center.m_x);
-            minCoord.m_y = std::min(minCoord.m_y, center.m_y);
-            maxCoord.m_x = std::max(maxCoord.m_x, center.m_x);
-            maxCoord.m_y = std::max(maxCoord.m_y, center.m_y);
-            ++iter;
+            insPinNets[fillPos[m_netPins[pinIdx]]++] = netKey;
         }
+    }
 
-        // calculate final hpwl from the net extents
-        auto delta = maxCoord - minCoord;
-        hpwl += static_cast<double>(delta.m_x) + static_cast<double>(delta.m_y);
+    m_insNetStart.assign(m_centers.size() + 1, 0);
+    m_insNets.clear();
+    for(std::size_t insIdx = 0; insIdx < m_centers.size(); insIdx++)
+    {
+        for(auto idx = insPinStart[insIdx]; idx < insPinStart[insIdx + 1]; idx++)
+        {
+            if ((idx > insPinStart[insIdx]) && (insPinNets[idx] == insPinNets[idx-1]))
+            {
+                m_insNets.back().m_pinCount++;
+            }
+            else
+            {
+                m_insNets.push_back(NetRef{insPinNets[idx], 1});
+            }
+        }
+        m_insNetStart[insIdx + 1] = m_insNets.size();
     }
 
-    return hpwl;
+    // each net only writes its own box
+    m_boxes.assign(maxNetKey + 1, NetBox{});
+
+    const PoolSelection selection(threads);
+    selection.forEach(0, m_boxes.size(), [this](std::size_t netIdx)
+        {
+            computeBox(static_cast<ChipDB::NetObjectKey>(netIdx));
+        },
+        256
+    );
+
+    m_totalHPWL = 0;
+    for(auto const& box : m_boxes)
+    {
+        m_totalHPWL += box.hpwl();
+    }
 }
 
-double LunaCore::NetlistTools::calcTotalCellArea(const ChipDB::Netlist &netlist)
+void LunaCore::NetlistTools::NetBoxCache::computeBox(ChipDB::NetObjectKey netKey)
 {
-    double um2 = 0.0;
-    for(auto const ins : netlist.m_instances)
+    auto &box = m_boxes[netKey];
+    box = NetBox{};
+
+    const auto first = m_netPinStart[netKey];
+    const auto last  = m_netPinStart[netKey + 1];
+    if (first == last)
     {
-        auto csize = ins->instanceSize();
-        double sx = static_cast<double>(csize.m_x) / 1000.0;
-        double sy = static_cast<double>(csize.m_y) / 1000.0;
-        um2 += sx*sy;
+        return;
     }
 
-    return um2;
+    auto const& firstCenter = m_centers[m_netPins[first]];
+    box.m_xmin = box.m_xmax = firstCenter.m_x;
+    box.m_ymin = box.m_ymax = firstCenter.m_y;
+
+    for(auto pinIdx = first; pinIdx < last; pinIdx++)
+    {
+        auto const& center = m_centers[m_netPins[pinIdx]];
+        box.m_xmin = std::min(box.m_xmin, center.m_x);
+        box.m_xmax = std::max(box.m_xmax, center.m_x);
+        box.m_ymin = std::min(box.m_ymin, center.m_y);
+        box.m_ymax = std::max(box.m_ymax, center.m_y);
+    }
+
+    for(auto pinIdx = first; pinIdx < last; pinIdx++)
+    {
+        auto const& center = m_centers[m_netPins[pinIdx]];
+        if (center.m_x == box.m_xmin) box.m_xminCount++;
+        if (center.m_x == box.m_xmax) box.m_xmaxCount++;
+        if (center.m_y == box.m_ymin) box.m_yminCount++;
+        if (center.m_y == box.m_ymax) box.m_ymaxCount++;
+    }
+}
+
+/** update one side of a net box for pins that move from oldPos to newPos.
+ *  beyond(a,b) is true if a lies outside a side at b.
+ *  Returns false if the last pin left the side and the box must be computed again.
+*/
+template<class Compare>
+static bool updateSide(ChipDB::CoordType &side, uint32_t &count,
+    const ChipDB::CoordType oldPos, const ChipDB::CoordType newPos, const uint32_t pins, Compare beyond)
+{
+    if (beyond(newPos, side))
+    {
+        side  = newPos;
+        count = pins;
+        return true;
+    }
+
+    if (newPos == side)
+    {
+        count += pins;
+    }
+
+    if (oldPos == side)
+    {
+        count -= pins;
+        return count > 0;
+    }
+
+    return true;
+}
+
+ChipDB::CoordType LunaCore::NetlistTools::NetBoxCache::moveInstance(ChipDB::InstanceObjectKey insKey,
+    const ChipDB::Coord64 &center)
+{
+    auto &insCenter = m_centers.at(insKey);
+    const auto oldCenter = insCenter;
+    if ((oldCenter.m_x == center.m_x) && (oldCenter.m_y == center.m_y))
+    {
+        return 0;
+    }
+
+    // computeBox reads the new center
+    insCenter = center;
+
+    ChipDB::CoordType delta = 0;
+    for(auto idx = m_insNetStart[insKey]; idx < m_insNetStart[insKey + 1]; idx++)
+    {
+        auto const& netRef = m_insNets[idx];
+        auto &box = m_boxes[netRef.m_netKey];
+        const auto before = box.hpwl();
+
+        bool valid = true;
+        valid &= updateSide(box.m_xmin, box.m_xminCount, oldCenter.m_x, center.m_x, netRef.m_pinCount, std::less<ChipDB::CoordType>());
+        valid &= updateSide(box.m_xmax, box.m_xmaxCount, oldCenter.m_x, center.m_x, netRef.m_pinCount, std::greater<ChipDB::CoordType>());
+        valid &= updateSide(box.m_ymin, box.m_yminCount, oldCenter.m_y, center.m_y, netRef.m_pinCount, std::less<ChipDB::CoordType>());
+        valid &= updateSide(box.m_ymax, box.m_ymaxCount, oldCenter.m_y, center.m_y, netRef.m_pinCount, std::greater<ChipDB::CoordType>());
+
+        if (!valid)
+        {
+            computeBox(netRef.m_netKey);
+        }
+
+        delta += box.hpwl() - before;
+    }
+
+    m_totalHPWL += delta;
+    return delta;
+}
+
+ChipDB::CoordType LunaCore::NetlistTools::NetBoxCache::updateInstance(const ChipDB::Netlist &netlist,
+    ChipDB::InstanceObjectKey insKey)
+{
+    return moveInstance(insKey, netlist.m_instances.at(insKey)->getCenter());
+}
+
+ChipDB::CoordType LunaCore::NetlistTools::NetBoxCache::netHPWL(ChipDB::NetObjectKey netKey) const noexcept
+{
+    if ((netKey < 0) || (static_cast<std::size_t>(netKey) >= m_boxes.size()))
+    {
+        return 0;
+    }
+
+    return m_boxes[netKey].hpwl();
+}
+
+ChipDB::Rect64 LunaCore::NetlistTools::NetBoxCache::netBox(ChipDB::NetObjectKey netKey) const
+{
+    auto const& box = m_boxes.at(netKey);
+    return ChipDB::Rect64{{box.m_xmin, box.m_ymin}, {box.m_xmax, box.m_ymax}};
+}
+
+std::vector<ChipDB::NetObjectKey> LunaCore::NetlistTools::NetBoxCache::instanceNets(ChipDB::InstanceObjectKey insKey) const
+{
+    std::vector<ChipDB::NetObjectKey> nets;
+    for(auto idx = m_insNetStart.at(insKey); idx < m_insNetStart.at(insKey + 1); idx++)
+    {
+        nets.push_back(m_insNets[idx].m_netKey);
+    }
+    return nets;
+}
+
+uint32_t LunaCore::NetlistTools::NetBoxCache::pinCount(ChipDB::InstanceObjectKey insKey, ChipDB::NetObjectKey netKey) const
+{
+    for(auto idx = m_insNetStart.at(insKey); idx < m_insNetStart.at(insKey + 1); idx++)
+    {
+        if (m_insNets[idx].m_netKey == netKey)
+        {
+            return m_insNets[idx].m_pinCount;
+        }
+    }
+    return 0;
+}
+
+std::optional<ChipDB::Rect64> LunaCore::NetlistTools::NetBoxCache::netBoxWithout(ChipDB::NetObjectKey netKey,
+    std::span<const ChipDB::InstanceObjectKey> excluded) const
+{
+    auto const& box = m_boxes.at(netKey);
+
+    // the box only changes if all pins on a side are excluded
+    uint32_t excludedPins = 0;
+    uint32_t xminPins = 0;
+    uint32_t xmaxPins = 0;
+    uint32_t yminPins = 0;
+    uint32_t ymaxPins = 0;
+    for(auto insKey : excluded)
+    {
+        const auto pins = pinCount(insKey, netKey);
+        if (pins == 0) continue;
+
+        auto const& center = m_centers[insKey];
+        if (center.m_x == box.m_xmin) xminPins += pins;
+        if (center.m_x == box.m_xmax) xmaxPins += pins;
+        if (center.m_y == box.m_ymin) yminPins += pins;
+        if (center.m_y == box.m_ymax) ymaxPins += pins;
+        excludedPins += pins;
+    }
+
+    const auto first = m_netPinStart[netKey];
+    const auto last  = m_netPinStart[netKey + 1];
+    if (excludedPins == (last - first))
+    {
+        return std::nullopt;
+    }
+
+    if ((xminPins < box.m_xminCount) && (xmaxPins < box.m_xmaxCount) &&
+        (yminPins < box.m_yminCount) && (ymaxPins < box.m_ymaxCount))
+    {
+        return ChipDB::Rect64{{box.m_xmin, box.m_ymin}, {box.m_xmax, box.m_ymax}};
+    }
+
+    std::optional<ChipDB::Rect64> result;
+    for(auto pinIdx = first; pinIdx < last; pinIdx++)
+    {
+        const auto insKey = m_netPins[pinIdx];
+        if (std::find(excluded.begin(), excluded.end(), insKey) != excluded.end()) continue;
+
+        auto const& center = m_centers[insKey];
+        if (!result.has_value())
+        {
+            result = ChipDB::Rect64{center, center};
+            continue;
+        }
+
+        result->m_ll.m_x = std::min(result->m_ll.m_x, center.m_x);
+        result->m_ll.m_y = std::min(result->m_ll.m_y, center.m_y);
+        result->m_ur.m_x = std::max(result->m_ur.m_x, center.m_x);
+        result->m_ur.m_y = std::max(result->m_ur.m_y, center.m_y);
+    }
+
+    return result;
 }
@@ -5,6 +5,9 @@
 #pragma once
 
 #include <map>
+#include <optional>
+#include <span>
+#include <vector>
 #include "netlist.h"
 
 namespace LunaCore::NetlistTools
@@ -23,9 +26,111 @@ namespace LunaCore::NetlistTools
     /** remote NETCON instances from a netlist. FIXME: does not work!!! */
     bool removeNetconInstances(ChipDB::Netlist &netlist);
 
-    /** calculate half-perimiter wire length, ignoring the exact pin locations */
-    double calcHPWL(const ChipDB::Netlist &netlist);
+    /** calculate half-perimiter wire length, ignoring the exact pin locations.
+     *  threads: see NetBoxCache::rebuild, by default on the calling thread.
+    */
+    double calcHPWL(const ChipDB::Netlist &netlist, std::size_t threads = 1);
 
     /** calculate the total cell area of cells in the netlist */
     double calcTotalCellArea(const ChipDB::Netlist &netlist);
+
+    /** Bounding boxes of all nets, based on the instance centers like calcHPWL.
+     *
+     *  Each side of a box keeps the number of pins on it, so moving an instance
+     *  only scans a net when the last pin leaves a side of its box. Updates are
+     *  O(1) amortized per connected net.
+     *
+     *  The cache does not watch the netlist: call moveInstance or updateInstance
+     *  when an instance moves and rebuild when instances or nets are added or removed.
+    */
+    class NetBoxCache
+    {
+    public:
+        NetBoxCache() = default;
+
+        /** see rebuild() */
+        explicit NetBoxCache(const ChipDB::Netlist &netlist, std::size_t threads = 0);
+
+        /** read the netlist and compute all boxes.
+         *  threads: the thread count, see PoolSelection.
+        */
+        void rebuild(const ChipDB::Netlist &netlist, std::size_t threads = 0);
+
+        /** move the center of an instance, returns the change of the total HPWL */
+        ChipDB::CoordType moveInstance(ChipDB::InstanceObjectKey insKey, const ChipDB::Coord64 &center);
+
+        /** take the current center of an instance from the netlist, returns the change of the total HPWL */
+        ChipDB::CoordType updateInstance(const ChipDB::Netlist &netlist, ChipDB::InstanceObjectKey insKey);
+
+        /** total half-perimeter wire length */
+        [[nodiscard]] double totalHPWL() const noexcept
+        {
+            return static_cast<double>(m_totalHPWL);
+        }
+
+        /** half-perimeter wire length of a net, 0 for unknown nets */
+        [[nodiscard]] ChipDB::CoordType netHPWL(ChipDB::NetObjectKey netKey) const noexcept;
+
+        /** bounding box of the instance centers on a net */
+        [[nodiscard]] ChipDB::Rect64 netBox(ChipDB::NetObjectKey netKey) const;
+
+        /** bounding box of a net without the pins of the excluded instances,
+         *  or std::nullopt if no other pins remain. The cache is not changed.
+         *  This is used to evaluate several candidate positions of a set of instances.
+        */
+        [[nodiscard]] std::optional<ChipDB::Rect64> netBoxWithout(ChipDB::NetObjectKey netKey,
+            std::span<const ChipDB::InstanceObjectKey> excluded) const;
+
+        /** center of an instance as known by the cache */
+        [[nodiscard]] ChipDB::Coord64 instanceCenter(ChipDB::InstanceObjectKey insKey) const
+        {
+            return m_centers.at(insKey);
+        }
+
+        /** keys of the nets connected to an instance */
+        [[nodiscard]] std::vector<ChipDB::NetObjectKey> instanceNets(ChipDB::InstanceObjectKey insKey) const;
+
+    protected:
+        /** bounding box with the number of pins on each side */
+        struct NetBox
+        {
+            ChipDB::CoordType m_xmin{0};
+            ChipDB::CoordType m_xmax{0};
+            ChipDB::CoordType m_ymin{0};
+            ChipDB::CoordType m_ymax{0};
+            uint32_t m_xminCount{0};
+            uint32_t m_xmaxCount{0};
+            uint32_t m_yminCount{0};
+            uint32_t m_ymaxCount{0};
+
+            [[nodiscard]] constexpr ChipDB::CoordType hpwl() const noexcept
+            {
+                return (m_xmax - m_xmin) + (m_ymax - m_ymin);
+            }
+        };
+
+        /** a net connected to an instance and the number of pins of the instance on it */
+        struct NetRef
+        {
+            ChipDB::NetObjectKey m_netKey;
+            uint32_t m_pinCount;
+        };
+
+        /** number of pins of an instance on a net */
+        [[nodiscard]] uint32_t pinCount(ChipDB::InstanceObjectKey insKey, ChipDB::NetObjectKey netKey) const;
+
+        /** compute the box of a net from the centers of all its pins */
+        void computeBox(ChipDB::NetObjectKey netKey);
+
+        std::vector<ChipDB::Coord64>    m_centers;      ///< indexed by instance key
+        std::vector<NetBox>             m_boxes;        ///< indexed by net key
+
+        std::vector<std::size_t>        m_netPinStart;  ///< start of the pins of a net in m_netPins, indexed by net key
+        std::vector<ChipDB::InstanceObjectKey> m_netPins;   ///< instance of each net connection
+
+        std::vector<std::size_t>        m_insNetStart;  ///< start of the nets of an instance in m_insNets, indexed by instance key
+        std::vector<NetRef>             m_insNets;
+
+        int64_t m_totalHPWL{0};
+    };
 };
@@ -59,12 +59,12 @@ PinInfo(const std::string &name) :
 
     virtual ~PinInfo() = default;
 
-    std::string name() const noexcept
+    const Name& name() const noexcept
     {
         return m_name;
     }
 
-    std::string m_name;     ///< pin name
+    Name        m_name;     ///< pin name
 
     IOType      m_iotype;   ///< in/out type of pin
 
@@ -187,6 +187,15 @@ public:
         return nullptr;
     }
 
+    /** access pin by key without copying the shared pointer. returns nullptr if not found */
+    const PinInfo* rawPtr(ObjectKey pinKey) const noexcept
+    {
+        if ((pinKey < m_pins.size()) && (pinKey >= 0))
+            return m_pins[pinKey].get();
+
+        return nullptr;
+    }
+
     /** access pin by name. returns KeyObjPair of pin */
     KeyObjPair<PinInfo> operator[](const std::string &name);
 
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "dbtypes.h"
+
+namespace ChipDB
+{
+
+/** straight wire of a net route, in chip coordinates */
+struct RouteSegment
+{
+    Coord64     m_start;                    ///< end point nearest to the root of the route
+    Coord64     m_end;
+    ObjectKey   m_layer{ObjectNotFound};    ///< tech lib routing layer, ObjectNotFound if no layer was assigned
+    int32_t     m_parent{-1};               ///< index of the segment whose end point is m_start, -1 for a root segment
+
+    [[nodiscard]] constexpr bool isHorizontal() const noexcept
+    {
+        return m_start.m_y == m_end.m_y;
+    }
+
+    [[nodiscard]] int64_t length() const noexcept
+    {
+        return m_start.manhattanDistance(m_end);
+    }
+};
+
+/** Route topology of a net.
+ *
+ *  The segments form a tree and are stored parent first. Segments only
+ *  touch at their end points; the start of a segment is the end of its
+ *  parent. Where segments on different layers touch, a via stack is
+ *  assumed. Net connections are on the bottom routing layer and are
+ *  attached to the route at m_terminals, which holds one point per
+ *  net connection in connection order.
+*/
+struct NetRoute
+{
+    std::vector<RouteSegment>   m_segments;
+    std::vector<Coord64>        m_terminals;
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_terminals.empty();
+    }
+
+    void clear() noexcept
+    {
+        m_segments.clear();
+        m_terminals.clear();
+    }
+
+    /** total length of all segments in nm */
+    [[nodiscard]] int64_t length() const noexcept
+    {
+        int64_t total = 0;
+        for(auto const& segment : m_segments)
+        {
+            total += segment.length();
+        }
+        return total;
+    }
+};
+
+};
@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace ChipDB
+{
+
+/** A memory arena shared by the objects allocated from it.
+ *
+ *  Allocation takes no lock, so it needs the same exclusive access as
+ *  modifying the container that owns the arena. Releasing an object
+ *  does not touch the arena, its memory is returned when the last
+ *  object referring to the arena is gone. Objects can therefore be
+ *  released on any thread.
+*/
+using SharedPool = std::shared_ptr<std::pmr::memory_resource>;
+
+/** create a new arena */
+[[nodiscard]] inline SharedPool makeSharedPool()
+{
+    return std::make_shared<std::pmr::monotonic_buffer_resource>();
+}
+
+/** An allocator that keeps its arena alive.
+ *
+ *  std::allocate_shared stores a copy of the allocator in the control
+ *  block, so objects made with it own a reference to the arena and their
+ *  memory stays valid for as long as the objects are referenced, even
+ *  after the container that made them is cleared or destroyed.
+*/
+template<class T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(SharedPool pool) noexcept : m_pool(std::move(pool)) {}
+
+    template<class U>
+    PoolAllocator(const PoolAllocator<U> &other) noexcept : m_pool(other.pool()) {}
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(m_pool->allocate(n*sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept
+    {
+        m_pool->deallocate(ptr, n*sizeof(T), alignof(T));
+    }
+
+    [[nodiscard]] const SharedPool& pool() const noexcept
+    {
+        return m_pool;
+    }
+
+    template<class U>
+    friend bool operator==(const PoolAllocator &lhs, const PoolAllocator<U> &rhs) noexcept
+    {
+        return lhs.m_pool == rhs.pool();
+    }
+
+protected:
+    SharedPool m_pool;
+};
+
+};
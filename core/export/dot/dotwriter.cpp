@@ -244,7 +244,7 @@ void Writer::writeOutputs(std::ostream &os, const std::shared_ptr<ChipDB::Instan
     }
 }
 
-std::string Writer::escapeString(const std::string &txt)
+std::string Writer::escapeString(std::string_view txt)
 {
     std::string result;
     for(auto c : txt)
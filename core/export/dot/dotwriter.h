@@ -35,7 +35,7 @@ protected:
 
     void writeInputs(std::ostream &os, const std::shared_ptr<ChipDB::Instance> ins);
     void writeOutputs(std::ostream &os, const std::shared_ptr<ChipDB::Instance> ins);
-    std::string escapeString(const std::string &txt);
+    std::string escapeString(std::string_view txt);
 
     const std::shared_ptr<ChipDB::Module> m_module;
 };
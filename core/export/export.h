@@ -4,3 +4,4 @@
 #include "def/defwriter.h"
 #include "txt/txtwriter.h"
 #include "gds2/gds2writer.hpp"
+#include "spef/spefwriter.h"
@@ -2,11 +2,17 @@
 //
 // SPDX-License-Identifier: GPL-3.0-only
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <chrono>
+#include <tuple>
+#include <unordered_map>
 
 #include "version.h"
 #include "common/logging.h"
+#include "common/textbuffer.hpp"
+#include "common/threadpool.h"
 #include "database/database.h"
 #include "spefwriter.h"
 
@@ -34,241 +40,627 @@ static std::string escapeSPEFString(const std::string &str)
     return result;
 }
 
-bool LunaCore::SPEF::write(std::ostream &os, const std::shared_ptr<ChipDB::Module> module)
+namespace
 {
-    if (!os.good())
-    {
-        Logging::logError("SPEF writer: output stream is invalid!\n");
-        return false;
-    }
+    using LunaCore::TextBuffer;
+
+    const double FaradToPicofarad = 1.0e12;
+
+    constexpr std::size_t NetsPerChunk   = 256;  ///< number of nets formatted by one task
+    constexpr std::size_t ChunksPerBatch = 64;   ///< number of chunks held in memory before they are written
 
-    if (!module)
+    /** resistance and capacitance per micron of a routing layer */
+    struct LayerRC
     {
-        Logging::logError("SPEF writer: module is nullptr!\n");
-        return false;
+        ChipDB::ObjectKey m_key{ChipDB::ObjectNotFound};
+        bool    m_horizontal{true};
+        double  m_resistance{0.0};      ///< in ohms per micron
+        double  m_capacitance{0.0};     ///< in picofarads per micron
+        double  m_viaResistance{0.0};   ///< resistance of a via to the next routing layer in ohms
+    };
+
+    /** the routing layers of a tech lib, bottom layer first */
+    std::vector<LayerRC> routingLayerRC(const ChipDB::TechLib &techLib)
+    {
+        std::vector<LayerRC> layers;
+        for(auto const layer : techLib.layers())
+        {
+            if (!layer.isValid()) continue;
+
+            if (layer->m_type == ChipDB::LayerType::CUT)
+            {
+                // a cut layer connects the routing layer below it to the one above
+                if (!layers.empty()) layers.back().m_viaResistance += layer->m_resistance;
+                continue;
+            }
+
+            if (layer->m_type != ChipDB::LayerType::ROUTING) continue;
+
+            LayerRC rc;
+            rc.m_key = layer.key();
+            rc.m_horizontal = (layer->m_dir != ChipDB::LayerDirection::VERTICAL);
+
+            // use half the pitch when the layer has no width
+            auto width_nm = static_cast<double>(layer->m_width);
+            if (width_nm <= 0.0)
+            {
+                width_nm = static_cast<double>(rc.m_horizontal ? layer->m_pitch.m_y : layer->m_pitch.m_x) / 2.0;
+            }
+
+            const double width_um = width_nm / 1000.0;
+            if (width_um > 0.0)
+            {
+                rc.m_resistance = layer->m_resistance / width_um;
+            }
+
+            rc.m_capacitance = (layer->m_capacitance * width_um + 2.0 * layer->m_edgeCapacitance) * FaradToPicofarad;
+            layers.push_back(rc);
+        }
+        return layers;
     }
 
-    auto currentTime = std::chrono::system_clock::now();
-    auto currentTime_t = std::chrono::system_clock::to_time_t(currentTime);
-    auto timeString = std::string(std::ctime(&currentTime_t));
-
-    // remove end of lines from the time string
-    timeString.erase(std::remove(timeString.begin(), timeString.end(), '\n'), timeString.cend());
-
-    os << "*SPEF        " << quoted("IEEE 1481-2009") << "\n";
-    os << "*DESIGN      " << quoted(module->name()) << "\n";
-    os << "*DATE        " << quoted(timeString) << "\n";
-    os << "*VENDOR      " << quoted(LUNAVERSIONSTRING) << "\n";
-    os << "*PROGRAM     " << quoted(LUNAVERSIONSTRING) << "\n";
-    os << "*VERSION     " << quoted("1.1.0") << "\n";
-    //os << "*DESIGN_FLOW " << quoted("EXTERNAL_LOADS") << "\n";
-    os << "*DESIGN_FLOW " << quoted("") << "\n";
-    os << "*DIVIDER /\n";
-    os << "*DELIMITER :\n";
-    os << "*BUS_DELIMITER [ ]\n";
-    os << "*T_UNIT 1 NS\n";
-    os << "*C_UNIT 1 PF\n";
-    os << "*R_UNIT 1 OHM\n";
-    os << "*L_UNIT 1 HENRY\n";
-    os << "\n";
-
-    const float FaradToPicofarad = 1.0e12f;
-
-    // FIXME: do a much better job
-    // assume all pins on instances are in the center..
-
-    auto const &nets = module->m_netlist->m_nets;
-    auto const &instances = module->m_netlist->m_instances;
-
-    os << "*PORTS\n";
-    for(auto const portPins : module->m_pins)
+    /** index of the routing layer of a segment */
+    std::size_t layerIndex(const std::vector<LayerRC> &layers, const ChipDB::RouteSegment &segment)
     {
-        os << portPins->name() << " ";
-        switch(portPins->m_iotype)
+        for(std::size_t idx = 0; idx < layers.size(); idx++)
         {
-        case ChipDB::IOType::INPUT:
-            os << "I\n";
-            break;
-        case ChipDB::IOType::OUTPUT:
-            os << "O\n";
-            break;
-        case ChipDB::IOType::OUTPUT_TRI:
-        case ChipDB::IOType::IO:
-        case ChipDB::IOType::ANALOG:
-            os << "B\n";
-            break;
-        case ChipDB::IOType::POWER:
-            break;
-        case ChipDB::IOType::GROUND:
-            break;
-        case ChipDB::IOType::UNKNOWN:
-            break;
+            if (layers[idx].m_key == segment.m_layer) return idx;
         }
-    }
 
-    os << "\n";
+        // no layer was assigned, use the lowest layer in the direction of the segment
+        for(std::size_t idx = 0; idx < layers.size(); idx++)
+        {
+            if (layers[idx].m_horizontal == segment.isHorizontal()) return idx;
+        }
+        return 0;
+    }
 
-    std::size_t resCounter = 0;
+    struct PinData
+    {
+        std::string m_name;
+        bool        m_valid{false};
+        bool        m_isInput{false};
+        double      m_cap{0.0};         ///< in picofarads
+    };
 
-    for(auto const netKeyPair : nets)
+    struct InstanceData
+    {
+        std::string     m_token;        ///< name or name map index
+        ChipDB::Coord64 m_pos;
+        ChipDB::Coord64 m_center;
+        std::size_t     m_cell{0};      ///< index into WriterContext::m_cells
+        bool            m_isPort{false};
+    };
+
+    struct CellData
     {
-        float totalCap = 0.0f;
-        std::stringstream osDNETBody;
+        std::string             m_name;
+        std::vector<PinData>    m_pins;     ///< indexed by pin key
+    };
+
+    /** everything the nets are formatted from. It is gathered before
+     *  formatting so that names are built once and the nets can be
+     *  formatted concurrently without touching the database objects.
+    */
+    struct WriterContext
+    {
+        std::vector<InstanceData>       m_instances;    ///< indexed by instance key
+        std::vector<CellData>           m_cells;
+        std::vector<const ChipDB::Net*> m_nets;
+        std::vector<std::string>        m_netTokens;    ///< name or name map index of each net
+        std::vector<LayerRC>            m_layers;
 
-        // write the connections
-        // and while we are iteration over the nets
-        // collect the resistive parasitics too..
-        osDNETBody << "*CONN\n";
+        std::atomic<std::size_t>        m_routedNets{0};
+        std::atomic<std::size_t>        m_invalidPins{0};
 
-        bool portNet = netKeyPair->m_isPortNet;
-        for(auto const& conn : *netKeyPair)
+        [[nodiscard]] const PinData& pin(const InstanceData &ins, ChipDB::PinObjectKey pinKey) const
         {
-            auto const ins = instances.at(conn.m_instanceKey);
-            auto const pin = ins->getPin(conn.m_pinKey);
+            static const PinData invalidPin{"INVALID", false, false, 0.0};
+
+            auto const& pins = m_cells[ins.m_cell].m_pins;
+            if ((pinKey < 0) || (static_cast<std::size_t>(pinKey) >= pins.size())) return invalidPin;
+            return pins[pinKey];
+        }
+    };
+
+    /** formats the nets of a chunk. The scratch space is kept between nets. */
+    class NetFormatter
+    {
+    public:
+        explicit NetFormatter(WriterContext &ctx) : m_ctx(ctx) {}
 
-            if ((portNet) && (ins->getArchetypeName() == std::string("__PIN")))
+        void format(TextBuffer &buffer, std::size_t netIndex)
+        {
+            auto const& net = *m_ctx.m_nets[netIndex];
+            m_netToken = m_ctx.m_netTokens[netIndex];
+
+            const bool hasRoute = !m_ctx.m_layers.empty() && !net.m_route.empty() &&
+                (net.m_route.m_terminals.size() == net.numberOfConnections());
+
+            if (hasRoute)
             {
-                osDNETBody << "*P " << ins->name()<< " ";
-                // note direction of port pins is reversed!
-                if (pin.m_pinInfo->isInput())
-                {
-                    osDNETBody << "O *C " << ins->m_pos.m_x/1000.0 << " " << ins->m_pos.m_y/1000.0 << "\n";
-                }
-                else
-                {
-                    osDNETBody << "I *C " << ins->m_pos.m_x/1000.0 << " " << ins->m_pos.m_y/1000.0 << "\n";
-                }
+                formatRoutedNet(buffer, net);
+                m_ctx.m_routedNets++;
             }
             else
             {
-                osDNETBody << "*I " << ins->name() << ":" << pin.name() << " ";
-                if (pin.m_pinInfo->isInput())
-                {
-                    osDNETBody << "I *C " << ins->m_pos.m_x/1000.0 << " " << ins->m_pos.m_y/1000.0 << " *L " << pin.m_pinInfo->m_cap*FaradToPicofarad << "\n";
-                    totalCap += pin.m_pinInfo->m_cap*FaradToPicofarad;
-                }
-                else
-                {
-                    osDNETBody << "O *C " << ins->m_pos.m_x/1000.0 << " " << ins->m_pos.m_y/1000.0 << " ";
-                    osDNETBody << "*D " << ins->getArchetypeName() << "\n";
-                }
+                formatStarNet(buffer, net);
             }
         }
 
-        // write DNET now we know the total capacitance...
-        os << "*D_NET " << escapeSPEFString(netKeyPair->name()) << " " << totalCap << "\n";
-        os << osDNETBody.str();
+    protected:
+        struct NodeKey
+        {
+            int64_t     m_x{0};
+            int64_t     m_y{0};
+            std::size_t m_layer{0};
+
+            friend bool operator==(const NodeKey&, const NodeKey&) = default;
+        };
 
-        // create resistor section
-        // we simply take the first connection and calculate the
-        // distance between all the other connections (manhattan)
-        // based on this length, we connect it all together
-        // FIXME: make a better network based on the PRIM/GlobalRouter segment network!
+        struct NodeKeyHash
+        {
+            std::size_t operator()(const NodeKey &key) const noexcept
+            {
+                auto h = static_cast<uint64_t>(key.m_x) * 0x9E3779B97F4A7C15ULL;
+                h ^= static_cast<uint64_t>(key.m_y) + 0x632BE59BD9B4E019ULL + (h << 6) + (h >> 2);
+                h ^= static_cast<uint64_t>(key.m_layer) + (h << 6) + (h >> 2);
+                return static_cast<std::size_t>(h);
+            }
+        };
+
+        /** a resistor node: an internal node when >= 0,
+         *  connection -(node+1) when negative.
+        */
+        using NodeRef = int64_t;
+
+        struct Resistor
+        {
+            NodeRef m_node1;
+            NodeRef m_node2;
+            double  m_value;
+        };
 
-        auto connIter = netKeyPair->begin();
-        if (connIter != netKeyPair->end())
+        static constexpr NodeRef connectionRef(std::size_t conn) noexcept
         {
-            os << "*RES\n";
-            auto const srcIns = instances.at(connIter->m_instanceKey);
-            auto const srcPin = srcIns->getPin(connIter->m_pinKey);
+            return -static_cast<NodeRef>(conn) - 1;
+        }
 
-            if (!srcPin.isValid())
+        std::size_t getNode(const ChipDB::Coord64 &p, std::size_t layer)
+        {
+            auto [iter, inserted] = m_nodeIndex.try_emplace(NodeKey{p.m_x, p.m_y, layer}, m_nodes.size());
+            if (inserted)
             {
-                Logging::logError("Invalid pin %ld key on instance %s of type %s\n",
-                    connIter->m_pinKey, srcIns->name().c_str(), srcIns->getArchetypeName().c_str());
+                m_nodes.push_back(iter->first);
+                m_nodeCap.push_back(0.0);
             }
+            return iter->second;
+        }
 
-            if (!srcIns)
+        void writeConnectionName(TextBuffer &buffer, const ChipDB::Net::NetConnect &conn) const
+        {
+            auto const& ins = m_ctx.m_instances[conn.m_instanceKey];
+            buffer << ins.m_token;
+            if (!ins.m_isPort)
             {
-                Logging::logError("Invalid instance key: %ld\n", connIter->m_instanceKey);
+                buffer << ':' << m_ctx.pin(ins, conn.m_pinKey).m_name;
             }
+        }
 
-            std::string srcName;
-            if (srcIns->getArchetypeName() == std::string("__PIN"))
+        void writeNode(TextBuffer &buffer, const ChipDB::Net &net, NodeRef node) const
+        {
+            if (node >= 0)
             {
-                srcName = escapeSPEFString(srcIns->name());
+                buffer << m_netToken << ':' << (node + 1);
             }
             else
             {
-                srcName = srcIns->name() + ":" + srcPin.name();
+                writeConnectionName(buffer, *(net.begin() + (-node - 1)));
             }
+        }
 
-            connIter++;
-            while(connIter != netKeyPair->end())
+        /** total load capacitance of the pins of a net in pF */
+        double pinCapacitance(const ChipDB::Net &net) const
+        {
+            double cap = 0.0;
+            for(auto const& conn : net)
             {
-                auto const dstIns = instances.at(connIter->m_instanceKey);
-                auto const dstPin = dstIns->getPin(connIter->m_pinKey);
+                auto const& ins = m_ctx.m_instances[conn.m_instanceKey];
+                auto const& pin = m_ctx.pin(ins, conn.m_pinKey);
+                if (!ins.m_isPort && pin.m_isInput) cap += pin.m_cap;
+            }
+            return cap;
+        }
 
-                if (!dstPin.isValid())
+        void writeConnections(TextBuffer &buffer, const ChipDB::Net &net) const
+        {
+            buffer << "*CONN\n";
+
+            for(auto const& conn : net)
+            {
+                auto const& ins = m_ctx.m_instances[conn.m_instanceKey];
+                auto const& pin = m_ctx.pin(ins, conn.m_pinKey);
+
+                if (!pin.m_valid) m_ctx.m_invalidPins++;
+
+                const double x = static_cast<double>(ins.m_pos.m_x) / 1000.0;
+                const double y = static_cast<double>(ins.m_pos.m_y) / 1000.0;
+
+                if (net.m_isPortNet && ins.m_isPort)
                 {
-                    Logging::logError("Invalid pin %ld key on instance %s of type %s\n",
-                        connIter->m_pinKey, dstIns->name().c_str(), dstIns->getArchetypeName().c_str());
+                    // note direction of port pins is reversed!
+                    buffer << "*P " << ins.m_token << (pin.m_isInput ? " O" : " I");
+                    buffer << " *C " << x << ' ' << y << '\n';
                 }
-
-                if (!dstIns)
+                else
                 {
-                    Logging::logError("Invalid instance key: %ld\n", connIter->m_instanceKey);
+                    buffer << "*I ";
+                    writeConnectionName(buffer, conn);
+                    if (pin.m_isInput)
+                    {
+                        buffer << " I *C " << x << ' ' << y << " *L " << pin.m_cap << '\n';
+                    }
+                    else
+                    {
+                        buffer << " O *C " << x << ' ' << y << " *D " << m_ctx.m_cells[ins.m_cell].m_name << '\n';
+                    }
                 }
+            }
+        }
 
-                std::string dstName;
-                if (dstIns->getArchetypeName() == std::string("__PIN"))
+        void writeResistors(TextBuffer &buffer, const ChipDB::Net &net) const
+        {
+            buffer << "*RES\n";
+            std::size_t resCounter = 1;
+            for(auto const& resistor : m_resistors)
+            {
+                buffer << resCounter++ << ' ';
+                writeNode(buffer, net, resistor.m_node1);
+                buffer << ' ';
+                writeNode(buffer, net, resistor.m_node2);
+                buffer << ' ' << resistor.m_value << '\n';
+            }
+        }
+
+        /** write the parasitics of a net that has a global route.
+         *  Every segment is a resistor between its end points with half of
+         *  its capacitance at either end. Segments on different layers are
+         *  connected by via stacks and each connection is connected to its
+         *  terminal by a wire on the bottom layer.
+        */
+        void formatRoutedNet(TextBuffer &buffer, const ChipDB::Net &net)
+        {
+            auto const& route  = net.m_route;
+            auto const& layers = m_ctx.m_layers;
+
+            m_nodeIndex.clear();
+            m_nodes.clear();
+            m_nodeCap.clear();
+            m_resistors.clear();
+
+            double wireCap = 0.0;
+            for(auto const& segment : route.m_segments)
+            {
+                const auto layer = layerIndex(layers, segment);
+                const auto node1 = getNode(segment.m_start, layer);
+                const auto node2 = getNode(segment.m_end, layer);
+
+                const double length_um = static_cast<double>(segment.length()) / 1000.0;
+                const double cap = layers[layer].m_capacitance * length_um;
+                m_nodeCap[node1] += cap / 2.0;
+                m_nodeCap[node2] += cap / 2.0;
+                wireCap += cap;
+
+                m_resistors.push_back({static_cast<NodeRef>(node1), static_cast<NodeRef>(node2),
+                    layers[layer].m_resistance * length_um});
+            }
+
+            // connections are on the bottom layer
+            std::size_t connIdx = 0;
+            for(auto const& conn : net)
+            {
+                auto const& ins = m_ctx.m_instances[conn.m_instanceKey];
+                auto const& terminal = route.m_terminals[connIdx];
+                const auto node = getNode(terminal, 0);
+
+                const double length_um = static_cast<double>(ins.m_center.manhattanDistance(terminal)) / 1000.0;
+                const double cap = layers[0].m_capacitance * length_um;
+                m_nodeCap[node] += cap;
+                wireCap += cap;
+
+                m_resistors.push_back({connectionRef(connIdx), static_cast<NodeRef>(node),
+                    layers[0].m_resistance * length_um});
+                connIdx++;
+            }
+
+            // via stacks between the layers that meet at a point
+            m_order.resize(m_nodes.size());
+            for(std::size_t idx = 0; idx < m_order.size(); idx++) m_order[idx] = idx;
+            std::sort(m_order.begin(), m_order.end(), [this](std::size_t a, std::size_t b)
                 {
-                    dstName = escapeSPEFString(dstIns->name());
+                    auto const& na = m_nodes[a];
+                    auto const& nb = m_nodes[b];
+                    return std::tie(na.m_x, na.m_y, na.m_layer) < std::tie(nb.m_x, nb.m_y, nb.m_layer);
                 }
-                else
+            );
+
+            for(std::size_t idx = 1; idx < m_order.size(); idx++)
+            {
+                auto const& lower = m_nodes[m_order[idx-1]];
+                auto const& upper = m_nodes[m_order[idx]];
+                if ((lower.m_x != upper.m_x) || (lower.m_y != upper.m_y)) continue;
+
+                double viaResistance = 0.0;
+                for(auto layer = lower.m_layer; layer < upper.m_layer; layer++)
                 {
-                    dstName = dstIns->name() + ":" + dstPin.name();
+                    viaResistance += layers[layer].m_viaResistance;
                 }
 
-                // we calculate parasitics here based on the manahattan distance
-                // length is in nm
-                auto d = srcIns->m_pos.manhattanDistance(dstIns->m_pos);
+                m_resistors.push_back({static_cast<NodeRef>(m_order[idx-1]), static_cast<NodeRef>(m_order[idx]),
+                    viaResistance});
+            }
+
+            buffer << "*D_NET " << m_netToken << ' ' << (pinCapacitance(net) + wireCap) << '\n';
+            writeConnections(buffer, net);
+
+            buffer << "*CAP\n";
+            std::size_t capCounter = 1;
+            for(std::size_t node = 0; node < m_nodeCap.size(); node++)
+            {
+                if (m_nodeCap[node] <= 0.0) continue;
+                buffer << capCounter++ << ' ' << m_netToken << ':' << (node + 1) << ' ' << m_nodeCap[node] << '\n';
+            }
+
+            writeResistors(buffer, net);
+            buffer << "*END\n\n";
+        }
+
+        /** write the parasitics of a net without a global route.
+         *  The first connection is connected to all the others
+         *  based on the manhattan distance.
+        */
+        void formatStarNet(TextBuffer &buffer, const ChipDB::Net &net)
+        {
+            buffer << "*D_NET " << m_netToken << ' ' << pinCapacitance(net) << '\n';
+            writeConnections(buffer, net);
+
+            auto connIter = net.begin();
+            if (connIter != net.end())
+            {
+                m_resistors.clear();
 
-                //FIXME:
-                // for now we take the OSU/TSMC180 value of 0.08 ohm per square
+                auto const& srcIns = m_ctx.m_instances[connIter->m_instanceKey];
+
+                // without a route there are no layers, so we take the
+                // OSU/TSMC180 value of 0.08 ohm per square
                 // each wire is 300nm wide, so a length of 300 nm is 0.08 ohms
-                const float RperSqInOhms = 0.08f;
-                const float trackWidth   = 300.0f;  // in nm.
+                const double RperSqInOhms = 0.08;
+                const double trackWidth   = 300.0;  // in nm.
 
-                const float area_um2 = (trackWidth/1000.0f) * (d/1000.0f);
-                const float cap_pf = (3.8e-17 * area_um2) / 1.0e-12;
+                for(std::size_t connIdx = 1; connIdx < net.numberOfConnections(); connIdx++)
+                {
+                    auto const& dstIns = m_ctx.m_instances[(connIter + connIdx)->m_instanceKey];
 
-                os << "// capacitance in pf: " << cap_pf << "\n";
-                os << resCounter << " " << srcName << " " << dstName << " ";
-                os << (RperSqInOhms*static_cast<float>(d/trackWidth)) << "\n";
-                resCounter++;
-                connIter++;
+                    // length is in nm
+                    const auto d = srcIns.m_pos.manhattanDistance(dstIns.m_pos);
+                    m_resistors.push_back({connectionRef(0), connectionRef(connIdx),
+                        RperSqInOhms * static_cast<double>(d) / trackWidth});
+                }
+
+                writeResistors(buffer, net);
             }
+
+            buffer << "*END\n\n";
         }
 
-        os << "*END\n\n";
-    }
+        WriterContext   &m_ctx;
+        std::string_view m_netToken;
 
-#if 0
-    os << "# Routing positions to center of the cells. Generated by LunaPnR " LUNAVERSIONSTRING "\n";
-    os << "# Format: <number of points> <point1 x> <point1 y> ... <pointN x> <pointN y> <newline>\n";
+        std::unordered_map<NodeKey, std::size_t, NodeKeyHash> m_nodeIndex;
+        std::vector<NodeKey>    m_nodes;
+        std::vector<double>     m_nodeCap;
+        std::vector<Resistor>   m_resistors;
+        std::vector<std::size_t> m_order;
+    };
 
-    for(auto const netKeyPair : netlist->m_nets)
+    /** gather the instance, cell and net data of a module */
+    void createContext(WriterContext &ctx, const ChipDB::Module &module, const LunaCore::SPEF::Options &options,
+        TextBuffer &nameMap)
     {
-        // write number of points in the net
-        os << netKeyPair->numberOfConnections() << " ";
+        auto const& netlist = *module.m_netlist;
+
+        std::size_t nameIndex = 1;
+        auto makeToken = [&](const std::string &name)
+        {
+            auto escaped = escapeSPEFString(name);
+            if (!options.m_nameMap) return escaped;
 
-        // write locations of all the terminals
-        for(auto netConnect : *netKeyPair)
+            nameMap << '*' << nameIndex << ' ' << escaped << '\n';
+            return "*" + std::to_string(nameIndex++);
+        };
+
+        ctx.m_nets.reserve(netlist.m_nets.size());
+        ctx.m_netTokens.reserve(netlist.m_nets.size());
+        for(auto const netKeyPair : netlist.m_nets)
         {
-            auto ins = netlist->lookupInstance(netConnect.m_instanceKey);
-            if (!ins->isPlaced())
+            ctx.m_nets.push_back(netKeyPair.rawPtr());
+            ctx.m_netTokens.push_back(makeToken(netKeyPair->name()));
+        }
+
+        ChipDB::ObjectKey maxKey = -1;
+        for(auto const insKeyPair : netlist.m_instances)
+        {
+            maxKey = std::max(maxKey, insKeyPair.key());
+        }
+        ctx.m_instances.resize(static_cast<std::size_t>(maxKey + 1));
+
+        std::unordered_map<const ChipDB::Cell*, std::size_t> cellIndex;
+        for(auto const insKeyPair : netlist.m_instances)
+        {
+            auto const& ins = *insKeyPair;
+            auto &data = ctx.m_instances[insKeyPair.key()];
+
+            auto const archetype = ins.getArchetypeName();
+            data.m_isPort = (archetype == "__PIN");
+            data.m_token  = data.m_isPort ? escapeSPEFString(ins.name()) : makeToken(ins.name());
+            data.m_pos    = ins.m_pos;
+            data.m_center = ins.getCenter();
+
+            auto const cell = ins.cell();
+            auto [iter, inserted] = cellIndex.try_emplace(cell.get(), ctx.m_cells.size());
+            data.m_cell = iter->second;
+            if (!inserted) continue;
+
+            auto &cellData = ctx.m_cells.emplace_back();
+            cellData.m_name = archetype;
+            if (!cell) continue;
+
+            cellData.m_pins.resize(cell->m_pins.size());
+            for(std::size_t pinKey = 0; pinKey < cellData.m_pins.size(); pinKey++)
             {
-                Logging::doLog(Logging::LogType::WARNING,"TXT writer: instance %s has no location / is not placed.!\n", ins->name().c_str());
-                return false;
+                auto const pin = ins.getPin(static_cast<ChipDB::PinObjectKey>(pinKey));
+                if (!pin.isValid()) continue;
+
+                auto &pinData = cellData.m_pins[pinKey];
+                pinData.m_name    = pin.name();
+                pinData.m_valid   = true;
+                pinData.m_isInput = pin.m_pinInfo->isInput();
+                pinData.m_cap     = pin.m_pinInfo->m_cap * FaradToPicofarad;
             }
+        }
+    }
+
+    bool writeSPEF(std::ostream &os, const std::shared_ptr<ChipDB::Module> module,
+        const ChipDB::TechLib *techLib, const LunaCore::SPEF::Options &options)
+    {
+        if (!os.good())
+        {
+            Logging::logError("SPEF writer: output stream is invalid!\n");
+            return false;
+        }
 
-            os << ins->m_pos.m_x << " " << ins->m_pos.m_y << "  ";
+        if (!module)
+        {
+            Logging::logError("SPEF writer: module is nullptr!\n");
+            return false;
         }
-        os << "\n";
+
+        auto currentTime = std::chrono::system_clock::now();
+        auto currentTime_t = std::chrono::system_clock::to_time_t(currentTime);
+        auto timeString = std::string(std::ctime(&currentTime_t));
+
+        // remove end of lines from the time string
+        timeString.erase(std::remove(timeString.begin(), timeString.end(), '\n'), timeString.cend());
+
+        LunaCore::TextBuffer buffer;
+        buffer << "*SPEF        " << quoted("IEEE 1481-2009") << "\n";
+        buffer << "*DESIGN      " << quoted(module->name()) << "\n";
+        buffer << "*DATE        " << ::quoted(timeString) << "\n";
+        buffer << "*VENDOR      " << quoted(LUNAVERSIONSTRING) << "\n";
+        buffer << "*PROGRAM     " << quoted(LUNAVERSIONSTRING) << "\n";
+        buffer << "*VERSION     " << quoted("1.1.0") << "\n";
+        //buffer << "*DESIGN_FLOW " << quoted("EXTERNAL_LOADS") << "\n";
+        buffer << "*DESIGN_FLOW " << quoted("") << "\n";
+        buffer << "*DIVIDER /\n";
+        buffer << "*DELIMITER :\n";
+        buffer << "*BUS_DELIMITER [ ]\n";
+        buffer << "*T_UNIT 1 NS\n";
+        buffer << "*C_UNIT 1 PF\n";
+        buffer << "*R_UNIT 1 OHM\n";
+        buffer << "*L_UNIT 1 HENRY\n";
+        buffer << "\n";
+
+        WriterContext ctx;
+        if (techLib != nullptr)
+        {
+            ctx.m_layers = routingLayerRC(*techLib);
+        }
+
+        TextBuffer nameMap;
+        createContext(ctx, *module, options, nameMap);
+
+        if (options.m_nameMap)
+        {
+            buffer << "*NAME_MAP\n" << nameMap.view() << "\n";
+            nameMap = TextBuffer();
+        }
+
+        buffer << "*PORTS\n";
+        for(auto const& portPins : module->m_pins)
+        {
+            switch(portPins->m_iotype)
+            {
+            case ChipDB::IOType::INPUT:
+                buffer << portPins->name() << " I\n";
+                break;
+            case ChipDB::IOType::OUTPUT:
+                buffer << portPins->name() << " O\n";
+                break;
+            case ChipDB::IOType::OUTPUT_TRI:
+            case ChipDB::IOType::IO:
+            case ChipDB::IOType::ANALOG:
+                buffer << portPins->name() << " B\n";
+                break;
+            case ChipDB::IOType::POWER:
+            case ChipDB::IOType::GROUND:
+            case ChipDB::IOType::UNKNOWN:
+                break;
+            }
+        }
+
+        buffer << "\n";
+        buffer.flush(os);
+
+        const LunaCore::PoolSelection threads(options.m_threads);
+
+        // format a batch of chunks, then write them in order
+        std::vector<TextBuffer> chunks(ChunksPerBatch);
+        const std::size_t netCount = ctx.m_nets.size();
+        for(std::size_t batchStart = 0; batchStart < netCount; batchStart += NetsPerChunk * ChunksPerBatch)
+        {
+            const auto batchEnd   = std::min(netCount, batchStart + NetsPerChunk * ChunksPerBatch);
+            const auto chunkCount = (batchEnd - batchStart + NetsPerChunk - 1) / NetsPerChunk;
+
+            auto formatChunk = [&](std::size_t chunk)
+            {
+                NetFormatter formatter(ctx);
+                const auto first = batchStart + chunk * NetsPerChunk;
+                const auto last  = std::min(batchEnd, first + NetsPerChunk);
+                for(auto netIndex = first; netIndex < last; netIndex++)
+                {
+                    formatter.format(chunks[chunk], netIndex);
+                }
+            };
+
+            threads.forEach(0, chunkCount, formatChunk);
+
+            for(std::size_t chunk = 0; chunk < chunkCount; chunk++)
+            {
+                chunks[chunk].flush(os);
+            }
+        }
+
+        if (ctx.m_invalidPins > 0)
+        {
+            Logging::logError("SPEF writer: %lu connections refer to an invalid pin\n", ctx.m_invalidPins.load());
+        }
+
+        Logging::logVerbose("SPEF writer: %lu of %lu nets extracted from their route\n",
+            ctx.m_routedNets.load(), netCount);
+
+        return os.good();
     }
-#endif
-    return true;
+};
+
+bool LunaCore::SPEF::write(std::ostream &os, const std::shared_ptr<ChipDB::Module> module)
+{
+    return writeSPEF(os, module, nullptr, Options{});
+}
+
+bool LunaCore::SPEF::write(std::ostream &os, const std::shared_ptr<ChipDB::Module> module,
+    const ChipDB::TechLib &techLib, const Options &options)
+{
+    return writeSPEF(os, module, &techLib, options);
 }
 
 bool LunaCore::SPEF::write(const std::string &filename, const std::shared_ptr<ChipDB::Module> module)
@@ -280,5 +672,18 @@ bool LunaCore::SPEF::write(const std::string &filename, const std::shared_ptr<Ch
         return false;
     }
 
-    return LunaCore::SPEF::write(ofile, module);
+    return writeSPEF(ofile, module, nullptr, Options{});
+}
+
+bool LunaCore::SPEF::write(const std::string &filename, const std::shared_ptr<ChipDB::Module> module,
+    const ChipDB::TechLib &techLib, const Options &options)
+{
+    std::ofstream ofile(filename);
+    if (!ofile.good())
+    {
+        Logging::logError("SPEF writer: cannot open file %s for writing!\n", filename.c_str());
+        return false;
+    }
+
+    return writeSPEF(ofile, module, &techLib, options);
 }
@@ -10,12 +10,27 @@
 #include "database/database.h"
 
 /** Parasitic file output for OpenSTA
- *  For now, it only does manhattan segment lengths from source to sink,
- *  all tied at the source.
+ *  Nets with a global route are extracted from the route using the
+ *  resistance and capacitance of the routing layers of the tech lib.
+ *  Other nets, or all nets when no tech lib is given, use manhattan
+ *  segment lengths from source to sink, all tied at the source.
  *
+ *  The nets are formatted in chunks, concurrently if so desired, and
+ *  the chunks are written in net order.
 */
 namespace LunaCore::SPEF
 {
+    struct Options
+    {
+        bool        m_nameMap{false};   ///< write a *NAME_MAP and refer to nets and instances by index
+
+        std::size_t m_threads{0};       ///< thread count, see PoolSelection
+    };
+
     bool write(std::ostream &os, const std::shared_ptr<ChipDB::Module> mod);
+    bool write(std::ostream &os, const std::shared_ptr<ChipDB::Module> mod, const ChipDB::TechLib &techLib,
+        const Options &options = {});
     bool write(const std::string &filename, const std::shared_ptr<ChipDB::Module> mod);
+    bool write(const std::string &filename, const std::shared_ptr<ChipDB::Module> mod, const ChipDB::TechLib &techLib,
+        const Options &options = {});
 };
@@ -11,15 +11,15 @@
 
 using namespace LunaCore::Verilog;
 
-static std::string escapeVerilogName(const std::string &name)
+static std::string escapeVerilogName(std::string_view name)
 {
     auto iter = name.find_first_of('[');
     if (iter != std::string::npos)
     {
-        return "\\" + name + " ";
+        return "\\" + std::string(name) + " ";
     }
 
-    return name;
+    return std::string(name);
 }
 
 bool Writer::write(std::ostream &os, const std::shared_ptr<ChipDB::Module> mod)
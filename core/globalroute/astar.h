@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstddef>
+#include "datatypes.h"
+#include "wavefront.h"
+
+namespace LunaCore::GlobalRouter
+{
+
+/** A* search on a four-connected grid of cells.
+ *
+ *  The cost of a path is the sum of the cost of the cells it enters plus
+ *  bendPenalty for every change of direction. The heuristic is the
+ *  Manhattan distance to the target times distanceCost, which must not
+ *  exceed the cost of any cell so the first path found to the target
+ *  is a cheapest one.
+ *
+ *  The search state is kept by the caller, through a Cells object with:
+ *    bool canEnter(const GCellCoord &pos)      pos is inside the search area and not blocked
+ *    PathCostType cellCost(const GCellCoord &pos)  cost of entering pos
+ *    PathCostType cost(const GCellCoord &pos)  cost of the cheapest path to pos found so far
+ *    Predecessor predecessor(const GCellCoord &pos)
+ *    void update(const GCellCoord &pos, PathCostType cost, Predecessor pred)
+ *
+ *  The sources must be on the wavefront and have their cost set.
+ *  Returns true when the target is reached, its path follows the
+ *  predecessors back to a source. evaluations is incremented for
+ *  every cell taken from the wavefront.
+*/
+template<typename Cells>
+bool aStarSearch(Wavefront &wavefront, const GCellCoord &target,
+    PathCostType distanceCost, PathCostType bendPenalty, Cells &cells, std::size_t &evaluations)
+{
+    auto heuristic = [&target, distanceCost](const GCellCoord &pos)
+    {
+        return distanceCost * pos.manhattanDistance(target);
+    };
+
+    auto expand = [&](PathCostType fromCost, Predecessor fromPred, const GCellCoord &to, Predecessor pred)
+    {
+        if (!cells.canEnter(to)) return;
+
+        auto cost = fromCost + cells.cellCost(to);
+        if ((fromPred != pred) && (fromPred != Predecessor::Undefined))
+        {
+            cost += bendPenalty;
+        }
+
+        if (cells.cost(to) <= cost) return;
+
+        cells.update(to, cost, pred);
+
+        WavefrontItem item;
+        item.m_gridpos  = to;
+        item.m_pred     = pred;
+        item.m_pathCost = cost + heuristic(to);
+        wavefront.push(item);
+    };
+
+    while(!wavefront.empty())
+    {
+        const auto item = wavefront.getLowestCostItem();
+        wavefront.pop();
+
+        const auto pos  = item.m_gridpos;
+        const auto cost = cells.cost(pos);
+
+        // skip items that were superseded by a cheaper path
+        if (item.m_pathCost > cost + heuristic(pos)) continue;
+
+        evaluations++;
+
+        if (pos == target)
+        {
+            return true;
+        }
+
+        const auto pred = cells.predecessor(pos);
+        expand(cost, pred, north(pos), Predecessor::South);
+        expand(cost, pred, south(pos), Predecessor::North);
+        expand(cost, pred, east(pos),  Predecessor::West);
+        expand(cost, pred, west(pos),  Predecessor::East);
+    }
+
+    return false;
+}
+
+};
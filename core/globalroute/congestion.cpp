@@ -0,0 +1,149 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include "common/logging.h"
+#include "common/strutils.hpp"
+#include "export/ppm/ppmwriter.h"
+#include "export/svg/svgwriter.h"
+#include "congestion.h"
+
+using namespace LunaCore::GlobalRouter;
+
+namespace
+{
+    /** size of a GCell in the SVG map, in SVG units */
+    constexpr int64_t SvgCellSize = 8;
+
+    /** heat map colour in RGBA format, green for unused to red for full */
+    uint32_t heatColour(int64_t usage, int64_t capacity)
+    {
+        if (usage > capacity) return 0xFF00FFFF;
+
+        const float ratio = (capacity > 0) ? static_cast<float>(usage) / static_cast<float>(capacity) : 1.0f;
+        const auto red   = static_cast<uint32_t>(255.0f * ratio);
+        const auto green = 255 - red;
+        return (red << 24) | (green << 16) | 0xFF;
+    }
+};
+
+CongestionStats LunaCore::GlobalRouter::calcCongestion(const Grid &grid)
+{
+    CongestionStats stats;
+
+    const int64_t capacity = grid.maxCellCapacity();
+    double utilisation = 0.0;
+
+    for(auto const& cell : grid.gcells())
+    {
+        stats.m_cells++;
+        if (cell.isBlocked())
+        {
+            stats.m_blockedCells++;
+            continue;
+        }
+
+        const int64_t usage = cell.m_capacity;
+        if (usage > 0) stats.m_usedCells++;
+        if (usage > capacity)
+        {
+            stats.m_overflowCells++;
+            stats.m_totalOverflow += usage - capacity;
+        }
+
+        stats.m_maxUsage = std::max(stats.m_maxUsage, usage);
+        if (capacity > 0) utilisation += static_cast<double>(usage) / static_cast<double>(capacity);
+    }
+
+    const auto unblocked = stats.m_cells - stats.m_blockedCells;
+    if (unblocked > 0)
+    {
+        stats.m_averageUtilisation = utilisation / static_cast<double>(unblocked);
+    }
+
+    return stats;
+}
+
+bool LunaCore::GlobalRouter::writeCongestionCSV(std::ostream &os, const Grid &grid)
+{
+    if (!os.good()) return false;
+
+    const auto capacity = grid.maxCellCapacity();
+
+    os << "x,y,usage,capacity,blocked\n";
+    for(GCellCoordType y = 0; y < grid.height(); y++)
+    {
+        for(GCellCoordType x = 0; x < grid.width(); x++)
+        {
+            auto const& cell = grid.at(x,y);
+            os << x << "," << y << "," << cell.m_capacity << "," << capacity << ",";
+            os << (cell.isBlocked() ? 1 : 0) << "\n";
+        }
+    }
+
+    return os.good();
+}
+
+bool LunaCore::GlobalRouter::writeCongestionSVG(std::ostream &os, const Grid &grid)
+{
+    if (!os.good()) return false;
+
+    const auto width  = grid.width();
+    const auto height = grid.height();
+    const int64_t capacity = grid.maxCellCapacity();
+
+    // the viewport is in grid units, SVG has y pointing down.
+    LunaCore::SVG::Writer svg(os, width * SvgCellSize, height * SvgCellSize);
+    svg.setViewport(ChipDB::Rect64{{0,0}, {width, height}});
+    svg.setStrokeWidth(0);
+
+    for(GCellCoordType y = 0; y < height; y++)
+    {
+        const auto top = height - 1 - y;
+        for(GCellCoordType x = 0; x < width; x++)
+        {
+            auto const& cell = grid.at(x,y);
+            const auto colour = cell.isBlocked() ? 0x808080FF : heatColour(cell.m_capacity, capacity);
+
+            svg.setFillColour(colour);
+            svg.setStrokeColour(colour);
+            svg.drawRectangle(ChipDB::Coord64{x, top}, ChipDB::Coord64{x+1, top+1});
+        }
+    }
+
+    svg.close();
+    return os.good();
+}
+
+bool LunaCore::GlobalRouter::writeCongestionMap(const std::string &filename, const Grid &grid)
+{
+    const auto extension = LunaCore::tolower(std::filesystem::path(filename).extension().string());
+
+    if (extension == ".ppm")
+    {
+        return LunaCore::PPM::write(filename, grid.generateCapacityBitmap());
+    }
+
+    if ((extension != ".csv") && (extension != ".svg"))
+    {
+        Logging::logError("Unknown congestion map format %s, use .csv, .svg or .ppm\n", extension.c_str());
+        return false;
+    }
+
+    std::ofstream ofile(filename);
+    if (!ofile.good())
+    {
+        Logging::logError("Cannot open %s for writing\n", filename.c_str());
+        return false;
+    }
+
+    if (extension == ".csv")
+    {
+        return writeCongestionCSV(ofile, grid);
+    }
+
+    return writeCongestionSVG(ofile, grid);
+}
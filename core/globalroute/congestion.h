@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "grid.h"
+
+namespace LunaCore::GlobalRouter
+{
+
+/** congestion statistics of a routed grid.
+ *  The usage of a GCell is its m_capacity value, the
+ *  capacity is Grid::maxCellCapacity().
+*/
+struct CongestionStats
+{
+    std::size_t m_cells{0};
+    std::size_t m_blockedCells{0};
+    std::size_t m_usedCells{0};         ///< cells used by at least one net
+    std::size_t m_overflowCells{0};     ///< cells used beyond capacity
+    int64_t     m_totalOverflow{0};     ///< sum of the overflow of all cells
+    int64_t     m_maxUsage{0};
+    double      m_averageUtilisation{0.0};  ///< mean usage / capacity of the unblocked cells
+};
+
+/** calculate the congestion statistics of a grid */
+[[nodiscard]] CongestionStats calcCongestion(const Grid &grid);
+
+/** write the usage of each GCell as CSV, one line per cell:
+ *  x,y,usage,capacity,blocked
+*/
+bool writeCongestionCSV(std::ostream &os, const Grid &grid);
+
+/** write the usage of each GCell as an SVG heat map, from green (unused)
+ *  to red (full). Overflowed cells are magenta, blocked cells are grey.
+ *  North is at the top.
+*/
+bool writeCongestionSVG(std::ostream &os, const Grid &grid);
+
+/** write a congestion map. The format is taken from the
+ *  extension of the filename: .csv, .svg or .ppm
+*/
+bool writeCongestionMap(const std::string &filename, const Grid &grid);
+
+};
@@ -74,6 +74,20 @@ namespace LunaCore::GlobalRouter
         };
     }
 
+    /** the neighbouring cell in a direction */
+    constexpr GCellCoord step(const GCellCoord &p, Direction dir) noexcept
+    {
+        switch(dir)
+        {
+        case Direction::East:  return east(p);
+        case Direction::West:  return west(p);
+        case Direction::North: return north(p);
+        case Direction::South: return south(p);
+        default:
+            return p;
+        }
+    }
+
     struct NetSegment
     {
         GCellCoord      m_start{0,0};   ///< grid starting coordinate
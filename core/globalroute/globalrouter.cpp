@@ -3,9 +3,14 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include <cmath>
+#include <algorithm>
+#include <limits>
 #include <queue>
+#include <unordered_map>
+#include <unordered_set>
 #include "globalrouter.h"
 #include "wavefront.h"
+#include "astar.h"
 #include "prim.h"
 #include "common/logging.h"
 
@@ -177,6 +182,49 @@ std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::routeTw
         return std::move(segments);
     }
 
+    // search in a box around the source and target first, most routes
+    // don't need to go far outside it. Grow the box when no path is found.
+    auto margin = std::max<GCellCoordType>(m_searchMargin, 0);
+    while(true)
+    {
+        const ChipDB::Rect64 searchArea{
+            {std::max<GCellCoordType>(std::min(sourceLoc.m_x, targetLoc.m_x) - margin, 0),
+             std::max<GCellCoordType>(std::min(sourceLoc.m_y, targetLoc.m_y) - margin, 0)},
+            {std::min<GCellCoordType>(std::max(sourceLoc.m_x, targetLoc.m_x) + margin, m_grid->width() - 1),
+             std::min<GCellCoordType>(std::max(sourceLoc.m_y, targetLoc.m_y) + margin, m_grid->height() - 1)}
+        };
+
+        auto segments = (m_searchMode == SearchMode::AStar) ?
+            aStarRoute(sourceLoc, targetLoc, searchArea) :
+            mazeRoute(sourceLoc, targetLoc, searchArea);
+        if (segments)
+        {
+            return segments;
+        }
+
+        // clear the reached cells of the failed search, this takes constant time.
+        m_grid->clearReachedAndResetCost();
+
+        const bool coversGrid = (searchArea.left() == 0) && (searchArea.bottom() == 0)
+            && (searchArea.right() == m_grid->width() - 1) && (searchArea.top() == m_grid->height() - 1);
+
+        if (coversGrid)
+        {
+            // no path found!
+            Logging::logVerbose("  maze: path not found\n");
+            m_grid->at(sourceLoc).clearSource();
+            m_grid->at(targetLoc).clearTarget();
+            return std::nullopt;
+        }
+
+        margin = std::max<GCellCoordType>(2*margin, 1);
+        Logging::logVerbose("  maze: growing search margin to %ld\n", margin);
+    }
+}
+
+std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::mazeRoute(
+    const GCellCoord &sourceLoc, const GCellCoord &targetLoc, const ChipDB::Rect64 &searchArea)
+{
     Wavefront wavefront;
     WavefrontItem waveItem;
     waveItem.m_gridpos  = sourceLoc;
@@ -197,8 +245,7 @@ std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::routeTw
     {
         if (wavefront.empty())
         {
-            // no path found!
-            Logging::logVerbose("  maze: path not found\n");
+            // no path found within the search area
             return std::nullopt;
         }
 
@@ -227,76 +274,7 @@ std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::routeTw
         auto const& gcell = m_grid->at(minCostPos);
         if (gcell.isValid() && (minCostPos == targetLoc))
         {
-            // back-trace from the target to the source
-            // through the predecessor flags.
-
-            // clear the grid reached and cost info to
-            // prepare for the next route.
-            m_grid->clearReachedAndResetCost();
-            m_grid->at(sourceLoc).clearSource();
-            m_grid->at(targetLoc).clearTarget();
-
-            // backtrack from target
-            auto backtrackPos = minCostPos;
-            bool doBacktrack = true;
-
-            SegmentList segments;
-            auto curSegment = segments.createNewSegment(backtrackPos, Direction::Undefined);
-
-            while(doBacktrack)
-            {
-                assert(curSegment != nullptr);
-
-                auto const& gridCell = m_grid->at(backtrackPos);
-
-                // check if this is the first segment
-                // if so, init the data of the segment
-                if (curSegment->m_dir == Direction::Undefined)
-                {
-                    curSegment->m_dir = predecessorToDirection(gridCell.getPredecessor());
-                    curSegment->m_length = 1;
-                }
-
-                // exit at the end of the track when we get to the source
-                if (backtrackPos == sourceLoc)
-                {
-                    Logging::logVerbose("  maze evaluations: %lu\n", evaluations);
-                    return std::move(segments);
-                }
-
-                // check if we changed direction
-                // if so, create a new segment
-                if (gridCell.getPredecessor() != directionToPredecessor(curSegment->m_dir))
-                {
-                    curSegment = segments.createNewSegment(backtrackPos,
-                        predecessorToDirection(gridCell.getPredecessor()), curSegment);
-                }
-
-                curSegment->m_length++;
-
-                // mark all the cells on the new path
-                m_grid->at(backtrackPos).setMark();
-
-                // go to the previous cell
-                switch(gridCell.getPredecessor())
-                {
-                case GlobalRouter::Predecessor::East:
-                    backtrackPos = east(backtrackPos);
-                    break;
-                case GlobalRouter::Predecessor::West:
-                    backtrackPos = west(backtrackPos);
-                    break;
-                case GlobalRouter::Predecessor::North:
-                    backtrackPos = north(backtrackPos);
-                    break;
-                case GlobalRouter::Predecessor::South:
-                    backtrackPos = south(backtrackPos);
-                    break;
-                default:
-                    doBacktrack = false;
-                    break;
-                };
-            }
+            return backtrack(sourceLoc, targetLoc, evaluations);
         }
         else
         {
@@ -305,7 +283,7 @@ std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::routeTw
             // ******************************************************************************************
 
             auto northPos = north(minCostPos);
-            if (m_grid->isValidGridCoord(northPos))
+            if (searchArea.contains(northPos))
             {
                 auto newCost  = calcGridCostDirected(minCostItem, northPos, targetLoc, GlobalRouter::Predecessor::South);
                 if (newCost)
@@ -313,7 +291,7 @@ std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::routeTw
             }
 
             auto southPos = south(minCostPos);
-            if (m_grid->isValidGridCoord(southPos))
+            if (searchArea.contains(southPos))
             {
                 auto newCost = calcGridCostDirected(minCostItem, southPos, targetLoc, GlobalRouter::Predecessor::North);
                 if (newCost)
@@ -325,7 +303,7 @@ std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::routeTw
             // ******************************************************************************************
 
             auto eastPos = east(minCostPos);
-            if (m_grid->isValidGridCoord(eastPos))
+            if (searchArea.contains(eastPos))
             {
                 auto newCost = calcGridCostDirected(minCostItem, eastPos, targetLoc, GlobalRouter::Predecessor::West);
                 if (newCost)
@@ -333,7 +311,7 @@ std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::routeTw
             }
 
             auto westPos = west(minCostPos);
-            if (m_grid->isValidGridCoord(westPos))
+            if (searchArea.contains(westPos))
             {
                 auto newCost = calcGridCostDirected(minCostItem, westPos, targetLoc, GlobalRouter::Predecessor::East);
                 if (newCost)
@@ -345,6 +323,149 @@ std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::routeTw
     return std::nullopt; // error
 }
 
+std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::aStarRoute(
+    const GCellCoord &sourceLoc, const GCellCoord &targetLoc, const ChipDB::Rect64 &searchArea)
+{
+    // the search state lives in the grid cells. The grid cost is reset
+    // to infinity by every new search epoch, so cells not reached in
+    // this search have an infinite cost.
+    struct GridCells
+    {
+        Grid                  &m_grid;
+        const ChipDB::Rect64  &m_searchArea;
+
+        bool canEnter(const GCellCoord &pos) const
+        {
+            if (!m_searchArea.contains(pos)) return false;
+            auto const& gcell = m_grid.at(pos);
+            return !gcell.isBlocked() && (gcell.m_capacity < m_grid.maxCellCapacity());
+        }
+
+        PathCostType cellCost(const GCellCoord &) const noexcept
+        {
+            return 1;
+        }
+
+        PathCostType cost(const GCellCoord &pos) const
+        {
+            return m_grid.at(pos).cost();
+        }
+
+        Predecessor predecessor(const GCellCoord &pos) const
+        {
+            return m_grid.at(pos).getPredecessor();
+        }
+
+        void update(const GCellCoord &pos, PathCostType cost, Predecessor pred)
+        {
+            m_grid.at(pos).setCost(cost);
+            m_grid.at(pos).setPredecessor(pred);
+        }
+    };
+
+    const PathCostType bendPenalty = 2;
+
+    m_grid->at(sourceLoc).setMark();
+    m_grid->at(sourceLoc).setSource();
+    m_grid->at(sourceLoc).clearTarget();
+    m_grid->at(sourceLoc).setCost(0);
+    m_grid->at(sourceLoc).setPredecessor(Predecessor::Undefined);
+    m_grid->at(targetLoc).setTarget();
+
+    Wavefront wavefront;
+    WavefrontItem waveItem;
+    waveItem.m_gridpos  = sourceLoc;
+    waveItem.m_pathCost = sourceLoc.manhattanDistance(targetLoc);
+    wavefront.push(waveItem);
+
+    GridCells cells{*m_grid, searchArea};
+    std::size_t evaluations = 0;
+    if (aStarSearch(wavefront, targetLoc, 1, bendPenalty, cells, evaluations))
+    {
+        return backtrack(sourceLoc, targetLoc, evaluations);
+    }
+
+    // no path found within the search area
+    return std::nullopt;
+}
+
+GlobalRouter::SegmentList GlobalRouter::Router::backtrack(const GCellCoord &sourceLoc,
+    const GCellCoord &targetLoc, std::size_t evaluations)
+{
+    // back-trace from the target to the source
+    // through the predecessor flags.
+
+    // clear the grid reached and cost info to
+    // prepare for the next route.
+    m_grid->clearReachedAndResetCost();
+    m_grid->at(sourceLoc).clearSource();
+    m_grid->at(targetLoc).clearTarget();
+
+    // backtrack from target
+    auto backtrackPos = targetLoc;
+    bool doBacktrack = true;
+
+    SegmentList segments;
+    auto curSegment = segments.createNewSegment(backtrackPos, Direction::Undefined);
+
+    while(doBacktrack)
+    {
+        assert(curSegment != nullptr);
+
+        auto const& gridCell = m_grid->at(backtrackPos);
+
+        // check if this is the first segment
+        // if so, init the data of the segment
+        if (curSegment->m_dir == Direction::Undefined)
+        {
+            curSegment->m_dir = predecessorToDirection(gridCell.getPredecessor());
+            curSegment->m_length = 1;
+        }
+
+        // exit at the end of the track when we get to the source
+        if (backtrackPos == sourceLoc)
+        {
+            Logging::logVerbose("  maze evaluations: %lu\n", evaluations);
+            return std::move(segments);
+        }
+
+        // check if we changed direction
+        // if so, create a new segment
+        if (gridCell.getPredecessor() != directionToPredecessor(curSegment->m_dir))
+        {
+            curSegment = segments.createNewSegment(backtrackPos,
+                predecessorToDirection(gridCell.getPredecessor()), curSegment);
+        }
+
+        curSegment->m_length++;
+
+        // mark all the cells on the new path
+        m_grid->at(backtrackPos).setMark();
+
+        // go to the previous cell
+        switch(gridCell.getPredecessor())
+        {
+        case GlobalRouter::Predecessor::East:
+            backtrackPos = east(backtrackPos);
+            break;
+        case GlobalRouter::Predecessor::West:
+            backtrackPos = west(backtrackPos);
+            break;
+        case GlobalRouter::Predecessor::North:
+            backtrackPos = north(backtrackPos);
+            break;
+        case GlobalRouter::Predecessor::South:
+            backtrackPos = south(backtrackPos);
+            break;
+        default:
+            doBacktrack = false;
+            break;
+        };
+    }
+
+    return segments;
+}
+
 bool GlobalRouter::Router::addWavefrontCell(
     Wavefront &wavefront,
     const GCellCoord &pos,
@@ -471,6 +592,208 @@ std::optional<LunaCore::GlobalRouter::SegmentList> GlobalRouter::Router::routeNe
     return std::move(allSegments);
 }
 
+std::optional<GlobalRouter::PathFinder::Result> GlobalRouter::Router::routeNets(
+    const std::vector<std::vector<ChipDB::Coord64>> &nets,
+    const PathFinder::Parameters &params)
+{
+    if (!m_grid)
+    {
+        Logging::logError("GlobalRouter::Router::routeNets grid is nullptr - createGrid wasn't called.\n");
+        return std::nullopt;
+    }
+
+    PathFinder pathFinder(*m_grid);
+    return pathFinder.route(nets, params);
+}
+
+std::optional<GlobalRouter::LayerAssigner::Result> GlobalRouter::Router::assignLayers(
+    const ChipDB::TechLib &techLib,
+    const std::vector<SegmentList> &routes,
+    const LayerAssigner::Parameters &params)
+{
+    if (!m_grid)
+    {
+        Logging::logError("GlobalRouter::Router::assignLayers grid is nullptr - createGrid wasn't called.\n");
+        return std::nullopt;
+    }
+
+    auto layers = LayerGrid::routingLayers(techLib, m_grid->cellSize());
+    if (layers.empty())
+    {
+        Logging::logError("GlobalRouter::Router::assignLayers no usable routing layers in tech lib.\n");
+        return std::nullopt;
+    }
+
+    for(auto const& layer : layers)
+    {
+        Logging::logVerbose("  layer %s: %s, %d tracks per GCell\n", layer.m_name.c_str(),
+            layer.m_horizontal ? "horizontal" : "vertical", layer.m_capacity);
+    }
+
+    m_layerGrid = std::make_unique<LayerGrid>(m_grid->width(), m_grid->height(), std::move(layers));
+
+    LayerAssigner assigner(*m_layerGrid);
+    return assigner.assign(routes, params);
+}
+
+ChipDB::NetRoute GlobalRouter::Router::createNetRoute(const SegmentList &route,
+    const std::vector<ChipDB::Coord64> &terminals,
+    const std::vector<uint8_t> &layers) const
+{
+    ChipDB::NetRoute netRoute;
+    if (!m_grid) return netRoute;
+
+    auto const& cellSize = m_grid->cellSize();
+    auto toChipCoord = [&cellSize](const GCellCoord &p)
+    {
+        return ChipDB::Coord64{p.m_x * cellSize.m_x + cellSize.m_x/2, p.m_y * cellSize.m_y + cellSize.m_y/2};
+    };
+
+    auto cellKey = [](const GCellCoord &p)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(p.m_x)) << 32) | static_cast<uint32_t>(p.m_y);
+    };
+
+    const bool hasLayers = m_layerGrid && (layers.size() == route.size());
+
+    // the cells where segments must be split: the terminals
+    // and the first and last cell of every segment.
+    std::unordered_set<uint64_t> junctions;
+    std::vector<GCellCoord> terminalCells;
+    terminalCells.reserve(terminals.size());
+    for(auto const& terminal : terminals)
+    {
+        terminalCells.push_back(m_grid->toGridCoord(terminal));
+        junctions.insert(cellKey(terminalCells.back()));
+    }
+
+    for(auto segment : route)
+    {
+        if (segment->m_length < 2) continue;
+        auto last = segment->m_start;
+        for(GCellCoordType idx = 1; idx < segment->m_length; idx++)
+        {
+            last = step(last, segment->m_dir);
+        }
+        junctions.insert(cellKey(segment->m_start));
+        junctions.insert(cellKey(last));
+    }
+
+    // split the segments into pieces between junctions. the
+    // pieces are the edges of a graph whose nodes are junctions.
+    struct Piece
+    {
+        std::size_t         m_node1{0};
+        std::size_t         m_node2{0};
+        ChipDB::ObjectKey   m_layer{ChipDB::ObjectNotFound};
+    };
+
+    std::vector<GCellCoord> nodeCells;
+    std::unordered_map<uint64_t, std::size_t> nodeIndex;
+    auto getNode = [&](const GCellCoord &p)
+    {
+        auto [iter, inserted] = nodeIndex.try_emplace(cellKey(p), nodeCells.size());
+        if (inserted) nodeCells.push_back(p);
+        return iter->second;
+    };
+
+    std::vector<Piece> pieces;
+    std::unordered_set<uint64_t> pieceKeys;
+    std::size_t segIdx = 0;
+    for(auto segment : route)
+    {
+        const auto layer = hasLayers ? m_layerGrid->layer(layers.at(segIdx)).m_key : ChipDB::ObjectNotFound;
+        segIdx++;
+
+        auto pos = segment->m_start;
+        auto pieceStart = pos;
+        for(GCellCoordType idx = 1; idx < segment->m_length; idx++)
+        {
+            pos = step(pos, segment->m_dir);
+            if (((idx + 1) == segment->m_length) || junctions.contains(cellKey(pos)))
+            {
+                const auto node1 = getNode(pieceStart);
+                const auto node2 = getNode(pos);
+
+                // overlapping segments produce the same piece more than once
+                const auto key = (static_cast<uint64_t>(std::min(node1, node2)) << 32) | std::max(node1, node2);
+                if (pieceKeys.insert(key).second)
+                {
+                    pieces.push_back({node1, node2, layer});
+                }
+                pieceStart = pos;
+            }
+        }
+    }
+
+    std::vector<std::vector<std::size_t>> nodePieces(nodeCells.size());
+    for(std::size_t idx = 0; idx < pieces.size(); idx++)
+    {
+        nodePieces[pieces[idx].m_node1].push_back(idx);
+        nodePieces[pieces[idx].m_node2].push_back(idx);
+    }
+
+    // orient the pieces away from the first terminal,
+    // breadth first so parents come before their children.
+    constexpr auto noSegment = std::numeric_limits<int32_t>::max();
+    std::vector<int32_t> nodeSegment(nodeCells.size(), noSegment);
+    std::vector<bool> pieceUsed(pieces.size(), false);
+    std::vector<std::size_t> queue;
+    queue.reserve(nodeCells.size());
+
+    auto visit = [&](std::size_t root)
+    {
+        if (nodeSegment[root] != noSegment) return;
+        nodeSegment[root] = -1;
+        queue.push_back(root);
+
+        for(std::size_t head = queue.size() - 1; head < queue.size(); head++)
+        {
+            const auto node = queue[head];
+            for(auto pieceIdx : nodePieces[node])
+            {
+                if (pieceUsed[pieceIdx]) continue;
+                pieceUsed[pieceIdx] = true;
+
+                auto const& piece = pieces[pieceIdx];
+                const auto other = (piece.m_node1 == node) ? piece.m_node2 : piece.m_node1;
+
+                ChipDB::RouteSegment segment;
+                segment.m_start  = toChipCoord(nodeCells[node]);
+                segment.m_end    = toChipCoord(nodeCells[other]);
+                segment.m_layer  = piece.m_layer;
+                segment.m_parent = nodeSegment[node];
+                netRoute.m_segments.push_back(segment);
+
+                if (nodeSegment[other] == noSegment)
+                {
+                    nodeSegment[other] = static_cast<int32_t>(netRoute.m_segments.size() - 1);
+                    queue.push_back(other);
+                }
+            }
+        }
+    };
+
+    if (!terminalCells.empty())
+    {
+        auto iter = nodeIndex.find(cellKey(terminalCells.front()));
+        if (iter != nodeIndex.end()) visit(iter->second);
+    }
+
+    for(std::size_t node = 0; node < nodeCells.size(); node++)
+    {
+        visit(node);
+    }
+
+    netRoute.m_terminals.reserve(terminalCells.size());
+    for(auto const& cell : terminalCells)
+    {
+        netRoute.m_terminals.push_back(toChipCoord(cell));
+    }
+
+    return netRoute;
+}
+
 void GlobalRouter::Router::clearGridForNewRoute()
 {
     if (m_grid) m_grid->clearAllFlagsAndResetCost();
@@ -7,10 +7,12 @@
 #include <optional>
 #include <utility>
 #include <memory>
-#include <optional>
 #include "datatypes.h"
 #include "wavefront.h"
 #include "grid.h"
+#include "pathfinder.h"
+#include "layergrid.h"
+#include "layerassign.h"
 
 namespace LunaCore::GlobalRouter
 {
@@ -20,6 +22,13 @@ class Router
 public:
     Router() = default;
 
+    /** cost model of the two-point maze search */
+    enum class SearchMode
+    {
+        Directed,   ///< the distance to the target is added to the cost of every step, finds a route quickly
+        AStar       ///< A* with the distance to the target as heuristic, finds a shortest route
+    };
+
     std::optional<ChipDB::Size64> determineGridCellSize(const ChipDB::Design &design,
         const std::string &siteName,
         int hRoutes, int vRoutes) const;
@@ -42,13 +51,84 @@ public:
     [[nodiscard]] std::optional<SegmentList> routeNet(const std::vector<ChipDB::Coord64> &netNodes,
         const std::string &netName);
 
+    /** route all nets using negotiated congestion routing.
+     *  each net is given by the chip coordinates of its terminals.
+     *  returns std::nullopt if there is no grid.
+    */
+    [[nodiscard]] std::optional<PathFinder::Result> routeNets(
+        const std::vector<std::vector<ChipDB::Coord64>> &nets,
+        const PathFinder::Parameters &params);
+
+    /** assign the segments of 2D routes to the routing layers of a tech lib.
+     *  A new layer grid with the size of the 2D grid is created first.
+     *  returns std::nullopt if there is no grid or no routing layer.
+    */
+    [[nodiscard]] std::optional<LayerAssigner::Result> assignLayers(
+        const ChipDB::TechLib &techLib,
+        const std::vector<SegmentList> &routes,
+        const LayerAssigner::Parameters &params);
+
+    /** get a raw pointer to the layer grid */
+    const LayerGrid* layerGrid() const {return m_layerGrid.get(); }
+
+    /** convert a routed net to a route topology in chip coordinates.
+     *  terminals are the terminals of the net as given to routeNets().
+     *  layers holds the layer of each segment as returned by assignLayers(),
+     *  or is empty if the layers have not been assigned.
+     *  Segments are split where other segments or terminals touch them.
+    */
+    [[nodiscard]] ChipDB::NetRoute createNetRoute(const SegmentList &route,
+        const std::vector<ChipDB::Coord64> &terminals,
+        const std::vector<uint8_t> &layers) const;
+
     /** clear the grid for a new route, capacity values remain in tact */
     void clearGridForNewRoute();
 
+    /** set the number of grid cells the two-point maze search may go outside
+     *  the bounding box of the source and target. The margin is doubled each
+     *  time a search fails, until the whole grid is searched.
+    */
+    void setSearchMargin(GCellCoordType margin) noexcept
+    {
+        m_searchMargin = margin;
+    }
+
+    [[nodiscard]] GCellCoordType searchMargin() const noexcept
+    {
+        return m_searchMargin;
+    }
+
+    void setSearchMode(SearchMode mode) noexcept
+    {
+        m_searchMode = mode;
+    }
+
+    [[nodiscard]] SearchMode searchMode() const noexcept
+    {
+        return m_searchMode;
+    }
+
 protected:
     /** route a two-point connection between p1 and p2. Used cells are marked so they can be extracted later. */
     [[nodiscard]] std::optional<SegmentList> routeTwoPointRoute(const ChipDB::Coord64 &p1, const ChipDB::Coord64 &p2);
 
+    /** maze search from source to target, restricted to searchArea (in grid coordinates). */
+    [[nodiscard]] std::optional<SegmentList> mazeRoute(const GCellCoord &sourceLoc,
+        const GCellCoord &targetLoc, const ChipDB::Rect64 &searchArea);
+
+    /** A* search from source to target, restricted to searchArea (in grid coordinates).
+     *  the grid cost holds the path cost from the source, so a cell is on the
+     *  wavefront at most once per improvement and stale items are skipped.
+    */
+    [[nodiscard]] std::optional<SegmentList> aStarRoute(const GCellCoord &sourceLoc,
+        const GCellCoord &targetLoc, const ChipDB::Rect64 &searchArea);
+
+    /** create the segments by following the predecessors from the target back to the source.
+     *  The cells on the path are marked.
+    */
+    [[nodiscard]] SegmentList backtrack(const GCellCoord &sourceLoc, const GCellCoord &targetLoc,
+        std::size_t evaluations);
+
     /** follow the mark path in the bitmap and recover the routing. */
     void updateCapacity(const SegmentList &segments) const;
 
@@ -65,6 +145,9 @@ protected:
     [[nodiscard]] std::optional<PathCostType> calcGridCostDirected(const WavefrontItem &from, const GCellCoord &to, const GCellCoord &destination, Predecessor expandDirection);
 
     std::unique_ptr<Grid> m_grid;
+    std::unique_ptr<LayerGrid> m_layerGrid;
+    GCellCoordType m_searchMargin{10};
+    SearchMode     m_searchMode{SearchMode::AStar};
 };
 
 };
\ No newline at end of file
@@ -42,7 +42,9 @@ const GlobalRouter::GCell& GlobalRouter::Grid::at(const GCellCoordType x, const
         return m_invalidCell;
     }
 
-    return m_grid.at(y*m_width + x);
+    auto &cell = m_grid.at(y*m_width + x);
+    refresh(cell);
+    return cell;
 }
 
 GlobalRouter::GCell& GlobalRouter::Grid::at(const GCellCoordType x, const GCellCoordType y)
@@ -53,7 +55,9 @@ GlobalRouter::GCell& GlobalRouter::Grid::at(const GCellCoordType x, const GCellC
         return m_invalidCell;
     }
 
-    return m_grid.at(y*m_width + x);
+    auto &cell = m_grid.at(y*m_width + x);
+    refresh(cell);
+    return cell;
 }
 
 const GlobalRouter::GCell& GlobalRouter::Grid::at(const GCellCoord &p) const
@@ -64,7 +68,9 @@ const GlobalRouter::GCell& GlobalRouter::Grid::at(const GCellCoord &p) const
         return m_invalidCell;
     }
 
-    return m_grid.at(p.m_y*m_width + p.m_x);
+    auto &cell = m_grid.at(p.m_y*m_width + p.m_x);
+    refresh(cell);
+    return cell;
 }
 
 GlobalRouter::GCell& GlobalRouter::Grid::at(const GCellCoord &p)
@@ -75,18 +81,37 @@ GlobalRouter::GCell& GlobalRouter::Grid::at(const GCellCoord &p)
         return m_invalidCell;
     }
 
-    return m_grid.at(p.m_y*m_width + p.m_x);
+    auto &cell = m_grid.at(p.m_y*m_width + p.m_x);
+    refresh(cell);
+    return cell;
 }
 
-void GlobalRouter::Grid::clearReachedAndResetCost()
+void GlobalRouter::Grid::nextEpoch(bool allFlags) noexcept
 {
-    for(auto &cell : m_grid)
+    if (m_epoch == std::numeric_limits<decltype(m_epoch)>::max())
     {
-        cell.clearReached();
-        cell.m_cost = std::numeric_limits<decltype(cell.m_cost)>::max();
+        // bring all cells up to date and restart the epoch counter
+        for(auto &cell : m_grid)
+        {
+            refresh(cell);
+            cell.m_stamp = 0;
+        }
+        m_epoch = 0;
+        m_flagsEpoch = 0;
+    }
+
+    m_epoch++;
+    if (allFlags)
+    {
+        m_flagsEpoch = m_epoch;
     }
 }
 
+void GlobalRouter::Grid::clearReachedAndResetCost()
+{
+    nextEpoch(false);
+}
+
 PPM::Bitmap GlobalRouter::Grid::generateCapacityBitmap() const noexcept
 {
     constexpr PPM::RGB uncongestedColor{0,255,0,0};
@@ -193,11 +218,7 @@ bool GlobalRouter::Grid::exportToPPM(const std::string &filename) const
 
 void GlobalRouter::Grid::clearAllFlagsAndResetCost()
 {
-    for(auto &cell : m_grid)
-    {
-        cell.resetFlags();
-        cell.m_cost = std::numeric_limits<decltype(cell.m_cost)>::max();
-    }
+    nextEpoch(true);
 }
 
 void GlobalRouter::Grid::clearGrid()
@@ -207,5 +228,6 @@ void GlobalRouter::Grid::clearGrid()
         cell.resetFlags();
         cell.m_capacity = 0;
         cell.m_cost = std::numeric_limits<decltype(cell.m_cost)>::max();
+        cell.m_stamp = m_epoch;
     }
 }
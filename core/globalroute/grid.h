@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cstdint>
+#include <limits>
 #include <vector>
 #include <cassert>
 #include "datatypes.h"
@@ -18,6 +19,7 @@ struct GCell
 {
     uint16_t        m_capacity{0};
     uint16_t        m_flags{0};
+    uint32_t        m_stamp{0};     ///< grid epoch in which the flags and cost were last brought up to date
     PathCostType    m_cost{0};
 
     [[nodiscard]] constexpr auto cost() const noexcept
@@ -92,6 +94,7 @@ public:
 
     [[nodiscard]] constexpr auto width() const {return m_width; }
     [[nodiscard]] constexpr auto height() const {return m_height; }
+    [[nodiscard]] constexpr auto const& cellSize() const {return m_cellSize; }
 
     [[nodiscard]] const GCell& at(const GCellCoordType x, const GCellCoordType y) const;
     [[nodiscard]] GCell& at(const GCellCoordType x, const GCellCoordType y);
@@ -104,10 +107,14 @@ public:
     void setMaxCellCapacity(int64_t cap) noexcept { m_maxCapacity = cap; assert(cap >= 0); }
     [[nodiscard]] auto maxCellCapacity() const noexcept { return m_maxCapacity; }
 
-    /** clears the reached flag and resets the grid cost to infinity */
+    /** clears the reached flag and resets the grid cost to infinity.
+     *  this takes constant time, each cell is reset on its next access.
+    */
     void clearReachedAndResetCost();
 
-    /** clears all the flags and cost in preparation for a new route */
+    /** clears all the flags and cost in preparation for a new route.
+     *  this takes constant time, each cell is reset on its next access.
+    */
     void clearAllFlagsAndResetCost();
 
     /** clears all the flags, reset costs and capacity in preparation for a new route */
@@ -119,16 +126,53 @@ public:
     /** create a capacity bitmap, showing capacity from green to red */
     [[nodiscard]] PPM::Bitmap generateCapacityBitmap() const noexcept;
 
-    auto const& gcells() const noexcept {return m_grid; };
+    /** return all the cells, brought up to date with the latest clear. */
+    auto const& gcells() const noexcept
+    {
+        for(auto &cell : m_grid)
+        {
+            refresh(cell);
+        }
+        return m_grid;
+    }
 
 protected:
+    /** reset the flags and cost of a cell that was cleared after its last access */
+    void refresh(GCell &cell) const noexcept
+    {
+        if (cell.m_stamp == m_epoch) [[likely]]
+        {
+            return;
+        }
+
+        if (cell.m_stamp < m_flagsEpoch)
+        {
+            cell.resetFlags();
+        }
+        else
+        {
+            cell.clearReached();
+        }
+        cell.m_cost  = std::numeric_limits<PathCostType>::max();
+        cell.m_stamp = m_epoch;
+    }
+
+    /** start a new epoch, invalidating the cost and reached flag
+     *  or all the flags of all cells.
+    */
+    void nextEpoch(bool allFlags) noexcept;
+
     int             m_maxCapacity{200};
     ChipDB::Size64  m_cellSize{0,0};
 
     GCellCoordType m_width{0};
     GCellCoordType m_height{0};
 
-    std::vector<GCell> m_grid;
+    uint32_t        m_epoch{1};
+    uint32_t        m_flagsEpoch{1};    ///< epoch of the last clearAllFlagsAndResetCost
+
+    /** mutable so cells can be brought up to date on const access */
+    mutable std::vector<GCell> m_grid;
 
     mutable GCell m_invalidCell;
 
@@ -0,0 +1,284 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include "common/logging.h"
+#include "layerassign.h"
+
+using namespace LunaCore::GlobalRouter;
+
+namespace
+{
+    constexpr double Infinity = std::numeric_limits<double>::infinity();
+
+    /** the last cell of a segment, segments include their first and last cell */
+    GCellCoord lastCell(const NetSegment &segment) noexcept
+    {
+        auto pos = segment.m_start;
+        for(GCellCoordType idx = 1; idx < segment.m_length; idx++)
+        {
+            pos = step(pos, segment.m_dir);
+        }
+        return pos;
+    }
+};
+
+template<typename Func>
+void LayerAssigner::forEachEdge(const NetSegment &segment, Func func) const
+{
+    auto pos = segment.m_start;
+    for(GCellCoordType idx = 1; idx < segment.m_length; idx++)
+    {
+        const auto next = step(pos, segment.m_dir);
+        func(std::min(pos.m_x, next.m_x), std::min(pos.m_y, next.m_y));
+        pos = next;
+    }
+}
+
+double LayerAssigner::segmentCost(const NetSegment &segment, std::size_t layer) const
+{
+    const bool hasEdges = segment.m_length > 1;
+    if (hasEdges && (m_grid.layer(layer).m_horizontal != isHorizontal(segment.m_dir)))
+    {
+        return Infinity;
+    }
+
+    double cost = 0.0;
+    forEachEdge(segment, [&](GCellCoordType x, GCellCoordType y)
+    {
+        if (!m_grid.hasEdge(layer, x, y)) return;
+
+        const auto capacity = m_grid.edgeCapacity(layer, x, y);
+        const auto usage    = m_grid.edgeUsage(layer, x, y);
+
+        if (usage >= capacity)
+        {
+            cost += 2.0 + m_params.m_overflowCost * (usage + 1 - capacity);
+        }
+        else
+        {
+            cost += 1.0 + static_cast<double>(usage + 1) / capacity;
+        }
+    });
+
+    return cost;
+}
+
+void LayerAssigner::addSegmentUsage(const NetSegment &segment, std::size_t layer)
+{
+    forEachEdge(segment, [&](GCellCoordType x, GCellCoordType y)
+    {
+        if (m_grid.hasEdge(layer, x, y))
+        {
+            m_grid.addEdgeUsage(layer, x, y, 1);
+        }
+    });
+}
+
+void LayerAssigner::addViaStack(const GCellCoord &pos, std::size_t layer1, std::size_t layer2)
+{
+    if ((pos.m_x < 0) || (pos.m_y < 0) || (pos.m_x >= m_grid.width()) || (pos.m_y >= m_grid.height()))
+    {
+        return;
+    }
+
+    for(auto layer = std::min(layer1, layer2); layer < std::max(layer1, layer2); layer++)
+    {
+        m_grid.addViaUsage(layer, pos.m_x, pos.m_y, 1);
+    }
+}
+
+bool LayerAssigner::assignNet(const SegmentList &route, std::vector<uint8_t> &layers)
+{
+    const std::size_t layerCount = m_grid.layerCount();
+
+    std::vector<const NetSegment*> segments(route.begin(), route.end());
+    const std::size_t segmentCount = segments.size();
+    layers.assign(segmentCount, 0);
+
+    if (segmentCount == 0) return true;
+
+    std::unordered_map<const NetSegment*, std::size_t> segmentIndex;
+    segmentIndex.reserve(segmentCount);
+    for(std::size_t idx = 0; idx < segmentCount; idx++)
+    {
+        segmentIndex[segments[idx]] = idx;
+    }
+
+    // build the segment tree. a segment whose parent is
+    // not part of this route is the root of a tree.
+    constexpr auto noParent = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> parent(segmentCount, noParent);
+    std::vector<std::vector<std::size_t>> children(segmentCount);
+    std::vector<std::size_t> roots;
+
+    for(std::size_t idx = 0; idx < segmentCount; idx++)
+    {
+        auto iter = segmentIndex.find(segments[idx]->m_parent);
+        if ((segments[idx]->m_parent != nullptr) && (iter != segmentIndex.end()))
+        {
+            parent[idx] = iter->second;
+            children[iter->second].push_back(idx);
+        }
+        else
+        {
+            roots.push_back(idx);
+        }
+    }
+
+    // order the segments so every segment comes after its parent
+    std::vector<std::size_t> order;
+    order.reserve(segmentCount);
+    order = roots;
+    for(std::size_t idx = 0; idx < order.size(); idx++)
+    {
+        for(auto child : children[order[idx]])
+        {
+            order.push_back(child);
+        }
+    }
+
+    const auto viaCost = [&](std::size_t layer1, std::size_t layer2)
+    {
+        return m_params.m_viaCost * static_cast<double>((layer1 > layer2) ? (layer1 - layer2) : (layer2 - layer1));
+    };
+
+    // cost[s*layerCount + l] is the cost of the subtree of segment s
+    // when s is on layer l, including the vias to its children.
+    std::vector<double> cost(segmentCount * layerCount, Infinity);
+
+    for(auto iter = order.rbegin(); iter != order.rend(); ++iter)
+    {
+        const auto seg = *iter;
+        for(std::size_t layer = 0; layer < layerCount; layer++)
+        {
+            double segCost = segmentCost(*segments[seg], layer);
+            if (std::isinf(segCost)) continue;
+
+            if (children[seg].empty())
+            {
+                // the end of the segment connects to a pin or to the tree
+                segCost += viaCost(0, layer);
+            }
+
+            for(auto child : children[seg])
+            {
+                double best = Infinity;
+                for(std::size_t childLayer = 0; childLayer < layerCount; childLayer++)
+                {
+                    best = std::min(best, cost[child*layerCount + childLayer] + viaCost(layer, childLayer));
+                }
+                segCost += best;
+            }
+
+            cost[seg*layerCount + layer] = segCost;
+        }
+    }
+
+    // choose the layers from the roots down
+    for(auto seg : order)
+    {
+        const auto parentLayer = (parent[seg] == noParent) ? std::size_t{0} : std::size_t{layers[parent[seg]]};
+
+        double best = Infinity;
+        std::size_t bestLayer = 0;
+        for(std::size_t layer = 0; layer < layerCount; layer++)
+        {
+            const double total = cost[seg*layerCount + layer] + viaCost(parentLayer, layer);
+            if (total < best)
+            {
+                best = total;
+                bestLayer = layer;
+            }
+        }
+
+        if (std::isinf(best))
+        {
+            return false;
+        }
+
+        layers[seg] = static_cast<uint8_t>(bestLayer);
+    }
+
+    // commit the edges and vias
+    for(auto seg : order)
+    {
+        auto const& segment = *segments[seg];
+        addSegmentUsage(segment, layers[seg]);
+
+        const auto parentLayer = (parent[seg] == noParent) ? std::size_t{0} : std::size_t{layers[parent[seg]]};
+        addViaStack(segment.m_start, parentLayer, layers[seg]);
+
+        if (children[seg].empty())
+        {
+            addViaStack(lastCell(segment), 0, layers[seg]);
+        }
+    }
+
+    return true;
+}
+
+LayerAssigner::Result LayerAssigner::assign(const std::vector<SegmentList> &routes, const Parameters &params)
+{
+    m_params = params;
+
+    Result result;
+    result.m_layers.resize(routes.size());
+
+    if (m_grid.layerCount() == 0)
+    {
+        Logging::logError("LayerAssigner: the layer grid has no routing layers\n");
+        result.m_unassignedNets = routes.size();
+        return result;
+    }
+
+    if (m_grid.layerCount() > std::numeric_limits<uint8_t>::max())
+    {
+        Logging::logError("LayerAssigner: too many routing layers\n");
+        result.m_unassignedNets = routes.size();
+        return result;
+    }
+
+    // shortest nets first, they have the fewest
+    // alternatives that don't cost extra vias.
+    std::vector<int64_t> lengths(routes.size(), 0);
+    for(std::size_t net = 0; net < routes.size(); net++)
+    {
+        for(auto segment : routes[net])
+        {
+            lengths[net] += segment->m_length;
+        }
+    }
+
+    std::vector<std::size_t> netOrder(routes.size());
+    std::iota(netOrder.begin(), netOrder.end(), 0);
+    std::stable_sort(netOrder.begin(), netOrder.end(),
+        [&lengths](std::size_t net1, std::size_t net2)
+        {
+            return lengths[net1] < lengths[net2];
+        }
+    );
+
+    for(auto net : netOrder)
+    {
+        if (!assignNet(routes[net], result.m_layers[net]))
+        {
+            result.m_layers[net].clear();
+            result.m_unassignedNets++;
+        }
+    }
+
+    result.m_vias          = m_grid.totalVias();
+    result.m_overflowEdges = m_grid.overflowEdges();
+    result.m_totalOverflow = m_grid.totalOverflow();
+
+    Logging::logInfo("LayerAssigner: %lu layers, %ld vias, %lu overflowed edges, %lu unassigned nets\n",
+        m_grid.layerCount(), result.m_vias, result.m_overflowEdges, result.m_unassignedNets);
+
+    return result;
+}
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "datatypes.h"
+#include "layergrid.h"
+
+namespace LunaCore::GlobalRouter
+{
+
+/** Assigns the segments of 2D routes to the layers of a LayerGrid.
+ *
+ *  Nets are assigned one at a time, shortest first. The segments of a
+ *  net form a tree through their parent pointers; the layers of all
+ *  segments of a net are chosen together by dynamic programming over
+ *  that tree, minimizing the congestion cost of the edges plus the cost
+ *  of the vias between a segment and its parent. The pins and the points
+ *  where connections join are assumed to be on the bottom layer.
+ *
+ *  Horizontal segments are only placed on horizontal layers and
+ *  vertical segments on vertical layers.
+*/
+class LayerAssigner
+{
+public:
+    struct Parameters
+    {
+        double m_viaCost{2.0};          ///< cost of a via, in units of the cost of an empty edge
+        double m_overflowCost{100.0};   ///< extra cost of an edge that is used beyond its capacity
+    };
+
+    struct Result
+    {
+        std::vector<std::vector<uint8_t>> m_layers;    ///< per net, the layer of each segment in SegmentList order
+        std::size_t m_unassignedNets{0};    ///< nets with a segment that has no layer in its direction
+        int64_t     m_vias{0};
+        std::size_t m_overflowEdges{0};
+        int64_t     m_totalOverflow{0};
+    };
+
+    explicit LayerAssigner(LayerGrid &grid) : m_grid(grid) {}
+
+    /** assign all routes. The edge and via usage is added to the grid. */
+    [[nodiscard]] Result assign(const std::vector<SegmentList> &routes, const Parameters &params);
+
+protected:
+    /** assign the segments of a single net. returns false if a segment can't be assigned. */
+    bool assignNet(const SegmentList &route, std::vector<uint8_t> &layers);
+
+    /** cost of routing a segment on a layer, without vias */
+    [[nodiscard]] double segmentCost(const NetSegment &segment, std::size_t layer) const;
+
+    /** add the edge usage of a segment on a layer */
+    void addSegmentUsage(const NetSegment &segment, std::size_t layer);
+
+    /** add a via stack between two layers */
+    void addViaStack(const GCellCoord &pos, std::size_t layer1, std::size_t layer2);
+
+    /** call func(x,y) for every grid edge covered by a segment */
+    template<typename Func>
+    void forEachEdge(const NetSegment &segment, Func func) const;
+
+    [[nodiscard]] static bool isHorizontal(Direction dir) noexcept
+    {
+        return (dir == Direction::East) || (dir == Direction::West);
+    }
+
+    LayerGrid   &m_grid;
+    Parameters  m_params;
+};
+
+};
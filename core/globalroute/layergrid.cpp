@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+#include <limits>
+#include "common/logging.h"
+#include "layergrid.h"
+
+using namespace LunaCore::GlobalRouter;
+
+LayerGrid::LayerGrid(GCellCoordType width, GCellCoordType height, std::vector<RoutingLayer> layers)
+    : m_width(std::max<GCellCoordType>(width, 0)),
+      m_height(std::max<GCellCoordType>(height, 0)),
+      m_layers(std::move(layers))
+{
+    const std::size_t cells = static_cast<std::size_t>(m_width) * static_cast<std::size_t>(m_height);
+    m_capacity.resize(cells * m_layers.size(), 0);
+    m_usage.resize(cells * m_layers.size(), 0);
+    m_vias.resize(cells * m_layers.size(), 0);
+
+    for(std::size_t layer = 0; layer < m_layers.size(); layer++)
+    {
+        for(GCellCoordType y = 0; y < m_height; y++)
+        {
+            for(GCellCoordType x = 0; x < m_width; x++)
+            {
+                if (hasEdge(layer, x, y))
+                {
+                    m_capacity[index(layer,x,y)] = m_layers[layer].m_capacity;
+                }
+            }
+        }
+    }
+}
+
+std::vector<RoutingLayer> LayerGrid::routingLayers(const ChipDB::TechLib &techLib,
+    const ChipDB::Size64 &cellSize)
+{
+    std::vector<RoutingLayer> layers;
+
+    for(auto const layer : techLib.layers())
+    {
+        if (!layer.isValid()) continue;
+        if (layer->m_type != ChipDB::LayerType::ROUTING) continue;
+
+        RoutingLayer routingLayer;
+        routingLayer.m_name = layer->name();
+        routingLayer.m_key  = layer.key();
+
+        int64_t tracks = 0;
+        if (layer->m_dir == ChipDB::LayerDirection::HORIZONTAL)
+        {
+            routingLayer.m_horizontal = true;
+            if (layer->m_pitch.m_y > 0) tracks = cellSize.m_y / layer->m_pitch.m_y;
+        }
+        else if (layer->m_dir == ChipDB::LayerDirection::VERTICAL)
+        {
+            routingLayer.m_horizontal = false;
+            if (layer->m_pitch.m_x > 0) tracks = cellSize.m_x / layer->m_pitch.m_x;
+        }
+        else
+        {
+            Logging::logWarning("LayerGrid: routing layer %s has no preferred direction and is skipped\n",
+                routingLayer.m_name.c_str());
+            continue;
+        }
+
+        if (tracks <= 0)
+        {
+            Logging::logWarning("LayerGrid: routing layer %s has no tracks in a GCell and is skipped\n",
+                routingLayer.m_name.c_str());
+            continue;
+        }
+
+        routingLayer.m_capacity = static_cast<uint16_t>(
+            std::min<int64_t>(tracks, std::numeric_limits<uint16_t>::max()));
+
+        layers.push_back(routingLayer);
+    }
+
+    return layers;
+}
+
+bool LayerGrid::hasEdge(std::size_t layer, GCellCoordType x, GCellCoordType y) const noexcept
+{
+    if ((x < 0) || (y < 0) || (x >= m_width) || (y >= m_height)) return false;
+    if (layer >= m_layers.size()) return false;
+
+    if (m_layers[layer].m_horizontal)
+    {
+        return (x + 1) < m_width;
+    }
+    return (y + 1) < m_height;
+}
+
+void LayerGrid::addEdgeUsage(std::size_t layer, GCellCoordType x, GCellCoordType y, int delta) noexcept
+{
+    auto &usage = m_usage[index(layer,x,y)];
+    usage = static_cast<uint16_t>(std::clamp<int>(usage + delta, 0, std::numeric_limits<uint16_t>::max()));
+}
+
+void LayerGrid::addViaUsage(std::size_t layer, GCellCoordType x, GCellCoordType y, int delta) noexcept
+{
+    auto &vias = m_vias[index(layer,x,y)];
+    vias = static_cast<uint16_t>(std::clamp<int>(vias + delta, 0, std::numeric_limits<uint16_t>::max()));
+}
+
+int32_t LayerGrid::totalCapacity(bool horizontal, GCellCoordType x, GCellCoordType y) const noexcept
+{
+    int32_t capacity = 0;
+    for(std::size_t layer = 0; layer < m_layers.size(); layer++)
+    {
+        if ((m_layers[layer].m_horizontal == horizontal) && hasEdge(layer, x, y))
+        {
+            capacity += m_capacity[index(layer,x,y)];
+        }
+    }
+    return capacity;
+}
+
+int64_t LayerGrid::totalOverflow() const noexcept
+{
+    int64_t overflow = 0;
+    for(std::size_t idx = 0; idx < m_usage.size(); idx++)
+    {
+        overflow += std::max(0, static_cast<int>(m_usage[idx]) - static_cast<int>(m_capacity[idx]));
+    }
+    return overflow;
+}
+
+std::size_t LayerGrid::overflowEdges() const noexcept
+{
+    std::size_t edges = 0;
+    for(std::size_t idx = 0; idx < m_usage.size(); idx++)
+    {
+        if (m_usage[idx] > m_capacity[idx]) edges++;
+    }
+    return edges;
+}
+
+int64_t LayerGrid::totalVias() const noexcept
+{
+    int64_t vias = 0;
+    for(auto const count : m_vias)
+    {
+        vias += count;
+    }
+    return vias;
+}
+
+void LayerGrid::clearUsage() noexcept
+{
+    std::fill(m_usage.begin(), m_usage.end(), 0);
+    std::fill(m_vias.begin(), m_vias.end(), 0);
+}
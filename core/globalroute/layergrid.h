@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "database/database.h"
+#include "datatypes.h"
+
+namespace LunaCore::GlobalRouter
+{
+
+/** a routing layer of a LayerGrid */
+struct RoutingLayer
+{
+    std::string         m_name;
+    ChipDB::ObjectKey   m_key{ChipDB::ObjectNotFound};  ///< layer key in the tech lib
+    bool                m_horizontal{true}; ///< preferred routing direction
+    uint16_t            m_capacity{0};      ///< number of tracks crossing a GCell boundary
+};
+
+/** Stack of routing layers on top of the 2D GCell grid.
+ *
+ *  Each layer routes only in its preferred direction, so a layer has
+ *  one edge per GCell: on a horizontal layer, edge (x,y) connects GCell
+ *  (x,y) to (x+1,y). On a vertical layer it connects (x,y) to (x,y+1).
+ *  Layers are connected by vias, via (l,x,y) connects layer l and l+1
+ *  in GCell (x,y).
+ *
+ *  Capacity and usage are stored as separate per-layer arrays of
+ *  uint16_t, so the grid takes 6 bytes per GCell per layer.
+*/
+class LayerGrid
+{
+public:
+    LayerGrid(GCellCoordType width, GCellCoordType height, std::vector<RoutingLayer> layers);
+
+    /** create the routing layers of a tech lib, bottom layer first.
+     *  the capacity of each layer is the number of tracks that fit
+     *  in a GCell perpendicular to the routing direction.
+     *  Layers without a valid direction or pitch are skipped.
+    */
+    [[nodiscard]] static std::vector<RoutingLayer> routingLayers(const ChipDB::TechLib &techLib,
+        const ChipDB::Size64 &cellSize);
+
+    [[nodiscard]] constexpr auto width() const noexcept {return m_width; }
+    [[nodiscard]] constexpr auto height() const noexcept {return m_height; }
+    [[nodiscard]] std::size_t layerCount() const noexcept {return m_layers.size(); }
+
+    [[nodiscard]] const RoutingLayer& layer(std::size_t layer) const {return m_layers.at(layer); }
+
+    /** true if the edge (x,y) of a layer stays within the grid */
+    [[nodiscard]] bool hasEdge(std::size_t layer, GCellCoordType x, GCellCoordType y) const noexcept;
+
+    [[nodiscard]] uint16_t edgeCapacity(std::size_t layer, GCellCoordType x, GCellCoordType y) const noexcept
+    {
+        return m_capacity[index(layer,x,y)];
+    }
+
+    /** set the capacity of a single edge, for instance to model a blockage */
+    void setEdgeCapacity(std::size_t layer, GCellCoordType x, GCellCoordType y, uint16_t capacity) noexcept
+    {
+        m_capacity[index(layer,x,y)] = capacity;
+    }
+
+    [[nodiscard]] uint16_t edgeUsage(std::size_t layer, GCellCoordType x, GCellCoordType y) const noexcept
+    {
+        return m_usage[index(layer,x,y)];
+    }
+
+    void addEdgeUsage(std::size_t layer, GCellCoordType x, GCellCoordType y, int delta) noexcept;
+
+    /** number of vias between layer and layer+1 in GCell (x,y) */
+    [[nodiscard]] uint16_t viaUsage(std::size_t layer, GCellCoordType x, GCellCoordType y) const noexcept
+    {
+        return m_vias[index(layer,x,y)];
+    }
+
+    void addViaUsage(std::size_t layer, GCellCoordType x, GCellCoordType y, int delta) noexcept;
+
+    /** total capacity of all horizontal or all vertical layers of an edge */
+    [[nodiscard]] int32_t totalCapacity(bool horizontal, GCellCoordType x, GCellCoordType y) const noexcept;
+
+    /** sum of the usage beyond capacity of all edges */
+    [[nodiscard]] int64_t totalOverflow() const noexcept;
+
+    /** number of edges used beyond capacity */
+    [[nodiscard]] std::size_t overflowEdges() const noexcept;
+
+    /** total number of vias */
+    [[nodiscard]] int64_t totalVias() const noexcept;
+
+    /** clear the usage of all edges and vias */
+    void clearUsage() noexcept;
+
+protected:
+    [[nodiscard]] constexpr std::size_t index(std::size_t layer, GCellCoordType x, GCellCoordType y) const noexcept
+    {
+        return (layer*m_height + y)*m_width + x;
+    }
+
+    GCellCoordType  m_width{0};
+    GCellCoordType  m_height{0};
+    std::vector<RoutingLayer>   m_layers;
+
+    std::vector<uint16_t>   m_capacity;
+    std::vector<uint16_t>   m_usage;
+    std::vector<uint16_t>   m_vias;
+};
+
+};
@@ -0,0 +1,565 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include "common/logging.h"
+#include "pathfinder.h"
+#include "astar.h"
+
+using namespace LunaCore::GlobalRouter;
+
+void PathFinder::Workspace::nextEpoch()
+{
+    m_epoch++;
+    if (m_epoch == 0)
+    {
+        // the epoch counter wrapped around,
+        // all stamps must be invalidated.
+        std::fill(m_stamp.begin(), m_stamp.end(), 0);
+        m_epoch = 1;
+    }
+    m_wavefront.clear();
+}
+
+std::unique_ptr<PathFinder::Workspace> PathFinder::acquireWorkspace()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_workspaceMutex);
+        if (!m_workspaces.empty())
+        {
+            auto ws = std::move(m_workspaces.back());
+            m_workspaces.pop_back();
+            return ws;
+        }
+    }
+
+    const std::size_t cells = m_width * m_height;
+    auto ws = std::make_unique<Workspace>();
+    ws->m_cost.resize(cells, 0);
+    ws->m_stamp.resize(cells, 0);
+    ws->m_pred.resize(cells, Predecessor::Undefined);
+    return ws;
+}
+
+void PathFinder::releaseWorkspace(std::unique_ptr<Workspace> ws)
+{
+    std::lock_guard<std::mutex> guard(m_workspaceMutex);
+    m_workspaces.emplace_back(std::move(ws));
+}
+
+PathCostType PathFinder::cellCost(CellIndex cell) const noexcept
+{
+    const auto overflow = std::max(0, m_usage[cell] + 1 - m_capacity);
+    const double present = 1.0 + m_presentFactor * overflow;
+    return static_cast<PathCostType>(std::llround(CostScale * (1.0 + m_history[cell]) * present));
+}
+
+PathFinder::Box PathFinder::fullBox() const noexcept
+{
+    return Box{0, 0, m_width - 1, m_height - 1};
+}
+
+PathFinder::Box PathFinder::searchBox(const NetState &net) const noexcept
+{
+    return Box{
+        std::max<GCellCoordType>(0, net.m_bbox.m_x1 - net.m_margin),
+        std::max<GCellCoordType>(0, net.m_bbox.m_y1 - net.m_margin),
+        std::min<GCellCoordType>(m_width - 1, net.m_bbox.m_x2 + net.m_margin),
+        std::min<GCellCoordType>(m_height - 1, net.m_bbox.m_y2 + net.m_margin)
+    };
+}
+
+bool PathFinder::routeConnection(const std::vector<CellIndex> &tree, CellIndex terminal,
+    const Box &box, Workspace &ws, std::vector<CellIndex> &path) const
+{
+    ws.nextEpoch();
+
+    // the search state lives in the workspace, cells with
+    // an old stamp have not been reached in this search.
+    struct WorkspaceCells
+    {
+        const PathFinder    &m_finder;
+        Workspace           &m_ws;
+        const Box           &m_box;
+        CellIndex           m_terminal;
+
+        bool canEnter(const GCellCoord &pos) const noexcept
+        {
+            if (!m_box.contains(pos.m_x, pos.m_y)) return false;
+            const auto cell = m_finder.toIndex(pos.m_x, pos.m_y);
+            return (m_finder.m_blocked[cell] == 0) || (cell == m_terminal);
+        }
+
+        PathCostType cellCost(const GCellCoord &pos) const noexcept
+        {
+            return m_finder.cellCost(m_finder.toIndex(pos.m_x, pos.m_y));
+        }
+
+        PathCostType cost(const GCellCoord &pos) const noexcept
+        {
+            const auto cell = m_finder.toIndex(pos.m_x, pos.m_y);
+            return (m_ws.m_stamp[cell] == m_ws.m_epoch) ? m_ws.m_cost[cell] : std::numeric_limits<PathCostType>::max();
+        }
+
+        Predecessor predecessor(const GCellCoord &pos) const noexcept
+        {
+            return m_ws.m_pred[m_finder.toIndex(pos.m_x, pos.m_y)];
+        }
+
+        void update(const GCellCoord &pos, PathCostType cost, Predecessor pred) noexcept
+        {
+            const auto cell = m_finder.toIndex(pos.m_x, pos.m_y);
+            m_ws.m_stamp[cell] = m_ws.m_epoch;
+            m_ws.m_cost[cell]  = cost;
+            m_ws.m_pred[cell]  = pred;
+        }
+    };
+
+    const auto target = toCoord(terminal);
+
+    // all cells of the tree are sources
+    for(auto cell : tree)
+    {
+        ws.m_stamp[cell] = ws.m_epoch;
+        ws.m_cost[cell]  = 0;
+        ws.m_pred[cell]  = Predecessor::Undefined;
+
+        WavefrontItem item;
+        item.m_gridpos  = toCoord(cell);
+        item.m_pathCost = CostScale * item.m_gridpos.manhattanDistance(target);
+        ws.m_wavefront.push(item);
+    }
+
+    const auto bendPenalty = static_cast<PathCostType>(std::llround(CostScale * m_params.m_bendPenalty));
+
+    WorkspaceCells cells{*this, ws, box, terminal};
+    std::size_t evaluations = 0;
+    if (!aStarSearch(ws.m_wavefront, target, CostScale, bendPenalty, cells, evaluations))
+    {
+        return false;
+    }
+
+    // back-trace from the terminal to the tree
+    path.clear();
+    auto current = terminal;
+    path.push_back(current);
+    while(ws.m_pred[current] != Predecessor::Undefined)
+    {
+        auto p = toCoord(current);
+        switch(ws.m_pred[current])
+        {
+        case Predecessor::North:
+            p = north(p);
+            break;
+        case Predecessor::South:
+            p = south(p);
+            break;
+        case Predecessor::East:
+            p = east(p);
+            break;
+        case Predecessor::West:
+            p = west(p);
+            break;
+        default:
+            break;
+        }
+        current = toIndex(p.m_x, p.m_y);
+        path.push_back(current);
+    }
+    return true;
+}
+
+bool PathFinder::routeNet(NetState &net, const Box &box, Workspace &ws) const
+{
+    net.m_paths.clear();
+    net.m_cells.clear();
+    net.m_routed = false;
+
+    if (!net.m_valid || net.m_terminals.empty())
+    {
+        return false;
+    }
+
+    std::vector<CellIndex> tree;
+    tree.push_back(net.m_terminals.front());
+
+    std::vector<CellIndex> path;
+    for(std::size_t idx = 1; idx < net.m_terminals.size(); idx++)
+    {
+        if (!routeConnection(tree, net.m_terminals[idx], box, ws, path))
+        {
+            net.m_paths.clear();
+            return false;
+        }
+
+        // the last cell of the path is already part of the tree
+        tree.insert(tree.end(), path.begin(), path.end() - 1);
+        net.m_paths.push_back(path);
+    }
+
+    std::sort(tree.begin(), tree.end());
+    tree.erase(std::unique(tree.begin(), tree.end()), tree.end());
+    net.m_cells  = std::move(tree);
+    net.m_routed = true;
+    return true;
+}
+
+void PathFinder::addUsage(const NetState &net, int delta)
+{
+    for(auto cell : net.m_cells)
+    {
+        m_usage[cell] += delta;
+    }
+}
+
+std::vector<std::vector<std::size_t>> PathFinder::makeBatches(
+    const std::vector<std::size_t> &netOrder) const
+{
+    // claimed areas are tracked on a coarse grid of tiles
+    const GCellCoordType tileSize = std::max<GCellCoordType>(4, std::max(m_width, m_height) / 64);
+    const auto tilesX = static_cast<std::size_t>((m_width  + tileSize - 1) / tileSize);
+    const auto tilesY = static_cast<std::size_t>((m_height + tileSize - 1) / tileSize);
+
+    std::vector<std::vector<std::size_t>> batches;
+    std::vector<std::size_t> pending = netOrder;
+    std::vector<std::size_t> deferred;
+    std::vector<uint8_t> claimed(tilesX * tilesY);
+
+    while(!pending.empty())
+    {
+        std::fill(claimed.begin(), claimed.end(), 0);
+        auto &batch = batches.emplace_back();
+        deferred.clear();
+
+        for(auto netIndex : pending)
+        {
+            auto const box = searchBox(m_nets[netIndex]);
+            const auto tx1 = static_cast<std::size_t>(box.m_x1 / tileSize);
+            const auto tx2 = static_cast<std::size_t>(box.m_x2 / tileSize);
+            const auto ty1 = static_cast<std::size_t>(box.m_y1 / tileSize);
+            const auto ty2 = static_cast<std::size_t>(box.m_y2 / tileSize);
+
+            bool overlaps = false;
+            for(auto ty = ty1; (ty <= ty2) && !overlaps; ty++)
+            {
+                for(auto tx = tx1; tx <= tx2; tx++)
+                {
+                    if (claimed[ty*tilesX + tx] != 0)
+                    {
+                        overlaps = true;
+                        break;
+                    }
+                }
+            }
+
+            if (overlaps)
+            {
+                deferred.push_back(netIndex);
+                continue;
+            }
+
+            for(auto ty = ty1; ty <= ty2; ty++)
+            {
+                for(auto tx = tx1; tx <= tx2; tx++)
+                {
+                    claimed[ty*tilesX + tx] = 1;
+                }
+            }
+            batch.push_back(netIndex);
+        }
+
+        std::swap(pending, deferred);
+    }
+
+    return batches;
+}
+
+SegmentList PathFinder::createSegments(const NetState &net) const
+{
+    SegmentList segments;
+
+    if (net.m_paths.empty())
+    {
+        // all terminals are within the same cell
+        auto seg = segments.createNewSegment(toCoord(net.m_terminals.front()), Direction::East, nullptr);
+        seg->m_length = 0;
+        return segments;
+    }
+
+    // segments follow the conventions of Router::routeTwoPointRoute:
+    // they start at the terminal side, the direction points to the
+    // tree and the length includes the first and last cell.
+    auto stepDirection = [](const GCellCoord &from, const GCellCoord &to)
+    {
+        if (to == east(from)) return Direction::East;
+        if (to == west(from)) return Direction::West;
+        if (to == north(from)) return Direction::North;
+        return Direction::South;
+    };
+
+    for(auto const& path : net.m_paths)
+    {
+        if (path.size() < 2) continue;
+
+        NetSegment *segment = nullptr;
+        for(std::size_t idx = 0; (idx + 1) < path.size(); idx++)
+        {
+            const auto from = toCoord(path[idx]);
+            const auto dir  = stepDirection(from, toCoord(path[idx+1]));
+
+            if ((segment == nullptr) || (segment->m_dir != dir))
+            {
+                segment = segments.createNewSegment(from, dir, segment);
+            }
+            segment->m_length++;
+        }
+    }
+
+    return segments;
+}
+
+PathFinder::Result PathFinder::route(const std::vector<std::vector<ChipDB::Coord64>> &nets,
+    const Parameters &params)
+{
+    m_params = params;
+    m_presentFactor = params.m_presentFactor;
+    m_width  = m_grid.width();
+    m_height = m_grid.height();
+    m_capacity = static_cast<int32_t>(m_grid.maxCellCapacity());
+
+    const std::size_t cells = m_width * m_height;
+    m_usage.assign(cells, 0);
+    m_history.assign(cells, 0.0f);
+    m_blocked.assign(cells, 0);
+    m_workspaces.clear();
+
+    for(GCellCoordType y = 0; y < m_height; y++)
+    {
+        for(GCellCoordType x = 0; x < m_width; x++)
+        {
+            auto const& gcell = m_grid.at(x, y);
+            m_usage[toIndex(x,y)]   = gcell.m_capacity;
+            m_blocked[toIndex(x,y)] = gcell.isBlocked() ? 1 : 0;
+        }
+    }
+
+    // convert the terminals to grid cells
+    m_nets.clear();
+    m_nets.resize(nets.size());
+    for(std::size_t netIndex = 0; netIndex < nets.size(); netIndex++)
+    {
+        auto &net = m_nets[netIndex];
+        net.m_margin = params.m_boxMargin;
+        net.m_bbox = Box{m_width, m_height, -1, -1};
+
+        for(auto const& terminal : nets[netIndex])
+        {
+            auto const pos = m_grid.toGridCoord(terminal);
+            if (!m_grid.isValidGridCoord(pos))
+            {
+                net.m_valid = false;
+                break;
+            }
+
+            const auto cell = toIndex(pos.m_x, pos.m_y);
+            if (std::find(net.m_terminals.begin(), net.m_terminals.end(), cell) == net.m_terminals.end())
+            {
+                net.m_terminals.push_back(cell);
+            }
+
+            net.m_bbox.m_x1 = std::min(net.m_bbox.m_x1, pos.m_x);
+            net.m_bbox.m_y1 = std::min(net.m_bbox.m_y1, pos.m_y);
+            net.m_bbox.m_x2 = std::max(net.m_bbox.m_x2, pos.m_x);
+            net.m_bbox.m_y2 = std::max(net.m_bbox.m_y2, pos.m_y);
+        }
+
+        if (!net.m_valid || net.m_terminals.empty())
+        {
+            net.m_valid = false;
+            net.m_bbox  = Box{};
+            Logging::logWarning("PathFinder: net %lu has terminals outside the grid\n", netIndex);
+        }
+    }
+
+    // small nets first
+    std::vector<std::size_t> netOrder(m_nets.size());
+    std::iota(netOrder.begin(), netOrder.end(), 0);
+    std::stable_sort(netOrder.begin(), netOrder.end(),
+        [this](std::size_t a, std::size_t b)
+        {
+            auto const& boxA = m_nets[a].m_bbox;
+            auto const& boxB = m_nets[b].m_bbox;
+            return (boxA.m_x2 - boxA.m_x1 + boxA.m_y2 - boxA.m_y1) < (boxB.m_x2 - boxB.m_x1 + boxB.m_y2 - boxB.m_y1);
+        }
+    );
+
+    const PoolSelection threads(params.m_threads);
+
+    Result result;
+    std::vector<std::size_t> toRoute;
+    for(auto netIndex : netOrder)
+    {
+        if (m_nets[netIndex].m_valid) toRoute.push_back(netIndex);
+    }
+
+    for(std::size_t iteration = 0; iteration < params.m_maxIterations; iteration++)
+    {
+        result.m_iterations = iteration + 1;
+
+        // route the nets in batches with non-overlapping search boxes.
+        // the nets of a batch only read the shared usage and history,
+        // the usage is updated in-order after the batch.
+        std::vector<std::size_t> failed;
+        for(auto const& batch : makeBatches(toRoute))
+        {
+            for(auto netIndex : batch)
+            {
+                addUsage(m_nets[netIndex], -1);
+            }
+
+            auto routeBatchNet = [this, &batch](std::size_t index)
+            {
+                auto &net = m_nets[batch[index]];
+                auto ws = acquireWorkspace();
+                routeNet(net, searchBox(net), *ws);
+                releaseWorkspace(std::move(ws));
+            };
+
+            threads.forEach(0, batch.size(), routeBatchNet);
+
+            for(auto netIndex : batch)
+            {
+                if (m_nets[netIndex].m_routed)
+                {
+                    addUsage(m_nets[netIndex], 1);
+                }
+                else
+                {
+                    failed.push_back(netIndex);
+                }
+            }
+        }
+
+        // nets that could not be routed within their search box
+        // are routed on the whole grid, one at a time.
+        auto ws = acquireWorkspace();
+        for(auto netIndex : failed)
+        {
+            auto &net = m_nets[netIndex];
+            net.m_margin = std::max<GCellCoordType>(1, 2*net.m_margin);
+            if (routeNet(net, fullBox(), *ws))
+            {
+                addUsage(net, 1);
+            }
+        }
+        releaseWorkspace(std::move(ws));
+
+        // update the history cost and collect
+        // the nets that need to be ripped up.
+        result.m_overflowCells = 0;
+        result.m_totalOverflow = 0;
+        for(CellIndex cell = 0; cell < cells; cell++)
+        {
+            if (isOverflowed(cell))
+            {
+                const auto overflow = m_usage[cell] - m_capacity;
+                result.m_overflowCells++;
+                result.m_totalOverflow += overflow;
+                m_history[cell] += static_cast<float>(params.m_historyIncrement * overflow);
+            }
+        }
+
+        // summed-area table of the overflowed cells, so we can
+        // check quickly if a search box contains congestion.
+        const auto stride = static_cast<std::size_t>(m_width + 1);
+        std::vector<uint32_t> overflowSum(stride * (m_height + 1), 0);
+        for(GCellCoordType y = 0; y < m_height; y++)
+        {
+            uint32_t rowSum = 0;
+            for(GCellCoordType x = 0; x < m_width; x++)
+            {
+                rowSum += isOverflowed(toIndex(x,y)) ? 1 : 0;
+                overflowSum[(y+1)*stride + x + 1] = overflowSum[y*stride + x + 1] + rowSum;
+            }
+        }
+
+        auto hasOverflow = [&](const Box &box)
+        {
+            return (overflowSum[(box.m_y2+1)*stride + box.m_x2 + 1] - overflowSum[box.m_y1*stride + box.m_x2 + 1]
+                - overflowSum[(box.m_y2+1)*stride + box.m_x1] + overflowSum[box.m_y1*stride + box.m_x1]) != 0;
+        };
+
+        toRoute.clear();
+        result.m_unroutedNets = 0;
+        for(auto netIndex : netOrder)
+        {
+            auto const& net = m_nets[netIndex];
+            if (!net.m_valid)
+            {
+                result.m_unroutedNets++;
+                continue;
+            }
+
+            if (!net.m_routed)
+            {
+                result.m_unroutedNets++;
+                toRoute.push_back(netIndex);
+                continue;
+            }
+
+            // all nets that could have used an overflowed cell are
+            // ripped up, so nets that block others get to move too.
+            if (hasOverflow(searchBox(net)))
+            {
+                toRoute.push_back(netIndex);
+            }
+        }
+
+        Logging::logVerbose("  PathFinder iteration %lu: %lu overflowed cells, total overflow %ld, %lu unrouted nets\n",
+            result.m_iterations, result.m_overflowCells, result.m_totalOverflow, result.m_unroutedNets);
+
+        // nets that are still unrouted failed on the whole grid,
+        // another iteration won't help them.
+        if (result.m_totalOverflow == 0)
+        {
+            break;
+        }
+
+        // limit the present factor so the path costs can't overflow
+        m_presentFactor = std::min(m_presentFactor * params.m_presentFactorGrowth, MaxPresentFactor);
+    }
+
+    // write back the usage and create the segments
+    for(GCellCoordType y = 0; y < m_height; y++)
+    {
+        for(GCellCoordType x = 0; x < m_width; x++)
+        {
+            const auto usage = std::min<int32_t>(m_usage[toIndex(x,y)], std::numeric_limits<uint16_t>::max());
+            m_grid.at(x, y).m_capacity = static_cast<uint16_t>(usage);
+        }
+    }
+
+    result.m_routes.reserve(m_nets.size());
+    for(auto const& net : m_nets)
+    {
+        if (net.m_routed)
+        {
+            result.m_routes.emplace_back(createSegments(net));
+            result.m_wirelength += static_cast<int64_t>(net.m_cells.size());
+        }
+        else
+        {
+            result.m_routes.emplace_back();
+        }
+    }
+
+    Logging::logInfo("PathFinder: %lu iterations, %lu overflowed cells, %lu unrouted nets, wirelength %ld cells\n",
+        result.m_iterations, result.m_overflowCells, result.m_unroutedNets, result.m_wirelength);
+
+    m_workspaces.clear();
+    return result;
+}
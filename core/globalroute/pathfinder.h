@@ -0,0 +1,171 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "common/threadpool.h"
+#include "datatypes.h"
+#include "wavefront.h"
+#include "grid.h"
+
+namespace LunaCore::GlobalRouter
+{
+
+/** Negotiated congestion router.
+ *
+ *  Routes a set of nets on a Grid using the PathFinder algorithm:
+ *  nets may share grid cells beyond their capacity, but the cost
+ *  of an overused cell rises with each iteration (present cost) and
+ *  cells that stay overused accumulate a history cost. Nets that run
+ *  through overused cells are ripped up and re-routed until there is
+ *  no overflow left or the iteration limit is reached.
+ *
+ *  The capacity of each cell is Grid::maxCellCapacity(). The GCell
+ *  m_capacity values present before routing count as existing usage,
+ *  and blocked cells are never used. When routing is done, the usage
+ *  of the nets is added to the GCell m_capacity values.
+ *
+ *  Nets whose bounding boxes don't overlap are routed concurrently.
+*/
+class PathFinder
+{
+public:
+    struct Parameters
+    {
+        std::size_t m_maxIterations{30};
+        double      m_presentFactor{0.5};       ///< initial present cost factor per unit of overflow
+        double      m_presentFactorGrowth{1.3}; ///< present cost factor multiplier per iteration
+        double      m_historyIncrement{1.0};    ///< history cost added per unit of overflow per iteration
+        double      m_bendPenalty{2.0};         ///< cost of a bend, in units of the base cell cost
+        GCellCoordType m_boxMargin{8};          ///< search box margin around the net bounding box, in grid cells
+
+        std::size_t m_threads{0};               ///< thread count, see PoolSelection
+    };
+
+    struct Result
+    {
+        std::vector<SegmentList> m_routes;      ///< one segment list per net, empty if the net is not routed
+        std::size_t m_iterations{0};
+        std::size_t m_unroutedNets{0};
+        std::size_t m_overflowCells{0};         ///< number of cells used beyond capacity
+        int64_t     m_totalOverflow{0};         ///< sum of the overflow of all cells
+        int64_t     m_wirelength{0};            ///< number of grid cells used by all nets
+
+        [[nodiscard]] bool success() const noexcept
+        {
+            return (m_unroutedNets == 0) && (m_totalOverflow == 0);
+        }
+    };
+
+    explicit PathFinder(Grid &grid) : m_grid(grid) {}
+
+    /** route all nets. each net is given by the chip coordinates of its terminals. */
+    [[nodiscard]] Result route(const std::vector<std::vector<ChipDB::Coord64>> &nets,
+        const Parameters &params);
+
+protected:
+    using CellIndex = uint32_t;
+
+    struct Box
+    {
+        GCellCoordType m_x1{0};
+        GCellCoordType m_y1{0};
+        GCellCoordType m_x2{0};
+        GCellCoordType m_y2{0};
+
+        [[nodiscard]] constexpr bool contains(GCellCoordType x, GCellCoordType y) const noexcept
+        {
+            return (x >= m_x1) && (x <= m_x2) && (y >= m_y1) && (y <= m_y2);
+        }
+    };
+
+    struct NetState
+    {
+        std::vector<CellIndex>  m_terminals;    ///< unique terminal cells in connection order
+        Box                     m_bbox;         ///< bounding box of the terminals
+        GCellCoordType          m_margin{0};    ///< current search box margin
+        std::vector<std::vector<CellIndex>> m_paths;    ///< one path per connection, from terminal to tree
+        std::vector<CellIndex>  m_cells;        ///< sorted unique cells used by the net
+        bool                    m_routed{false};
+        bool                    m_valid{true};  ///< false if a terminal is outside the grid
+    };
+
+    /** per-thread search state. cells whose stamp differs from
+     *  the current epoch have not been reached yet.
+    */
+    struct Workspace
+    {
+        std::vector<PathCostType>   m_cost;
+        std::vector<uint32_t>       m_stamp;
+        std::vector<Predecessor>    m_pred;
+        uint32_t                    m_epoch{0};
+        Wavefront                   m_wavefront;
+
+        void nextEpoch();
+    };
+
+    [[nodiscard]] std::unique_ptr<Workspace> acquireWorkspace();
+    void releaseWorkspace(std::unique_ptr<Workspace> ws);
+
+    /** route all connections of a net within a box. returns false if a connection fails. */
+    bool routeNet(NetState &net, const Box &box, Workspace &ws) const;
+
+    /** A* search from the cells already in the tree to a terminal */
+    bool routeConnection(const std::vector<CellIndex> &tree, CellIndex terminal,
+        const Box &box, Workspace &ws, std::vector<CellIndex> &path) const;
+
+    /** cost of entering a cell, in fixed-point units */
+    [[nodiscard]] PathCostType cellCost(CellIndex cell) const noexcept;
+
+    void addUsage(const NetState &net, int delta);
+
+    [[nodiscard]] Box searchBox(const NetState &net) const noexcept;
+    [[nodiscard]] Box fullBox() const noexcept;
+
+    /** split the nets into batches whose search boxes don't overlap */
+    [[nodiscard]] std::vector<std::vector<std::size_t>> makeBatches(
+        const std::vector<std::size_t> &netOrder) const;
+
+    /** convert the paths of a net into a segment list */
+    [[nodiscard]] SegmentList createSegments(const NetState &net) const;
+
+    [[nodiscard]] constexpr CellIndex toIndex(GCellCoordType x, GCellCoordType y) const noexcept
+    {
+        return static_cast<CellIndex>(y * m_width + x);
+    }
+
+    [[nodiscard]] constexpr GCellCoord toCoord(CellIndex cell) const noexcept
+    {
+        return {static_cast<GCellCoordType>(cell % m_width), static_cast<GCellCoordType>(cell / m_width)};
+    }
+
+    [[nodiscard]] constexpr bool isOverflowed(CellIndex cell) const noexcept
+    {
+        return m_usage[cell] > m_capacity;
+    }
+
+    static constexpr PathCostType CostScale = 256;   ///< fixed-point scale of the base cell cost
+    static constexpr double MaxPresentFactor = 1.0e6;
+
+    Grid            &m_grid;
+    GCellCoordType  m_width{0};
+    GCellCoordType  m_height{0};
+    int32_t         m_capacity{0};
+    Parameters      m_params;
+    double          m_presentFactor{0};
+
+    std::vector<NetState>   m_nets;
+    std::vector<int32_t>    m_usage;    ///< number of nets using each cell, including existing usage
+    std::vector<float>      m_history;  ///< history cost of each cell
+    std::vector<uint8_t>    m_blocked;
+
+    std::mutex                              m_workspaceMutex;
+    std::vector<std::unique_ptr<Workspace>> m_workspaces;
+};
+
+};
@@ -2,7 +2,7 @@
 //
 // SPDX-License-Identifier: GPL-3.0-only
 
-#include <memory>
+#include <algorithm>
 #include <sstream>
 #include "prim.h"
 #include "prim_private.h"
@@ -36,16 +36,6 @@ void LunaCore::Prim::MSTreeNode::addEdge(NodeId child, const ChipDB::Coord64 &ch
 
 MSTree LunaCore::Prim::prim(const std::vector<ChipDB::Coord64> &netNodes)
 {
-    Prim::Private::PriorityQueue pqueue;
-    for(NodeId idx = 1; idx < netNodes.size(); ++idx)
-    {
-        auto newEdge = new Prim::Private::TreeEdge;
-        newEdge->from = 0;
-        newEdge->to   = idx;
-        newEdge->m_edgeCost = calcCost(netNodes.at(0), netNodes.at(idx));
-        pqueue.push(newEdge);
-    }
-
     MSTree tree;
     tree.resize(netNodes.size());
 
@@ -58,48 +48,53 @@ MSTree LunaCore::Prim::prim(const std::vector<ChipDB::Coord64> &netNodes)
         idx++;
     }
 
+    if (netNodes.empty()) return tree;
+
     tree.at(0).m_parent = 0;
 
-    while(!pqueue.empty())
-    {
-        std::unique_ptr<TreeEdge> minEdge;
-        minEdge.reset(pqueue.top());      // take ownership of TreeEdge ptr
+    // only the nearest neighbours in each octant can be part
+    // of the tree, so Prim runs on a graph with O(n) edges.
+    CandidateGraph graph;
+    graph.build(netNodes);
 
-        pqueue.pop();
-        auto currentNodeId = minEdge->to;
+    std::vector<TreeEdge> pqueue;
+    pqueue.reserve(2*graph.edgeCount() + 1);
 
-        for(NodeId idx=0; idx < netNodes.size(); idx++)
+    uint32_t sequence = 0;
+    auto addEdges = [&](NodeId from)
+    {
+        for(auto edgeIdx = graph.m_offsets[from]; edgeIdx < graph.m_offsets[from+1]; edgeIdx++)
         {
-            auto nextNodeId = idx;
+            const auto to = graph.m_neighbours[edgeIdx];
+            if (tree[to].hasParent()) continue;
+
+            TreeEdge newEdge;
+            newEdge.from = from;
+            newEdge.to   = to;
+            newEdge.m_edgeCost = calcCost(netNodes[from], netNodes[to]);
+            newEdge.m_sequence = sequence++;
+            pqueue.push_back(newEdge);
+            std::push_heap(pqueue.begin(), pqueue.end(), TreeEdgeCompare{});
+        }
+    };
 
-            if (tree.at(idx).hasParent()) continue;
+    addEdges(0);
 
-            if (nextNodeId == currentNodeId)
-            {
-                // the head node has from == -1,
-                // and this will cause an exception if we don't
-                // check for it.
-                if (minEdge->from >= 0)
-                {
-                    tree.at(minEdge->from).addEdge(minEdge->to, netNodes.at(minEdge->to));
-                }
-                if (minEdge->to != 0) tree.at(minEdge->to).m_parent = minEdge->from;
-            }
-            else
-            {
-                auto newEdge = new TreeEdge;
-                newEdge->from = currentNodeId;
-                newEdge->to   = nextNodeId;
-                auto const& currentNodePos = netNodes.at(currentNodeId);
-                auto const& nextNodePos = netNodes.at(nextNodeId);
-                newEdge->m_edgeCost = calcCost(currentNodePos, nextNodePos);
-                pqueue.push(newEdge);
-            }
-        }
-    }
+    while(!pqueue.empty())
+    {
+        std::pop_heap(pqueue.begin(), pqueue.end(), TreeEdgeCompare{});
+        const auto minEdge = pqueue.back();
+        pqueue.pop_back();
+
+        if (tree[minEdge.to].hasParent()) continue;
 
+        tree[minEdge.from].addEdge(minEdge.to, netNodes[minEdge.to]);
+        tree[minEdge.to].m_parent = minEdge.from;
+
+        addEdges(minEdge.to);
+    }
 
-    return std::move(tree);
+    return tree;
 }
 
 std::vector<ChipDB::Coord64> LunaCore::Prim::loadNetNodes(const std::string &src)
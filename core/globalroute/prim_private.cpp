@@ -2,6 +2,9 @@
 //
 // SPDX-License-Identifier: GPL-3.0-only
 
+#include <algorithm>
+#include <map>
+#include <numeric>
 #include "prim_private.h"
 
 bool LunaCore::Prim::Private::operator<(
@@ -19,3 +22,84 @@ bool LunaCore::Prim::Private::operator<(
     // and lhs.m_minAbsY == rhs.m_minAbsY here.
     return (lhs.m_minMaxX < rhs.m_minMaxX);
 }
+
+void LunaCore::Prim::Private::CandidateGraph::build(const std::vector<ChipDB::Coord64> &netNodes)
+{
+    const auto nodeCount = netNodes.size();
+
+    // sweep the nodes four times, each time with the coordinates
+    // mirrored or swapped so that every octant is covered once.
+    std::vector<ChipDB::Coord64> points(netNodes);
+    std::vector<NodeId> order(nodeCount);
+    std::iota(order.begin(), order.end(), 0);
+
+    std::vector<std::pair<NodeId, NodeId>> edges;
+    edges.reserve(4*nodeCount);
+
+    std::map<ChipDB::CoordType, NodeId> active;
+    for(int pass = 0; pass < 4; pass++)
+    {
+        std::sort(order.begin(), order.end(), [&points](NodeId lhs, NodeId rhs)
+            {
+                const auto lhsKey = points[lhs].m_x + points[lhs].m_y;
+                const auto rhsKey = points[rhs].m_x + points[rhs].m_y;
+                if (lhsKey != rhsKey) return lhsKey < rhsKey;
+                return lhs < rhs;
+            }
+        );
+
+        // the active set holds the nodes that have not found their
+        // nearest neighbour in the current octant yet, keyed on -y.
+        active.clear();
+        for(auto node : order)
+        {
+            auto iter = active.lower_bound(-points[node].m_y);
+            while(iter != active.end())
+            {
+                const auto other = iter->second;
+                const auto dx = points[node].m_x - points[other].m_x;
+                const auto dy = points[node].m_y - points[other].m_y;
+                if (dy > dx) break;
+
+                edges.emplace_back(node, other);
+                iter = active.erase(iter);
+            }
+            active[-points[node].m_y] = node;
+        }
+
+        for(auto &point : points)
+        {
+            if (pass & 1)
+            {
+                point.m_x = -point.m_x;
+            }
+            else
+            {
+                std::swap(point.m_x, point.m_y);
+            }
+        }
+    }
+
+    // store the edges in both directions
+    m_offsets.assign(nodeCount + 1, 0);
+    for(auto const& edge : edges)
+    {
+        m_offsets[edge.first + 1]++;
+        m_offsets[edge.second + 1]++;
+    }
+
+    std::partial_sum(m_offsets.begin(), m_offsets.end(), m_offsets.begin());
+
+    m_neighbours.resize(2*edges.size());
+    std::vector<uint32_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+    for(auto const& edge : edges)
+    {
+        m_neighbours[fill[edge.first]++]  = edge.second;
+        m_neighbours[fill[edge.second]++] = edge.first;
+    }
+
+    for(std::size_t node = 0; node < nodeCount; node++)
+    {
+        std::sort(m_neighbours.begin() + m_offsets[node], m_neighbours.begin() + m_offsets[node+1]);
+    }
+}
@@ -3,7 +3,8 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #pragma once
-#include <queue>
+#include <cstdint>
+#include <vector>
 #include "database/database.h"
 #include "prim.h"
 
@@ -27,17 +28,41 @@ struct TreeEdge
     NodeId from{c_Undefined};
     NodeId to{c_Undefined};
     CostTuple m_edgeCost;
+    uint32_t  m_sequence{0};  ///< order in which the edge was found
 };
 
+/** heap order for TreeEdges: the top of the heap is the edge with the
+    lowest cost. Of edges with equal costs, the one found last is on top. */
 struct TreeEdgeCompare
 {
-    [[nodiscard]] bool operator()(const TreeEdge* lhs, const TreeEdge* rhs) const noexcept
+    [[nodiscard]] bool operator()(const TreeEdge &lhs, const TreeEdge &rhs) const noexcept
     {
-        return !(lhs->m_edgeCost < rhs->m_edgeCost);
+        if (lhs.m_edgeCost < rhs.m_edgeCost) return false;
+        if (rhs.m_edgeCost < lhs.m_edgeCost) return true;
+        return lhs.m_sequence < rhs.m_sequence;
     }
 };
 
-using PriorityQueue = std::priority_queue<TreeEdge*, std::vector<TreeEdge*>, TreeEdgeCompare>;
+/** Candidate edges for the rectilinear minimum spanning tree, stored in CSR form.
+    For each node, only the nearest node in each of the eight octants around it
+    is a candidate. The candidate graph has at most 4n edges and contains a
+    rectilinear MST.
+    Based on: "Efficient Minimum Spanning Tree Construction without Delaunay
+    Triangulation", H. Zhou, N. Shenoy, W. Nicholls, ASP-DAC 2001.
+*/
+struct CandidateGraph
+{
+    std::vector<uint32_t>   m_offsets;      ///< CSR offsets into m_neighbours, one entry per node + 1
+    std::vector<NodeId>     m_neighbours;
+
+    /** build the candidate graph in O(n log n) */
+    void build(const std::vector<ChipDB::Coord64> &netNodes);
+
+    [[nodiscard]] std::size_t edgeCount() const noexcept
+    {
+        return m_neighbours.size() / 2;
+    }
+};
 
 inline CostTuple calcCost(const ChipDB::Coord64 &node1, const ChipDB::Coord64 &node2) noexcept
 {
@@ -1,24 +1,72 @@
-
 // SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
 //
 // SPDX-License-Identifier: GPL-3.0-only
 
-#include "wavefront.h"
+#include <bit>
+#include <cassert>
 #include <algorithm>
+#include "wavefront.h"
 
 using namespace LunaCore;
 
-const GlobalRouter::WavefrontItem& GlobalRouter::Wavefront::getLowestCostItem() const
+std::size_t GlobalRouter::Wavefront::bucketIndex(PathCostType cost) const noexcept
 {
-    return m_items.top();
+    const auto diff = static_cast<uint64_t>(cost) ^ static_cast<uint64_t>(m_last);
+    return (diff == 0) ? 0 : static_cast<std::size_t>(64 - std::countl_zero(diff));
+}
+
+const GlobalRouter::WavefrontItem& GlobalRouter::Wavefront::getLowestCostItem()
+{
+    assert(m_size > 0);
+
+    if (m_buckets[0].empty())
+    {
+        // find the first non-empty bucket and move its items
+        // to lower buckets, relative to its lowest cost.
+        std::size_t idx = 1;
+        while(m_buckets[idx].empty()) idx++;
+
+        auto &bucket = m_buckets[idx];
+        m_last = std::min_element(bucket.begin(), bucket.end(),
+            [](const WavefrontItem &lhs, const WavefrontItem &rhs)
+            {
+                return lhs.m_pathCost < rhs.m_pathCost;
+            }
+        )->m_pathCost;
+
+        for(auto const& item : bucket)
+        {
+            m_buckets[bucketIndex(item.m_pathCost)].push_back(item);
+        }
+        bucket.clear();
+    }
+
+    return m_buckets[0].back();
 }
 
 void GlobalRouter::Wavefront::push(const WavefrontItem &item)
 {
-    m_items.push(item);
+    // a cost below the last one taken violates the monotone
+    // property. such an item is taken next, at the last cost.
+    assert(item.m_pathCost >= m_last);
+    const auto idx = (item.m_pathCost < m_last) ? 0 : bucketIndex(item.m_pathCost);
+    m_buckets[idx].push_back(item);
+    m_size++;
+}
+
+void GlobalRouter::Wavefront::pop()
+{
+    getLowestCostItem();
+    m_buckets[0].pop_back();
+    m_size--;
 }
 
 void GlobalRouter::Wavefront::clear()
 {
-    m_items = PQueueType{};
+    for(auto &bucket : m_buckets)
+    {
+        bucket.clear();
+    }
+    m_last = 0;
+    m_size = 0;
 }
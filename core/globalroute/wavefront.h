@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <queue>
+#include <array>
 #include <vector>
 #include "datatypes.h"
 
@@ -18,31 +18,38 @@ struct WavefrontItem
     PathCostType    m_pathCost{0};
 };
 
+/** Monotone priority queue of wavefront items, implemented as a radix heap.
+ *
+ *  The cost of a pushed item may not be lower than the cost of the last
+ *  item taken from the wavefront. This holds for maze searches with
+ *  non-negative cell costs, and for A* with a consistent heuristic.
+ *
+ *  Items are kept in 65 buckets by the highest bit in which their cost
+ *  differs from the last cost taken. Each item moves to a lower bucket
+ *  at most 64 times, so push and pop don't pay the log factor of a
+ *  binary heap and there is no comparison based sorting at all.
+*/
 class Wavefront
 {
 public:
-    using iterator_type = std::vector<WavefrontItem>::iterator;
+    /** return the item with the lowest cost. the wavefront must not be empty. */
+    const WavefrontItem& getLowestCostItem();
 
-    const WavefrontItem& getLowestCostItem() const;
-
-    bool empty() const {return m_items.empty(); }
+    bool empty() const {return m_size == 0; }
     void push(const WavefrontItem &item);
-    void pop() {m_items.pop(); }
+    void pop();
     void clear();
 
-protected:
+    std::size_t size() const {return m_size; }
 
-    struct WavefrontItemCompare
-    {
-        constexpr bool operator()(const WavefrontItem &left, const WavefrontItem &right) const
-        {
-            return left.m_pathCost > right.m_pathCost;
-        }
-    };
+protected:
+    static constexpr std::size_t Buckets = 65;
 
-    using PQueueType = std::priority_queue<WavefrontItem, std::vector<WavefrontItem>, WavefrontItemCompare>;
+    [[nodiscard]] std::size_t bucketIndex(PathCostType cost) const noexcept;
 
-    PQueueType m_items;
+    std::array<std::vector<WavefrontItem>, Buckets> m_buckets;
+    PathCostType    m_last{0};  ///< cost of the last item taken from the wavefront
+    std::size_t     m_size{0};
 };
 
-};
\ No newline at end of file
+};
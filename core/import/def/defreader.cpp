@@ -2,21 +2,26 @@
 //
 // SPDX-License-Identifier: GPL-3.0-only
 
+#include <iterator>
 #include "common/logging.h"
+#include "common/mappedfile.h"
 #include "defreader.h"
 #include "defreaderimpl.h"
 
 using namespace ChipDB::DEF;
 
 bool Reader::load(Design &design, std::istream &source)
+{
+    const std::string src{std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>()};
+    return load(design, std::string_view(src));
+}
+
+bool Reader::load(Design &design, std::string_view source)
 {
     try
     {
-        std::stringstream src;
-        src << source.rdbuf();
-
         ReaderImpl readerimpl(design);
-        if (!readerimpl.parse(src.str()))
+        if (!readerimpl.parse(source))
         {
             Logging::logError("DEF::Reader failed to load file.\n");
             return false;
@@ -31,3 +36,15 @@ bool Reader::load(Design &design, std::istream &source)
 
     return false;
 }
+
+bool Reader::loadFile(Design &design, const std::string &filename)
+{
+    LunaCore::MappedFile file(filename);
+    if (!file.good())
+    {
+        Logging::logError("DEF::Reader cannot open file %s\n", filename.c_str());
+        return false;
+    }
+
+    return load(design, file.view());
+}
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <istream>
+#include <string>
+#include <string_view>
 #include "database/database.h"
 
 /** Namespace for the DEF importers and exporters */
@@ -20,6 +22,12 @@ public:
      *  exist.
     */
     static bool load(Design &design, std::istream &source);
+
+    /** load DEF source text */
+    static bool load(Design &design, std::string_view source);
+
+    /** load a DEF file, the file is memory mapped and not copied */
+    static bool loadFile(Design &design, const std::string &filename);
 };
 
 };
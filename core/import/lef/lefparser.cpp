@@ -69,12 +69,12 @@ char Parser::peek() const
     if (atEnd())
         return 0;
 
-    return m_src->at(m_idx);
+    return m_src[m_idx];
 }
 
 bool Parser::atEnd() const
 {
-    return !(m_idx < m_src->size());
+    return !(m_idx < m_src.size());
 }
 
 #if 0
@@ -356,9 +356,9 @@ Parser::token_t Parser::tokenize(std::string &tokstr)
     return TOK_ERR;
 }
 
-bool Parser::parse(const std::string &lefstring)
+bool Parser::parse(std::string_view lefstring)
 {
-    m_src = &lefstring;
+    m_src = lefstring;
     m_idx = 0;
     m_col = 1;
     m_lineNum = 1;
@@ -7,6 +7,7 @@
 #include <list>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <regex>
 
@@ -25,7 +26,6 @@ class Parser
 public:
     Parser() :
         m_curtok(TOK_ERR),
-        m_src(nullptr),
         m_idx(0),
         m_lineNum(0),
         m_col(0),
@@ -53,7 +53,8 @@ public:
         TOK_ERR
     };
 
-    bool parse(const std::string &lefstring);
+    /** parse a source text, which must stay valid while parsing */
+    bool parse(std::string_view lefstring);
 
     /** callback for each LEF macro */
     virtual void onMacro(const std::string &macroName) {}
@@ -293,8 +294,8 @@ protected:
 
     int64_t flt2int(const std::string &value, bool &ok);  ///< convert LEF/DEF values to nanometers
 
-    const std::string *m_src;
-    uint32_t    m_idx;
+    std::string_view m_src;   ///< source text
+    std::size_t m_idx;
     uint32_t    m_lineNum;
     uint32_t    m_col;
 
@@ -2,21 +2,304 @@
 //
 // SPDX-License-Identifier: GPL-3.0-only
 
+#include <functional>
+#include <iterator>
 #include "common/logging.h"
+#include "common/mappedfile.h"
+#include "import/recorder.h"
 #include "lefreader.h"
 #include "lefreaderimpl.h"
 
 using namespace ChipDB::LEF;
 
+namespace
+{
+
+/** records the parser callbacks so they can be replayed
+ *  on a ReaderImpl later. This allows files to be parsed
+ *  concurrently while the database is updated by one thread.
+*/
+class Recorder : public Parser
+{
+public:
+    /** call the recorded callbacks on a parser */
+    void replay(Parser &target) const
+    {
+        for(auto const& call : m_calls)
+        {
+            call(target);
+        }
+    }
+
+    void onMacro(const std::string &macroName) override
+    {
+        m_calls.emplace_back([macroName = text(macroName)](Parser &p){ p.onMacro(std::string(macroName)); });
+    }
+
+    void onEndMacro(const std::string &macroName) override
+    {
+        m_calls.emplace_back([macroName = text(macroName)](Parser &p){ p.onEndMacro(std::string(macroName)); });
+    }
+
+    void onClass(const std::string &className) override
+    {
+        m_calls.emplace_back([className = text(className)](Parser &p){ p.onClass(std::string(className)); });
+    }
+
+    void onClass(const std::string &className, const std::string &subclass) override
+    {
+        m_calls.emplace_back([className = text(className), subclass = text(subclass)](Parser &p){ p.onClass(std::string(className), std::string(subclass)); });
+    }
+
+    void onOrigin(int64_t x, int64_t y) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onOrigin(x, y); });
+    }
+
+    void onForeign(const std::string &foreignName, int64_t x, int64_t y) override
+    {
+        m_calls.emplace_back([=, foreignName = text(foreignName)](Parser &p){ p.onForeign(std::string(foreignName), x, y); });
+    }
+
+    void onSize(int64_t sx, int64_t sy) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onSize(sx, sy); });
+    }
+
+    void onSymmetry(const ChipDB::SymmetryFlags &symmetry) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onSymmetry(symmetry); });
+    }
+
+    void onMacroSite(const std::string &site) override
+    {
+        m_calls.emplace_back([site = text(site)](Parser &p){ p.onMacroSite(std::string(site)); });
+    }
+
+    void onPin(const std::string &pinName) override
+    {
+        m_calls.emplace_back([pinName = text(pinName)](Parser &p){ p.onPin(std::string(pinName)); });
+    }
+
+    void onPinDirection(const std::string &direction) override
+    {
+        m_calls.emplace_back([direction = text(direction)](Parser &p){ p.onPinDirection(std::string(direction)); });
+    }
+
+    void onPinUse(const std::string &use) override
+    {
+        m_calls.emplace_back([use = text(use)](Parser &p){ p.onPinUse(std::string(use)); });
+    }
+
+    void onEndPin(const std::string &pinName) override
+    {
+        m_calls.emplace_back([pinName = text(pinName)](Parser &p){ p.onEndPin(std::string(pinName)); });
+    }
+
+    void onObstruction() override
+    {
+        m_calls.emplace_back([](Parser &p){ p.onObstruction(); });
+    }
+
+    void onObstructionLayer(const std::string &layerName) override
+    {
+        m_calls.emplace_back([layerName = text(layerName)](Parser &p){ p.onObstructionLayer(std::string(layerName)); });
+    }
+
+    void OnEndObstruction() override
+    {
+        m_calls.emplace_back([](Parser &p){ p.OnEndObstruction(); });
+    }
+
+    void onEndParse() override
+    {
+        m_calls.emplace_back([](Parser &p){ p.onEndParse(); });
+    }
+
+    void onVia(const std::string &viaName) override
+    {
+        m_calls.emplace_back([viaName = text(viaName)](Parser &p){ p.onVia(std::string(viaName)); });
+    }
+
+    void onViaRule(const std::string &viaRuleName) override
+    {
+        m_calls.emplace_back([viaRuleName = text(viaRuleName)](Parser &p){ p.onViaRule(std::string(viaRuleName)); });
+    }
+
+    void onLayer(const std::string &layerName) override
+    {
+        m_calls.emplace_back([layerName = text(layerName)](Parser &p){ p.onLayer(std::string(layerName)); });
+    }
+
+    void onEndLayer(const std::string &layerName) override
+    {
+        m_calls.emplace_back([layerName = text(layerName)](Parser &p){ p.onEndLayer(std::string(layerName)); });
+    }
+
+    void onLayerType(const std::string &layerType) override
+    {
+        m_calls.emplace_back([layerType = text(layerType)](Parser &p){ p.onLayerType(std::string(layerType)); });
+    }
+
+    void onLayerPitch(int64_t xpitch, int64_t ypitch) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerPitch(xpitch, ypitch); });
+    }
+
+    void onLayerSpacing(int64_t spacing) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerSpacing(spacing); });
+    }
+
+    void onLayerSpacingRange(int64_t value1, int64_t value2) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerSpacingRange(value1, value2); });
+    }
+
+    void onLayerSpacingRangeInfluence(int64_t influence) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerSpacingRangeInfluence(influence); });
+    }
+
+    void onLayerOffset(int64_t x_offset, int64_t y_offset) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerOffset(x_offset, y_offset); });
+    }
+
+    void onLayerDirection(const std::string &direction) override
+    {
+        m_calls.emplace_back([direction = text(direction)](Parser &p){ p.onLayerDirection(std::string(direction)); });
+    }
+
+    void onLayerWidth(int64_t width) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerWidth(width); });
+    }
+
+    void onLayerMaxWidth(int64_t maxWidth) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerMaxWidth(maxWidth); });
+    }
+
+    void onLayerMinWidth(int64_t minWidth) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerMinWidth(minWidth); });
+    }
+
+    void onLayerResistance(double ohms) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerResistance(ohms); });
+    }
+
+    void onLayerResistancePerSq(double ohms) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerResistancePerSq(ohms); });
+    }
+
+    void onLayerCapacitancePerSq(double farads) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerCapacitancePerSq(farads); });
+    }
+
+    void onLayerEdgeCapacitance(double farads) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerEdgeCapacitance(farads); });
+    }
+
+    void onLayerThickness(double thickness) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerThickness(thickness); });
+    }
+
+    void onLayerMinArea(double minArea) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onLayerMinArea(minArea); });
+    }
+
+    void onPort() override
+    {
+        m_calls.emplace_back([](Parser &p){ p.onPort(); });
+    }
+
+    void onPortLayer(const std::string &name) override
+    {
+        m_calls.emplace_back([name = text(name)](Parser &p){ p.onPortLayer(std::string(name)); });
+    }
+
+    void onEndPort() override
+    {
+        m_calls.emplace_back([](Parser &p){ p.onEndPort(); });
+    }
+
+    void onRect(int64_t x1, int64_t y1, int64_t x2, int64_t y2) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onRect(x1, y1, x2, y2); });
+    }
+
+    void onPolygon(const std::vector<ChipDB::Coord64> &points) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onPolygon(points); });
+    }
+
+    void onSite(const std::string &siteName) override
+    {
+        m_calls.emplace_back([siteName = text(siteName)](Parser &p){ p.onSite(std::string(siteName)); });
+    }
+
+    void onEndSite(const std::string &siteName) override
+    {
+        m_calls.emplace_back([siteName = text(siteName)](Parser &p){ p.onEndSite(std::string(siteName)); });
+    }
+
+    void onSiteClass(const std::string &siteClass) override
+    {
+        m_calls.emplace_back([siteClass = text(siteClass)](Parser &p){ p.onSiteClass(std::string(siteClass)); });
+    }
+
+    void onSiteSymmetry(const ChipDB::SymmetryFlags &symmetry) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onSiteSymmetry(symmetry); });
+    }
+
+    void onSiteSize(int64_t x, int64_t y) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onSiteSize(x, y); });
+    }
+
+    void onDatabaseUnitsMicrons(int64_t unitsPerMicron) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onDatabaseUnitsMicrons(unitsPerMicron); });
+    }
+
+    void onManufacturingGrid(int64_t value) override
+    {
+        m_calls.emplace_back([=](Parser &p){ p.onManufacturingGrid(value); });
+    }
+
+protected:
+    [[nodiscard]] std::string_view text(const std::string &str)
+    {
+        return m_text.store(m_src.substr(0, m_idx), str);
+    }
+
+    std::vector<std::function<void(Parser&)>> m_calls;
+    ChipDB::RecordedText    m_text;     ///< the strings of m_calls
+};
+
+};
+
 bool Reader::load(Design &design, std::istream &source)
+{
+    const std::string src{std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>()};
+    return load(design, std::string_view(src));
+}
+
+bool Reader::load(Design &design, std::string_view source)
 {
     try
     {
-        std::stringstream src;
-        src << source.rdbuf();
-
         ReaderImpl readerimpl(design);
-        if (!readerimpl.parse(src.str()))
+        if (!readerimpl.parse(source))
         {
             Logging::logError("LEF::Reader failed to load file.\n");
             return false;
@@ -31,3 +314,81 @@ bool Reader::load(Design &design, std::istream &source)
 
     return false;
 }
+
+bool Reader::loadFile(Design &design, const std::string &filename)
+{
+    LunaCore::MappedFile file(filename);
+    if (!file.good())
+    {
+        Logging::logError("LEF::Reader cannot open file %s\n", filename.c_str());
+        return false;
+    }
+
+    return load(design, file.view());
+}
+
+bool Reader::loadFiles(Design &design, const std::vector<std::string> &filenames)
+{
+    /** the recording refers to the mapped file, so both
+     *  are kept until the file has been replayed.
+    */
+    struct ParsedFile
+    {
+        std::unique_ptr<LunaCore::MappedFile> m_file;
+        std::unique_ptr<Recorder>   m_recorder;
+        std::string m_error;
+    };
+
+    std::vector<ParsedFile> parsed(filenames.size());
+
+    auto parseFile = [&](std::size_t idx)
+        {
+            auto &result = parsed[idx];
+
+            result.m_file = std::make_unique<LunaCore::MappedFile>(filenames[idx]);
+            if (!result.m_file->good())
+            {
+                result.m_error = "cannot open file";
+                return false;
+            }
+
+            try
+            {
+                result.m_recorder = std::make_unique<Recorder>();
+                return result.m_recorder->parse(result.m_file->view());
+            }
+            catch(std::runtime_error &e)
+            {
+                result.m_error = e.what();
+            }
+            return false;
+        };
+
+    // update the database in file order
+    auto replayFile = [&](std::size_t idx, bool parseOk)
+        {
+            auto &result = parsed[idx];
+            if (!parseOk)
+            {
+                Logging::logError("LEF::Reader failed to load file %s %s\n", filenames[idx].c_str(), result.m_error.c_str());
+                return false;
+            }
+
+            try
+            {
+                ReaderImpl readerimpl(design);
+                result.m_recorder->replay(readerimpl);
+            }
+            catch(std::runtime_error &e)
+            {
+                Logging::logError("LEF::Reader failed to load file %s %s\n", filenames[idx].c_str(), e.what());
+                return false;
+            }
+
+            result.m_recorder.reset();
+            result.m_file.reset();
+            return true;
+        };
+
+    return ChipDB::replayInOrder(filenames.size(), parseFile, replayFile);
+}
@@ -5,6 +5,9 @@
 #pragma once
 
 #include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "database/database.h"
 
 /** Namespace for the LEF importers and exporters */
@@ -15,6 +18,18 @@ class Reader
 {
 public:
     static bool load(Design &design, std::istream &source);
+
+    /** load LEF source text */
+    static bool load(Design &design, std::string_view source);
+
+    /** load a LEF file, the file is memory mapped and not copied */
+    static bool loadFile(Design &design, const std::string &filename);
+
+    /** load a number of LEF files. The files are parsed concurrently
+     *  and added to the design in the order given, so the result is
+     *  the same as loading them one after the other.
+    */
+    static bool loadFiles(Design &design, const std::vector<std::string> &filenames);
 };
 
 };
@@ -65,12 +65,12 @@ char Parser::peek() const
     if (atEnd())
         return 0;
 
-    return m_src->at(m_idx);
+    return m_src[m_idx];
 }
 
 bool Parser::atEnd() const
 {
-    return !(m_idx < m_src->size());
+    return !(m_idx < m_src.size());
 }
 
 
@@ -359,9 +359,9 @@ Parser::token_t Parser::tokenize(std::string &tokstr)
     return TOK_ERR;
 }
 
-bool Parser::parse(const std::string &libertyString)
+bool Parser::parse(std::string_view libertyString)
 {
-    m_src = &libertyString;
+    m_src = libertyString;
     m_idx = 0;
     m_col = 1;
     m_lineNum = 1;
@@ -9,6 +9,7 @@
 #include<iostream>
 #include<vector>
 #include<string>
+#include<string_view>
 #include<iostream>
 
 namespace ChipDB::Liberty {
@@ -23,7 +24,6 @@ class Parser
 public:
     Parser() :
         m_curtok(TOK_ERR),
-        m_src(nullptr),
         m_idx(0),
         m_lineNum(0),
         m_col(0)
@@ -57,7 +57,8 @@ public:
         TOK_ERR
     };
 
-    bool parse(const std::string &libertyString);
+    /** parse a source text, which must stay valid while parsing */
+    bool parse(std::string_view libertyString);
 
     /** Called for groups without a name/parameter */
     virtual void onGroup(const std::string &group) {}
@@ -121,8 +122,8 @@ protected:
     char peek() const;
     bool atEnd() const;
 
-    const std::string *m_src;
-    uint32_t    m_idx;
+    std::string_view m_src;   ///< source text
+    std::size_t m_idx;
     uint32_t    m_lineNum;
     uint32_t    m_col;
 };
@@ -2,21 +2,155 @@
 //
 // SPDX-License-Identifier: GPL-3.0-only
 
+#include <iterator>
 #include "common/logging.h"
+#include "common/mappedfile.h"
+#include "import/recorder.h"
 #include "libreader.h"
 #include "libreaderimpl.h"
 
 using namespace ChipDB::Liberty;
 
+namespace
+{
+
+/** records the parser callbacks so they can be replayed
+ *  on a ReaderImpl later. This allows files to be parsed
+ *  concurrently while the database is updated by one thread.
+*/
+class Recorder : public Parser
+{
+public:
+    /** call the recorded callbacks on a parser */
+    void replay(Parser &target) const
+    {
+        std::string name;
+        std::string value;
+        std::vector<std::string> list;
+
+        for(auto const& event : m_events)
+        {
+            name.assign(event.m_name);
+            value.assign(event.m_value);
+            switch(event.m_type)
+            {
+            case EventType::GROUP:
+                target.onGroup(name);
+                break;
+            case EventType::NAMED_GROUP:
+                target.onGroup(name, value);
+                break;
+            case EventType::SIMPLE_ATTRIBUTE:
+                target.onSimpleAttribute(name, value);
+                break;
+            case EventType::COMPLEX_ATTRIBUTE:
+                list.resize(event.m_listSize);
+                for(std::size_t idx = 0; idx < event.m_listSize; idx++)
+                {
+                    list[idx].assign(m_listItems[event.m_listStart + idx]);
+                }
+                target.onComplexAttribute(name, list);
+                break;
+            case EventType::END_GROUP:
+                target.onEndGroup();
+                break;
+            case EventType::END_PARSE:
+                target.onEndParse();
+                break;
+            }
+        }
+    }
+
+    void onGroup(const std::string &group) override
+    {
+        addEvent(EventType::GROUP, group);
+    }
+
+    void onGroup(const std::string &group, const std::string &name) override
+    {
+        addEvent(EventType::NAMED_GROUP, group, name);
+    }
+
+    void onSimpleAttribute(const std::string &name, const std::string &value) override
+    {
+        addEvent(EventType::SIMPLE_ATTRIBUTE, name, value);
+    }
+
+    void onComplexAttribute(const std::string &attrname, const std::vector<std::string> &list) override
+    {
+        auto &event = addEvent(EventType::COMPLEX_ATTRIBUTE, attrname);
+        event.m_listStart = m_listItems.size();
+        event.m_listSize  = list.size();
+        for(auto const& item : list)
+        {
+            m_listItems.push_back(text(item));
+        }
+    }
+
+    void onEndGroup() override
+    {
+        addEvent(EventType::END_GROUP);
+    }
+
+    void onEndParse() override
+    {
+        addEvent(EventType::END_PARSE);
+    }
+
+protected:
+    enum class EventType
+    {
+        GROUP,
+        NAMED_GROUP,
+        SIMPLE_ATTRIBUTE,
+        COMPLEX_ATTRIBUTE,
+        END_GROUP,
+        END_PARSE
+    };
+
+    /** the strings are views into the source or m_text */
+    struct Event
+    {
+        EventType           m_type{EventType::END_PARSE};
+        std::string_view    m_name;
+        std::string_view    m_value;
+        std::size_t         m_listStart{0};     ///< first item of a complex attribute in m_listItems
+        std::size_t         m_listSize{0};
+    };
+
+    Event& addEvent(EventType type, const std::string &name = {}, const std::string &value = {})
+    {
+        auto &event = m_events.emplace_back();
+        event.m_type  = type;
+        event.m_name  = text(name);
+        event.m_value = text(value);
+        return event;
+    }
+
+    [[nodiscard]] std::string_view text(const std::string &str)
+    {
+        return m_text.store(m_src.substr(0, m_idx), str);
+    }
+
+    std::vector<Event>              m_events;
+    std::vector<std::string_view>   m_listItems;
+    ChipDB::RecordedText            m_text;
+};
+
+};
+
 bool Reader::load(Design &design, std::istream &source)
+{
+    const std::string src{std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>()};
+    return load(design, std::string_view(src));
+}
+
+bool Reader::load(Design &design, std::string_view source)
 {
     try
     {
-        std::stringstream src;
-        src << source.rdbuf();
-
         ReaderImpl readerimpl(design);
-        if (!readerimpl.parse(src.str()))
+        if (!readerimpl.parse(source))
         {
             Logging::logError("Liberty::Reader failed to load file.\n");
             return false;
@@ -31,3 +165,82 @@ bool Reader::load(Design &design, std::istream &source)
 
     return false;
 }
+
+bool Reader::loadFile(Design &design, const std::string &filename)
+{
+    LunaCore::MappedFile file(filename);
+    if (!file.good())
+    {
+        Logging::logError("Liberty::Reader cannot open file %s\n", filename.c_str());
+        return false;
+    }
+
+    return load(design, file.view());
+}
+
+bool Reader::loadFiles(Design &design, const std::vector<std::string> &filenames)
+{
+    /** the recording refers to the mapped file, so both
+     *  are kept until the file has been replayed.
+    */
+    struct ParsedFile
+    {
+        std::unique_ptr<LunaCore::MappedFile> m_file;
+        std::unique_ptr<Recorder>   m_recorder;
+        std::string m_error;
+    };
+
+    std::vector<ParsedFile> parsed(filenames.size());
+
+    auto parseFile = [&](std::size_t idx)
+        {
+            auto &result = parsed[idx];
+
+            result.m_file = std::make_unique<LunaCore::MappedFile>(filenames[idx]);
+            if (!result.m_file->good())
+            {
+                result.m_error = "cannot open file";
+                return false;
+            }
+
+            try
+            {
+                result.m_recorder = std::make_unique<Recorder>();
+                return result.m_recorder->parse(result.m_file->view());
+            }
+            catch(std::runtime_error &e)
+            {
+                result.m_error = e.what();
+            }
+            return false;
+        };
+
+    // update the database in file order
+    auto replayFile = [&](std::size_t idx, bool parseOk)
+        {
+            auto &result = parsed[idx];
+            if (!parseOk)
+            {
+                Logging::logError("Liberty::Reader failed to load file %s %s\n", filenames[idx].c_str(), result.m_error.c_str());
+                return false;
+            }
+
+            try
+            {
+                ReaderImpl readerimpl(design);
+                result.m_recorder->replay(readerimpl);
+            }
+            catch(std::exception &e)
+            {
+                // std::stof throws invalid_argument on malformed values
+                Logging::logError("Liberty::Reader failed to load file %s %s\n", filenames[idx].c_str(), e.what());
+                return false;
+            }
+
+            result.m_recorder.reset();
+            result.m_file.reset();
+            return true;
+        };
+
+    return ChipDB::replayInOrder(filenames.size(), parseFile, replayFile);
+}
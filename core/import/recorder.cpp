@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <cstring>
+#include "recorder.h"
+
+using namespace ChipDB;
+
+std::string_view RecordedText::store(std::string_view consumed, const std::string &text)
+{
+    if (text.empty())
+    {
+        return {};
+    }
+
+    // the strings of the callbacks appear in source order, so the
+    // search starts after the previous string that was found.
+    if (m_cursor < consumed.size())
+    {
+        const auto pos = consumed.find(text, m_cursor);
+        if (pos != std::string_view::npos)
+        {
+            m_cursor = pos + text.size();
+            return consumed.substr(pos, text.size());
+        }
+    }
+
+    return copy(text);
+}
+
+std::string_view RecordedText::copy(const std::string &text)
+{
+    if (text.size() > BlockSize / 4)
+    {
+        // large strings get their own block
+        auto &block = m_largeBlocks.emplace_back(new char[text.size()]);
+        std::memcpy(block.get(), text.data(), text.size());
+        return {block.get(), text.size()};
+    }
+
+    if (m_blockUsed + text.size() > BlockSize)
+    {
+        m_blocks.emplace_back(new char[BlockSize]);
+        m_blockUsed = 0;
+    }
+
+    char *dest = m_blocks.back().get() + m_blockUsed;
+    std::memcpy(dest, text.data(), text.size());
+    m_blockUsed += text.size();
+    return {dest, text.size()};
+}
+
+void RecordedText::clear()
+{
+    m_cursor = 0;
+    m_blocks.clear();
+    m_largeBlocks.clear();
+    m_blockUsed = BlockSize;
+}
@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+/*
+
+    Helpers for readers that parse files concurrently and
+    replay the recorded parser callbacks on the database.
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "common/threadpool.h"
+
+namespace ChipDB
+{
+
+/** Stores the strings of recorded parser callbacks.
+ *
+ *  A string that appears verbatim in the consumed part of the source
+ *  is stored as a view into the source, which must stay valid until
+ *  the recording has been replayed. Other strings, such as quoted
+ *  strings with line continuations, are copied into blocks owned
+ *  by the RecordedText.
+*/
+class RecordedText
+{
+public:
+    /** return a view of the text. consumed is the part of the
+     *  source the parser has read so far.
+    */
+    [[nodiscard]] std::string_view store(std::string_view consumed, const std::string &text);
+
+    /** forget all strings and start at the beginning of the source */
+    void clear();
+
+protected:
+    /** copy the text into a block */
+    [[nodiscard]] std::string_view copy(const std::string &text);
+
+    static constexpr std::size_t BlockSize = 4096;
+
+    std::size_t m_cursor{0};    ///< the source before this position is not searched
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    std::vector<std::unique_ptr<char[]>> m_largeBlocks;
+    std::size_t m_blockUsed{BlockSize};   ///< characters used in the last block
+};
+
+/** call parse(idx) for the files [0, count) concurrently and replay
+ *  in file order. Each file is replayed as soon as it has been parsed
+ *  and the files before it have been replayed, so its recording can be
+ *  freed early. Both functions return false on failure, after which the
+ *  remaining files are neither parsed nor replayed. replay(idx, parsed)
+ *  is also called for a file that failed to parse, so it can report it.
+ *
+ *  returns true if all files were replayed.
+*/
+template<typename ParseFunc, typename ReplayFunc>
+bool replayInOrder(std::size_t count, ParseFunc &&parse, ReplayFunc &&replay)
+{
+    std::mutex mutex;
+    std::vector<uint8_t> parsed(count, 0);
+    std::size_t next = 0;       ///< next file to replay
+    bool replaying = false;     ///< a task is replaying files
+    bool ok = true;
+
+    LunaCore::parallelFor(0, count, [&](std::size_t idx)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!ok) return;
+            }
+
+            const bool parseOk = parse(idx);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            parsed[idx] = parseOk ? 1 : 2;
+            if (replaying) return;
+
+            // replay all files that are ready, in order.
+            replaying = true;
+            while(ok && (next < count) && (parsed[next] != 0))
+            {
+                const auto fileIdx = next;
+                const bool fileOk = (parsed[fileIdx] == 1);
+
+                lock.unlock();
+                const bool replayOk = replay(fileIdx, fileOk);
+                lock.lock();
+
+                ok = replayOk;
+                next++;
+            }
+            replaying = false;
+        }
+    );
+
+    return ok && (next == count);
+}
+
+};
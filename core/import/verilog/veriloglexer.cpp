@@ -2,7 +2,8 @@
 //
 // SPDX-License-Identifier: GPL-3.0-only
 
-#include <algorithm>
+#include <array>
+#include <charconv>
 #include "veriloglexer.h"
 #include "common/logging.h"
 
@@ -12,7 +13,7 @@ bool Lexer::match(char c)
 {
     if (peek() == c)
     {
-        m_idx++;
+        advance();
         return true;
     }
 
@@ -25,7 +26,7 @@ char Lexer::peek() const
     if (atEnd())
         return 0;
 
-    return m_src->at(m_idx);
+    return m_src[m_idx];
 }
 
 
@@ -33,7 +34,15 @@ void Lexer::advance()
 {
     if (!atEnd())
     {
-        m_col++;
+        if (m_src[m_idx] == '\n')
+        {
+            m_col = 1;
+            m_line++;
+        }
+        else
+        {
+            m_col++;
+        }
         m_idx++;
     }
 }
@@ -41,7 +50,7 @@ void Lexer::advance()
 /** returns true if we're at the end of the source */
 bool Lexer::atEnd() const
 {
-    return !(m_idx < m_src->size());
+    return !(m_idx < m_src.size());
 }
 
 bool Lexer::isDigit(char c) const
@@ -75,360 +84,251 @@ bool Lexer::isWhitespace(char c) const
     return (c == '\r') || (c == '\n') || (c == '\t') || (c== ' ');
 }
 
-bool Lexer::execute(const std::string &src, std::vector<token> &tokens)
+Lexer::tokenId Lexer::keyword(std::string_view ident)
 {
-    std::string tmpstr;
-    token token;
+    struct Keyword
+    {
+        std::string_view m_name;
+        tokenId          m_tok;
+    };
 
-    m_col = 1;
-    m_line = 1;
-    m_idx = 0;
-    m_src = &src;
+    static constexpr std::array<Keyword, 6> keywords =
+    {{
+        {"WIRE",      TOK_WIRE},
+        {"MODULE",    TOK_MODULE},
+        {"ENDMODULE", TOK_ENDMODULE},
+        {"ASSIGN",    TOK_ASSIGN},
+        {"INPUT",     TOK_INPUT},
+        {"OUTPUT",    TOK_OUTPUT}
+    }};
 
-    m_state = S_IDLE;
-    while(!atEnd())
+    // keywords are matched case insensitive
+    for(auto const& kw : keywords)
     {
-        if (m_state == S_IDLE)
+        if (kw.m_name.size() != ident.size()) continue;
+
+        bool equal = true;
+        for(std::size_t idx = 0; (idx < ident.size()) && equal; idx++)
         {
-            token.m_value.clear();
-            char c = peek();
+            auto c = ident[idx];
+            if ((c >= 'a') && (c <= 'z')) c -= 'a' - 'A';
+            equal = (c == kw.m_name[idx]);
+        }
 
-            // skip white space
-            if ((c == ' ') || (c == '\t'))
-            {
-                advance();
-                continue;
-            }
+        if (equal) return kw.m_tok;
+    }
 
-            token.m_col = m_col;
-            token.m_line = m_line;
+    return TOK_IDENT;
+}
 
-            // read numbers
-            if (isDigit(c))
-            {
-                token.m_tok = TOK_INTEGER;
-                token.m_value += c;
-                advance();
-                m_state = S_INTEGER;
-                continue;
-            }
+void Lexer::begin(std::string_view src)
+{
+    m_src   = src;
+    m_idx   = 0;
+    m_col   = 1;
+    m_line  = 1;
+    m_error = false;
+}
 
-            // read identifiers
-            if (isAlpha(c))
-            {
-                token.m_tok = TOK_IDENT;
-                token.m_value += c;
-                advance();
-                m_state = S_IDENT;
-                continue;
-            }
+bool Lexer::readInteger(tokenView &tok)
+{
+    tok.m_tok = TOK_INTEGER;
 
-            switch(c)
-            {
-            case 10:
-                advance();
-                match(13);  // skip additional CR
-                m_col = 1;
-                m_line++;
-                break;
-            case 13:
-                advance();
-                match(10);  // skip additional LF
-                m_col = 1;
-                m_line++;
-                break;
-            case '(':
-                advance();
-                if (match('*'))
-                {
-                    // start of attribute
-                    token.m_tok = TOK_ATTRIBUTE;
-                    m_state = S_ATTRIBUTE;
-                }
-                else
-                {
-                    token.m_tok = TOK_LPAREN;
-                    tokens.push_back(token);
-                }
-                break;
-            case ')':
-                token.m_tok = TOK_RPAREN;
-                tokens.push_back(token);
-                advance();
-                break;
-            case '[':
-                token.m_tok = TOK_LBRACKET;
-                tokens.push_back(token);
-                advance();
-                break;
-            case ']':
-                token.m_tok = TOK_RBRACKET;
-                tokens.push_back(token);
-                advance();
-                break;
-            case '{':
-                token.m_tok = TOK_LCURLY;
-                tokens.push_back(token);
-                advance();
-                break;
-            case '}':
-                token.m_tok = TOK_RCURLY;
-                tokens.push_back(token);
-                advance();
-                break;
-            case '=':
-                token.m_tok = TOK_EQUAL;
-                tokens.push_back(token);
-                advance();
-                break;
-            case ',':
-                token.m_tok = TOK_COMMA;
-                tokens.push_back(token);
-                advance();
-                break;
-            case '.':
-                token.m_tok = TOK_PERIOD;
-                tokens.push_back(token);
-                advance();
-                break;
-            case ';':
-                token.m_tok = TOK_SEMICOL;
-                tokens.push_back(token);
-                advance();
-                break;
-            case ':':
-                token.m_tok = TOK_COLON;
-                tokens.push_back(token);
-                advance();
-                break;
-            case '\\':  // start of escaped identifier
-                token.m_tok = TOK_IDENT;
-                token.m_value.clear();
-                advance();
-                m_state = S_ESCAPEDIDENT;
-                break;
-            case '/':
-                advance();
-                if (match('*'))
-                {
-                    m_state = S_COMMENT;
-                }
-                else if (match('/'))
-                {
-                    m_state = S_LINECOMMENT;
-                }
-                else
-                {
-                    token.m_tok = TOK_SLASH;
-                    tokens.push_back(token);
-                }
-                break;
-            default:
-                Logging::logError("Skipping %c (%d) on line %d\n", c,
-                    static_cast<uint32_t>(c), m_line);
-                advance();
-                break;
-            }
-        }
-        else if (m_state == S_ATTRIBUTE)
-        {
-            if (match('*'))
-            {
-                if (match(')'))
-                {
-                    tokens.push_back(token);
-                    m_state = S_IDLE;
-                }
-            }
-            else
-            {
-                token.m_value += peek();
-                advance();
-            }
-        }
-        else if (m_state == S_IDENT)
-        {
-            char c = peek();
-            while (isDigit(c) || isAlpha(c))
-            {
-                token.m_value += c;
-                advance();
-                c = peek();
-            }
+    auto start = m_idx;
+    while (isDigit(peek()))
+    {
+        advance();
+    }
 
-            // check for keywords
-            tmpstr = token.m_value;
-            std::transform(tmpstr.begin(), tmpstr.end(), tmpstr.begin(), ::toupper);
+    tok.m_value = m_src.substr(start, m_idx - start);
 
-            if (tmpstr == "WIRE")
-            {
-                token.m_tok = TOK_WIRE;
-            }
-            else if (tmpstr == "MODULE")
-            {
-                token.m_tok = TOK_MODULE;
-            }
-            else if (tmpstr == "ENDMODULE")
-            {
-                token.m_tok = TOK_ENDMODULE;
-            }
-            else if (tmpstr == "ASSIGN")
-            {
-                token.m_tok = TOK_ASSIGN;
-            }
-            else if (tmpstr == "INPUT")
-            {
-                token.m_tok = TOK_INPUT;
-            }
-            else if (tmpstr == "OUTPUT")
-            {
-                token.m_tok = TOK_OUTPUT;
-            }
+    // check if this is a hex,dec or bin constant
+    if (!match('\''))
+    {
+        // regular integer
+        return true;
+    }
+
+    std::from_chars(tok.m_value.data(), tok.m_value.data() + tok.m_value.size(), m_bitwidth);
+
+    const char base = peek();
+    if ((base != 'h') && (base != 'd') && (base != 'b'))
+    {
+        Logging::logError("Expected 'd' or 'h' or 'b' after bit width specification.\n");
+        m_error = true;
+        return false;
+    }
+
+    advance();
+    start = m_idx;
+
+    char c = peek();
+    while (((base == 'h') && (isHex(c) || (c == 'X'))) ||
+        ((base == 'd') && isDigit(c)) ||
+        ((base == 'b') && isBin(c)))
+    {
+        advance();
+        c = peek();
+    }
+
+    tok.m_value = m_src.substr(start, m_idx - start);
+    return true;
+}
+
+bool Lexer::next(tokenView &tok)
+{
+    while(!atEnd() && !m_error)
+    {
+        const char c = peek();
 
-            tokens.push_back(token);
-            m_state = S_IDLE;
+        // skip white space
+        if (isWhitespace(c))
+        {
+            advance();
+            continue;
         }
-        else if (m_state == S_ESCAPEDIDENT)
+
+        tok.m_col  = m_col;
+        tok.m_line = m_line;
+        tok.m_value = {};
+
+        // read numbers
+        if (isDigit(c))
         {
-            char c = peek();
-            while (!isWhitespace(c))
-            {
-                token.m_value += c;
-                advance();
-                c = peek();
-            }
-            tokens.push_back(token);
-            m_state = S_IDLE;
+            return readInteger(tok);
         }
-        else if (m_state == S_INTEGER)
+
+        // read identifiers
+        if (isAlpha(c))
         {
-            char c = peek();
-            while (isDigit(c))
+            const auto start = m_idx;
+            while (isDigit(peek()) || isAlpha(peek()))
             {
-                token.m_value += c;
                 advance();
-                c = peek();
             }
 
-            // check if this is a hex,dec or bin constant
-            if (c == '\'')
-            {
-                advance();
-                c = peek();
-                if (c == 'h')
-                {
-                    m_bitwidth = std::stod(token.m_value);
-                    token.m_value.clear();
-                    advance();
-                    m_state = S_HEXINTEGER;
-                    continue;
-                }
-                else if (c == 'd')
-                {
-                    m_bitwidth = std::stod(token.m_value);
-                    token.m_value.clear();
-                    advance();
-                    m_state = S_DECINTEGER;
-                    continue;
-                }
-                else if (c == 'b')
-                {
-                    m_bitwidth = std::stod(token.m_value);
-                    token.m_value.clear();
-                    advance();
-                    m_state = S_BININTEGER;
-                    continue;
-                }
-                else
-                {
-                    Logging::logError("Expected 'd' or 'h' or 'b' after bit width specification.\n");
-                    return false;
-                }
-            }
-            else
-            {
-                // regular integer, so emit!
-                tokens.push_back(token);
-                m_state = S_IDLE;
-            }
+            tok.m_value = m_src.substr(start, m_idx - start);
+            tok.m_tok   = keyword(tok.m_value);
+            return true;
         }
-        else if (m_state == S_HEXINTEGER)
+
+        advance();
+        switch(c)
         {
-            char c = peek();
-            while (isHex(c) || c=='X')
+        case '(':
+            if (match('*'))
             {
-                // replace all don't care's with zeros.
-                if (c == 'X') c = '0';
+                // attribute, ends with *)
+                const auto start = m_idx;
+                auto end = m_src.find("*)", start);
+                if (end == std::string_view::npos)
+                {
+                    end = m_src.size();
+                }
 
-                token.m_value += c;
+                while(m_idx < end) advance();
+                advance();
                 advance();
-                c = peek();
+
+                tok.m_tok   = TOK_ATTRIBUTE;
+                tok.m_value = m_src.substr(start, end - start);
             }
-            tokens.push_back(token);
-            m_state = S_IDLE;
-        }
-        else if (m_state == S_DECINTEGER)
-        {
-            char c = peek();
-            while (isDigit(c))
+            else
             {
-                token.m_value += c;
-                advance();
-                c = peek();
+                tok.m_tok = TOK_LPAREN;
             }
-            tokens.push_back(token);
-            m_state = S_IDLE;
-        }
-        else if (m_state == S_BININTEGER)
+            return true;
+        case ')':
+            tok.m_tok = TOK_RPAREN;
+            return true;
+        case '[':
+            tok.m_tok = TOK_LBRACKET;
+            return true;
+        case ']':
+            tok.m_tok = TOK_RBRACKET;
+            return true;
+        case '{':
+            tok.m_tok = TOK_LCURLY;
+            return true;
+        case '}':
+            tok.m_tok = TOK_RCURLY;
+            return true;
+        case '=':
+            tok.m_tok = TOK_EQUAL;
+            return true;
+        case ',':
+            tok.m_tok = TOK_COMMA;
+            return true;
+        case '.':
+            tok.m_tok = TOK_PERIOD;
+            return true;
+        case ';':
+            tok.m_tok = TOK_SEMICOL;
+            return true;
+        case ':':
+            tok.m_tok = TOK_COLON;
+            return true;
+        case '\\':  // escaped identifier, ends with white space
         {
-            char c = peek();
-            while (isBin(c))
+            const auto start = m_idx;
+            while (!atEnd() && !isWhitespace(peek()))
             {
-                token.m_value += c;
                 advance();
-                c = peek();
             }
-            tokens.push_back(token);
-            m_state = S_IDLE;
+
+            tok.m_tok   = TOK_IDENT;
+            tok.m_value = m_src.substr(start, m_idx - start);
+            return true;
         }
-        else if (m_state == S_COMMENT)
-        {
+        case '/':
             if (match('*'))
             {
-                if (match('/'))
+                // block comment
+                while(!atEnd())
                 {
-                    m_state = S_IDLE;
+                    if (match('*') && match('/')) break;
+                    if (peek() != '*') advance();
                 }
+                continue;
             }
-            else
-            {
-                // still in comment, next char..
-                advance();
-            }
-        }
-        else if (m_state == S_LINECOMMENT)
-        {
-            // wait for EOL.
-            char c = peek();
-            if ((c != 10) && (c != 13) && (!atEnd()))
-            {
-                advance();
-            }
-            else
+            else if (match('/'))
             {
-                m_line++;
-                m_col = 1;
-                m_state = S_IDLE;
+                // line comment
+                while(!atEnd() && (peek() != '\n') && (peek() != '\r'))
+                {
+                    advance();
+                }
+                continue;
             }
-        }
-        else
-        {
-            Logging::logError("Error: incorrect state\n");
-            return false;
+
+            tok.m_tok = TOK_SLASH;
+            return true;
+        default:
+            Logging::logError("Skipping %c (%d) on line %d\n", c,
+                static_cast<uint32_t>(c), m_line);
+            break;
         }
     }
 
+    return false;
+}
+
+bool Lexer::execute(const std::string &src, std::vector<token> &tokens)
+{
+    begin(src);
+
+    tokenView tok;
+    while(next(tok))
+    {
+        tokens.push_back({tok.m_tok, std::string(tok.m_value), tok.m_line, tok.m_col});
+    }
+
+    if (m_error)
+    {
+        return false;
+    }
+
     Logging::logVerbose("Lexer processed %d lines\n", m_line);
 
     return true;
-}
\ No newline at end of file
+}
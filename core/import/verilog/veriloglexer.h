@@ -6,6 +6,7 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <stdint.h>
 
 namespace ChipDB::Verilog
@@ -50,11 +51,42 @@ public:
         uint32_t    m_col;
     };
 
+    /** token that refers to the source text */
+    struct tokenView
+    {
+        tokenId             m_tok;
+        std::string_view    m_value;
+        uint32_t            m_line;
+        uint32_t            m_col;
+    };
+
     /** tokenize the input source
      *  returns true if no errors.
     */
     bool execute(const std::string &src, std::vector<token> &tokens);
 
+    /** start tokenizing a source. The source must stay valid
+     *  for as long as the tokens returned by next() are used.
+    */
+    void begin(std::string_view src);
+
+    /** read the next token.
+     *  returns false at the end of the source or on an error.
+    */
+    bool next(tokenView &tok);
+
+    /** returns true if next() stopped because of an error */
+    [[nodiscard]] bool hasError() const noexcept
+    {
+        return m_error;
+    }
+
+    /** returns the current line number */
+    [[nodiscard]] uint32_t line() const noexcept
+    {
+        return m_line;
+    }
+
 protected:
     /** if character == c -> advance and return true,
      *  else return false
@@ -76,28 +108,18 @@ protected:
     bool isBin(char c) const;
     bool isWhitespace(char c) const;
 
-    uint32_t m_idx;     ///< index of current character
-    uint32_t m_line;    ///< current line number
-    uint32_t m_col;     ///< current column number
-
-    enum state_t
-    {
-        S_IDLE,
-        S_COMMENT,
-        S_LINECOMMENT,
-        S_ATTRIBUTE,
-        S_INTEGER,
-        S_IDENT,
-        S_ESCAPEDIDENT,
-        S_HEXINTEGER,
-        S_DECINTEGER,
-        S_BININTEGER
-    };
+    /** read an integer or a sized constant such as 4'hF */
+    bool readInteger(tokenView &tok);
 
-    state_t m_state;
+    /** returns the keyword token of an identifier or TOK_IDENT */
+    static tokenId keyword(std::string_view ident);
 
-    uint32_t           m_bitwidth;  ///< number of bit in constants
-    const std::string *m_src;       ///< source text
+    std::string_view    m_src;          ///< source text
+    std::size_t         m_idx{0};       ///< index of current character
+    uint32_t            m_line{1};      ///< current line number
+    uint32_t            m_col{1};       ///< current column number
+    uint32_t            m_bitwidth{0};  ///< number of bit in constants
+    bool                m_error{false};
 };
 
 /// \endcond
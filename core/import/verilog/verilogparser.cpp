@@ -2,6 +2,7 @@
 //
 // SPDX-License-Identifier: GPL-3.0-only
 
+#include <charconv>
 #include <sstream>
 #include <iostream>
 #include "verilogparser.h"
@@ -9,20 +10,51 @@
 
 using namespace ChipDB::Verilog;
 
-Lexer::token Parser::previous() const
+namespace
 {
-    return m_tokens->at(m_idx-1);
+    uint32_t toInteger(std::string_view value)
+    {
+        // FIXME: better type checking
+        uint32_t result = 0;
+        std::from_chars(value.data(), value.data() + value.size(), result);
+        return result;
+    }
+};
+
+const Lexer::tokenView& Parser::previous() const
+{
+    return m_previous;
 }
 
-Lexer::token Parser::peek() const
+const Lexer::tokenView& Parser::peek() const
 {
-    return m_tokens->at(m_idx);
+    return m_current;
+}
+
+void Parser::fetch()
+{
+    if (m_tokens != nullptr)
+    {
+        m_atEnd = (m_idx >= m_tokens->size());
+        if (!m_atEnd)
+        {
+            auto const& tok = m_tokens->at(m_idx++);
+            m_current = {tok.m_tok, tok.m_value, tok.m_line, tok.m_col};
+        }
+    }
+    else
+    {
+        m_atEnd = !m_lexer.next(m_current);
+    }
 }
 
 void Parser::advance()
 {
     if (!atEnd())
-        m_idx++;
+    {
+        m_previous = m_current;
+        fetch();
+    }
 }
 
 bool Parser::match(Lexer::tokenId tok)
@@ -40,13 +72,20 @@ bool Parser::match(Lexer::tokenId tok)
 
 bool Parser::atEnd() const
 {
-    return m_idx >= m_tokens->size();
+    return m_atEnd;
 }
 
 void Parser::error(const std::string &error)
 {
     std::stringstream ss;
-    ss << "Line: " << peek().m_line << " col: " << peek().m_col << " " << error;
+    if (atEnd())
+    {
+        ss << "End of file: " << error;
+    }
+    else
+    {
+        ss << "Line: " << peek().m_line << " col: " << peek().m_col << " " << error;
+    }
     Logging::logError(ss.str());
 }
 
@@ -54,7 +93,28 @@ bool Parser::execute(const std::vector<Lexer::token> &tokens)
 {
     m_tokens = &tokens;
     m_idx = 0;
+    fetch();
+
+    return source();
+}
 
+bool Parser::execute(std::string_view src)
+{
+    m_tokens = nullptr;
+    m_lexer.begin(src);
+    fetch();
+
+    if (!source() || m_lexer.hasError())
+    {
+        return false;
+    }
+
+    Logging::logVerbose("Lexer processed %d lines\n", m_lexer.line());
+    return true;
+}
+
+bool Parser::source()
+{
     while(!atEnd())
     {
         if (match(Lexer::TOK_MODULE))
@@ -67,7 +127,7 @@ bool Parser::execute(const std::vector<Lexer::token> &tokens)
         }
         else if (match(Lexer::TOK_ATTRIBUTE))
         {
-            onAttribute(previous().m_value);
+            onAttribute(std::string(previous().m_value));
         }
         else
         {
@@ -80,6 +140,77 @@ bool Parser::execute(const std::vector<Lexer::token> &tokens)
     return true;
 }
 
+bool Parser::pRange(bool &hasRange, uint32_t &start, uint32_t &stop)
+{
+    // ('[' INTEGER ':' INTEGER ']')
+
+    hasRange = false;
+    start = 0; // range start default
+    stop  = 0; // range stop default
+    if (!match(Lexer::TOK_LBRACKET))
+    {
+        return true;
+    }
+
+    if (!match(Lexer::TOK_INTEGER))
+    {
+        error("Expected integer in range.\n");
+        return false;
+    }
+
+    start = toInteger(previous().m_value);
+
+    if (!match(Lexer::TOK_COLON))
+    {
+        error("Expected ':' in range.\n");
+        return false;
+    }
+
+    if (!match(Lexer::TOK_INTEGER))
+    {
+        error("Expected integer in range.\n");
+        return false;
+    }
+
+    stop = toInteger(previous().m_value);
+
+    if (!match(Lexer::TOK_RBRACKET))
+    {
+        error("Expected ']' in range.\n");
+        return false;
+    }
+
+    hasRange = true;
+    return true;
+}
+
+bool Parser::pSlice(std::string &netname)
+{
+    // optional slice [x]
+    if (!match(Lexer::TOK_LBRACKET))
+    {
+        return true;
+    }
+
+    if (!match(Lexer::TOK_INTEGER))
+    {
+        error("Expected integer in slice.\n");
+        return false;
+    }
+
+    netname += '[';
+    netname += previous().m_value;
+    netname += ']';
+
+    if (!match(Lexer::TOK_RBRACKET))
+    {
+        error("Expected ']' in slice.\n");
+        return false;
+    }
+
+    return true;
+}
+
 bool Parser::module()
 {
     // module_ident '(' ')' ';'
@@ -90,7 +221,7 @@ bool Parser::module()
         return false;
     }
 
-    std::string modName = previous().m_value;
+    std::string modName(previous().m_value);
     std::vector<std::string> ports;
 
     if (!match(Lexer::TOK_LPAREN))
@@ -102,7 +233,7 @@ bool Parser::module()
     if (match(Lexer::TOK_IDENT))
     {
         // first port
-        ports.push_back(previous().m_value);
+        ports.emplace_back(previous().m_value);
 
         while(match(Lexer::TOK_COMMA))
         {
@@ -112,7 +243,7 @@ bool Parser::module()
                 return false;
             }
             // additional port
-            ports.push_back(previous().m_value);
+            ports.emplace_back(previous().m_value);
         }
     }
 
@@ -158,7 +289,7 @@ bool Parser::moduleItems()
         }
         else if (match(Lexer::TOK_ATTRIBUTE))
         {
-            onAttribute(previous().m_value);
+            onAttribute(std::string(previous().m_value));
         }
         else if (match(Lexer::TOK_IDENT))
         {
@@ -168,7 +299,7 @@ bool Parser::moduleItems()
         else
         {
             std::stringstream ss;
-            ss << "Unexpected token: " << peek().m_value << ".\n";
+            ss << "Unexpected token: " << (atEnd() ? std::string_view("") : peek().m_value) << ".\n";
             error(ss.str());
             return false;
         }
@@ -182,41 +313,11 @@ bool Parser::pInput()
     // ('[' INTEGER ':' INTEGER ']') ident ';'
 
     bool hasRange = false;
-    uint32_t start = 0; // range start default
-    uint32_t stop  = 0; // range stop default
-    if (match(Lexer::TOK_LBRACKET))
+    uint32_t start = 0;
+    uint32_t stop  = 0;
+    if (!pRange(hasRange, start, stop))
     {
-        if (!match(Lexer::TOK_INTEGER))
-        {
-            error("Expected integer in range.\n");
-            return false;
-        }
-
-        // FIXME: better type checking
-        start = atoi(previous().m_value.c_str());
-
-        if (!match(Lexer::TOK_COLON))
-        {
-            error("Expected ':' in range.\n");
-            return false;
-        }
-
-        if (!match(Lexer::TOK_INTEGER))
-        {
-            error("Expected integer in range.\n");
-            return false;
-        }
-
-        // FIXME: better type checking
-        stop = atoi(previous().m_value.c_str());
-
-        if (!match(Lexer::TOK_RBRACKET))
-        {
-            error("Expected ']' in range.\n");
-            return false;
-        }
-
-        hasRange = true;
+        return false;
     }
 
     if (!match(Lexer::TOK_IDENT))
@@ -225,10 +326,11 @@ bool Parser::pInput()
         return false;
     }
 
+    m_netName.assign(previous().m_value);
     if (hasRange)
-        onInput(previous().m_value, start, stop);
+        onInput(m_netName, start, stop);
     else
-        onInput(previous().m_value);
+        onInput(m_netName);
 
     if (!match(Lexer::TOK_SEMICOL))
     {
@@ -244,41 +346,11 @@ bool Parser::pOutput()
     // ('[' INTEGER ':' INTEGER ']') ident ';'
 
     bool hasRange = false;
-    uint32_t start = 0; // range start default
-    uint32_t stop  = 0; // range stop default
-    if (match(Lexer::TOK_LBRACKET))
+    uint32_t start = 0;
+    uint32_t stop  = 0;
+    if (!pRange(hasRange, start, stop))
     {
-        if (!match(Lexer::TOK_INTEGER))
-        {
-            error("Expected integer in range.\n");
-            return false;
-        }
-
-        // FIXME: better type checking
-        start = atoi(previous().m_value.c_str());
-
-        if (!match(Lexer::TOK_COLON))
-        {
-            error("Expected ':' in range.\n");
-            return false;
-        }
-
-        if (!match(Lexer::TOK_INTEGER))
-        {
-            error("Expected integer in range.\n");
-            return false;
-        }
-
-        // FIXME: better type checking
-        stop = atoi(previous().m_value.c_str());
-
-        if (!match(Lexer::TOK_RBRACKET))
-        {
-            error("Expected ']' in range.\n");
-            return false;
-        }
-
-        hasRange = true;
+        return false;
     }
 
     if (!match(Lexer::TOK_IDENT))
@@ -287,10 +359,11 @@ bool Parser::pOutput()
         return false;
     }
 
+    m_netName.assign(previous().m_value);
     if (hasRange)
-        onOutput(previous().m_value, start, stop);
+        onOutput(m_netName, start, stop);
     else
-        onOutput(previous().m_value);
+        onOutput(m_netName);
 
     if (!match(Lexer::TOK_SEMICOL))
     {
@@ -308,41 +381,12 @@ bool Parser::pWire()
 
     do
     {
-        uint32_t start = 0; // range start default
-        uint32_t stop  = 0; // range stop default
         bool hasRange = false;
-        if (match(Lexer::TOK_LBRACKET))
+        uint32_t start = 0;
+        uint32_t stop  = 0;
+        if (!pRange(hasRange, start, stop))
         {
-            hasRange = true;
-            if (!match(Lexer::TOK_INTEGER))
-            {
-                error("Expected integer in range.\n");
-                return false;
-            }
-
-            // FIXME: better type checking
-            start = atoi(previous().m_value.c_str());
-
-            if (!match(Lexer::TOK_COLON))
-            {
-                error("Expected ':' in range.\n");
-                return false;
-            }
-
-            if (!match(Lexer::TOK_INTEGER))
-            {
-                error("Expected integer in range.\n");
-                return false;
-            }
-
-            // FIXME: better type checking
-            stop = atoi(previous().m_value.c_str());
-
-            if (!match(Lexer::TOK_RBRACKET))
-            {
-                error("Expected ']' in range.\n");
-                return false;
-            }
+            return false;
         }
 
         if (!match(Lexer::TOK_IDENT))
@@ -351,13 +395,14 @@ bool Parser::pWire()
             return false;
         }
 
+        m_netName.assign(previous().m_value);
         if (hasRange)
         {
-            onWire(previous().m_value, start, stop);
+            onWire(m_netName, start, stop);
         }
         else
         {
-            onWire(previous().m_value);
+            onWire(m_netName);
         }
 
     } while(match(Lexer::TOK_COMMA));
@@ -382,7 +427,7 @@ bool Parser::pAssign()
         return false;
     }
 
-    std::string left = previous().m_value;
+    std::string left(previous().m_value);
 
     if (!match(Lexer::TOK_EQUAL))
     {
@@ -396,7 +441,7 @@ bool Parser::pAssign()
         return false;
     }
 
-    std::string right = previous().m_value;
+    std::string right(previous().m_value);
 
     if (!match(Lexer::TOK_SEMICOL))
     {
@@ -411,7 +456,7 @@ bool Parser::pAssign()
 
 bool Parser::pInstance()
 {
-    std::string itype = previous().m_value;
+    m_typeName.assign(previous().m_value);
 
     // iname '(' port_connection_list ')' ';'
     if (!match(Lexer::TOK_IDENT))
@@ -420,7 +465,7 @@ bool Parser::pInstance()
         return false;
     }
 
-    std::string iname = previous().m_value;
+    m_insName.assign(previous().m_value);
 
     if (!match(Lexer::TOK_LPAREN))
     {
@@ -429,9 +474,9 @@ bool Parser::pInstance()
     }
 
     // emit onInstance before the port list
-    onInstance(itype, iname);
+    onInstance(m_typeName, m_insName);
 
-    if (peek().m_tok == Lexer::TOK_PERIOD)
+    if (!atEnd() && (peek().m_tok == Lexer::TOK_PERIOD))
     {
         if (!pInstanceNamedPortList())
             return false;
@@ -463,26 +508,13 @@ bool Parser::pInstanceOrderedPortList()
     // accept zero or more net names
     if (match(Lexer::TOK_IDENT))
     {
-        std::string netname = previous().m_value;
+        m_netName.assign(previous().m_value);
 
-        // optional slice [x] or [x:y]
-        if (match(Lexer::TOK_LBRACKET))
+        if (!pSlice(m_netName))
         {
-            if (!match(Lexer::TOK_INTEGER))
-            {
-                error("Expected integer in slice.\n");
-                return false;
-            }
-            netname += '[';
-            netname += previous().m_value;
-            netname += ']';
-            if (!match(Lexer::TOK_RBRACKET))
-            {
-                error("Expected ']' in slice.\n");
-                return false;
-            }
+            return false;
         }
-        onInstancePort(portIndex++, netname);
+        onInstancePort(portIndex++, m_netName);
 
         while(match(Lexer::TOK_COMMA))
         {
@@ -491,26 +523,13 @@ bool Parser::pInstanceOrderedPortList()
                 error("Expected net name.\n");
                 return false;
             }
-            netname = previous().m_value;
+            m_netName.assign(previous().m_value);
 
-            // optional slice [x] or [x:y]
-            if (match(Lexer::TOK_LBRACKET))
+            if (!pSlice(m_netName))
             {
-                if (!match(Lexer::TOK_INTEGER))
-                {
-                    error("Expected integer in slice.\n");
-                    return false;
-                }
-                netname += '[';
-                netname += previous().m_value;
-                netname += ']';
-                if (!match(Lexer::TOK_RBRACKET))
-                {
-                    error("Expected ']' in slice.\n");
-                    return false;
-                }
+                return false;
             }
-            onInstancePort(portIndex++, netname);
+            onInstancePort(portIndex++, m_netName);
         }
     }
     return true;
@@ -520,7 +539,7 @@ bool Parser::pInstanceNamedPortList()
 {
     // accept zero or more net names
 
-    if (peek().m_tok == Lexer::TOK_RPAREN)
+    if (!atEnd() && (peek().m_tok == Lexer::TOK_RPAREN))
     {
         return true;
     }
@@ -539,7 +558,7 @@ bool Parser::pInstanceNamedPortList()
             return false;
         }
 
-        std::string portname = previous().m_value;
+        m_portName.assign(previous().m_value);
 
         if (!match(Lexer::TOK_LPAREN))
         {
@@ -553,24 +572,11 @@ bool Parser::pInstanceNamedPortList()
             return false;
         }
 
-        std::string netname = previous().m_value;
+        m_netName.assign(previous().m_value);
 
-        // optional slice [x] or [x:y]
-        if (match(Lexer::TOK_LBRACKET))
+        if (!pSlice(m_netName))
         {
-            if (!match(Lexer::TOK_INTEGER))
-            {
-                error("Expected integer in slice.\n");
-                return false;
-            }
-            netname += '[';
-            netname += previous().m_value;
-            netname += ']';
-            if (!match(Lexer::TOK_RBRACKET))
-            {
-                error("Expected ']' in slice.\n");
-                return false;
-            }
+            return false;
         }
 
         if (!match(Lexer::TOK_RPAREN))
@@ -579,7 +585,7 @@ bool Parser::pInstanceNamedPortList()
             return false;
         }
 
-        onInstanceNamedPort(portname, netname);
+        onInstanceNamedPort(m_portName, m_netName);
     } while(match(Lexer::TOK_COMMA));
 
     return true;
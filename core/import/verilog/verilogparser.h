@@ -5,6 +5,8 @@
 #pragma once
 
 #include <stdint.h>
+#include <string>
+#include <string_view>
 #include <vector>
 #include "veriloglexer.h"
 
@@ -20,6 +22,11 @@ public:
 
     bool execute(const std::vector<Lexer::token> &tokens);
 
+    /** tokenize and parse a source text while reading it,
+     *  without storing the tokens.
+    */
+    bool execute(std::string_view src);
+
     /** callback for each module encountered in the netlist */
     virtual void onModule(const std::string &modName,
         const std::vector<std::string> &ports) {};
@@ -59,6 +66,7 @@ public:
 
 protected:
     // grammar rules
+    bool source();
     bool module();
     bool moduleItems();
     bool pInput();
@@ -69,16 +77,36 @@ protected:
     bool pInstanceOrderedPortList();
     bool pInstanceNamedPortList();
 
-    Lexer::token previous() const;
-    Lexer::token peek() const;
+    /** parse an optional [x] slice and append it to the net name */
+    bool pSlice(std::string &netname);
+
+    /** parse an optional [start:stop] range */
+    bool pRange(bool &hasRange, uint32_t &start, uint32_t &stop);
+
+    const Lexer::tokenView& previous() const;
+    const Lexer::tokenView& peek() const;
     void advance();
     bool match(Lexer::tokenId tok);
     bool atEnd() const;
 
+    /** read the next token into m_current */
+    void fetch();
+
     void error(const std::string &error);
 
-    uint32_t m_idx;
-    const std::vector<Lexer::token> *m_tokens;
+    std::size_t m_idx;
+    const std::vector<Lexer::token> *m_tokens;  ///< tokens when not tokenizing a source
+    Lexer       m_lexer;
+
+    Lexer::tokenView m_previous{};
+    Lexer::tokenView m_current{};
+    bool             m_atEnd{true};
+
+    // names passed to the callbacks, kept to reuse their storage
+    std::string m_typeName;
+    std::string m_insName;
+    std::string m_portName;
+    std::string m_netName;
 };
 
 /// \endcond
@@ -6,7 +6,9 @@
 #include <sstream>
 #include <algorithm>
 #include <cassert>
+#include <iterator>
 #include "common/logging.h"
+#include "common/mappedfile.h"
 #include "database/database.h"
 #include "verilogreader.h"
 
@@ -15,28 +17,21 @@ using namespace ChipDB::Verilog;
 constexpr static bool extraDebug = false;
 
 bool Reader::load(Design &design, std::istream &source)
+{
+    const std::string src{std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>()};
+    return load(design, std::string_view(src));
+}
+
+bool Reader::load(Design &design, std::string_view source)
 {
     try
     {
-        std::stringstream src;
-        src << source.rdbuf();
-
-        Lexer lex;
-        std::vector<Lexer::token> tokens;
-        if (lex.execute(src.str(), tokens))
+        ReaderImpl parser(design);
+        if (parser.execute(source))
         {
-            ReaderImpl parser(design);
-            if (parser.execute(tokens))
-            {
-                Logging::logInfo("Verilog netlist parsed.\n");
-                Logging::logInfo("  modules %d\n", design.m_moduleLib->size());
-                return true;
-            }
-        }
-        else
-        {
-            Logging::logError("Verilog::Reader failed to load netlist.\n");
-            return false;
+            Logging::logInfo("Verilog netlist parsed.\n");
+            Logging::logInfo("  modules %d\n", design.m_moduleLib->size());
+            return true;
         }
     }
     catch(std::runtime_error &e)
@@ -56,6 +51,18 @@ bool Reader::load(Design &design, std::istream &source)
     return false;
 }
 
+bool Reader::loadFile(Design &design, const std::string &filename)
+{
+    LunaCore::MappedFile file(filename);
+    if (!file.good())
+    {
+        Logging::logError("Verilog::Reader cannot open file %s\n", filename.c_str());
+        return false;
+    }
+
+    return load(design, file.view());
+}
+
 
 // **********************************************************************
 //   ReaderImpl
@@ -108,8 +115,7 @@ void ReaderImpl::onInstance(const std::string &modName, const std::string &insNa
     auto const cellKeyObjPtr = m_design.m_cellLib->lookupCell(modName);
     if (cellKeyObjPtr.isValid())
     {
-        auto insPtr = std::make_shared<Instance>(insName, ChipDB::InstanceType::CELL, cellKeyObjPtr.ptr());
-        auto insKeyObjPair = m_currentModule->addInstance(insPtr);
+        auto insKeyObjPair = m_currentModule->createInstance(insName, ChipDB::InstanceType::CELL, cellKeyObjPtr.ptr());
 
         if (!insKeyObjPair.isValid())
         {
@@ -126,8 +132,7 @@ void ReaderImpl::onInstance(const std::string &modName, const std::string &insNa
     auto moduleKeyObjPair = m_design.m_moduleLib->lookupModule(modName);
     if (moduleKeyObjPair.isValid())
     {
-        auto insPtr = std::make_shared<Instance>(modName, ChipDB::InstanceType::MODULE, moduleKeyObjPair.ptr());
-        auto insKeyObjPair = m_currentModule->addInstance(insPtr);
+        auto insKeyObjPair = m_currentModule->createInstance(modName, ChipDB::InstanceType::MODULE, moduleKeyObjPair.ptr());
         if (!insKeyObjPair.isValid())
         {
             std::stringstream ss;
@@ -182,10 +187,8 @@ void ReaderImpl::onInput(const std::string &netname)
     auto pin = m_currentModule->createPin(netname);
     pin->m_iotype = ChipDB::IOType::INPUT;
 
-    auto pinInstance = std::make_shared<ChipDB::Instance>(netname, ChipDB::InstanceType::PIN,
+    auto pinInsKeyObjPair = m_currentModule->createInstance(netname, ChipDB::InstanceType::PIN,
         m_design.m_cellLib->lookupCell("__INPIN").ptr());
-
-    auto pinInsKeyObjPair = m_currentModule->addInstance(pinInstance);
     if (!m_currentModule->connect(netname, "Y", netname))   // output on the inner level
     {
         Logging::logError("VerilogReader::ReaderImpl::onInput: cannot connect to pin Instance!\n");
@@ -216,10 +219,8 @@ void ReaderImpl::onInput(const std::string &netname, uint32_t start, uint32_t st
         pin->m_iotype = ChipDB::IOType::INPUT;
 
         // add a PinInstance for each pin to the netlist
-        auto pinInstance = std::make_shared<ChipDB::Instance>(netname, ChipDB::InstanceType::PIN,
-        m_design.m_cellLib->lookupCell("__INPIN").ptr());
-
-        auto pinInsKeyObjPair = m_currentModule->addInstance(pinInstance);
+        auto pinInsKeyObjPair = m_currentModule->createInstance(netname, ChipDB::InstanceType::PIN,
+            m_design.m_cellLib->lookupCell("__INPIN").ptr());
         if (!m_currentModule->connect(netname, "Y", netname))    // output on the inner level
         {
             Logging::logError("VerilogReader::ReaderImpl::onInput: cannot connect to pin Instance!\n");
@@ -242,11 +243,9 @@ void ReaderImpl::onOutput(const std::string &netname)
     pin->m_iotype = ChipDB::IOType::OUTPUT;
 
     // add a PinInstance for each pin to the netlist
-    auto pinInstance = std::make_shared<ChipDB::Instance>(netname, ChipDB::InstanceType::PIN,
+    auto pinInsKeyObjPair = m_currentModule->createInstance(netname, ChipDB::InstanceType::PIN,
         m_design.m_cellLib->lookupCell("__OUTPIN").ptr());
 
-    auto pinInsKeyObjPair = m_currentModule->addInstance(pinInstance);
-
     if (!m_currentModule->connect(netname, "A", netname))    // input on the inner level
     {
         Logging::logError("VerilogReader::ReaderImpl::onOutput: cannot connect to pin Instance!\n");
@@ -276,11 +275,9 @@ void ReaderImpl::onOutput(const std::string &netname, uint32_t start, uint32_t s
         pin->m_iotype = ChipDB::IOType::OUTPUT;
 
         // add a PinInstance for each pin to the netlist
-        auto pinInstance = std::make_shared<ChipDB::Instance>(netname, ChipDB::InstanceType::PIN,
+        auto pinInsKeyObjPair = m_currentModule->createInstance(netname, ChipDB::InstanceType::PIN,
             m_design.m_cellLib->lookupCell("__OUTPIN").ptr());
 
-        auto pinInsKeyObjPair = m_currentModule->addInstance(pinInstance);
-
         if (!m_currentModule->connect(netname, "A", netname))    // input on the inner level
         {
             Logging::logError("VerilogReader::ReaderImpl::onOutput: cannot connect to pin Instance!\n");
@@ -357,28 +354,28 @@ void ReaderImpl::onAssign(const std::string &left, const std::string &right)
         return;
     }
 
-    auto insPtr = std::make_shared<Instance>(ss.str(), ChipDB::InstanceType::CELL, cellKeyObjPair.ptr());
-    auto insKeyObjPair = m_currentModule->addInstance(insPtr);
+    auto insKeyObjPair = m_currentModule->createInstance(ss.str(), ChipDB::InstanceType::CELL, cellKeyObjPair.ptr());
 
     if (!insKeyObjPair.isValid())
     {
         std::stringstream ss2;
         ss2 << "Verilog reader: failed to create instance " << ss.str() << "\n";
         Logging::logError(ss2.str());
+        return;
     }
 
     // **********************************************************************
     //   find Y and A pins on the __NETCON cell
     // **********************************************************************
 
-    auto pinY = insPtr->getPin("Y");
+    auto pinY = insKeyObjPair->getPin("Y");
     if (!pinY.isValid())
     {
         Logging::logError("Verilog reader: __NETCON cell does not have a Y pin.\n");
         return;
     }
 
-    auto pinA = insPtr->getPin("A");
+    auto pinA = insKeyObjPair->getPin("A");
     if (!pinA.isValid())
     {
         Logging::logError("Verilog reader: __NETCON cell does not have a A pin.\n");
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <iostream>
+#include <string>
+#include <string_view>
 #include "veriloglexer.h"
 #include "verilogparser.h"
 #include "database/database.h"
@@ -74,6 +76,14 @@ class Reader
 public:
     /** read a Verilog netlist into a Design */
     static bool load(Design &design, std::istream &is);
+
+    /** read a Verilog netlist from source text into a Design */
+    static bool load(Design &design, std::string_view source);
+
+    /** read a Verilog netlist file into a Design.
+     *  The file is memory mapped and tokenized while it is parsed.
+    */
+    static bool loadFile(Design &design, const std::string &filename);
 };
 
 };
@@ -14,6 +14,8 @@
 //#include "../cellplacer/densitybitmap.h"
 #include "../cellplacer/netlistsplitter.h"
 #include "../cellplacer/rowlegalizer.h"
+#include "../cellplacer/detailedplacer.h"
+#include "../cellplacer/eplacer.h"
 #include "../cellplacer2/cellplacer2.h"
 #include "../cellplacer2/fillerhandler.h"
 #include "../partitioner/fmpart.h"
@@ -29,6 +31,10 @@
 #include "../globalroute/globalrouter.h"
 #include "../globalroute/prim.h"
 #include "../globalroute/lshape.h"
+#include "../globalroute/pathfinder.h"
+#include "../globalroute/layergrid.h"
+#include "../globalroute/layerassign.h"
+#include "../globalroute/congestion.h"
 
 #include "../passes/passes.hpp"
 #include "../padring/padring.hpp"
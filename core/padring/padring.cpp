@@ -623,8 +623,12 @@ bool Padring::fillGap(
                 return false;
             }
 
-            auto insPtr = std::make_shared<ChipDB::Instance>(ss.str(), ChipDB::InstanceType::CELL, cellPtr);
-            topModule->addInstance(insPtr);
+            auto insPtr = topModule->createInstance(ss.str(), ChipDB::InstanceType::CELL, cellPtr);
+            if (!insPtr.isValid())
+            {
+                Logging::logError("Cannot create padring filler %s\n", ss.str().c_str());
+                return false;
+            }
 
             ChipDB::Orientation edgeOrientation{ChipDB::Orientation::UNDEFINED};
             ChipDB::CoordType offset{0};    // offset to align the cell to the outside edge of the padring.
@@ -25,7 +25,7 @@ namespace LunaCore::Partitioner
     * build node and net vectors by index / filter on physical node location.
     * create and fill two partitions.
     * run FM algorithm
-    * write back the physical positions in the instances (delayed in multi-threaded mode)
+    * write back the physical positions in the instances
     * call partitioner on the two new partitions if the partition size is larger than
       a certain threshold. (or contains more than x number of cells)
 
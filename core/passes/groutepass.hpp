@@ -0,0 +1,351 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+#include <chrono>
+#include <fstream>
+#include <optional>
+#include <vector>
+#include "common/logging.h"
+#include "globalroute/globalrouter.h"
+#include "globalroute/congestion.h"
+#include "pass.hpp"
+
+namespace LunaCore::Passes
+{
+
+class GRoutePass : public Pass
+{
+public:
+    GRoutePass() : Pass("groute")
+    {
+        registerNamedParameter("site", "", 1, false);
+        registerNamedParameter("hroutes", "", 1, false);
+        registerNamedParameter("vroutes", "", 1, false);
+        registerNamedParameter("capacity", "", 1, false);
+        registerNamedParameter("iterations", "", 1, false);
+        registerNamedParameter("nolayers", "", 0, false);
+        registerNamedParameter("stats", "", 1, false);
+        registerNamedParameter("map", "", 1, false);
+    }
+
+    virtual ~GRoutePass() = default;
+
+    /** execute a pass given a list of input arguments.
+        returns true if succesful, else false.
+    */
+    [[nodiscard]] bool execute(Database &database) override
+    {
+        using Clock = std::chrono::steady_clock;
+
+        m_stats.clear();
+
+        auto const siteName = m_namedParams.contains("site") ? m_namedParams.at("site").front() : std::string("core");
+
+        long hRoutes = 100;
+        long vRoutes = 100;
+        long capacity = -1;
+        long iterations = -1;
+        if (!getNumber("hroutes", hRoutes, 1)) return false;
+        if (!getNumber("vroutes", vRoutes, 1)) return false;
+        if (!getNumber("capacity", capacity, 1)) return false;
+        if (!getNumber("iterations", iterations, 1)) return false;
+
+        auto topModule = database.m_design.getTopModule();
+        if (!topModule)
+        {
+            Logging::logError("Top module not set\n");
+            return false;
+        }
+
+        if (!topModule->m_netlist)
+        {
+            Logging::logError("Top module has no netlist\n");
+            return false;
+        }
+
+        auto const& floorplan = database.m_design.m_floorplan;
+        if (!floorplan || floorplan->dieSize().isNullSize())
+        {
+            Logging::logError("No die defined in floorplan!\n");
+            return false;
+        }
+
+        // setup: determine the GCell size and capacity
+        // and collect the terminals of all nets.
+        auto phaseStart = Clock::now();
+
+        LunaCore::GlobalRouter::Router grouter;
+
+        auto gcellSize = grouter.determineGridCellSize(database.m_design, siteName, hRoutes, vRoutes);
+        if (!gcellSize.has_value())
+        {
+            Logging::logError("Could not determine GCell size!\n");
+            return false;
+        }
+
+        if (capacity < 0)
+        {
+            auto trackInfo = grouter.calcNumberOfTracks(database.m_design, siteName, gcellSize.value());
+            if (!trackInfo)
+            {
+                Logging::logError("Could not determine the number of tracks in a GCell!\n");
+                return false;
+            }
+            capacity = trackInfo->horizontal + trackInfo->vertical;
+        }
+
+        if (capacity <= 0)
+        {
+            Logging::logError("GCell capacity is zero, check the routing layers or use -capacity\n");
+            return false;
+        }
+
+        const auto dieSize  = floorplan->dieSize();
+        const auto coreRect = floorplan->coreRect();
+        const auto gridWidth  = (dieSize.m_x + gcellSize->m_x - 1) / gcellSize->m_x;
+        const auto gridHeight = (dieSize.m_y + gcellSize->m_y - 1) / gcellSize->m_y;
+
+        Logging::logInfo("Die size  = %ld by %ld nm\n", dieSize.m_x, dieSize.m_y);
+        Logging::logInfo("Core area = (%ld,%ld) - (%ld,%ld) nm\n",
+            coreRect.left(), coreRect.bottom(), coreRect.right(), coreRect.top());
+        Logging::logInfo("GCell size = %ld by %ld nm, capacity %ld\n", gcellSize->m_x, gcellSize->m_y, capacity);
+        Logging::logInfo("Grid size = %ld by %ld cells\n", gridWidth, gridHeight);
+
+        grouter.createGrid(gridWidth, gridHeight, gcellSize.value(), capacity);
+
+        auto netlist = topModule->m_netlist;
+
+        std::vector<std::vector<ChipDB::Coord64>> nets;
+        std::vector<std::shared_ptr<ChipDB::Net>> routedNets;
+        nets.reserve(netlist->m_nets.size());
+        routedNets.reserve(netlist->m_nets.size());
+
+        for(auto const netKeyPair : netlist->m_nets)
+        {
+            auto net = netKeyPair.ptr();
+            net->m_route.clear();
+            if (net->numberOfConnections() < 2) continue;
+
+            routedNets.push_back(net);
+            auto &netNodes = nets.emplace_back();
+            netNodes.reserve(net->numberOfConnections());
+
+            for(auto netConnect : *net)
+            {
+                auto ins = netlist->lookupInstance(netConnect.m_instanceKey);
+                if (!ins->isPlaced())
+                {
+                    Logging::logError("Instance %s has not been placed!\n", ins->name().c_str());
+                    return false;
+                }
+
+                netNodes.push_back(ins->getCenter());
+            }
+        }
+
+        addPhaseTime("setup", phaseStart);
+
+        // route
+        phaseStart = Clock::now();
+
+        LunaCore::GlobalRouter::PathFinder::Parameters params;
+        if (iterations > 0) params.m_maxIterations = static_cast<std::size_t>(iterations);
+
+        auto result = grouter.routeNets(nets, params);
+        if (!result)
+        {
+            Logging::logError("Routing failed!\n");
+            return false;
+        }
+
+        addPhaseTime("route", phaseStart);
+
+        Logging::logInfo("Routed %lu of %lu nets in %lu iterations\n",
+            nets.size() - result->m_unroutedNets, nets.size(), result->m_iterations);
+
+        const auto congestion = LunaCore::GlobalRouter::calcCongestion(*grouter.grid());
+
+        m_stats.emplace_back("nets", std::to_string(nets.size()));
+        m_stats.emplace_back("unrouted_nets", std::to_string(result->m_unroutedNets));
+        m_stats.emplace_back("iterations", std::to_string(result->m_iterations));
+        m_stats.emplace_back("grid_width", std::to_string(gridWidth));
+        m_stats.emplace_back("grid_height", std::to_string(gridHeight));
+        m_stats.emplace_back("gcell_width_nm", std::to_string(gcellSize->m_x));
+        m_stats.emplace_back("gcell_height_nm", std::to_string(gcellSize->m_y));
+        m_stats.emplace_back("gcell_capacity", std::to_string(capacity));
+        m_stats.emplace_back("wirelength_gcells", std::to_string(result->m_wirelength));
+        m_stats.emplace_back("overflow_gcells", std::to_string(result->m_overflowCells));
+        m_stats.emplace_back("total_overflow", std::to_string(result->m_totalOverflow));
+        m_stats.emplace_back("max_usage", std::to_string(congestion.m_maxUsage));
+        m_stats.emplace_back("average_utilisation", std::to_string(congestion.m_averageUtilisation));
+
+        if (result->m_totalOverflow > 0)
+        {
+            Logging::logWarning("%lu GCells are over capacity, total overflow %ld\n",
+                result->m_overflowCells, result->m_totalOverflow);
+        }
+
+        // layer assignment
+        std::optional<LunaCore::GlobalRouter::LayerAssigner::Result> layerResult;
+        if (!m_namedParams.contains("nolayers"))
+        {
+            phaseStart = Clock::now();
+
+            LunaCore::GlobalRouter::LayerAssigner::Parameters layerParams;
+            layerResult = grouter.assignLayers(*database.m_design.m_techLib, result->m_routes, layerParams);
+            if (!layerResult)
+            {
+                Logging::logError("Layer assignment failed!\n");
+                return false;
+            }
+
+            addPhaseTime("layers", phaseStart);
+
+            m_stats.emplace_back("layers", std::to_string(grouter.layerGrid()->layerCount()));
+            m_stats.emplace_back("unassigned_nets", std::to_string(layerResult->m_unassignedNets));
+            m_stats.emplace_back("vias", std::to_string(layerResult->m_vias));
+            m_stats.emplace_back("layer_overflow_edges", std::to_string(layerResult->m_overflowEdges));
+            m_stats.emplace_back("layer_total_overflow", std::to_string(layerResult->m_totalOverflow));
+        }
+
+        // store the routes on the nets
+        phaseStart = Clock::now();
+
+        const std::vector<uint8_t> noLayers;
+        for(std::size_t idx = 0; idx < routedNets.size(); idx++)
+        {
+            if (result->m_routes.at(idx).size() == 0) continue;     // not routed
+
+            auto const& layers = layerResult ? layerResult->m_layers.at(idx) : noLayers;
+            routedNets[idx]->m_route = grouter.createNetRoute(result->m_routes.at(idx), nets.at(idx), layers);
+        }
+
+        addPhaseTime("store", phaseStart);
+
+        // reports
+        phaseStart = Clock::now();
+
+        if (m_namedParams.contains("map"))
+        {
+            auto const& mapFilename = m_namedParams.at("map").front();
+            if (!LunaCore::GlobalRouter::writeCongestionMap(mapFilename, *grouter.grid()))
+            {
+                Logging::logError("Could not write congestion map %s\n", mapFilename.c_str());
+                return false;
+            }
+            Logging::logInfo("Congestion map written to %s\n", mapFilename.c_str());
+        }
+
+        addPhaseTime("report", phaseStart);
+
+        for(auto const& [name, value] : m_stats)
+        {
+            Logging::logInfo("  %-24s %s\n", name.c_str(), value.c_str());
+        }
+
+        if (m_namedParams.contains("stats"))
+        {
+            auto const& statsFilename = m_namedParams.at("stats").front();
+            std::ofstream ofile(statsFilename);
+            if (!ofile.good())
+            {
+                Logging::logError("Cannot open %s for writing\n", statsFilename.c_str());
+                return false;
+            }
+
+            ofile << "name,value\n";
+            for(auto const& [name, value] : m_stats)
+            {
+                ofile << name << "," << value << "\n";
+            }
+        }
+
+        if (result->m_unroutedNets > 0)
+        {
+            Logging::logError("%lu nets could not be routed\n", result->m_unroutedNets);
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+        returns help text for a pass.
+    */
+    std::string help() const noexcept override
+    {
+        std::stringstream ss;
+        ss << "groute - global route the placed top module\n";
+        ss << "  groute [options]\n\n";
+        ss << "  The routing grid covers the die of the floorplan.\n";
+        ss << "  The routes are stored on the nets for parasitic extraction.\n";
+        ss << "  Options:\n";
+        ss << "    -site <name>         : site used to determine the GCell size (default core)\n";
+        ss << "    -hroutes <number>    : number of horizontal routes per GCell (default 100)\n";
+        ss << "    -vroutes <number>    : number of vertical routes per GCell (default 100)\n";
+        ss << "    -capacity <number>   : GCell capacity, default is the number of tracks in a GCell\n";
+        ss << "    -iterations <number> : maximum number of rip-up and re-route iterations\n";
+        ss << "    -nolayers            : skip layer assignment\n";
+        ss << "    -stats <file>        : write the routing statistics and phase times as CSV\n";
+        ss << "    -map <file>          : write a congestion map, the extension selects the format: .ppm, .svg or .csv\n";
+        ss << "\n";
+        return ss.str();
+    }
+
+    /**
+        returns a one-line short help text for a pass.
+    */
+    virtual std::string shortHelp() const noexcept
+    {
+        return "global route the top module";
+    }
+
+    /**
+        Initialize a pass. this is called by registerPass()
+    */
+    bool init() override
+    {
+        return true;
+    }
+
+protected:
+    /** read an optional integer parameter, value is unchanged if the parameter is absent */
+    bool getNumber(const std::string &name, long &value, long minValue) const
+    {
+        if (!m_namedParams.contains(name)) return true;
+
+        auto const& valueStr = m_namedParams.at(name).front();
+
+        long number = minValue - 1;
+        try
+        {
+            number = std::stol(valueStr);
+        }
+        catch(...)
+        {
+        }
+
+        if (number < minValue)
+        {
+            Logging::logError("Invalid value for -%s: %s\n", name.c_str(), valueStr.c_str());
+            return false;
+        }
+
+        value = number;
+        return true;
+    }
+
+    void addPhaseTime(const std::string &phase, std::chrono::steady_clock::time_point start)
+    {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        Logging::logInfo("groute %s took %.3f s\n", phase.c_str(), elapsed.count());
+        m_stats.emplace_back("time_" + phase + "_s", std::to_string(elapsed.count()));
+    }
+
+    std::vector<std::pair<std::string, std::string>> m_stats;   ///< name, value
+};
+
+
+};
@@ -65,7 +65,7 @@ public:
 
                 for(auto pin : cellKp->m_pins)
                 {
-                    Logging::logInfo("        %s\t%s\n", pin->m_name.c_str(), toString(pin->m_iotype).c_str());
+                    Logging::logInfo("        %s\t%s\n", pin->name().c_str(), toString(pin->m_iotype).c_str());
                 }
             }
         }
@@ -20,6 +20,7 @@
 #include "setpass.hpp"
 #include "clearpass.hpp"
 #include "gdsmerge.hpp"
+#include "groutepass.hpp"
 
 namespace LunaCore::Passes
 {
@@ -53,6 +54,7 @@ void registerAllPasses()
     registerPass(new SetPass());
     registerPass(new ClearPass());
     registerPass(new GDSMergePass());
+    registerPass(new GRoutePass());
 }
 
 };
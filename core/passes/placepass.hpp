@@ -6,6 +6,7 @@
 #include <fstream>
 #include <filesystem>
 #include "common/logging.h"
+#include "cellplacer/eplacer.h"
 #include "pass.hpp"
 
 namespace LunaCore::Passes
@@ -29,8 +30,35 @@ public:
     {
         if (m_namedParams.contains("core"))
         {
-            Logging::logError("Not implemented yet\n");
-            return false;
+            auto topModule = database.m_design.getTopModule();
+            if (!topModule)
+            {
+                Logging::logError("Top module not set\n");
+                return false;
+            }
+
+            if (!topModule->m_netlist)
+            {
+                Logging::logError("Top module has no netlist\n");
+                return false;
+            }
+
+            auto const& floorplan = database.m_design.m_floorplan;
+            if (!floorplan)
+            {
+                Logging::logError("No floorplan defined\n");
+                return false;
+            }
+
+            // the placer uses the thread pool set with set -threads
+            LunaCore::EPlacer::Parameters params;
+            if (!LunaCore::EPlacer::place(*floorplan, *topModule->m_netlist, params, nullptr))
+            {
+                Logging::logError("Core placement failed\n");
+                return false;
+            }
+
+            floorplan->contentsChanged();
         }
         else if (m_namedParams.contains("cell"))
         {
@@ -55,7 +83,7 @@ public:
         ss << "place - place pads/core/cell\n";
         ss << "  place <place type>\n\n";
         ss << "  Place type options:\n";
-        ss << "    -core    : place all core cells\n";
+        ss << "    -core    : place and legalize all core cells in the rows of the floorplan\n";
         ss << "    -cell    : place a specific cell at a specified position\n";
         ss << "\n";
         return ss.str();
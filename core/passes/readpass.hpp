@@ -5,6 +5,7 @@
 #pragma once
 #include <fstream>
 #include <filesystem>
+#include <vector>
 #include "common/logging.h"
 #include "import/import.h"
 #include "padring/padringplacer.hpp"
@@ -31,29 +32,24 @@ public:
     */
     [[nodiscard]] bool execute(Database &database) override
     {
-        if (m_namedParams.contains("verilog"))
+        for(auto const& fname : m_params)
         {
-            for(auto const& fname : m_params)
+            if (!std::filesystem::is_regular_file(fname))
             {
-                if (!std::filesystem::is_regular_file(fname))
-                {
-                    std::stringstream ss;
-                    ss << "'"<< fname << "' is not a file\n";
-                    Logging::logError(ss.str());
-                    return false;
-                }
+                std::stringstream ss;
+                ss << "'"<< fname << "' is not a file\n";
+                Logging::logError(ss.str());
+                return false;
+            }
+        }
 
-                std::ifstream infile(fname);
-                if (!infile.is_open())
-                {
-                    std::stringstream ss;
-                    ss << "Cannot open file '"<< fname << "'\n";
-                    Logging::logError(ss.str());
-                    return false;
-                }
+        const std::vector<std::string> filenames(m_params.begin(), m_params.end());
 
-                ChipDB::Verilog::Reader reader;
-                if (!reader.load(database.m_design, infile))
+        if (m_namedParams.contains("verilog"))
+        {
+            for(auto const& fname : filenames)
+            {
+                if (!ChipDB::Verilog::Reader::loadFile(database.m_design, fname))
                 {
                     std::stringstream ss;
                     ss << "Failed to load '"<< fname << "'\n";
@@ -64,64 +60,20 @@ public:
         }
         else if (m_namedParams.contains("lib"))
         {
-            for(auto const& fname : m_params)
+            // the files are parsed concurrently
+            if (!ChipDB::Liberty::Reader::loadFiles(database.m_design, filenames))
             {
-                if (!std::filesystem::is_regular_file(fname))
-                {
-                    std::stringstream ss;
-                    ss << "'"<< fname << "' is not a file\n";
-                    Logging::logError(ss.str());
-                    return false;
-                }
-
-                std::ifstream infile(fname);
-                if (!infile.is_open())
-                {
-                    std::stringstream ss;
-                    ss << "Cannot open file '"<< fname << "'\n";
-                    Logging::logError(ss.str());
-                    return false;
-                }
-
-                ChipDB::Liberty::Reader reader;
-                if (!reader.load(database.m_design, infile))
-                {
-                    std::stringstream ss;
-                    ss << "Failed to load '"<< fname << "'\n";
-                    Logging::logError(ss.str());
-                    return false;
-                }
+                Logging::logError("Failed to load the Liberty files\n");
+                return false;
             }
         }
         else if (m_namedParams.contains("lef"))
         {
-            for(auto const& fname : m_params)
+            // the files are parsed concurrently
+            if (!ChipDB::LEF::Reader::loadFiles(database.m_design, filenames))
             {
-                if (!std::filesystem::is_regular_file(fname))
-                {
-                    std::stringstream ss;
-                    ss << "'"<< fname << " is not a file'\n";
-                    Logging::logError(ss.str());
-                    return false;
-                }
-
-                std::ifstream infile(fname);
-                if (!infile.is_open())
-                {
-                    std::stringstream ss;
-                    ss << "Cannot open file '"<< fname << "'\n";
-                    Logging::logError(ss.str());
-                    return false;
-                }
-
-                ChipDB::LEF::Reader reader;
-                if (!reader.load(database.m_design, infile))
-                {
-                    std::stringstream ss;
-                    ss << "Failed to load '"<< fname << "'\n";
-                    Logging::logError(ss.str());
-                    return false;
-                }
+                Logging::logError("Failed to load the LEF files\n");
+                return false;
             }
         }
         else if (m_namedParams.contains("sdc"))
@@ -153,6 +105,7 @@ public:
         ss << "    -sdc     : read timing specification file\n";
         ss << "\n";
         ss << "Note: the order of the files is important; specify lower hierarchy files first.\n";
+        ss << "      LEF and Liberty files are parsed concurrently but added in the order given.\n";
         return ss.str();
     }
 
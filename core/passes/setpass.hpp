@@ -7,6 +7,7 @@
 #include <filesystem>
 #include "common/logging.h"
 #include "common/strutils.hpp"
+#include "common/threadpool.h"
 #include "pass.hpp"
 
 namespace LunaCore::Passes
@@ -22,6 +23,7 @@ public:
         registerNamedParameter("cell", "", 1, false);
         registerNamedParameter("class", "", 1, false);
         registerNamedParameter("subclass", "", 1, false);
+        registerNamedParameter("threads", "", 1, false);
     }
 
     virtual ~SetPass() = default;
@@ -49,6 +51,29 @@ public:
             }
             return true;
         }
+        else if (m_namedParams.contains("threads"))
+        {
+            auto const& threadsStr = m_namedParams.at("threads").front();
+
+            long threads = -1;
+            try
+            {
+                threads = std::stol(threadsStr);
+            }
+            catch(...)
+            {
+            }
+
+            if (threads < 0)
+            {
+                Logging::logError("Invalid number of threads: %s\n", threadsStr.c_str());
+                return false;
+            }
+
+            ThreadPool::setGlobalThreadCount(static_cast<std::size_t>(threads));
+            Logging::logInfo("Using %d threads\n", static_cast<int>(ThreadPool::globalThreadCount()));
+            return true;
+        }
         else if (m_namedParams.contains("top"))
         {
             auto moduleName = m_namedParams.at("top").front();
@@ -80,7 +105,7 @@ public:
         }
         else
         {
-            Logging::logError("Missing parameters, use -loglevel, -top or -cell\n");
+            Logging::logError("Missing parameters, use -loglevel, -threads, -top or -cell\n");
             return false;
         }
 
@@ -97,6 +122,7 @@ public:
         ss << "  set <set type>\n\n";
         ss << "  set type options:\n";
         ss << "    -loglevel <level>                    : set log level to NORMAL, DEBUG or VERBOSE.\n";
+        ss << "    -threads <number>                    : set number of worker threads, 0 = all hardware threads.\n";
         ss << "    -top <module name>                   : set top level module\n";
         ss << "    -cell <cell name> -class <class>     : change cell class\n";
         ss << "    -cell <cell name> -subclass <sclass> : change cell subclass\n";
@@ -21,6 +21,9 @@ public:
         registerNamedParameter("def", "", 2, false);
         registerNamedParameter("txt", "", 2, false);
         registerNamedParameter("gds2", "", 2, false);
+        registerNamedParameter("spef", "", 2, false);
+        registerNamedParameter("namemap", "", 0, false);
+        registerNamedParameter("threads", "", 1, false);
     }
 
     virtual ~WritePass() = default;
@@ -241,9 +244,88 @@ public:
                 return true;
             }
         }
+        else if (m_namedParams.contains("spef"))
+        {
+            auto params = m_namedParams.at("spef");
+            if (params.size() != 2)
+            {
+                std::stringstream ss;
+                ss << "write -spef requires exactly two parameters\n";
+                Logging::logError(ss.str());
+                return false;
+            }
+
+            auto moduleName = params.at(0);
+            auto fname      = params.at(1);
+
+            auto modKp = database.m_design.m_moduleLib->lookupModule(moduleName);
+            if (!modKp.isValid())
+            {
+                std::stringstream ss;
+                ss << "cannot find module '"<< moduleName << "'\n";
+                Logging::logError(ss.str());
+                return false;
+            }
+
+            if (std::filesystem::is_directory(fname))
+            {
+                std::stringstream ss;
+                ss << "'"<< fname << "' is a directory\n";
+                Logging::logError(ss.str());
+                return false;
+            }
+
+            LunaCore::SPEF::Options options;
+            options.m_nameMap = m_namedParams.contains("namemap");
+            if (m_namedParams.contains("threads"))
+            {
+                auto const& threadsStr = m_namedParams.at("threads").front();
+
+                long threads = -1;
+                try
+                {
+                    threads = std::stol(threadsStr);
+                }
+                catch(...)
+                {
+                }
+
+                if (threads < 0)
+                {
+                    Logging::logError("Invalid number of threads: %s\n", threadsStr.c_str());
+                    return false;
+                }
+
+                options.m_threads = static_cast<std::size_t>(threads);
+            }
+
+            std::ofstream outfile(fname, std::ios::out | std::ios::trunc);
+            if (!outfile.is_open())
+            {
+                std::stringstream ss;
+                ss << "Cannot open file '"<< fname << "'\n";
+                Logging::logError(ss.str());
+                return false;
+            }
+
+            if (!LunaCore::SPEF::write(outfile, modKp.ptr(), *database.m_design.m_techLib, options))
+            {
+                std::stringstream ss;
+                ss << "Failed to write '"<< fname << "'\n";
+                Logging::logError(ss.str());
+                return false;
+            }
+            else
+            {
+                std::stringstream ss;
+                ss << "Parasitics of module '" << modKp->name() << "' have been exported to " << fname << "'\n";
+                Logging::logInfo(ss.str());
+                return true;
+            }
+        }
         else
         {
-            Logging::logError("Missing file type, use -verilog, -def, -gds2 or -txt\n");
+            Logging::logError("Missing file type, use -verilog, -def, -gds2, -spef or -txt\n");
             return false;
         }
 
@@ -262,8 +344,14 @@ public:
         ss << "    -verilog : write a Verilog netlist\n";
         ss << "    -def     : write a DEF design file\n";
         ss << "    -gds2    : write a GDS2 design file\n";
+        ss << "    -spef    : write the parasitics as a SPEF file, routed nets are extracted from their route\n";
         ss << "    -txt     : write a TXT file\n";
         ss << "\n";
+        ss << "  SPEF options:\n";
+        ss << "    -namemap     : write a name map and refer to nets and instances by index\n";
+        ss << "    -threads <n> : 1 formats the nets on the calling thread, 0 (default) uses the\n";
+        ss << "                   shared pool set with set -threads, n uses n private threads\n";
+        ss << "\n";
         return ss.str();
     }
 
@@ -64,6 +64,11 @@ PyObject* Python::toPython(const char *t)
     return PyUnicode_FromString(t);
 }
 
+PyObject* Python::toPython(const ChipDB::Name &t)
+{
+    return toPython(t.view());
+}
+
 PyObject* Python::toPython(const ChipDB::Coord64 &t)
 {
     return Py_BuildValue("ll", t.m_x, t.m_y);
@@ -40,6 +40,8 @@ PyObject* toPython(const std::string &t);
 
 PyObject* toPython(const char *t);
 
+PyObject* toPython(const ChipDB::Name &t);
+
 PyObject* toPython(const ChipDB::Coord64 &t);
 
 PyObject* toPython(const ChipDB::Rect64 &t);
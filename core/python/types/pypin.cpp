@@ -14,9 +14,34 @@
 #include "pypin.h"
 #include "pypininfo.h"
 
+/** holds a copy of an instance pin. The pin doesn't own its pin
+ *  information, so the container keeps a copy of that too.
+*/
+class PinContainer : public Python::ValueContainer<ChipDB::Instance::Pin>
+{
+public:
+    void set(const ChipDB::Instance::Pin &pin)
+    {
+        m_value = pin;
+        m_pinInfo.reset();
+        if (pin.m_pinInfo != nullptr)
+        {
+            m_pinInfo = std::make_shared<ChipDB::PinInfo>(*pin.m_pinInfo);
+            m_value.m_pinInfo = m_pinInfo.get();
+        }
+    }
+
+    [[nodiscard]] const std::shared_ptr<ChipDB::PinInfo>& pinInfo() const noexcept
+    {
+        return m_pinInfo;
+    }
+
+protected:
+    std::shared_ptr<ChipDB::PinInfo> m_pinInfo;
+};
+
 /** container for LunaCore::Cell */
-struct PyPin : public Python::TypeTemplate<ChipDB::Instance::Pin,
-    Python::ValueContainer<ChipDB::Instance::Pin> >
+struct PyPin : public Python::TypeTemplate<ChipDB::Instance::Pin, PinContainer>
 {
     static PyObject* getName(PyPin *self, void *closure)
     {
@@ -55,7 +80,7 @@ struct PyPin : public Python::TypeTemplate<ChipDB::Instance::Pin,
     {
         if (self->ok())
         {
-            return Python::toPython(self->obj()->m_pinInfo);
+            return Python::toPython(self->m_holder->pinInfo());
         }
 
         PyErr_Format(PyExc_RuntimeError, "Self is uninitialized");
@@ -147,7 +172,7 @@ PyObject* Python::toPython(const ChipDB::Instance::Pin &pin)
     auto pinObject = reinterpret_cast<PyPin*>(PyObject_CallObject((PyObject*)&PyPinType, nullptr));
     if (pinObject->m_holder != nullptr)
     {
-        *pinObject->m_holder = pin;
+        pinObject->m_holder->set(pin);
         return (PyObject*)pinObject;
     }
     return nullptr;
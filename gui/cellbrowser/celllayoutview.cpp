@@ -327,7 +327,7 @@ void CellLayoutView::paintEvent(QPaintEvent *event)
                     auto txtRect = std::get<ChipDB::Rectangle>(obj);
                     QRectF screenRect(toScreen(txtRect.m_rect.getLL()), toScreen(txtRect.m_rect.getUR()));
                     painter.setPen(Qt::white);
-                    drawCenteredText(painter, screenRect.center() , pin->m_name, font(), Qt::NoBrush);
+                    drawCenteredText(painter, screenRect.center() , pin->name(), font(), Qt::NoBrush);
                 }
             }
         }
@@ -177,19 +177,19 @@ bool LayerRenderInfoDB::readJson(const std::string &txt)
     }
 
     notifyAll();
-    Logging::logVerbose("Loaded %d layers from JSON file\n", m_objects.size());
+    Logging::logVerbose("Loaded %d layers from JSON file\n", size());
     return true;
 }
 
 std::string LayerRenderInfoDB::writeJson() const
 {
     QJsonArray  arr;
-    for(auto layer : m_objects)
+    for(auto layer : *this)
     {
         QJsonObject obj;
-        if (layer.second)
+        if (layer.isValid())
         {
-            layer.second->write(obj);
+            layer->write(obj);
             arr.append(obj);
         }
     }
@@ -36,6 +36,7 @@ struct ProjectSetup
 
     std::string m_openSTALocation{"/usr/local/bin/sta"};    ///< this comes from the Luna config file, not the project file.
     std::string m_floorplanScriptLocation;                  ///< if this is not empty, this script is used to generate the floorplan
+    std::size_t m_threads{0};                               ///< worker threads of the core engines, 0 = all hardware threads. this comes from the Luna config file.
 
     bool readFromJSON(std::istream &is);
     bool writeToJSON(std::ostream &os) const;
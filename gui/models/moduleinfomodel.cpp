@@ -106,7 +106,7 @@ void ModuleInfoModel::setModule(std::shared_ptr<ChipDB::Module> module)
     {
         m_altColors.resetState();
 
-        auto pinNode = new ModuleInfoNode("Pin", QString::fromStdString(pin->m_name), m_pinColor);
+        auto pinNode = new ModuleInfoNode("Pin", QString::fromStdString(pin->name()), m_pinColor);
         pinNode->setIcon(QPixmap("://pinicon.png"));
         m_rootNode->addChild(pinNode);
 
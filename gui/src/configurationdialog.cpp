@@ -36,11 +36,19 @@ ConfigurationDialog::ConfigurationDialog(Database &db, QWidget *parent)
 
     connect(openSTALocationButton, &QPushButton::clicked, this, &ConfigurationDialog::onOpenSTALocationOpen);
 
+    m_threadsSpinBox = new QSpinBox();
+    m_threadsSpinBox->setRange(0, 256);
+    m_threadsSpinBox->setSpecialValueText("all");
+    m_threadsSpinBox->setValue(static_cast<int>(db.m_projectSetup.m_threads));
+
+    layout->addWidget(new QLabel("Worker threads"),1,0);
+    layout->addWidget(m_threadsSpinBox,1,1);
+
     auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
     connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
     connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
 
-    layout->addWidget(buttonBox, 1, 0, 1, 3);
+    layout->addWidget(buttonBox, 2, 0, 1, 3);
     setLayout(layout);
 }
 
@@ -59,5 +67,7 @@ void ConfigurationDialog::accept()
 {
     //std::cout << "ConfigurationDialog::accept\n";
     m_db.m_projectSetup.m_openSTALocation = m_openSTALocationEdit->text().toStdString();
+    m_db.m_projectSetup.m_threads = static_cast<std::size_t>(m_threadsSpinBox->value());
+    LunaCore::ThreadPool::setGlobalThreadCount(m_db.m_projectSetup.m_threads);
     QDialog::accept();
 }
@@ -6,6 +6,7 @@
 
 #include <QDialog>
 #include <QLineEdit>
+#include <QSpinBox>
 #include "common/database.h"
 
 namespace GUI
@@ -25,6 +26,7 @@ protected slots:
 protected:
     void onOpenSTALocationOpen();
     QLineEdit   *m_openSTALocationEdit;
+    QSpinBox    *m_threadsSpinBox;
     Database    &m_db;
 };
 
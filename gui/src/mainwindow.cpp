@@ -257,6 +257,7 @@ void MainWindow::saveSettings()
     settings.setValue("console/fontsize", m_console->font().pointSize());
 
     settings.setValue("opensta_location", QString::fromStdString(m_db->m_projectSetup.m_openSTALocation));
+    settings.setValue("threads", static_cast<qulonglong>(m_db->m_projectSetup.m_threads));
 }
 
 void MainWindow::loadSettings()
@@ -281,6 +282,9 @@ void MainWindow::loadSettings()
 
     auto openStaLocation = settings.value("opensta_location", "/usr/local/bin/sta").toString();
     m_db->m_projectSetup.m_openSTALocation = openStaLocation.toStdString();
+
+    m_db->m_projectSetup.m_threads = settings.value("threads", 0).toULongLong();
+    LunaCore::ThreadPool::setGlobalThreadCount(m_db->m_projectSetup.m_threads);
 }
 
 void MainWindow::onQuit()
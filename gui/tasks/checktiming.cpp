@@ -29,7 +29,13 @@ void Tasks::CheckTiming::execute(GUI::Database &database, ProgressCallback callb
         // create SPEF file
         info("Creating SPEF file..\n");
 
-        if (!LunaCore::SPEF::write(spefTempFile->m_stream, topModule))
+        // the file is only read by OpenSTA, so the shorter name map
+        // output is used. the nets are formatted by the shared pool.
+        LunaCore::SPEF::Options options;
+        options.m_nameMap = true;
+        options.m_threads = 0;
+
+        if (!LunaCore::SPEF::write(spefTempFile->m_stream, topModule, *database.techLib(), options))
         {
             error("SPEF file creation failed!");
             return;
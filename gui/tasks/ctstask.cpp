@@ -36,15 +36,15 @@ void Tasks::CTS::execute(GUI::Database &database, ProgressCallback callback)
 
     for(auto pin : topModule->m_pins)
     {
-        auto pinInstance = netlist->lookupInstance(pin->m_name);
+        auto pinInstance = netlist->lookupInstance(pin->name());
         if (!pinInstance.isValid())
         {
-            error("Module %s does not have a pin instance corresponding to pin %s!\n", topModule->name().c_str(), pin->m_name.c_str());
+            error("Module %s does not have a pin instance corresponding to pin %s!\n", topModule->name().c_str(), pin->name().c_str());
             return;
         }
         if (!pinInstance->isPlaced())
         {
-            error("Pin %s of module %s has not been placed!\n", pin->m_name.c_str(), topModule->name().c_str());
+            error("Pin %s of module %s has not been placed!\n", pin->name().c_str(), topModule->name().c_str());
             return;
         }
     }
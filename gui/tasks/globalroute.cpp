@@ -129,34 +129,21 @@ void Tasks::GlobalRoute::execute(GUI::Database &database, ProgressCallback callb
     // help to update the GUI ..
     std::this_thread::yield();
 
-    // sort nets according to the number of nodes
-    const std::size_t totalNets = netlist->m_nets.size();
-    std::vector<ChipDB::ObjectKey> netKeys(totalNets);
+    // collect the terminal positions of all nets
+    std::vector<std::vector<ChipDB::Coord64>> nets;
+    std::vector<std::shared_ptr<ChipDB::Net>> routedNets;
+    nets.reserve(netlist->m_nets.size());
+    routedNets.reserve(netlist->m_nets.size());
 
-    std::size_t idx = 0;
     for(auto const netKeyPair : netlist->m_nets)
     {
-        netKeys.at(idx++) = netKeyPair.key();
-    }
-
-    std::sort(netKeys.begin(), netKeys.end(),
-        [&netlist](auto const &key1, auto const &key2)
-        {
-            return netlist->m_nets.at(key1)->numberOfConnections() < netlist->m_nets.at(key2)->numberOfConnections();
-        }
-    );
-
-    auto logLevel = Logging::getLogLevel();
-    Logging::setLogLevel(Logging::LogType::INFO);
+        auto net = netKeyPair.ptr();
+        net->m_route.clear();
+        if (net->numberOfConnections() < 2) continue;
 
-    std::size_t netsRouted  = 0;
-    for(auto const netKey : netKeys)
-    {
-        auto net = netlist->m_nets.at(netKey);
-
-        std::size_t index = 0;
-        std::vector<ChipDB::Coord64> netNodes;
-        netNodes.resize(net->numberOfConnections());
+        routedNets.push_back(net);
+        auto &netNodes = nets.emplace_back();
+        netNodes.reserve(net->numberOfConnections());
 
         // write locations of all the terminals
         for(auto netConnect : *net)
@@ -170,30 +157,76 @@ void Tasks::GlobalRoute::execute(GUI::Database &database, ProgressCallback callb
                 return;
             }
 
-            netNodes.at(index++) = ins->m_pos;
+            netNodes.push_back(ins->getCenter());
         }
+    }
 
-        auto segList = grouter.routeNet(netNodes, net->name());
-        if (!segList)
-        {
-            auto debugBitmap = grouter.grid()->generateCapacityBitmap();
-            LunaCore::PPM::write("globalroutegrid_fail.ppm", debugBitmap);
+    const std::size_t totalNets = nets.size();
 
-            std::stringstream ss;
-            ss << "  routed " << netsRouted << " of " << totalNets << " nets\n";
-            info(ss.str());
+    auto logLevel = Logging::getLogLevel();
+    Logging::setLogLevel(Logging::LogType::INFO);
 
-            error("Routing failed!\n");
-            Logging::setLogLevel(logLevel);
-            return;
-        }
-        netsRouted++;
+    LunaCore::GlobalRouter::PathFinder::Parameters params;
+    auto result = grouter.routeNets(nets, params);
+    if (!result)
+    {
+        error("Routing failed!\n");
+        Logging::setLogLevel(logLevel);
+        return;
     }
 
     ss.str("");
-    ss << "  routed " << netsRouted << " of " << totalNets << " nets\n";
+    ss << "  routed " << (totalNets - result->m_unroutedNets) << " of " << totalNets << " nets in ";
+    ss << result->m_iterations << " iterations\n";
     info(ss.str());
 
+    if (result->m_unroutedNets > 0)
+    {
+        auto debugBitmap = grouter.grid()->generateCapacityBitmap();
+        LunaCore::PPM::write("globalroutegrid_fail.ppm", debugBitmap);
+
+        error("Routing failed!\n");
+        Logging::setLogLevel(logLevel);
+        return;
+    }
+
+    if (result->m_totalOverflow > 0)
+    {
+        ss.str("");
+        ss << "  " << result->m_overflowCells << " GCells are over capacity, total overflow " << result->m_totalOverflow << "\n";
+        warning(ss.str());
+    }
+
+    // put the 2D routes on the routing layers
+    LunaCore::GlobalRouter::LayerAssigner::Parameters layerParams;
+    auto layerResult = grouter.assignLayers(*database.techLib(), result->m_routes, layerParams);
+    if (!layerResult)
+    {
+        error("Layer assignment failed!\n");
+        Logging::setLogLevel(logLevel);
+        return;
+    }
+
+    ss.str("");
+    ss << "  assigned " << grouter.layerGrid()->layerCount() << " layers using ";
+    ss << layerResult->m_vias << " vias\n";
+    info(ss.str());
+
+    if (layerResult->m_totalOverflow > 0)
+    {
+        ss.str("");
+        ss << "  " << layerResult->m_overflowEdges << " layer edges are over capacity, total overflow ";
+        ss << layerResult->m_totalOverflow << "\n";
+        warning(ss.str());
+    }
+
+    // keep the routes on the nets for parasitic extraction
+    for(std::size_t idx = 0; idx < routedNets.size(); idx++)
+    {
+        routedNets[idx]->m_route = grouter.createNetRoute(result->m_routes.at(idx), nets.at(idx),
+            layerResult->m_layers.at(idx));
+    }
+
     auto debugBitmap = grouter.grid()->generateCapacityBitmap();
     LunaCore::PPM::write("globalroutegrid_ok.ppm", debugBitmap);
 
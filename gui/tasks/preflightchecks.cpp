@@ -129,15 +129,15 @@ void Tasks::PreflightChecks::execute(GUI::Database &database, ProgressCallback c
 
     for(auto pin : topModule->m_pins)
     {
-        auto pinInstance = topModule->m_netlist->lookupInstance(pin->m_name);
+        auto pinInstance = topModule->m_netlist->lookupInstance(pin->name());
         if (!pinInstance.isValid())
         {
-            error(Logging::fmt("Module %s does not have a pin instance corresponding to pin %s!\n", topModule->name().c_str(), pin->m_name.c_str()));
+            error(Logging::fmt("Module %s does not have a pin instance corresponding to pin %s!\n", topModule->name().c_str(), pin->name().c_str()));
             return;
         }
         if (!pinInstance->isPlaced())
         {
-            error(Logging::fmt("Pin %s of module %s has not been placed!\n", pin->m_name.c_str(), topModule->name().c_str()));
+            error(Logging::fmt("Pin %s of module %s has not been placed!\n", pin->name().c_str(), topModule->name().c_str()));
             return;
         }
     }
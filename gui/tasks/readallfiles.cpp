@@ -4,6 +4,7 @@
 
 #include <sstream>
 #include <fstream>
+#include <vector>
 #include "readallfiles.h"
 
 void Tasks::ReadAllFiles::execute(GUI::Database &database, ProgressCallback callback)
@@ -12,44 +13,43 @@ void Tasks::ReadAllFiles::execute(GUI::Database &database, ProgressCallback call
 
     database.clear();
 
+    // LEF and Liberty files are parsed concurrently
+    std::vector<std::string> lefFiles;
     for(auto const& lef : database.m_projectSetup.m_lefFiles)
     {
-        std::ifstream lefFile(LunaCore::expandEnvironmentVars(lef));
-        if (!lefFile.good())
+        lefFiles.push_back(LunaCore::expandEnvironmentVars(lef));
+        if (!LunaCore::fileExists(lefFiles.back()))
         {
             std::stringstream ss;
             ss << "Could not open LEF file " << lef << "\n";
             error(ss.str());
             return;
         }
+    }
 
-        std::stringstream ss;
-        ss << lefFile.rdbuf();
-        if (!ChipDB::LEF::Reader::load(database.design(), ss))
-        {
-            error("Could not parse LEF file");
-            return;
-        }
+    if (!ChipDB::LEF::Reader::loadFiles(database.design(), lefFiles))
+    {
+        error("Could not parse LEF file");
+        return;
     }
 
+    std::vector<std::string> libFiles;
     for(auto const& lib : database.m_projectSetup.m_libFiles)
     {
-        std::ifstream libFile(LunaCore::expandEnvironmentVars(lib));
-        if (!libFile.good())
+        libFiles.push_back(LunaCore::expandEnvironmentVars(lib));
+        if (!LunaCore::fileExists(libFiles.back()))
         {
             std::stringstream ss;
             ss << "Could not open LIB file " << lib << "\n";
             error(ss.str());
             return;
         }
+    }
 
-        std::stringstream ss;
-        ss << libFile.rdbuf();
-        if (!ChipDB::Liberty::Reader::load(database.design(), ss))
-        {
-            error("Could not parse LIB file");
-            return;
-        }
+    if (!ChipDB::Liberty::Reader::loadFiles(database.design(), libFiles))
+    {
+        error("Could not parse LIB file");
+        return;
     }
 
     for(auto const& layerFileName : database.m_projectSetup.m_layerFiles)
@@ -75,8 +75,8 @@ void Tasks::ReadAllFiles::execute(GUI::Database &database, ProgressCallback call
 
     for(auto const& verilog : database.m_projectSetup.m_verilogFiles)
     {
-        std::ifstream verilogFile(LunaCore::expandEnvironmentVars(verilog));
-        if (!verilogFile.good())
+        const auto verilogFilename = LunaCore::expandEnvironmentVars(verilog);
+        if (!LunaCore::fileExists(verilogFilename))
         {
             std::stringstream ss;
             ss << "Could not open Verilog file " << verilog << "\n";
@@ -84,9 +84,7 @@ void Tasks::ReadAllFiles::execute(GUI::Database &database, ProgressCallback call
             return;
         }
 
-        std::stringstream ss;
-        ss << verilogFile.rdbuf();
-        if (!ChipDB::Verilog::Reader::load(database.design(), ss))
+        if (!ChipDB::Verilog::Reader::loadFile(database.design(), verilogFilename))
         {
             error("Could not parse Verilog file");
             return;
@@ -10,6 +10,7 @@
 #include <stdexcept>
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include "algebra/algebra.hpp"
 #include <boost/test/unit_test.hpp>
 
@@ -64,6 +65,11 @@ BOOST_AUTO_TEST_CASE(SDSolver_1)
 
     std::cout << "  Iterations = " << info.m_iterations << "\n";
     std::cout << "  Error      = " << info.m_error << "\n";
+
+    // a maximum iteration count that is too low is reported
+    vx.zero();
+    auto limitedInfo = Algebra::SDSolver::solve(mat, vb, vx, 1.0e-5f, 1);
+    BOOST_CHECK(!limitedInfo.m_converged);
 }
 
 BOOST_AUTO_TEST_CASE(CGSolver_1)
@@ -103,6 +109,274 @@ BOOST_AUTO_TEST_CASE(CGSolver_1)
 }
 
 
+BOOST_AUTO_TEST_CASE(CSRMatrix_builder)
+{
+    std::cout << "--== TEST ALGEBRA::CSRMATRIX BUILDER ==--\n";
+
+    const size_t N = 3;
+    Algebra::TripletBuilder<float> builder(N);
+
+    // add entries out of order and with duplicates
+    builder.add(2, 2, 1.0f);
+    builder.add(0, 1, -1.0f);
+    builder.add(0, 0, 2.0f);
+    builder.add(2, 1, -1.0f);
+    builder.add(2, 2, 1.0f);
+    builder.add(0, 0, 1.0f);
+
+    auto mat = builder.freeze();
+
+    BOOST_CHECK(mat.rowCount() == N);
+    BOOST_CHECK(mat.nonzeroCount() == 4);
+    BOOST_CHECK(mat.rowEntryCount(0) == 2);
+    BOOST_CHECK(mat.rowEntryCount(1) == 0);
+    BOOST_CHECK(mat.rowEntryCount(2) == 2);
+    BOOST_CHECK(mat.at(0,0) == 3.0f);
+    BOOST_CHECK(mat.at(0,1) == -1.0f);
+    BOOST_CHECK(mat.at(2,1) == -1.0f);
+    BOOST_CHECK(mat.at(2,2) == 2.0f);
+    BOOST_CHECK(mat.diagonal(1) == 0.0f);
+    BOOST_CHECK_THROW(mat.at(1,1), std::out_of_range);
+
+    Algebra::Vector<float> x(N);
+    x = "1, 2, 3";
+
+    auto y = mat * x;
+    BOOST_CHECK(y[0] == 1.0f);
+    BOOST_CHECK(y[1] == 0.0f);
+    BOOST_CHECK(y[2] == 4.0f);
+}
+
+BOOST_AUTO_TEST_CASE(CGSolver_CSR)
+{
+    std::cout << "--== TEST ALGEBRA::CGSOLVER CSR ==--\n";
+
+    // 1D Laplacian with both ends tied to fixed positions 0 and N+1
+    const size_t N = 20;
+    Algebra::TripletBuilder<float> builder(N);
+    Algebra::Vector<float> vb(N);
+    Algebra::Vector<float> vx(N);
+
+    for(size_t row = 0; row < N; row++)
+    {
+        builder.add(row, row, 2.0f);
+        if (row > 0) builder.add(row, row-1, -1.0f);
+        if (row < N-1) builder.add(row, row+1, -1.0f);
+    }
+    vb[N-1] = static_cast<float>(N+1);
+
+    auto mat = builder.freeze();
+    Algebra::CGSolver::JacobiPreconditioner precon(mat);
+    auto info = Algebra::CGSolver::solve(mat, vb, vx, precon, 1.0e-6f, 1000);
+
+    std::cout << "  " << info << "\n";
+
+    for(size_t row = 0; row < N; row++)
+    {
+        BOOST_CHECK_SMALL(vx[row] - static_cast<float>(row+1), 1.0e-3f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CGSolver_reuse)
+{
+    std::cout << "--== TEST ALGEBRA::CGSOLVER REUSE ==--\n";
+
+    // solve 1D Laplacians of decreasing size with the same solver
+    Algebra::CGSolver::Solver<float> solver;
+    Algebra::CGSolver::JacobiPreconditioner<float> precon;
+    Algebra::TripletBuilder<float> builder;
+    Algebra::CSRMatrix<float> mat;
+    Algebra::Vector<float> vb;
+    Algebra::Vector<float> vx;
+
+    for(size_t N : {30, 10, 20})
+    {
+        builder.reset(N);
+        for(size_t row = 0; row < N; row++)
+        {
+            builder.add(row, row, 2.0f);
+            if (row > 0) builder.add(row, row-1, -1.0f);
+            if (row < N-1) builder.add(row, row+1, -1.0f);
+        }
+        builder.freeze(mat);
+        precon.update(mat);
+
+        vb.resize(N);
+        vb.zero();
+        vb[N-1] = static_cast<float>(N+1);
+        vx.resize(N);
+        vx.zero();
+
+        auto info = solver.solve(mat, vb, vx, precon, 1.0e-6f, 1000);
+        std::cout << "  N=" << N << " " << info << "\n";
+
+        for(size_t row = 0; row < N; row++)
+        {
+            BOOST_CHECK_SMALL(vx[row] - static_cast<float>(row+1), 1.0e-3f);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CGSolver_Preconditioners)
+{
+    std::cout << "--== TEST ALGEBRA::CGSOLVER PRECONDITIONERS ==--\n";
+
+    // 2D grid Laplacian with anchors on the left and right edges,
+    // similar to the systems of quadratic placement.
+    const size_t W = 24;
+    const size_t N = W*W;
+    Algebra::TripletBuilder<float> builder(N);
+    Algebra::Vector<float> vb(N);
+
+    for(size_t y = 0; y < W; y++)
+    {
+        for(size_t x = 0; x < W; x++)
+        {
+            const size_t row = y*W + x;
+            auto connect = [&](size_t other)
+            {
+                builder.add(row, row, 1.0f);
+                builder.add(row, other, -1.0f);
+            };
+
+            if (x > 0)   connect(row - 1);
+            if (x < W-1) connect(row + 1);
+            if (y > 0)   connect(row - W);
+            if (y < W-1) connect(row + W);
+
+            if (x == 0)
+            {
+                builder.add(row, row, 1.0f);
+            }
+            if (x == W-1)
+            {
+                builder.add(row, row, 1.0f);
+                vb[row] = 100.0f;
+            }
+        }
+    }
+    auto mat = builder.freeze();
+
+    auto solveWith = [&](auto &precon)
+    {
+        Algebra::Vector<float> vx(N);
+        auto info = Algebra::CGSolver::solve(mat, vb, vx, precon, 1.0e-5f, 1000);
+        BOOST_CHECK(info.m_converged);
+
+        // the solution increases linearly from left to right
+        for(size_t x = 0; x < W; x++)
+        {
+            const float expected = 100.0f * static_cast<float>(x + 1) / static_cast<float>(W + 1);
+            BOOST_CHECK_SMALL(vx[(W/2)*W + x] - expected, 0.05f);
+        }
+        return info;
+    };
+
+    Algebra::CGSolver::JacobiPreconditioner<float> jacobi(mat);
+    Algebra::CGSolver::IC0Preconditioner<float>    ic0(mat);
+    Algebra::CGSolver::SSORPreconditioner<float>   ssor(mat, 1.5f);
+
+    auto infoJacobi = solveWith(jacobi);
+    auto infoIC0    = solveWith(ic0);
+    auto infoSSOR   = solveWith(ssor);
+
+    std::cout << "  Jacobi : " << infoJacobi << "\n";
+    std::cout << "  IC(0)  : " << infoIC0 << "\n";
+    std::cout << "  SSOR   : " << infoSSOR << "\n";
+
+    BOOST_CHECK(ic0.shift() == 0.0f);
+    BOOST_CHECK(infoIC0.m_iterations < infoJacobi.m_iterations);
+    BOOST_CHECK(infoSSOR.m_iterations < infoJacobi.m_iterations);
+
+    // a maximum iteration count that is too low is reported
+    Algebra::Vector<float> vx(N);
+    auto info = Algebra::CGSolver::solve(mat, vb, vx, jacobi, 1.0e-5f, 3);
+    BOOST_CHECK(!info.m_converged);
+    BOOST_CHECK(info.m_iterations == 3);
+
+    // a matrix without a factorization falls back to Jacobi instead of shifting forever
+    Algebra::TripletBuilder<float> badBuilder(2);
+    badBuilder.add(0, 0, -1.0f);
+    badBuilder.add(1, 1, std::numeric_limits<float>::quiet_NaN());
+    auto badMat = badBuilder.freeze();
+    Algebra::CGSolver::IC0Preconditioner<float> bad(badMat);
+    BOOST_CHECK(bad.isJacobi());
+    BOOST_CHECK(!infoIC0.m_jacobiFallback);
+
+    // the solver reports the fallback
+    Algebra::Vector<float> badRhs(2);
+    badRhs = "1, 1";
+    Algebra::Vector<float> badX(2);
+    auto badInfo = Algebra::CGSolver::solve(badMat, badRhs, badX, bad, 1.0e-5f, 10);
+    BOOST_CHECK(badInfo.m_jacobiFallback);
+}
+
+BOOST_AUTO_TEST_CASE(Kernels)
+{
+    std::cout << "--== TEST ALGEBRA::KERNELS ==--\n";
+
+    using Algebra::Kernels::InstructionSet;
+    auto const detected = Algebra::Kernels::detectInstructionSet();
+    std::cout << "  detected instruction set: " << Algebra::Kernels::toString(detected) << "\n";
+
+    // sizes that exercise the vector bodies and the scalar tails
+    const size_t N = 37;
+    Algebra::Vector<float> va(N);
+    Algebra::Vector<float> vb(N);
+    for(size_t idx = 0; idx < N; idx++)
+    {
+        va[idx] = static_cast<float>(idx) * 0.5f - 3.0f;
+        vb[idx] = 1.0f / static_cast<float>(idx + 1);
+    }
+
+    // banded matrix with rows of varying length, some longer than 8 entries
+    Algebra::TripletBuilder<float> builder(N);
+    for(size_t row = 0; row < N; row++)
+    {
+        const size_t width = row % 13;
+        for(size_t col = (row > width ? row - width : 0); col <= std::min(N-1, row + width); col++)
+        {
+            builder.add(row, col, (row == col) ? 4.0f : -0.25f);
+        }
+    }
+    auto mat = builder.freeze();
+
+    for(auto isa : {InstructionSet::SCALAR, InstructionSet::SSE, InstructionSet::AVX2})
+    {
+        Algebra::Kernels::setInstructionSet(isa);
+
+        BOOST_CHECK_CLOSE(Algebra::dot(va, vb), 3.794448f, 0.01f);
+        BOOST_CHECK_CLOSE(Algebra::norm2(va), 2386.5f, 0.01f);
+
+        auto vy = vb;
+        auto n2 = Algebra::axpyNorm2(2.0f, va, vy);
+        BOOST_CHECK_CLOSE(n2, Algebra::norm2(vy), 0.01f);
+        BOOST_CHECK_CLOSE(vy[N-1], 2.0f*va[N-1] + vb[N-1], 0.001f);
+
+        Algebra::xpby(va, -1.0f, vy);
+        BOOST_CHECK_CLOSE(vy[5], -va[5] - vb[5], 0.01f);
+
+        auto vs = 2.0f*va - va;
+        BOOST_CHECK_CLOSE(vs[N-1], va[N-1], 0.001f);
+
+        Algebra::Vector<float> result(N);
+        Algebra::multiply(mat, va, result);
+        for(size_t row = 0; row < N; row++)
+        {
+            float expected = 0.0f;
+            auto const rowPtr = mat.rowPtr();
+            for(auto index = rowPtr[row]; index < rowPtr[row+1]; index++)
+            {
+                expected += mat.values()[index] * va[mat.colIdx()[index]];
+            }
+            BOOST_CHECK_SMALL(result[row] - expected, 1.0e-4f);
+        }
+    }
+
+    Algebra::Kernels::setInstructionSet(detected);
+    BOOST_CHECK(Algebra::Kernels::instructionSet() == detected);
+}
+
 #if 0
 BOOST_AUTO_TEST_CASE(SDSolver)
 {
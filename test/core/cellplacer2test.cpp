@@ -0,0 +1,351 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "lunacore.h"
+#include "testhelpers.h"
+
+#include <string>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(CellPlacer2Test)
+
+using Helpers::c_rowHeight;
+using Helpers::c_siteWidth;
+
+/** a chain of cells, each cell drives the next two cells. The ends
+ *  of the chain connect to fixed cells in the corners of the core.
+*/
+static void createChainNetlist(ChipDB::Netlist &netlist, std::size_t numCells,
+    std::size_t numRows, ChipDB::CoordType rowWidth)
+{
+    const auto cellTypes = Helpers::createCellTypes(3);
+
+    const std::array<ChipDB::Coord64, 4> corners =
+    {
+        ChipDB::Coord64{0, 0},
+        ChipDB::Coord64{0, static_cast<ChipDB::CoordType>(numRows-1)*c_rowHeight},
+        ChipDB::Coord64{rowWidth - 3*c_siteWidth, 0},
+        ChipDB::Coord64{rowWidth - 3*c_siteWidth, static_cast<ChipDB::CoordType>(numRows-1)*c_rowHeight}
+    };
+
+    std::vector<ChipDB::InstanceObjectKey> terminals;
+    for(std::size_t idx = 0; idx < corners.size(); idx++)
+    {
+        auto insKp = netlist.createInstance("t" + std::to_string(idx), ChipDB::InstanceType::CELL, cellTypes.at(2));
+        BOOST_REQUIRE(insKp.isValid());
+        insKp->m_pos = corners.at(idx);
+        insKp->m_placementInfo = ChipDB::PlacementInfo::PLACEDANDFIXED;
+        terminals.push_back(insKp.key());
+    }
+
+    std::vector<ChipDB::InstanceObjectKey> insKeys;
+    for(std::size_t idx = 0; idx < numCells; idx++)
+    {
+        auto insKp = netlist.createInstance("u" + std::to_string(idx), ChipDB::InstanceType::CELL,
+            cellTypes.at(idx % cellTypes.size()));
+        BOOST_REQUIRE(insKp.isValid());
+        insKp->m_placementInfo = ChipDB::PlacementInfo::UNPLACED;
+        insKeys.push_back(insKp.key());
+    }
+
+    // the first two cells are driven by the left terminals
+    // and the last two cells drive the right terminals.
+    auto connect = [&netlist](const std::string &netName,
+        std::initializer_list<std::pair<ChipDB::InstanceObjectKey, ChipDB::PinObjectKey>> pins)
+    {
+        auto netKp = netlist.createNet(netName);
+        BOOST_REQUIRE(netKp.isValid());
+        for(auto const& [insKey, pinKey] : pins)
+        {
+            BOOST_CHECK(netlist.connect(insKey, pinKey, netKp.key()));
+        }
+    };
+
+    connect("left0", {{terminals.at(0), 2}, {insKeys.at(0), 0}, {insKeys.at(1), 1}});
+    connect("left1", {{terminals.at(1), 2}, {insKeys.at(0), 1}});
+    for(std::size_t idx = 0; (idx + 2) < numCells; idx++)
+    {
+        connect("n" + std::to_string(idx), {{insKeys.at(idx), 2}, {insKeys.at(idx + 1), 0}, {insKeys.at(idx + 2), 1}});
+    }
+    connect("right0", {{insKeys.at(numCells - 2), 2}, {insKeys.at(numCells - 1), 0}, {terminals.at(2), 0}});
+    connect("right1", {{insKeys.at(numCells - 1), 2}, {terminals.at(3), 0}});
+}
+
+/** exposes the region subdivision of the placer */
+class SubdividePlacer : public LunaCore::CellPlacer2::Placer
+{
+public:
+    using Placer::splitByArea;
+
+    /** subdivide a region covering the whole core. r2 is the left/lower part. */
+    void split(const ChipDB::Netlist &netlist, ChipDB::Floorplan &floorplan,
+        LunaCore::CellPlacer2::PlacementRegion &r1, LunaCore::CellPlacer2::PlacementRegion &r2)
+    {
+        populateGatePositions(netlist, floorplan);
+
+        LunaCore::CellPlacer2::PlacementRegion region;
+        region.m_rect = floorplan.coreRect();
+        region.m_capacity = m_capacityMap.capacity(region.m_rect);
+        for(LunaCore::CellPlacer2::GateIndex gate = 0; gate < m_netlist.gateCount(); gate++)
+        {
+            if (!m_netlist.isFixed(gate))
+            {
+                region.m_gatesInRegion.push_back(gate);
+            }
+        }
+
+        subdivide(region, r1, r2);
+    }
+
+    [[nodiscard]] double gateArea(const LunaCore::CellPlacer2::PlacementRegion &region) const
+    {
+        double area = 0.0;
+        for(auto gate : region.m_gatesInRegion)
+        {
+            area += m_netlist.m_area.at(gate);
+        }
+        return area;
+    }
+};
+
+/** a chain netlist on a core with a fixed macro covering a quarter of the rows */
+static void createBlockedCore(ChipDB::Netlist &netlist, ChipDB::Floorplan &floorplan,
+    std::size_t numCells, std::size_t numRows, ChipDB::CoordType rowWidth)
+{
+    floorplan.setCoreSize(ChipDB::Size64{rowWidth, static_cast<ChipDB::CoordType>(numRows)*c_rowHeight});
+    Helpers::createRows(floorplan, numRows, rowWidth);
+
+    createChainNetlist(netlist, numCells, numRows, rowWidth);
+
+    // the macro sits on the left, between the corner terminals
+    auto macro = std::make_shared<ChipDB::Cell>("macro");
+    macro->m_size = ChipDB::Coord64{rowWidth / 2, static_cast<ChipDB::CoordType>(numRows / 2)*c_rowHeight};
+    auto macroKp = netlist.createInstance("macro", ChipDB::InstanceType::CELL, macro);
+    BOOST_REQUIRE(macroKp.isValid());
+    macroKp->m_pos = ChipDB::Coord64{0, c_rowHeight};
+    macroKp->m_placementInfo = ChipDB::PlacementInfo::PLACEDANDFIXED;
+}
+
+BOOST_AUTO_TEST_CASE(check_density_cut)
+{
+    std::cout << "--== CHECK CELLPLACER2 DENSITY CUT ==--\n";
+
+    const std::size_t numRows = 10;
+    const ChipDB::CoordType rowWidth = 80000;
+    const std::size_t numCells = 60;
+
+    ChipDB::Netlist netlist;
+    ChipDB::Floorplan floorplan;
+    createBlockedCore(netlist, floorplan, numCells, numRows, rowWidth);
+
+    // the geometric cut halves the core and the gate count
+    {
+        SubdividePlacer placer;
+        LunaCore::CellPlacer2::PlacementRegion r1, r2;
+        placer.split(netlist, floorplan, r1, r2);
+
+        BOOST_CHECK(r2.m_rect.right() == rowWidth / 2);
+        BOOST_CHECK(r1.m_gatesInRegion.size() == numCells / 2);
+        BOOST_CHECK(r2.m_gatesInRegion.size() == numCells / 2);
+    }
+
+    // the macro blocks a quarter of the core, so the density cut
+    // moves to the right until both sides have the same row area.
+    SubdividePlacer placer;
+    placer.setCutMode(LunaCore::CellPlacer2::Placer::CutMode::DENSITY);
+    LunaCore::CellPlacer2::PlacementRegion r1, r2;
+    placer.split(netlist, floorplan, r1, r2);
+
+    BOOST_CHECK(r2.m_rect.right() > rowWidth / 2);
+    BOOST_CHECK(r1.m_rect.left() == r2.m_rect.right());
+
+    // the cut is snapped to the site grid, which moves one site column
+    const double siteColumn = static_cast<double>(c_siteWidth)*static_cast<double>(numRows)*c_rowHeight;
+    BOOST_CHECK(std::abs(r1.m_capacity - r2.m_capacity) <= siteColumn);
+
+    // the cell area follows the capacity, within the largest cell
+    BOOST_CHECK(!r1.m_gatesInRegion.empty());
+    BOOST_CHECK(!r2.m_gatesInRegion.empty());
+    BOOST_CHECK(r1.m_gatesInRegion.size() + r2.m_gatesInRegion.size() == numCells);
+
+    const double maxCellArea = 3.0*c_siteWidth*c_rowHeight;
+    const double r1Area = placer.gateArea(r1);
+    const double r2Area = placer.gateArea(r2);
+    const double expectedR2Area = (r1Area + r2Area) * r2.m_capacity / (r1.m_capacity + r2.m_capacity);
+    BOOST_CHECK(std::abs(r2Area - expectedR2Area) <= maxCellArea);
+
+    // a sub-region without capacity still gets a gate
+    BOOST_CHECK(placer.splitByArea(r1, 0.0, 1.0) == 1);
+    BOOST_CHECK(placer.splitByArea(r1, 1.0, 0.0) == r1.m_gatesInRegion.size() - 1);
+
+    // a full placement in density mode is legal
+    ChipDB::Netlist placed;
+    ChipDB::Floorplan placedFloorplan;
+    createBlockedCore(placed, placedFloorplan, numCells, numRows, rowWidth);
+
+    LunaCore::CellPlacer2::Placer densityPlacer;
+    densityPlacer.setCutMode(LunaCore::CellPlacer2::Placer::CutMode::DENSITY);
+    BOOST_REQUIRE(densityPlacer.place(placed, placedFloorplan, 6, 4));
+    BOOST_CHECK(Helpers::isLegal(placed, numRows, rowWidth));
+}
+
+BOOST_AUTO_TEST_CASE(check_thread_count)
+{
+    std::cout << "--== CHECK CELLPLACER2 THREAD COUNT ==--\n";
+
+    const std::size_t numRows = 20;
+    const ChipDB::CoordType rowWidth = 80000;
+    const std::size_t numCells = 500;
+
+    ChipDB::Floorplan floorplan;
+    floorplan.setCoreSize(ChipDB::Size64{rowWidth, static_cast<ChipDB::CoordType>(numRows)*c_rowHeight});
+    Helpers::createRows(floorplan, numRows, rowWidth);
+
+    // the level schedule must not depend on the number of threads,
+    // nor on how the work happens to be scheduled.
+    const std::array<std::size_t, 5> threadCounts = {1, 2, 4, 0, 4};
+    std::array<ChipDB::Netlist, 5> netlists;
+    for(std::size_t idx = 0; idx < netlists.size(); idx++)
+    {
+        createChainNetlist(netlists.at(idx), numCells, numRows, rowWidth);
+
+        LunaCore::CellPlacer2::Placer placer;
+        placer.setSchedule(LunaCore::CellPlacer2::Placer::Schedule::LEVEL);
+        placer.setThreadCount(threadCounts.at(idx));
+        BOOST_REQUIRE(placer.place(netlists.at(idx), floorplan, 6, 10));
+        BOOST_CHECK(Helpers::isLegal(netlists.at(idx), numRows, rowWidth));
+    }
+
+    for(std::size_t idx = 1; idx < netlists.size(); idx++)
+    {
+        for(auto insKp : netlists.at(0).m_instances)
+        {
+            auto otherKp = netlists.at(idx).m_instances[insKp->name()];
+            BOOST_REQUIRE(otherKp.isValid());
+            BOOST_CHECK((insKp->m_pos == otherKp->m_pos));
+        }
+    }
+
+    // neither does the region schedule
+    std::array<ChipDB::Netlist, 2> sequential;
+    for(std::size_t idx = 0; idx < sequential.size(); idx++)
+    {
+        createChainNetlist(sequential.at(idx), numCells, numRows, rowWidth);
+
+        LunaCore::CellPlacer2::Placer placer;
+        placer.setThreadCount((idx == 0) ? 1 : 4);
+        BOOST_REQUIRE(placer.place(sequential.at(idx), floorplan, 6, 10));
+        BOOST_CHECK(Helpers::isLegal(sequential.at(idx), numRows, rowWidth));
+    }
+
+    for(auto insKp : sequential.at(0).m_instances)
+    {
+        auto otherKp = sequential.at(1).m_instances[insKp->name()];
+        BOOST_REQUIRE(otherKp.isValid());
+        BOOST_CHECK((insKp->m_pos == otherKp->m_pos));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_compact_netlist)
+{
+    std::cout << "--== CHECK CELLPLACER2 COMPACT NETLIST ==--\n";
+
+    auto cell = std::make_shared<ChipDB::Cell>("nand2");
+    cell->m_size = ChipDB::Coord64{1600, 10000};
+    auto pinA = cell->createPin("A");
+    auto pinB = cell->createPin("B");
+    auto pinY = cell->createPin("Y");
+    auto pinVDD = cell->createPin("VDD");
+    auto pinVSS = cell->createPin("VSS");
+    BOOST_REQUIRE(pinA.isValid() && pinB.isValid() && pinY.isValid() && pinVDD.isValid() && pinVSS.isValid());
+    pinVDD->m_iotype = ChipDB::IOType::POWER;
+    pinVSS->m_iotype = ChipDB::IOType::GROUND;
+
+    // a removed instance leaves a hole in the instance keys
+    ChipDB::Netlist netlist;
+    auto u0 = netlist.createInstance("u0", ChipDB::InstanceType::CELL, cell);
+    auto removed = netlist.createInstance("removed", ChipDB::InstanceType::CELL, cell);
+    auto u1 = netlist.createInstance("u1", ChipDB::InstanceType::CELL, cell);
+    auto u2 = netlist.createInstance("u2", ChipDB::InstanceType::CELL, cell);
+    auto t0 = netlist.createInstance("t0", ChipDB::InstanceType::CELL, cell);
+    BOOST_REQUIRE(u0.isValid() && removed.isValid() && u1.isValid() && u2.isValid() && t0.isValid());
+    const auto removedKey = removed.key();
+    BOOST_REQUIRE(netlist.m_instances.remove(removedKey));
+
+    t0->m_pos = ChipDB::Coord64{8000, 20000};
+    t0->m_placementInfo = ChipDB::PlacementInfo::PLACEDANDFIXED;
+
+    auto n0 = netlist.createNet("n0");
+    auto n1 = netlist.createNet("n1");
+    auto single = netlist.createNet("single");
+    auto vdd = netlist.createNet("vdd");
+    auto vss = netlist.createNet("vss");
+    BOOST_REQUIRE(n0.isValid() && n1.isValid() && single.isValid() && vdd.isValid() && vss.isValid());
+
+    BOOST_CHECK(netlist.connect(u0.key(), pinY.key(), n0.key()));
+    BOOST_CHECK(netlist.connect(u1.key(), pinA.key(), n0.key()));
+    BOOST_CHECK(netlist.connect(u2.key(), pinA.key(), n0.key()));
+    BOOST_CHECK(netlist.connect(u1.key(), pinY.key(), n1.key()));
+    BOOST_CHECK(netlist.connect(u2.key(), pinB.key(), n1.key()));
+    BOOST_CHECK(netlist.connect(t0.key(), pinA.key(), n1.key()));
+    BOOST_CHECK(netlist.connect(u2.key(), pinY.key(), single.key()));
+    for(auto insKey : {u0.key(), u1.key(), u2.key(), t0.key()})
+    {
+        BOOST_CHECK(netlist.connect(insKey, pinVDD.key(), vdd.key()));
+        BOOST_CHECK(netlist.connect(insKey, pinVSS.key(), vss.key()));
+    }
+
+    LunaCore::CellPlacer2::CompactNetlist compact;
+    compact.build(netlist);
+
+    // key <-> index round trip, the fixed instance is kept but marked
+    BOOST_REQUIRE(compact.gateCount() == 4);
+    for(LunaCore::CellPlacer2::GateIndex gate = 0; gate < compact.gateCount(); gate++)
+    {
+        BOOST_CHECK(compact.gateIndex(compact.gateId(gate)) == gate);
+        BOOST_CHECK(compact.isFixed(gate) == (compact.gateId(gate) == t0.key()));
+    }
+    BOOST_CHECK(compact.gateIndex(removedKey) == LunaCore::CellPlacer2::CompactNetlist::InvalidGate);
+    BOOST_CHECK(compact.gateIndex(1000) == LunaCore::CellPlacer2::CompactNetlist::InvalidGate);
+
+    const auto g0 = compact.gateIndex(u0.key());
+    const auto g1 = compact.gateIndex(u1.key());
+    const auto g2 = compact.gateIndex(u2.key());
+    const auto gt = compact.gateIndex(t0.key());
+
+    BOOST_CHECK(compact.m_x.at(gt) == 8800.0f);
+    BOOST_CHECK(compact.m_y.at(gt) == 25000.0f);
+    BOOST_CHECK(compact.m_area.at(gt) == 1600.0*10000.0);
+
+    // only n0 and n1 remain: the power nets only connect power pins
+    // and the single net has one connection.
+    BOOST_REQUIRE(compact.netCount() == 2);
+
+    auto sorted = [](auto span)
+    {
+        std::vector<uint32_t> items(span.begin(), span.end());
+        std::sort(items.begin(), items.end());
+        return items;
+    };
+
+    auto const net0 = compact.gateNets(g0).front();
+    BOOST_CHECK(compact.gateNets(g0).size() == 1);
+    BOOST_CHECK((sorted(compact.netGates(net0)) == sorted(std::vector<uint32_t>{g0, g1, g2})));
+    BOOST_CHECK_CLOSE(compact.netWeight(net0), 0.5f, 1.0e-4f);
+
+    auto const net1 = compact.gateNets(gt).front();
+    BOOST_CHECK(net1 != net0);
+    BOOST_CHECK(compact.gateNets(gt).size() == 1);
+    BOOST_CHECK((sorted(compact.netGates(net1)) == sorted(std::vector<uint32_t>{g1, g2, gt})));
+
+    // the net -> gate and gate -> net adjacencies agree
+    BOOST_CHECK((sorted(compact.gateNets(g1)) == sorted(std::vector<uint32_t>{net0, net1})));
+    BOOST_CHECK((sorted(compact.gateNets(g2)) == sorted(std::vector<uint32_t>{net0, net1})));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
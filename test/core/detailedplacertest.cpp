@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "lunacore.h"
+#include "testhelpers.h"
+
+#include <string>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(DetailedPlacerTest)
+
+using Helpers::c_rowHeight;
+using Helpers::c_siteWidth;
+
+BOOST_AUTO_TEST_CASE(check_detailed_placement)
+{
+    std::cout << "--== CHECK DETAILED PLACER ==--\n";
+
+    const std::size_t numRows = 30;
+    const ChipDB::CoordType rowWidth = 100000;
+
+    ChipDB::Floorplan floorplan;
+    Helpers::createRows(floorplan, numRows, rowWidth);
+
+    auto macroCell = std::make_shared<ChipDB::Cell>("macro");
+    macroCell->m_size = ChipDB::Coord64{20000, 50000};
+
+    const auto cellTypes = Helpers::createCellTypes(3);
+
+    // a chain-like netlist, the cells connect to cells with a nearby index
+    // but start at random positions, so there is plenty to gain.
+    const std::size_t numCells = 1500;
+    std::array<ChipDB::Netlist, 2> netlists;
+    for(auto &netlist : netlists)
+    {
+        Helpers::Random random(11);
+
+        auto macroKp = netlist.createInstance("macro0", ChipDB::InstanceType::CELL, macroCell);
+        BOOST_REQUIRE(macroKp.isValid());
+        macroKp->m_pos = ChipDB::Coord64{40000, 100000};
+        macroKp->m_placementInfo = ChipDB::PlacementInfo::PLACEDANDFIXED;
+
+        std::vector<ChipDB::InstanceObjectKey> insKeys;
+        for(std::size_t idx = 0; idx < numCells; idx++)
+        {
+            auto insKp = netlist.createInstance("u" + std::to_string(idx), ChipDB::InstanceType::CELL,
+                cellTypes.at(idx % cellTypes.size()));
+            BOOST_REQUIRE(insKp.isValid());
+            insKp->m_pos = ChipDB::Coord64{random(rowWidth - 3*c_siteWidth), random((numRows-1)*c_rowHeight)};
+            insKp->m_placementInfo = ChipDB::PlacementInfo::PLACED;
+            insKeys.push_back(insKp.key());
+        }
+
+        for(std::size_t idx = 0; idx < numCells; idx++)
+        {
+            auto netKp = netlist.createNet("n" + std::to_string(idx));
+            BOOST_REQUIRE(netKp.isValid());
+            BOOST_CHECK(netlist.connect(insKeys.at(idx), 2, netKp.key()));
+
+            const auto sink1 = std::min(numCells-1, idx + 1);
+            const auto sink2 = std::min(numCells-1, idx + 1 + random(8));
+            BOOST_CHECK(netlist.connect(insKeys.at(sink1), 0, netKp.key()));
+            BOOST_CHECK(netlist.connect(insKeys.at(sink2), 1, netKp.key()));
+        }
+
+        LunaCore::Legalizer legalizer;
+        BOOST_REQUIRE(legalizer.legalize(floorplan, netlist));
+        BOOST_REQUIRE(Helpers::isLegal(netlist, numRows, rowWidth));
+    }
+
+    const auto legalHPWL = LunaCore::NetlistTools::calcHPWL(netlists.at(0));
+
+    LunaCore::DetailedPlacer placer;
+    LunaCore::DetailedPlacer::Parameters params;
+    params.m_threads = 1;
+    BOOST_CHECK(placer.place(floorplan, netlists.at(0), params));
+
+    params.m_threads = 0;
+    BOOST_CHECK(placer.place(floorplan, netlists.at(1), params));
+
+    const auto detailedHPWL = LunaCore::NetlistTools::calcHPWL(netlists.at(0));
+    std::cout << "HPWL legalized: " << legalHPWL << "  detailed: " << detailedHPWL << "\n";
+
+    BOOST_CHECK(Helpers::isLegal(netlists.at(0), numRows, rowWidth));
+    BOOST_CHECK(detailedHPWL < 0.95*legalHPWL);
+
+    // the result does not depend on the number of threads
+    for(auto insKp : netlists.at(0).m_instances)
+    {
+        auto otherKp = netlists.at(1).m_instances[insKp->name()];
+        BOOST_REQUIRE(otherKp.isValid());
+        BOOST_CHECK((insKp->m_pos == otherKp->m_pos));
+        BOOST_CHECK(insKp->m_orientation == otherKp->m_orientation);
+    }
+
+    // cells that are not legalized are refused
+    auto insKp = netlists.at(0).m_instances["u0"];
+    insKp->m_pos.m_y += c_rowHeight/2;
+    BOOST_CHECK(!placer.place(floorplan, netlists.at(0), params));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,236 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "lunacore.h"
+#include "testhelpers.h"
+
+#include <string>
+#include <array>
+#include <vector>
+#include <cmath>
+#include <numbers>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(EPlacerTest)
+
+using Helpers::c_rowHeight;
+using Helpers::c_siteWidth;
+
+BOOST_AUTO_TEST_CASE(check_transforms)
+{
+    std::cout << "--== CHECK EPLACER TRANSFORMS ==--\n";
+
+    const std::size_t n = 16;
+    LunaCore::EPlacer::Private::Transform transform(n);
+    LunaCore::EPlacer::Private::Transform::Scratch scratch;
+
+    std::vector<double> in(n);
+    for(std::size_t idx = 0; idx < n; idx++)
+    {
+        in[idx] = std::sin(0.7*static_cast<double>(idx*idx)) + 0.25*static_cast<double>(idx % 3);
+    }
+
+    std::vector<double> dct(n);
+    std::vector<double> cosSeries(n);
+    std::vector<double> sinSeries(n);
+    transform.dct(in.data(), dct.data(), scratch);
+    transform.cosSeries(in.data(), cosSeries.data(), scratch);
+    transform.sinSeries(in.data(), sinSeries.data(), scratch);
+
+    // compare with the sums
+    for(std::size_t k = 0; k < n; k++)
+    {
+        double dctSum = 0.0;
+        double cosSum = 0.0;
+        double sinSum = 0.0;
+        for(std::size_t m = 0; m < n; m++)
+        {
+            const double angle1 = std::numbers::pi*static_cast<double>(k*(2*m+1)) / static_cast<double>(2*n);
+            const double angle2 = std::numbers::pi*static_cast<double>(m*(2*k+1)) / static_cast<double>(2*n);
+            dctSum += in[m]*std::cos(angle1);
+            cosSum += in[m]*std::cos(angle2);
+            sinSum += in[m]*std::sin(angle2);
+        }
+
+        BOOST_CHECK_SMALL(dct[k] - dctSum, 1.0e-9);
+        BOOST_CHECK_SMALL(cosSeries[k] - cosSum, 1.0e-9);
+        BOOST_CHECK_SMALL(sinSeries[k] - sinSum, 1.0e-9);
+    }
+
+    // the field points away from a cluster of charges
+    LunaCore::EPlacer::Private::DensityGrid grid(ChipDB::Rect64{{0,0}, {160000, 160000}}, n);
+    std::vector<double> x;
+    std::vector<double> y;
+    for(std::size_t idx = 0; idx < 20; idx++)
+    {
+        grid.addCharge(10000, 10000, false);
+        x.push_back(80000);
+        y.push_back(80000);
+    }
+
+    grid.update(x, y, 1.0, nullptr);
+    BOOST_CHECK(grid.overflow() > 0.5);
+    BOOST_CHECK(grid.potential(8,8) > grid.potential(2,8));
+    BOOST_CHECK(grid.fieldX(12, 8) > 0.0);
+    BOOST_CHECK(grid.fieldX(4, 8) < 0.0);
+    BOOST_CHECK(grid.fieldY(8, 12) > 0.0);
+    BOOST_CHECK(grid.fieldY(8, 4) < 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(check_electrostatic_placement)
+{
+    std::cout << "--== CHECK EPLACER ==--\n";
+
+    const std::size_t numRows = 40;
+    const ChipDB::CoordType rowWidth = 160000;
+
+    ChipDB::Floorplan floorplan;
+    floorplan.setCoreSize(ChipDB::Size64{rowWidth, static_cast<ChipDB::CoordType>(numRows)*c_rowHeight});
+    Helpers::createRows(floorplan, numRows, rowWidth);
+
+    auto macroCell = std::make_shared<ChipDB::Cell>("macro");
+    macroCell->m_size = ChipDB::Coord64{24000, 60000};
+    std::ignore = macroCell->createPin("A");
+
+    const auto cellTypes = Helpers::createCellTypes(3, 2);
+
+    // a grid of cells, each connected to its right and upper neighbour,
+    // with the corners of the grid connected to fixed cells in the corners
+    // of the core. The wire length pulls the grid together, the density
+    // penalty has to spread it out.
+    const std::size_t gridSize = 30;
+    std::array<ChipDB::Netlist, 2> netlists;
+    for(auto &netlist : netlists)
+    {
+        auto macroKp = netlist.createInstance("macro0", ChipDB::InstanceType::CELL, macroCell);
+        BOOST_REQUIRE(macroKp.isValid());
+        macroKp->m_pos = ChipDB::Coord64{40000, 160000};
+        macroKp->m_placementInfo = ChipDB::PlacementInfo::PLACEDANDFIXED;
+
+        const std::array<ChipDB::Coord64, 4> corners =
+        {
+            ChipDB::Coord64{0, 0},
+            ChipDB::Coord64{rowWidth - 4*c_siteWidth, 0},
+            ChipDB::Coord64{0, static_cast<ChipDB::CoordType>(numRows-1)*c_rowHeight},
+            ChipDB::Coord64{rowWidth - 4*c_siteWidth, static_cast<ChipDB::CoordType>(numRows-1)*c_rowHeight}
+        };
+
+        std::vector<ChipDB::InstanceObjectKey> terminals;
+        for(std::size_t idx = 0; idx < corners.size(); idx++)
+        {
+            auto insKp = netlist.createInstance("t" + std::to_string(idx), ChipDB::InstanceType::CELL, cellTypes.at(2));
+            BOOST_REQUIRE(insKp.isValid());
+            insKp->m_pos = corners.at(idx);
+            insKp->m_placementInfo = ChipDB::PlacementInfo::PLACEDANDFIXED;
+            terminals.push_back(insKp.key());
+        }
+
+        std::vector<ChipDB::InstanceObjectKey> insKeys;
+        for(std::size_t idx = 0; idx < gridSize*gridSize; idx++)
+        {
+            auto insKp = netlist.createInstance("u" + std::to_string(idx), ChipDB::InstanceType::CELL,
+                cellTypes.at(idx % cellTypes.size()));
+            BOOST_REQUIRE(insKp.isValid());
+            insKp->m_placementInfo = ChipDB::PlacementInfo::PLACED;
+            insKeys.push_back(insKp.key());
+        }
+
+        for(std::size_t row = 0; row < gridSize; row++)
+        {
+            for(std::size_t col = 0; col < gridSize; col++)
+            {
+                const auto idx = row*gridSize + col;
+                auto netKp = netlist.createNet("n" + std::to_string(idx));
+                BOOST_REQUIRE(netKp.isValid());
+                BOOST_CHECK(netlist.connect(insKeys.at(idx), 2, netKp.key()));
+                if (col + 1 < gridSize) BOOST_CHECK(netlist.connect(insKeys.at(idx + 1), 0, netKp.key()));
+                if (row + 1 < gridSize) BOOST_CHECK(netlist.connect(insKeys.at(idx + gridSize), 1, netKp.key()));
+            }
+        }
+
+        const std::array<std::size_t, 4> cornerCells = {0, gridSize-1, gridSize*(gridSize-1), gridSize*gridSize-1};
+        for(std::size_t idx = 0; idx < cornerCells.size(); idx++)
+        {
+            auto netKp = netlist.createNet("corner" + std::to_string(idx));
+            BOOST_REQUIRE(netKp.isValid());
+            BOOST_CHECK(netlist.connect(terminals.at(idx), 2, netKp.key()));
+            BOOST_CHECK(netlist.connect(insKeys.at(cornerCells.at(idx)), 0, netKp.key()));
+        }
+    }
+
+    std::size_t callbacks = 0;
+    LunaCore::EPlacer::Parameters params;
+    params.m_threads = 1;
+    BOOST_REQUIRE(LunaCore::EPlacer::place(floorplan, netlists.at(0), params,
+        [&callbacks](const LunaCore::QPlacer::PlacerNetlist &) { callbacks++; }));
+
+    params.m_threads = 0;
+    BOOST_REQUIRE(LunaCore::EPlacer::place(floorplan, netlists.at(1), params, nullptr));
+
+    BOOST_CHECK(callbacks > 0);
+    BOOST_CHECK(callbacks < params.m_maxIterations);
+    BOOST_CHECK(Helpers::isLegal(netlists.at(0), numRows, rowWidth));
+
+    // the grid packed at the target density has about 10000 nm per net,
+    // spread over the whole core it has twice that.
+    const auto hpwl = LunaCore::NetlistTools::calcHPWL(netlists.at(0));
+    const auto nets = static_cast<double>(netlists.at(0).m_nets.size());
+    std::cout << "HPWL: " << hpwl << "  per net: " << hpwl / nets << "\n";
+    BOOST_CHECK(hpwl / nets < 14000.0);
+
+    // the result does not depend on the number of threads
+    for(auto insKp : netlists.at(0).m_instances)
+    {
+        auto otherKp = netlists.at(1).m_instances[insKp->name()];
+        BOOST_REQUIRE(otherKp.isValid());
+        BOOST_CHECK((insKp->m_pos == otherKp->m_pos));
+    }
+
+    // the number of bins must be a power of two
+    params.m_bins = 24;
+    BOOST_CHECK(!LunaCore::EPlacer::place(floorplan, netlists.at(0), params, nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(check_place_pass)
+{
+    std::cout << "--== CHECK PLACE -CORE ==--\n";
+
+    const std::size_t numRows = 10;
+    const ChipDB::CoordType rowWidth = 40000;
+
+    LunaCore::Database db;
+    db.m_design.m_floorplan->setCoreSize(ChipDB::Size64{rowWidth, static_cast<ChipDB::CoordType>(numRows)*c_rowHeight});
+    Helpers::createRows(*db.m_design.m_floorplan, numRows, rowWidth);
+
+    auto modKp = db.m_design.m_moduleLib->createModule("top");
+    BOOST_REQUIRE(modKp.isValid());
+    BOOST_REQUIRE(db.m_design.setTopModule("top"));
+
+    // a chain of cells
+    const auto cellTypes = Helpers::createCellTypes(3);
+    auto &netlist = *modKp->m_netlist;
+    const std::size_t numCells = 200;
+    for(std::size_t idx = 0; idx < numCells; idx++)
+    {
+        auto insKp = netlist.createInstance("u" + std::to_string(idx), ChipDB::InstanceType::CELL,
+            cellTypes.at(idx % cellTypes.size()));
+        BOOST_REQUIRE(insKp.isValid());
+        insKp->m_placementInfo = ChipDB::PlacementInfo::PLACED;
+
+        if (idx > 0)
+        {
+            auto netKp = netlist.createNet("n" + std::to_string(idx));
+            BOOST_REQUIRE(netKp.isValid());
+            BOOST_CHECK(netlist.connect(netlist.m_instances["u" + std::to_string(idx-1)].key(), 2, netKp.key()));
+            BOOST_CHECK(netlist.connect(insKp.key(), 0, netKp.key()));
+        }
+    }
+
+    LunaCore::Passes::registerAllPasses();
+    BOOST_REQUIRE(LunaCore::Passes::run(db, "place -core"));
+    BOOST_CHECK(Helpers::isLegal(netlist, numRows, rowWidth));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -38,5 +38,133 @@ BOOST_AUTO_TEST_CASE(check_grid)
     BOOST_CHECK(!grid.at(-1,-1).isValid());
 }
 
+BOOST_AUTO_TEST_CASE(check_grid_clear)
+{
+    std::cout << "--== CHECK GLOBAL ROUTER GRID CLEAR ==--\n";
+
+    LunaCore::GlobalRouter::Grid grid(20,10,{1,1});
+
+    grid.at(3,4).setReached();
+    grid.at(3,4).setBlocked();
+    grid.at(3,4).setCost(5);
+    grid.at(5,6).setMark();
+    grid.at(5,6).m_capacity = 7;
+
+    // clearing the reached flags keeps the other flags
+    grid.clearReachedAndResetCost();
+    BOOST_CHECK(!grid.at(3,4).isReached());
+    BOOST_CHECK(grid.at(3,4).isBlocked());
+    BOOST_CHECK(grid.at(3,4).cost() == std::numeric_limits<LunaCore::GlobalRouter::PathCostType>::max());
+    BOOST_CHECK(grid.at(5,6).isMarked());
+
+    // a cell that is reached after a clear keeps its state
+    grid.at(3,4).setReached();
+    grid.at(3,4).setCost(9);
+    BOOST_CHECK(grid.at(3,4).isReached());
+    BOOST_CHECK(grid.at(3,4).cost() == 9);
+
+    // a cell that wasn't accessed in between
+    // two clears is reset by both of them.
+    grid.clearReachedAndResetCost();
+    grid.clearAllFlagsAndResetCost();
+    grid.clearReachedAndResetCost();
+
+    for(auto const& cell : grid.gcells())
+    {
+        BOOST_CHECK(!cell.isBlocked());
+        BOOST_CHECK(!cell.isMarked());
+        BOOST_CHECK(!cell.isReached());
+    }
+
+    // capacity is not reset
+    BOOST_CHECK(grid.at(5,6).m_capacity == 7);
+}
+
+BOOST_AUTO_TEST_CASE(check_congestion_report)
+{
+    std::cout << "--== CHECK GLOBAL ROUTER CONGESTION REPORT ==--\n";
+
+    LunaCore::GlobalRouter::Grid grid(4,3,{1,1});
+    grid.setMaxCellCapacity(4);
+
+    grid.at(0,0).m_capacity = 2;
+    grid.at(1,0).m_capacity = 4;
+    grid.at(2,1).m_capacity = 7;
+    grid.at(3,2).setBlocked();
+
+    auto stats = LunaCore::GlobalRouter::calcCongestion(grid);
+    BOOST_CHECK(stats.m_cells == 12);
+    BOOST_CHECK(stats.m_blockedCells == 1);
+    BOOST_CHECK(stats.m_usedCells == 3);
+    BOOST_CHECK(stats.m_overflowCells == 1);
+    BOOST_CHECK(stats.m_totalOverflow == 3);
+    BOOST_CHECK(stats.m_maxUsage == 7);
+    BOOST_CHECK_CLOSE(stats.m_averageUtilisation, (13.0/4.0)/11.0, 1e-6);
+
+    std::stringstream csv;
+    BOOST_CHECK(LunaCore::GlobalRouter::writeCongestionCSV(csv, grid));
+
+    std::vector<std::string> lines;
+    std::string line;
+    while(std::getline(csv, line))
+    {
+        lines.push_back(line);
+    }
+
+    BOOST_REQUIRE(lines.size() == 13);
+    BOOST_CHECK(lines.at(0) == "x,y,usage,capacity,blocked");
+    BOOST_CHECK(lines.at(1) == "0,0,2,4,0");
+    BOOST_CHECK(lines.at(7) == "2,1,7,4,0");
+    BOOST_CHECK(lines.at(12) == "3,2,0,4,1");
+
+    std::stringstream svg;
+    BOOST_CHECK(LunaCore::GlobalRouter::writeCongestionSVG(svg, grid));
+    auto svgText = svg.str();
+    BOOST_CHECK(std::count(svgText.begin(), svgText.end(), '\n') == 14);
+}
+
+
+BOOST_AUTO_TEST_CASE(check_wavefront)
+{
+    std::cout << "--== CHECK GLOBAL ROUTER WAVEFRONT ==--\n";
+
+    // items must come out in cost order, also when
+    // new items are pushed in between.
+    LunaCore::GlobalRouter::Wavefront wavefront;
+    LunaCore::GlobalRouter::PathCostType lastCost = 0;
+    uint32_t seed = 1;
+    std::size_t popped = 0;
+
+    for(int idx=0; idx<1000; idx++)
+    {
+        seed = seed*1103515245 + 12345;
+        LunaCore::GlobalRouter::WavefrontItem item;
+        item.m_pathCost = lastCost + (seed >> 16) % 1000;
+        wavefront.push(item);
+
+        if ((idx % 3) == 2)
+        {
+            auto const cost = wavefront.getLowestCostItem().m_pathCost;
+            BOOST_CHECK(cost >= lastCost);
+            lastCost = cost;
+            wavefront.pop();
+            popped++;
+        }
+    }
+
+    while(!wavefront.empty())
+    {
+        auto const cost = wavefront.getLowestCostItem().m_pathCost;
+        BOOST_CHECK(cost >= lastCost);
+        lastCost = cost;
+        wavefront.pop();
+        popped++;
+    }
+
+    BOOST_CHECK(popped == 1000);
+
+    wavefront.clear();
+    BOOST_CHECK(wavefront.empty());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
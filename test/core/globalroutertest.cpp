@@ -426,5 +426,345 @@ BOOST_AUTO_TEST_CASE(global_router_parallel_routes)
     BOOST_CHECK(tree2->size() == 2);
 }
 
+BOOST_AUTO_TEST_CASE(global_router_search_margin)
+{
+    std::cout << "--== CHECK GLOBAL ROUTER (search margin) ==--\n";
+
+    TestableRouter router;
+    router.createGrid(100,100,{1,1}, 100);
+    BOOST_REQUIRE(router.grid() != nullptr);
+    router.setSearchMargin(2);
+
+    // a wall with a single gap far outside the
+    // initial search box of the route.
+    for(int x=0; x<95; x++)
+    {
+        router.setBlockage({x,50});
+    }
+
+    auto route = router.routeTwoPointRoute({10,40},{10,60});
+    BOOST_REQUIRE(route);
+
+    bool usesGap = false;
+    for(int x=95; x<100; x++)
+    {
+        usesGap |= router.at({x,50}).isMarked();
+    }
+    BOOST_CHECK(usesGap);
+    BOOST_CHECK(router.searchMargin() == 2);
+
+    // close the gap, the route is now impossible
+    for(int x=95; x<100; x++)
+    {
+        router.setBlockage({x,50});
+    }
+
+    BOOST_CHECK(!router.routeTwoPointRoute({20,40},{20,60}));
+}
+
+BOOST_AUTO_TEST_CASE(global_router_astar)
+{
+    std::cout << "--== CHECK GLOBAL ROUTER (A* search) ==--\n";
+
+    // a wall between source and target with a gap at the top.
+    // the shortest route climbs over the wall: 30 cells
+    // horizontally and 2*11 cells vertically.
+    auto countMarked = [](const TestableRouter &router)
+    {
+        std::size_t marked = 0;
+        for(auto const& cell : router.grid()->gcells())
+        {
+            if (cell.isMarked()) marked++;
+        }
+        return marked;
+    };
+
+    auto route = [&](TestableRouter &router, LunaCore::GlobalRouter::Router::SearchMode mode)
+    {
+        router.createGrid(40,40,{1,1}, 100);
+        router.setSearchMode(mode);
+        for(int y=0; y<31; y++)
+        {
+            router.setBlockage({20,y});
+        }
+        return router.routeTwoPointRoute({5,20},{35,20});
+    };
+
+    TestableRouter astarRouter;
+    BOOST_CHECK(astarRouter.searchMode() == LunaCore::GlobalRouter::Router::SearchMode::AStar);
+    BOOST_REQUIRE(route(astarRouter, LunaCore::GlobalRouter::Router::SearchMode::AStar));
+    BOOST_CHECK(countMarked(astarRouter) == 30 + 2*11 + 1);
+
+    TestableRouter directedRouter;
+    BOOST_REQUIRE(route(directedRouter, LunaCore::GlobalRouter::Router::SearchMode::Directed));
+    BOOST_CHECK(countMarked(directedRouter) >= 30 + 2*11 + 1);
+}
+
+BOOST_AUTO_TEST_CASE(global_router_negotiated_congestion)
+{
+    std::cout << "--== CHECK GLOBAL ROUTER (negotiated congestion) ==--\n";
+
+    // a wall at x=10 with five single-cell gaps. the first routes
+    // of neighbouring nets share gaps, negotiation must give each
+    // net its own gap.
+    LunaCore::GlobalRouter::Router router;
+    router.createGrid(20,20,{1,1}, 1);
+    for(int y=0; y<20; y++)
+    {
+        if ((y % 3) != 0) router.setBlockage({10,y});
+    }
+
+    std::vector<std::vector<ChipDB::Coord64>> nets;
+    for(int y=5; y<15; y+=2)
+    {
+        nets.push_back({{0,y}, {19,y}});
+    }
+
+    LunaCore::GlobalRouter::PathFinder::Parameters params;
+    params.m_threads = 1;
+
+    auto result = router.routeNets(nets, params);
+    BOOST_REQUIRE(result);
+    BOOST_CHECK(result->success());
+    BOOST_CHECK(result->m_iterations > 1);
+    BOOST_CHECK(result->m_routes.size() == nets.size());
+
+    for(auto const& route : result->m_routes)
+    {
+        BOOST_CHECK(route.size() > 0);
+    }
+
+    for(auto const& cell : router.grid()->gcells())
+    {
+        BOOST_CHECK(cell.m_capacity <= 1);
+        if (cell.isBlocked())
+        {
+            BOOST_CHECK(cell.m_capacity == 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(global_router_negotiated_congestion_threads)
+{
+    std::cout << "--== CHECK GLOBAL ROUTER (negotiated congestion, threads) ==--\n";
+
+    // 8x8 tiles, each with a wall that has three gaps
+    // and three nets that all want the middle gap.
+    std::vector<std::vector<ChipDB::Coord64>> nets;
+    for(int ty=0; ty<8; ty++)
+    {
+        for(int tx=0; tx<8; tx++)
+        {
+            for(int n=0; n<3; n++)
+            {
+                nets.push_back({{tx*32 + 4, ty*32 + 15 + n}, {tx*32 + 27, ty*32 + 15 + n}});
+            }
+        }
+    }
+
+    auto route = [&nets](std::size_t threads, LunaCore::GlobalRouter::Router &router)
+    {
+        router.createGrid(256,256,{1,1}, 1);
+        for(int ty=0; ty<8; ty++)
+        {
+            for(int tx=0; tx<8; tx++)
+            {
+                for(int y=2; y<30; y++)
+                {
+                    if ((y != 12) && (y != 16) && (y != 20)) router.setBlockage({tx*32 + 16, ty*32 + y});
+                }
+            }
+        }
+
+        LunaCore::GlobalRouter::PathFinder::Parameters params;
+        params.m_threads = threads;
+        return router.routeNets(nets, params);
+    };
+
+    LunaCore::GlobalRouter::Router router1;
+    auto result1 = route(1, router1);
+
+    LunaCore::GlobalRouter::Router router4;
+    auto result4 = route(4, router4);
+
+    BOOST_REQUIRE(result1);
+    BOOST_REQUIRE(result4);
+    BOOST_CHECK(result1->success());
+    BOOST_CHECK(result4->success());
+
+    // the result must not depend on the number of threads
+    BOOST_CHECK(result4->m_iterations == result1->m_iterations);
+    BOOST_CHECK(result4->m_wirelength == result1->m_wirelength);
+
+    auto const& gcells1 = router1.grid()->gcells();
+    auto const& gcells4 = router4.grid()->gcells();
+    BOOST_REQUIRE(gcells1.size() == gcells4.size());
+
+    bool sameUsage = true;
+    for(std::size_t idx = 0; idx < gcells1.size(); idx++)
+    {
+        sameUsage = sameUsage && (gcells1.at(idx).m_capacity == gcells4.at(idx).m_capacity);
+    }
+    BOOST_CHECK(sameUsage);
+}
+
+BOOST_AUTO_TEST_CASE(global_router_layer_assignment)
+{
+    std::cout << "--== CHECK GLOBAL ROUTER (layer assignment) ==--\n";
+
+    ChipDB::TechLib techLib;
+    auto addLayer = [&techLib](const std::string &name, ChipDB::LayerType type,
+        ChipDB::LayerDirection dir, ChipDB::CoordType pitch)
+    {
+        auto layer = techLib.createLayer(name);
+        layer->m_type  = type;
+        layer->m_dir   = dir;
+        layer->m_pitch = {pitch, pitch};
+    };
+
+    addLayer("metal1", ChipDB::LayerType::ROUTING, ChipDB::LayerDirection::HORIZONTAL, 200);
+    addLayer("via1",   ChipDB::LayerType::CUT,     ChipDB::LayerDirection::UNDEFINED, 0);
+    addLayer("metal2", ChipDB::LayerType::ROUTING, ChipDB::LayerDirection::VERTICAL, 200);
+    addLayer("via2",   ChipDB::LayerType::CUT,     ChipDB::LayerDirection::UNDEFINED, 0);
+    addLayer("metal3", ChipDB::LayerType::ROUTING, ChipDB::LayerDirection::HORIZONTAL, 400);
+
+    auto layers = LunaCore::GlobalRouter::LayerGrid::routingLayers(techLib, {1000,1000});
+    BOOST_REQUIRE(layers.size() == 3);
+    BOOST_CHECK(layers.at(0).m_horizontal  && (layers.at(0).m_capacity == 5));
+    BOOST_CHECK(!layers.at(1).m_horizontal && (layers.at(1).m_capacity == 5));
+    BOOST_CHECK(layers.at(2).m_horizontal  && (layers.at(2).m_capacity == 2));
+
+    // six parallel horizontal nets don't fit on metal1
+    // and one L-shaped net that needs metal2.
+    std::vector<std::vector<ChipDB::Coord64>> nets;
+    for(int n=0; n<6; n++)
+    {
+        nets.push_back({{1500, 5500}, {18500, 5500}});
+    }
+    nets.push_back({{1500, 12500}, {15500, 18500}});
+
+    LunaCore::GlobalRouter::Router router;
+    router.createGrid(20,20,{1000,1000}, 10);
+
+    LunaCore::GlobalRouter::PathFinder::Parameters params;
+    params.m_threads = 1;
+    auto routeResult = router.routeNets(nets, params);
+    BOOST_REQUIRE(routeResult);
+    BOOST_REQUIRE(routeResult->success());
+
+    LunaCore::GlobalRouter::LayerAssigner::Parameters layerParams;
+    auto layerResult = router.assignLayers(techLib, routeResult->m_routes, layerParams);
+    BOOST_REQUIRE(layerResult);
+    BOOST_REQUIRE(router.layerGrid() != nullptr);
+    BOOST_CHECK(router.layerGrid()->layerCount() == 3);
+    BOOST_CHECK(layerResult->m_unassignedNets == 0);
+    BOOST_CHECK(layerResult->m_totalOverflow == 0);
+    BOOST_CHECK(layerResult->m_vias > 0);
+
+    // segments must be on a layer with their direction
+    std::size_t metal3Nets = 0;
+    for(std::size_t net = 0; net < nets.size(); net++)
+    {
+        auto const& route  = routeResult->m_routes.at(net);
+        auto const& layers = layerResult->m_layers.at(net);
+        BOOST_REQUIRE(layers.size() == route.size());
+
+        std::size_t segIdx = 0;
+        for(auto segment : route)
+        {
+            auto const layer = layers.at(segIdx++);
+            if (segment->m_length > 1)
+            {
+                const bool horizontal = (segment->m_dir == LunaCore::GlobalRouter::Direction::East) ||
+                    (segment->m_dir == LunaCore::GlobalRouter::Direction::West);
+                BOOST_CHECK(router.layerGrid()->layer(layer).m_horizontal == horizontal);
+            }
+            if ((net < 6) && (layer == 2)) metal3Nets++;
+        }
+    }
+
+    BOOST_CHECK(metal3Nets == 1);
+    BOOST_CHECK(router.layerGrid()->edgeUsage(0, 10, 5) == 5);
+    BOOST_CHECK(router.layerGrid()->edgeUsage(2, 10, 5) == 1);
+}
+
+BOOST_AUTO_TEST_CASE(global_router_net_route)
+{
+    std::cout << "--== CHECK GLOBAL ROUTER (net route topology) ==--\n";
+
+    ChipDB::TechLib techLib;
+    auto addLayer = [&techLib](const std::string &name, ChipDB::LayerDirection dir)
+    {
+        auto layer = techLib.createLayer(name);
+        layer->m_type  = ChipDB::LayerType::ROUTING;
+        layer->m_dir   = dir;
+        layer->m_pitch = {200, 200};
+    };
+
+    addLayer("metal1", ChipDB::LayerDirection::HORIZONTAL);
+    addLayer("metal2", ChipDB::LayerDirection::VERTICAL);
+
+    // a net with three terminals, the third one in the middle of
+    // the straight connection between the first two.
+    std::vector<std::vector<ChipDB::Coord64>> nets;
+    nets.push_back({{1500, 1500}, {15500, 1500}, {8500, 12500}, {8500, 1500}});
+
+    LunaCore::GlobalRouter::Router router;
+    router.createGrid(20,20,{1000,1000}, 10);
+
+    LunaCore::GlobalRouter::PathFinder::Parameters params;
+    params.m_threads = 1;
+    auto routeResult = router.routeNets(nets, params);
+    BOOST_REQUIRE(routeResult);
+    BOOST_REQUIRE(routeResult->success());
+
+    LunaCore::GlobalRouter::LayerAssigner::Parameters layerParams;
+    auto layerResult = router.assignLayers(techLib, routeResult->m_routes, layerParams);
+    BOOST_REQUIRE(layerResult);
+
+    auto netRoute = router.createNetRoute(routeResult->m_routes.at(0), nets.at(0), layerResult->m_layers.at(0));
+
+    // the terminals are at the centres of their GCells
+    BOOST_REQUIRE(netRoute.m_terminals.size() == 4);
+    BOOST_CHECK(netRoute.m_terminals.at(0) == ChipDB::Coord64(1500, 1500));
+    BOOST_CHECK(netRoute.m_terminals.at(3) == ChipDB::Coord64(8500, 1500));
+
+    // the route is a tree with the first terminal as root
+    BOOST_REQUIRE(!netRoute.m_segments.empty());
+    BOOST_CHECK(netRoute.length() == (routeResult->m_wirelength - 1) * 1000);
+
+    for(std::size_t idx = 0; idx < netRoute.m_segments.size(); idx++)
+    {
+        auto const& segment = netRoute.m_segments.at(idx);
+        BOOST_CHECK(segment.length() > 0);
+        BOOST_CHECK((segment.m_start.m_x == segment.m_end.m_x) || (segment.m_start.m_y == segment.m_end.m_y));
+        BOOST_CHECK(segment.m_parent < static_cast<int32_t>(idx));
+
+        if (segment.m_parent < 0)
+        {
+            BOOST_CHECK(segment.m_start == netRoute.m_terminals.at(0));
+        }
+        else
+        {
+            BOOST_CHECK(segment.m_start == netRoute.m_segments.at(segment.m_parent).m_end);
+        }
+
+        auto layer = techLib.lookupLayer(segment.m_layer);
+        BOOST_REQUIRE(layer);
+        BOOST_CHECK((layer->m_dir == ChipDB::LayerDirection::HORIZONTAL) == segment.isHorizontal());
+    }
+
+    // every terminal is the end point of a segment
+    for(auto const& terminal : netRoute.m_terminals)
+    {
+        auto iter = std::find_if(netRoute.m_segments.begin(), netRoute.m_segments.end(),
+            [&terminal](auto const& segment)
+            {
+                return (segment.m_start == terminal) || (segment.m_end == terminal);
+            }
+        );
+        BOOST_CHECK(iter != netRoute.m_segments.end());
+    }
+}
 
 BOOST_AUTO_TEST_SUITE_END()
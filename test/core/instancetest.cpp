@@ -80,4 +80,86 @@ BOOST_AUTO_TEST_CASE(various_instance_tests)
     BOOST_CHECK(insPtr->getPin(0).netKey() == 123);   // lookup by id for good measure
 }
 
+BOOST_AUTO_TEST_CASE(netlist_owned_instances)
+{
+    std::cout << "--== NETLIST OWNED INSTANCE TEST ==--\n";
+
+    auto cell = std::make_shared<ChipDB::Cell>("inv");
+    cell->createPin("A");
+    cell->createPin("Y");
+
+    ChipDB::Netlist netlist;
+
+    const std::size_t N = 1000;
+    for(std::size_t idx=0; idx<N; idx++)
+    {
+        auto insKp = netlist.createInstance("u" + std::to_string(idx), ChipDB::InstanceType::CELL, cell);
+        BOOST_REQUIRE(insKp.isValid());
+        BOOST_CHECK(insKp.key() == static_cast<ChipDB::ObjectKey>(idx));
+    }
+
+    BOOST_CHECK(!netlist.createInstance("u0", ChipDB::InstanceType::CELL, cell).isValid());
+    BOOST_CHECK(!netlist.createInstance("", ChipDB::InstanceType::CELL, cell).isValid());
+    BOOST_CHECK(!netlist.createInstance("nocell", ChipDB::InstanceType::CELL, nullptr).isValid());
+    BOOST_CHECK(netlist.m_instances.size() == N);
+
+    auto netKp = netlist.createNet("n1");
+    BOOST_REQUIRE(netKp.isValid());
+    BOOST_CHECK(netlist.connect("u10", "Y", "n1"));
+    BOOST_CHECK(netlist.connect("u11", "A", "n1"));
+
+    auto pin = netlist.lookupInstance("u10")->getPin("Y");
+    BOOST_CHECK(pin.isValid());
+    BOOST_CHECK(pin.netKey() == netKp.key());
+    BOOST_CHECK(pin.name() == "Y");
+    BOOST_CHECK(pin.m_pinInfo == cell->m_pins["Y"].rawPtr());
+
+    // removed instances stay valid while they are referenced
+    auto removedIns = netlist.lookupInstance("u10").ptr();
+    std::size_t count = 0;
+    for(std::size_t idx=0; idx<N; idx += 2)
+    {
+        BOOST_CHECK(netlist.m_instances.remove("u" + std::to_string(idx)));
+    }
+
+    for(auto insKp : netlist.m_instances)
+    {
+        BOOST_CHECK(insKp->name() == "u" + std::to_string(insKp.key()));
+        BOOST_CHECK(insKp->getNumberOfPins() == 2);
+        count++;
+    }
+    BOOST_CHECK(count == N/2);
+    BOOST_CHECK(removedIns->name() == "u10");
+    BOOST_CHECK(removedIns->getPin("Y").netKey() == netKp.key());
+
+    auto insKp = netlist.createInstance("u0", ChipDB::InstanceType::CELL, cell);
+    BOOST_REQUIRE(insKp.isValid());
+    BOOST_CHECK(insKp.key() == static_cast<ChipDB::ObjectKey>(N));
+    BOOST_CHECK(netlist.lookupInstance("u11")->getPin("A").netKey() == netKp.key());
+
+    // so do the instances and nets of a cleared or destroyed netlist
+    auto keptIns = netlist.lookupInstance("u11").ptr();
+    auto keptNet = netKp.ptr();
+    netlist.clear();
+    BOOST_CHECK(netlist.m_instances.size() == 0);
+    BOOST_CHECK(netlist.m_nets.size() == 0);
+    BOOST_CHECK(netlist.createInstance("u0", ChipDB::InstanceType::CELL, cell).isValid());
+
+    {
+        auto otherNetlist = std::make_unique<ChipDB::Netlist>();
+        auto otherKp = otherNetlist->createInstance("v0", ChipDB::InstanceType::CELL, cell);
+        BOOST_REQUIRE(otherKp.isValid());
+        BOOST_REQUIRE(otherNetlist->createNet("n2").isValid());
+        BOOST_CHECK(otherNetlist->connect("v0", "A", "n2"));
+        auto otherIns = otherKp.ptr();
+        otherNetlist.reset();
+        BOOST_CHECK(otherIns->name() == "v0");
+        BOOST_CHECK(otherIns->getPin("A").isValid());
+    }
+
+    BOOST_CHECK(keptIns->name() == "u11");
+    BOOST_CHECK(keptIns->getPin("A").netKey() == netKp.key());
+    BOOST_CHECK(keptNet->name() == "n1");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -214,4 +214,43 @@ BOOST_AUTO_TEST_CASE(can_read_lef4)
     std::cout << "== END IHP130 ==\n\n";
 }
 
+BOOST_AUTO_TEST_CASE(can_load_lef_files_concurrently)
+{
+    std::cout << "--== LEF READER CONCURRENT ==--\n";
+
+    const std::vector<std::string> filenames =
+    {
+        "test/files/iit_stdcells_extra/fake_ties018.lef",
+        "test/files/iit_stdcells_extra/fake_pad_fillers35.lef"
+    };
+
+    ChipDB::Design serialDesign;
+    for(auto const& filename : filenames)
+    {
+        std::ifstream leffile(filename);
+        BOOST_REQUIRE(leffile.good());
+        BOOST_REQUIRE(ChipDB::LEF::Reader::load(serialDesign, leffile));
+    }
+
+    ChipDB::Design design;
+    BOOST_REQUIRE(ChipDB::LEF::Reader::loadFiles(design, filenames));
+
+    // the cells are added in file order
+    BOOST_REQUIRE(design.m_cellLib->size() == serialDesign.m_cellLib->size());
+    BOOST_CHECK(design.m_cellLib->lookupCell("TIEHI").isValid());
+    BOOST_CHECK(design.m_cellLib->lookupCell("PADNC50").isValid());
+
+    for(auto const cellKeyObjPair : *serialDesign.m_cellLib)
+    {
+        auto cell = design.m_cellLib->lookupCell(cellKeyObjPair->name());
+        BOOST_REQUIRE(cell.isValid());
+        BOOST_CHECK(cell.key() == cellKeyObjPair.key());
+        BOOST_CHECK(cell->m_size == cellKeyObjPair->m_size);
+        BOOST_CHECK(cell->m_pins.size() == cellKeyObjPair->m_pins.size());
+    }
+
+    // a missing file is an error
+    BOOST_CHECK(!ChipDB::LEF::Reader::loadFiles(design, {"test/files/iit_stdcells_extra/missing.lef"}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -130,4 +130,38 @@ BOOST_AUTO_TEST_CASE(can_read_Liberty5)
     BOOST_CHECK(design.m_cellLib->size() == 432);
 }
 
+BOOST_AUTO_TEST_CASE(can_load_liberty_files_concurrently)
+{
+    std::cout << "--== LIBERTY READER CONCURRENT ==--\n";
+
+    const std::string filename("test/files/iit_stdcells_extra/fake_ties018.lib");
+
+    std::ifstream libertyfile(filename);
+    BOOST_REQUIRE(libertyfile.good());
+
+    ChipDB::Design serialDesign;
+    BOOST_REQUIRE(ChipDB::Liberty::Reader::load(serialDesign, libertyfile));
+
+    // loading the same file twice must give the same cells
+    ChipDB::Design design;
+    BOOST_REQUIRE(ChipDB::Liberty::Reader::loadFiles(design, {filename, filename}));
+
+    BOOST_REQUIRE(design.m_cellLib->size() == serialDesign.m_cellLib->size());
+    for(auto const cellKeyObjPair : *serialDesign.m_cellLib)
+    {
+        auto cell = design.m_cellLib->lookupCell(cellKeyObjPair->name());
+        BOOST_REQUIRE(cell.isValid());
+        BOOST_CHECK(cell.key() == cellKeyObjPair.key());
+        BOOST_CHECK(cell->m_pins.size() == cellKeyObjPair->m_pins.size());
+
+        for(auto const pinKeyObjPair : cellKeyObjPair->m_pins)
+        {
+            auto pin = cell->lookupPin(pinKeyObjPair->name());
+            BOOST_REQUIRE(pin.isValid());
+            BOOST_CHECK(pin->m_iotype == pinKeyObjPair->m_iotype);
+            BOOST_CHECK(pin->m_function == pinKeyObjPair->m_function);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
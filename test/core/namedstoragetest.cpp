@@ -60,6 +60,156 @@ BOOST_AUTO_TEST_CASE(check_NamedStorage)
     BOOST_CHECK(storage.remove("FakeName") == false);
 }
 
+BOOST_AUTO_TEST_CASE(check_NamedStorage_compaction)
+{
+    std::cout << "--== CHECK NAMEDSTORAGE COMPACTION ==--\n";
+
+    ChipDB::NamedStorage<MyObject> storage;
+
+    const std::size_t N = 100;
+    std::vector<ChipDB::ObjectKey> keys;
+    for(std::size_t idx=0; idx<N; idx++)
+    {
+        auto kp = storage.add(std::make_shared<MyObject>("Obj" + std::to_string(idx)));
+        BOOST_REQUIRE(kp.has_value());
+        keys.push_back(kp->key());
+    }
+
+    // remove all even objects, this triggers a compaction
+    for(std::size_t idx=0; idx<N; idx+=2)
+    {
+        BOOST_CHECK(storage.remove(keys.at(idx)));
+    }
+
+    BOOST_CHECK(storage.size() == N/2);
+
+    // removed keys stay invalid, the others still resolve
+    for(std::size_t idx=0; idx<N; idx++)
+    {
+        if ((idx % 2) == 0)
+        {
+            BOOST_CHECK(!storage.contains(keys.at(idx)));
+            BOOST_CHECK(storage[keys.at(idx)] == nullptr);
+            BOOST_CHECK_THROW(storage.atRef(keys.at(idx)), std::out_of_range);
+        }
+        else
+        {
+            BOOST_CHECK(storage.contains(keys.at(idx)));
+            BOOST_CHECK(storage.atRef(keys.at(idx)).name() == "Obj" + std::to_string(idx));
+            BOOST_CHECK(storage.at("Obj" + std::to_string(idx)).key() == keys.at(idx));
+        }
+    }
+
+    // iteration skips tombstones and follows insertion order
+    std::size_t count = 0;
+    ChipDB::ObjectKey prevKey = ChipDB::ObjectNotFound;
+    for(auto kp : storage)
+    {
+        BOOST_CHECK(kp.isValid());
+        BOOST_CHECK(kp.key() > prevKey);
+        prevKey = kp.key();
+        count++;
+    }
+    BOOST_CHECK(count == N/2);
+
+    // new objects never re-use keys of removed objects
+    auto kp = storage.add(std::make_shared<MyObject>("Obj0"));
+    BOOST_REQUIRE(kp.has_value());
+    BOOST_CHECK(kp->key() == static_cast<ChipDB::ObjectKey>(N));
+}
+
+BOOST_AUTO_TEST_CASE(check_object_refs)
+{
+    std::cout << "--== CHECK NAMEDSTORAGE OBJECT REFS ==--\n";
+
+    ChipDB::NamedStorage<MyObject> storage;
+    auto obj = std::make_shared<MyObject>("Obj #1");
+    BOOST_REQUIRE(storage.add(obj).has_value());
+    BOOST_REQUIRE(storage.create("Obj #2").has_value());
+
+    // iterating doesn't share ownership of the objects
+    const auto useCount = obj.use_count();
+    for(auto ref : storage)
+    {
+        BOOST_CHECK(ref.isValid());
+        BOOST_CHECK(obj.use_count() == useCount);
+        BOOST_CHECK(ref->name() == (*ref).name());
+        BOOST_CHECK(ref.rawPtr() == storage.atRaw(ref.key()));
+    }
+
+    // unless asked to
+    auto ref = *storage.begin();
+    auto kept = ref.ptr();
+    BOOST_CHECK(kept == obj);
+    BOOST_CHECK(obj.use_count() == useCount + 1);
+
+    ChipDB::KeyObjPair<MyObject> kp = *std::next(storage.begin());
+    BOOST_CHECK(kp.isValid());
+    BOOST_CHECK(kp.key() == 1);
+    BOOST_CHECK(kp->name() == "Obj #2");
+
+    // objects made by create() outlive the container
+    auto created = kp.ptr();
+    storage.clear();
+    BOOST_CHECK(created->name() == "Obj #2");
+}
+
+BOOST_AUTO_TEST_CASE(check_interned_names)
+{
+    std::cout << "--== CHECK INTERNED NAMES ==--\n";
+
+    ChipDB::NameTable table;
+    auto const name1 = table.intern("net_123");
+    auto const name2 = table.intern(std::string("net_") + "123");
+    BOOST_CHECK(name1.data() == name2.data());
+    BOOST_CHECK(table.size() == 1);
+    BOOST_CHECK(table.find("net_123").data() == name1.data());
+    BOOST_CHECK(table.find("net_124").data() == nullptr);
+
+    // names remain valid while the table grows
+    for(std::size_t idx=0; idx<10000; idx++)
+    {
+        std::ignore = table.intern("n" + std::to_string(idx));
+    }
+    BOOST_CHECK(table.size() == 10001);
+    BOOST_CHECK(name1 == "net_123");
+    BOOST_CHECK(table.intern("n42") == "n42");
+    BOOST_CHECK(table.arenaBytes() < 2*table.characters() + 64*1024);
+
+    // a table without handles can be cleared
+    BOOST_CHECK(table.clear());
+    BOOST_CHECK(table.size() == 0);
+    BOOST_CHECK(table.find("n42").data() == nullptr);
+
+    ChipDB::Name a("inv1");
+    ChipDB::Name b(std::string("inv") + "1");
+    BOOST_CHECK(a == b);
+    BOOST_CHECK(a == "inv1");
+    BOOST_CHECK(a.view().data() == b.view().data());
+    BOOST_CHECK(a.size() == 4);
+    BOOST_CHECK(std::string(a.c_str()) == "inv1");
+    BOOST_CHECK(ChipDB::Name() == ChipDB::Name(""));
+    BOOST_CHECK(ChipDB::Name().empty());
+
+    // database objects with the same name share the interned string
+    ChipDB::Net net1("shared_name");
+    ChipDB::Net net2("shared_name");
+    BOOST_CHECK(net1.name() == net2.name());
+    BOOST_CHECK(net1.name().c_str() == net2.name().c_str());
+
+    // the global table is not cleared while names refer to it
+    BOOST_CHECK(!ChipDB::NameTable::global().clear());
+    BOOST_CHECK(net1.name() == "shared_name");
+
+    ChipDB::NamedStorage<ChipDB::Net> nets;
+    auto netKp = nets.add(std::make_shared<ChipDB::Net>("shared_name"));
+    BOOST_REQUIRE(netKp.has_value());
+    BOOST_CHECK(nets.at(std::string_view("shared_name")).key() == netKp->key());
+    BOOST_CHECK(nets["shared_name"].isValid());
+    BOOST_CHECK(nets.remove("shared_name"));
+    BOOST_CHECK(!nets["shared_name"].isValid());
+}
+
 struct MyListener : public ChipDB::INamedStorageListener
 {
     MyListener() :
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include "lunacore.h"
+#include "testhelpers.h"
 
 #include <string>
 #include <sstream>
@@ -107,6 +108,101 @@ BOOST_AUTO_TEST_CASE(check_histogram_2)
     setLogLevel(ll);
 }
 
+BOOST_AUTO_TEST_CASE(check_netboxcache)
+{
+    std::cout << "--== CHECK NETLISTTOOLS NET BOX CACHE ==--\n";
+
+    auto cell = std::make_shared<ChipDB::Cell>("nand2");
+    cell->m_size = ChipDB::Coord64{1600, 10000};
+    auto pinA = cell->createPin("A");
+    auto pinB = cell->createPin("B");
+    auto pinY = cell->createPin("Y");
+    BOOST_REQUIRE(pinA.isValid() && pinB.isValid() && pinY.isValid());
+
+    Helpers::Random random(3);
+
+    ChipDB::Netlist netlist;
+    const std::size_t numInstances = 200;
+    std::vector<ChipDB::InstanceObjectKey> insKeys;
+    for(std::size_t idx = 0; idx < numInstances; idx++)
+    {
+        auto insKp = netlist.createInstance("u" + std::to_string(idx), ChipDB::InstanceType::CELL, cell);
+        BOOST_REQUIRE(insKp.isValid());
+        insKp->m_pos = ChipDB::Coord64{random(100) * 800, random(50) * 10000};
+        insKeys.push_back(insKp.key());
+    }
+
+    // every output drives a net, the inputs connect to random outputs.
+    // Some instances have both inputs on the same net.
+    for(std::size_t idx = 0; idx < numInstances; idx++)
+    {
+        auto netKp = netlist.createNet("n" + std::to_string(idx));
+        BOOST_REQUIRE(netKp.isValid());
+        BOOST_CHECK(netlist.connect(insKeys.at(idx), pinY.key(), netKp.key()));
+    }
+
+    for(std::size_t idx = 0; idx < numInstances; idx++)
+    {
+        const auto netA = static_cast<ChipDB::NetObjectKey>(random(numInstances));
+        const auto netB = ((idx % 5) == 0) ? netA : static_cast<ChipDB::NetObjectKey>(random(numInstances));
+        BOOST_CHECK(netlist.connect(insKeys.at(idx), pinA.key(), netA));
+        BOOST_CHECK(netlist.connect(insKeys.at(idx), pinB.key(), netB));
+    }
+
+    // an unconnected net has no wire length
+    auto emptyNet = netlist.createNet("empty");
+    BOOST_REQUIRE(emptyNet.isValid());
+
+    LunaCore::NetlistTools::NetBoxCache cache(netlist, 1);
+    BOOST_CHECK(cache.totalHPWL() == LunaCore::NetlistTools::calcHPWL(netlist));
+    BOOST_CHECK(cache.netHPWL(emptyNet.key()) == 0);
+    BOOST_CHECK(cache.instanceNets(insKeys.at(0)).size() == 2);   // both inputs on the same net
+
+    // incremental updates match a full rebuild. Moves to the same
+    // position and along the edges of the boxes are frequent.
+    bool allMatch = true;
+    for(std::size_t moveIdx = 0; moveIdx < 2000; moveIdx++)
+    {
+        const auto insKey = insKeys.at(random(numInstances));
+        auto ins = netlist.m_instances.at(insKey);
+        if ((moveIdx % 3) == 0)
+        {
+            ins->m_pos.m_x = random(100) * 800;
+        }
+        else
+        {
+            ins->m_pos = ChipDB::Coord64{random(100) * 800, random(50) * 10000};
+        }
+
+        const auto before = cache.totalHPWL();
+        const auto delta  = cache.updateInstance(netlist, insKey);
+        allMatch &= ((before + static_cast<double>(delta)) == cache.totalHPWL());
+
+        if ((moveIdx % 100) == 0)
+        {
+            LunaCore::NetlistTools::NetBoxCache fresh(netlist, 1);
+            allMatch &= (fresh.totalHPWL() == cache.totalHPWL());
+            for(auto const netKp : netlist.m_nets)
+            {
+                allMatch &= (fresh.netHPWL(netKp.key()) == cache.netHPWL(netKp.key()));
+            }
+        }
+    }
+
+    BOOST_CHECK(allMatch);
+    BOOST_CHECK(cache.totalHPWL() == LunaCore::NetlistTools::calcHPWL(netlist));
+
+    // the parallel rebuild gives the same boxes
+    LunaCore::NetlistTools::NetBoxCache parallel(netlist, 0);
+    BOOST_CHECK(parallel.totalHPWL() == cache.totalHPWL());
+    for(auto const netKp : netlist.m_nets)
+    {
+        auto const box1 = parallel.netBox(netKp.key());
+        auto const box2 = cache.netBox(netKp.key());
+        BOOST_CHECK((box1.m_ll == box2.m_ll) && (box1.m_ur == box2.m_ur));
+    }
+}
+
 #if 0
 BOOST_AUTO_TEST_CASE(remove_netcons)
 {
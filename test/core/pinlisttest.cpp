@@ -29,7 +29,8 @@ BOOST_AUTO_TEST_CASE(check_pin)
     // create a valid pin
     pin.m_netKey = 123;
     pin.m_pinKey = 456;
-    pin.m_pinInfo = std::make_shared<ChipDB::PinInfo>();
+    ChipDB::PinInfo pinInfo;
+    pin.m_pinInfo = &pinInfo;
     BOOST_CHECK(pin.isValid());
 
     // check that we can copy a pin
@@ -124,4 +124,45 @@ BOOST_AUTO_TEST_CASE(check_prim_routines)
 }
 
 
+BOOST_AUTO_TEST_CASE(check_prim_large_net)
+{
+    std::cout << "--== CHECK PRIM LARGE NET ==--\n";
+
+    // a regular grid of 2500 terminals: every tree edge
+    // must connect two neighbouring terminals.
+    const int64_t pitch = 1000;
+    std::vector<ChipDB::Coord64> netNodes;
+    for(int64_t y=0; y<50; y++)
+    {
+        for(int64_t x=0; x<50; x++)
+        {
+            netNodes.push_back({x*pitch, y*pitch});
+        }
+    }
+
+    // and a duplicate terminal
+    netNodes.push_back({25*pitch, 25*pitch});
+
+    auto tree = LunaCore::Prim::prim(netNodes);
+    BOOST_REQUIRE(tree.size() == netNodes.size());
+
+    std::size_t edges = 0;
+    int64_t length = 0;
+    for(auto const& node : tree)
+    {
+        BOOST_CHECK(node.hasParent());
+        for(auto const& edge : node.m_edges)
+        {
+            BOOST_CHECK(tree.at(edge.m_self).m_parent == node.m_self);
+            length += std::abs(edge.m_pos.m_x - node.m_pos.m_x) + std::abs(edge.m_pos.m_y - node.m_pos.m_y);
+            edges++;
+        }
+    }
+
+    BOOST_CHECK(edges == netNodes.size() - 1);
+    BOOST_CHECK(length == (50*50 - 1) * pitch);
+
+    BOOST_CHECK(LunaCore::Prim::prim({}).empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
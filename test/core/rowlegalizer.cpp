@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include "lunacore.h"
+#include "testhelpers.h"
 
 #include <string>
 #include <array>
@@ -109,4 +110,139 @@ BOOST_AUTO_TEST_CASE(check_legal_positions)
     BOOST_CHECK((cells.at(3).m_legalPos == ChipDB::Coord64{20200,0}));
 }
 
+BOOST_AUTO_TEST_CASE(check_bounded_legalizer)
+{
+    const std::size_t numRows = 20;
+    const ChipDB::CoordType rowWidth = 80000;
+
+    ChipDB::Floorplan floorplan;
+    Helpers::createRows(floorplan, numRows, rowWidth);
+
+    const auto cellTypes = Helpers::createCellTypes(3);
+
+    // 75% utilisation, cells bunched up in the middle of the core
+    std::array<std::unordered_map<ChipDB::ObjectKey, ChipDB::Coord64>, 2> globalPos;
+    std::array<ChipDB::Netlist, 2> netlists;
+    for(auto &netlist : netlists)
+    {
+        Helpers::Random random(1);
+
+        ChipDB::CoordType area = 0;
+        std::size_t idx = 0;
+        while(area < (rowWidth*numRows*3)/4)
+        {
+            auto const& cellType = cellTypes.at(idx % cellTypes.size());
+            auto insKp = netlist.createInstance("u" + std::to_string(idx), ChipDB::InstanceType::CELL, cellType);
+            BOOST_REQUIRE(insKp.isValid());
+            insKp->m_pos = ChipDB::Coord64{20000 + random(40000), 40000 + random(120000)};
+            insKp->m_placementInfo = ChipDB::PlacementInfo::PLACED;
+            area += cellType->m_size.m_x;
+            idx++;
+        }
+    }
+
+    for(auto insKp : netlists.at(0).m_instances) globalPos.at(0)[insKp.key()] = insKp->m_pos;
+    for(auto insKp : netlists.at(1).m_instances) globalPos.at(1)[insKp.key()] = insKp->m_pos;
+
+    LunaCore::Legalizer legalizer;
+    LunaCore::Legalizer::Parameters params;
+
+    params.m_mode = LunaCore::Legalizer::Mode::BOUNDED;
+    BOOST_CHECK(legalizer.legalize(floorplan, netlists.at(0), params));
+
+    params.m_mode = LunaCore::Legalizer::Mode::EXHAUSTIVE;
+    BOOST_CHECK(legalizer.legalize(floorplan, netlists.at(1), params));
+
+    const auto boundedDisplacement    = Helpers::checkLegalPlacement(netlists.at(0), numRows, rowWidth, &globalPos.at(0));
+    const auto exhaustiveDisplacement = Helpers::checkLegalPlacement(netlists.at(1), numRows, rowWidth, &globalPos.at(1));
+
+    // the bounded search may give up a little displacement,
+    // but no more than 10% over the exhaustive search.
+    BOOST_CHECK(boundedDisplacement >= 0);
+    BOOST_CHECK(exhaustiveDisplacement >= 0);
+    BOOST_CHECK(boundedDisplacement <= 1.1*exhaustiveDisplacement);
+
+    // cells that don't fit in any row are an error
+    ChipDB::Netlist fullNetlist;
+    for(std::size_t idx = 0; idx < 2*numRows; idx++)
+    {
+        auto insKp = fullNetlist.createInstance("u" + std::to_string(idx), ChipDB::InstanceType::CELL, cellTypes.at(2));
+        insKp->m_pos = ChipDB::Coord64{0, 0};
+        insKp->m_placementInfo = ChipDB::PlacementInfo::PLACED;
+    }
+
+    ChipDB::Floorplan smallFloorplan;
+    Helpers::createRows(smallFloorplan, numRows, 4000);
+    params.m_mode = LunaCore::Legalizer::Mode::BOUNDED;
+    BOOST_CHECK(!legalizer.legalize(smallFloorplan, fullNetlist, params));
+}
+
+BOOST_AUTO_TEST_CASE(check_banded_legalizer)
+{
+    const std::size_t numRows = 20;
+    const ChipDB::CoordType rowWidth = 80000;
+
+    ChipDB::Floorplan floorplan;
+    Helpers::createRows(floorplan, numRows, rowWidth);
+
+    auto macroCell = std::make_shared<ChipDB::Cell>("macro");
+    macroCell->m_size = ChipDB::Coord64{16500, 40000};   // not a multiple of the site width
+
+    const auto cellTypes = Helpers::createCellTypes(3);
+
+    // a fixed macro in the middle of the core, the cells are
+    // spread over the rows around it at 70% utilisation.
+    std::array<std::unordered_map<ChipDB::ObjectKey, ChipDB::Coord64>, 2> globalPos;
+    std::array<ChipDB::Netlist, 2> netlists;
+    for(std::size_t netlistIdx = 0; netlistIdx < netlists.size(); netlistIdx++)
+    {
+        auto &netlist = netlists.at(netlistIdx);
+
+        auto macroKp = netlist.createInstance("macro0", ChipDB::InstanceType::CELL, macroCell);
+        BOOST_REQUIRE(macroKp.isValid());
+        macroKp->m_pos = ChipDB::Coord64{30000, 50000};
+        macroKp->m_placementInfo = ChipDB::PlacementInfo::PLACEDANDFIXED;
+
+        Helpers::Random random(7);
+
+        ChipDB::CoordType area = 0;
+        std::size_t idx = 0;
+        while(area < ((rowWidth*numRows - 4*16500)*7)/10)
+        {
+            auto const& cellType = cellTypes.at(idx % cellTypes.size());
+            auto insKp = netlist.createInstance("u" + std::to_string(idx), ChipDB::InstanceType::CELL, cellType);
+            BOOST_REQUIRE(insKp.isValid());
+            insKp->m_pos = ChipDB::Coord64{random(rowWidth - 2400), random(numRows*10000 - 10000)};
+            insKp->m_placementInfo = ChipDB::PlacementInfo::PLACED;
+            globalPos.at(netlistIdx)[insKp.key()] = insKp->m_pos;
+            area += cellType->m_size.m_x;
+            idx++;
+        }
+    }
+
+    LunaCore::Legalizer legalizer;
+    LunaCore::Legalizer::Parameters params;
+    params.m_mode = LunaCore::Legalizer::Mode::BOUNDED;
+    params.m_rowsPerBand = 3;
+
+    params.m_threads = 1;
+    BOOST_CHECK(legalizer.legalize(floorplan, netlists.at(0), params));
+
+    params.m_threads = 0;
+    BOOST_CHECK(legalizer.legalize(floorplan, netlists.at(1), params));
+
+    const auto displacement = Helpers::checkLegalPlacement(netlists.at(0), numRows, rowWidth, &globalPos.at(0));
+    std::cout << "Displacement banded: " << displacement << "\n";
+    BOOST_CHECK(displacement >= 0);
+
+    // the result does not depend on the number of threads
+    for(auto insKp : netlists.at(0).m_instances)
+    {
+        auto otherKp = netlists.at(1).m_instances[insKp->name()];
+        BOOST_REQUIRE(otherKp.isValid());
+        BOOST_CHECK((insKp->m_pos == otherKp->m_pos));
+        BOOST_CHECK(insKp->m_orientation == otherKp->m_orientation);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
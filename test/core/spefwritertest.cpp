@@ -38,4 +38,228 @@ BOOST_AUTO_TEST_CASE(can_write_spef)
     BOOST_CHECK(LunaCore::SPEF::write("test/files/results/adders2.spef", mod.ptr()));
 }
 
+BOOST_AUTO_TEST_CASE(can_write_routed_spef)
+{
+    std::cout << "--== SPEF WRITER (routed net) ==--\n";
+
+    ChipDB::Design design;
+
+    auto addLayer = [&design](const std::string &name, ChipDB::LayerType type,
+        ChipDB::LayerDirection dir, double resistance)
+    {
+        auto layer = design.m_techLib->createLayer(name);
+        layer->m_type  = type;
+        layer->m_dir   = dir;
+        layer->m_pitch = {400, 400};
+        layer->m_width = 200;
+        layer->m_resistance  = resistance;
+        layer->m_capacitance = 1.0e-16;    // farads per square micron
+    };
+
+    // 0.5 ohm per micron on the metal layers, 5 ohm per via
+    addLayer("metal1", ChipDB::LayerType::ROUTING, ChipDB::LayerDirection::HORIZONTAL, 0.1);
+    addLayer("via1",   ChipDB::LayerType::CUT,     ChipDB::LayerDirection::UNDEFINED, 5.0);
+    addLayer("metal2", ChipDB::LayerType::ROUTING, ChipDB::LayerDirection::VERTICAL, 0.1);
+
+    auto cell = design.m_cellLib->createCell("BUF");
+    cell->m_size = ChipDB::Coord64{1000,1000};
+    auto inPin = cell->m_pins.createPin("A");
+    inPin->m_iotype = ChipDB::IOType::INPUT;
+    inPin->m_cap = 1.0e-15;
+    auto outPin = cell->m_pins.createPin("Y");
+    outPin->m_iotype = ChipDB::IOType::OUTPUT;
+
+    auto mod = design.m_moduleLib->createModule("top");
+    BOOST_REQUIRE(mod.isValid());
+
+    auto u1 = std::make_shared<ChipDB::Instance>("u1", ChipDB::InstanceType::CELL, cell.ptr());
+    auto u2 = std::make_shared<ChipDB::Instance>("u2", ChipDB::InstanceType::CELL, cell.ptr());
+    BOOST_REQUIRE(mod->addInstance(u1).isValid());
+    BOOST_REQUIRE(mod->addInstance(u2).isValid());
+    u1->m_pos = ChipDB::Coord64{0,0};
+    u2->m_pos = ChipDB::Coord64{10000,5000};
+
+    auto net = mod->createNet("n1");
+    BOOST_REQUIRE(mod->m_netlist->connect("u1", "Y", "n1"));
+    BOOST_REQUIRE(mod->m_netlist->connect("u2", "A", "n1"));
+
+    // an L-shaped route from the centre of u1 to the centre of u2
+    auto &route = net->m_route;
+    route.m_terminals = {u1->getCenter(), u2->getCenter()};
+    route.m_segments.push_back({{500,500}, {10500,500}, design.m_techLib->lookupLayer("metal1").key(), -1});
+    route.m_segments.push_back({{10500,500}, {10500,5500}, design.m_techLib->lookupLayer("metal2").key(), 0});
+
+    std::stringstream spef;
+    BOOST_REQUIRE(LunaCore::SPEF::write(spef, mod.ptr(), *design.m_techLib));
+
+    // sum the resistors and read the total net capacitance
+    double totalResistance = 0.0;
+    double totalCapacitance = 0.0;
+    std::size_t resistors = 0;
+    bool inResSection = false;
+
+    std::string line;
+    while(std::getline(spef, line))
+    {
+        std::stringstream ss(line);
+        std::string token;
+        ss >> token;
+
+        if (token == "*D_NET")
+        {
+            std::string netName;
+            ss >> netName >> totalCapacitance;
+        }
+        else if (token == "*RES")
+        {
+            inResSection = true;
+        }
+        else if (token == "*END")
+        {
+            inResSection = false;
+        }
+        else if (inResSection)
+        {
+            std::string node1, node2;
+            double value = 0.0;
+            ss >> node1 >> node2 >> value;
+            totalResistance += value;
+            resistors++;
+        }
+    }
+
+    // two wires of 10 and 5 micron, a via where the route turns
+    // and a via from metal2 down to the pin of u2. The pins are
+    // at the terminals, so their stubs have no resistance.
+    BOOST_CHECK(resistors == 6);
+    BOOST_CHECK_CLOSE(totalResistance, 5.0 + 2.5 + 5.0 + 5.0, 1e-3);
+
+    // 15 micron of wire at 2e-5 pF per micron and the input pin of u2
+    BOOST_CHECK_CLOSE(totalCapacitance, 15.0 * 2.0e-5 + 1.0e-3, 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(spef_output_does_not_depend_on_threads)
+{
+    std::cout << "--== SPEF WRITER (threads) ==--\n";
+
+    ChipDB::Design design;
+
+    auto cell = design.m_cellLib->createCell("BUF");
+    cell->m_size = ChipDB::Coord64{1000,1000};
+    auto inPin = cell->m_pins.createPin("A");
+    inPin->m_iotype = ChipDB::IOType::INPUT;
+    inPin->m_cap = 1.0e-15;
+    auto outPin = cell->m_pins.createPin("Y");
+    outPin->m_iotype = ChipDB::IOType::OUTPUT;
+
+    auto mod = design.m_moduleLib->createModule("top");
+    BOOST_REQUIRE(mod.isValid());
+
+    // a chain of buffers, long enough to need several chunks
+    const std::size_t bufferCount = 2000;
+    for(std::size_t idx = 0; idx < bufferCount; idx++)
+    {
+        auto ins = std::make_shared<ChipDB::Instance>("u" + std::to_string(idx), ChipDB::InstanceType::CELL, cell.ptr());
+        ins->m_pos = ChipDB::Coord64{static_cast<int64_t>(idx % 50) * 1000, static_cast<int64_t>(idx / 50) * 2000};
+        BOOST_REQUIRE(mod->addInstance(ins).isValid());
+    }
+
+    for(std::size_t idx = 1; idx < bufferCount; idx++)
+    {
+        auto const netName = "n[" + std::to_string(idx) + "]";
+        mod->createNet(netName);
+        BOOST_REQUIRE(mod->m_netlist->connect("u" + std::to_string(idx-1), "Y", netName));
+        BOOST_REQUIRE(mod->m_netlist->connect("u" + std::to_string(idx), "A", netName));
+    }
+
+    // remove the *DATE line so outputs can be compared
+    auto writeSPEF = [&](const LunaCore::SPEF::Options &options)
+    {
+        std::stringstream spef;
+        BOOST_REQUIRE(LunaCore::SPEF::write(spef, mod.ptr(), *design.m_techLib, options));
+
+        std::string result;
+        std::string line;
+        while(std::getline(spef, line))
+        {
+            if (line.starts_with("*DATE")) continue;
+            result += line;
+            result += '\n';
+        }
+        return result;
+    };
+
+    LunaCore::SPEF::Options options;
+    options.m_nameMap = true;
+    options.m_threads = 1;
+    auto const serial = writeSPEF(options);
+
+    options.m_threads = 4;
+    auto const parallel = writeSPEF(options);
+
+    BOOST_CHECK(serial == parallel);
+    BOOST_CHECK(serial.find("*NAME_MAP\n") != std::string::npos);
+    BOOST_CHECK(serial.find(" n\\[1234\\]\n") != std::string::npos);
+    BOOST_CHECK(std::count(serial.begin(), serial.end(), '\n') > 5 * bufferCount);
+
+    options.m_nameMap = false;
+    auto const plain = writeSPEF(options);
+    BOOST_CHECK(plain.find("*NAME_MAP") == std::string::npos);
+    BOOST_CHECK(plain.find("*D_NET n\\[1234\\] ") != std::string::npos);
+    BOOST_CHECK(plain.find("*I u1234:A I ") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(write_pass_spef_options)
+{
+    std::cout << "--== SPEF WRITER (write pass) ==--\n";
+
+    LunaCore::Database db;
+
+    auto cell = db.m_design.m_cellLib->createCell("BUF");
+    cell->m_size = ChipDB::Coord64{1000,1000};
+    auto inPin = cell->m_pins.createPin("A");
+    inPin->m_iotype = ChipDB::IOType::INPUT;
+    auto outPin = cell->m_pins.createPin("Y");
+    outPin->m_iotype = ChipDB::IOType::OUTPUT;
+
+    auto mod = db.m_design.m_moduleLib->createModule("top");
+    BOOST_REQUIRE(mod.isValid());
+
+    for(std::size_t idx = 0; idx < 3; idx++)
+    {
+        auto ins = std::make_shared<ChipDB::Instance>("u" + std::to_string(idx), ChipDB::InstanceType::CELL, cell.ptr());
+        ins->m_pos = ChipDB::Coord64{static_cast<int64_t>(idx) * 2000, 0};
+        BOOST_REQUIRE(mod->addInstance(ins).isValid());
+    }
+
+    for(std::size_t idx = 1; idx < 3; idx++)
+    {
+        auto const netName = "n" + std::to_string(idx);
+        mod->createNet(netName);
+        BOOST_REQUIRE(mod->m_netlist->connect("u" + std::to_string(idx-1), "Y", netName));
+        BOOST_REQUIRE(mod->m_netlist->connect("u" + std::to_string(idx), "A", netName));
+    }
+
+    auto readFile = [](const std::string &fname)
+    {
+        std::ifstream file(fname);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    };
+
+    LunaCore::Passes::registerAllPasses();
+
+    BOOST_REQUIRE(LunaCore::Passes::run(db, "write -spef top test/files/results/pass_namemap.spef -namemap -threads 2"));
+    auto const mapped = readFile("test/files/results/pass_namemap.spef");
+    BOOST_CHECK(mapped.find("*NAME_MAP") != std::string::npos);
+
+    BOOST_REQUIRE(LunaCore::Passes::run(db, "write -spef top test/files/results/pass_plain.spef -threads 1"));
+    auto const plain = readFile("test/files/results/pass_plain.spef");
+    BOOST_CHECK(plain.find("*NAME_MAP") == std::string::npos);
+    BOOST_CHECK(plain.find("*D_NET n1 ") != std::string::npos);
+
+    BOOST_CHECK(!LunaCore::Passes::run(db, "write -spef top test/files/results/pass_plain.spef -threads many"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
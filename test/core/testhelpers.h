@@ -7,6 +7,12 @@
 #include <limits>
 #include <stdexcept>
 #include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
 #include "lunacore.h"
 
 namespace Helpers
@@ -97,4 +103,116 @@ inline std::optional<LunaCore::PPM::Bitmap> createDiffBitmap(const LunaCore::PPM
     return diff;
 }
 
+/** linear congruential generator, gives the same numbers on every platform */
+class Random
+{
+public:
+    explicit Random(uint32_t seed) : m_seed(seed) {}
+
+    /** returns a number in [0, range) */
+    ChipDB::CoordType operator()(ChipDB::CoordType range)
+    {
+        m_seed = m_seed*1103515245 + 12345;
+        return static_cast<ChipDB::CoordType>((m_seed >> 8) % range);
+    }
+
+protected:
+    uint32_t m_seed;
+};
+
+constexpr ChipDB::CoordType c_rowHeight = 10000;
+constexpr ChipDB::CoordType c_siteWidth = 800;
+
+/** add rows starting at y = 0, the odd rows are flipped */
+inline void createRows(ChipDB::Floorplan &floorplan, std::size_t numRows, ChipDB::CoordType rowWidth)
+{
+    floorplan.setMinimumCellSize(ChipDB::Size64{c_siteWidth, c_rowHeight});
+    for(std::size_t rowIdx = 0; rowIdx < numRows; rowIdx++)
+    {
+        auto &row = floorplan.rows().emplace_back();
+        const ChipDB::CoordType y = static_cast<ChipDB::CoordType>(rowIdx)*c_rowHeight;
+        row.m_rect = ChipDB::Rect64{{0, y}, {rowWidth, y + c_rowHeight}};
+        row.m_rowType = ((rowIdx % 2) == 0) ? ChipDB::RowType::NORMAL : ChipDB::RowType::FLIPY;
+    }
+}
+
+/** create cells one row high with pins A, B and Y.
+ *  The first cell is minSites sites wide, each next cell one site wider.
+*/
+inline std::vector<std::shared_ptr<ChipDB::Cell>> createCellTypes(std::size_t count, std::size_t minSites = 1)
+{
+    std::vector<std::shared_ptr<ChipDB::Cell>> cellTypes;
+    for(std::size_t idx = 0; idx < count; idx++)
+    {
+        auto cell = std::make_shared<ChipDB::Cell>("cell" + std::to_string(idx));
+        cell->m_size = ChipDB::Coord64{static_cast<ChipDB::CoordType>(idx + minSites)*c_siteWidth, c_rowHeight};
+        std::ignore = cell->createPin("A");
+        std::ignore = cell->createPin("B");
+        std::ignore = cell->createPin("Y");
+        cellTypes.push_back(cell);
+    }
+
+    return cellTypes;
+}
+
+/** check the movable cells are on the sites of the rows made by createRows,
+ *  with the orientation of their row, and don't overlap each other or fixed instances.
+ *  Returns the total displacement from globalPos, 0 without globalPos,
+ *  or -1 if the placement is not legal.
+*/
+inline double checkLegalPlacement(const ChipDB::Netlist &netlist, std::size_t numRows, ChipDB::CoordType rowWidth,
+    const std::unordered_map<ChipDB::ObjectKey, ChipDB::Coord64> *globalPos = nullptr)
+{
+    const auto coreHeight = static_cast<ChipDB::CoordType>(numRows)*c_rowHeight;
+
+    std::vector<std::vector<std::pair<ChipDB::CoordType, ChipDB::CoordType>>> rowCells(numRows);
+    double displacement = 0;
+    for(auto const insKp : netlist.m_instances)
+    {
+        auto const rect = insKp->rect();
+
+        // fixed instances block the rows they cover
+        if (insKp->isFixed())
+        {
+            for(auto y = std::max<ChipDB::CoordType>(0, rect.bottom()); y < std::min(rect.top(), coreHeight); y += c_rowHeight)
+            {
+                rowCells.at(y / c_rowHeight).emplace_back(rect.left(), rect.right());
+            }
+            continue;
+        }
+
+        auto const pos = insKp->m_pos;
+        if (((pos.m_y % c_rowHeight) != 0) || (pos.m_y < 0) || (pos.m_y >= coreHeight)) return -1;
+        if ((pos.m_x < 0) || (rect.right() > rowWidth) || ((pos.m_x % c_siteWidth) != 0)) return -1;
+
+        const auto rowIdx = pos.m_y / c_rowHeight;
+        const auto expectedOrientation = ((rowIdx % 2) == 0) ? ChipDB::Orientation::R0 : ChipDB::Orientation::MX;
+        if (insKp->m_orientation != expectedOrientation) return -1;
+
+        rowCells.at(rowIdx).emplace_back(rect.left(), rect.right());
+
+        if (globalPos != nullptr)
+        {
+            auto const& gpos = globalPos->at(insKp.key());
+            displacement += std::abs(gpos.m_x - pos.m_x) + std::abs(gpos.m_y - pos.m_y);
+        }
+    }
+
+    for(auto &cells : rowCells)
+    {
+        std::sort(cells.begin(), cells.end());
+        for(std::size_t idx = 1; idx < cells.size(); idx++)
+        {
+            if (cells.at(idx-1).second > cells.at(idx).first) return -1;   // overlap
+        }
+    }
+
+    return displacement;
+}
+
+inline bool isLegal(const ChipDB::Netlist &netlist, std::size_t numRows, ChipDB::CoordType rowWidth)
+{
+    return checkLegalPlacement(netlist, numRows, rowWidth) >= 0;
+}
+
 };
\ No newline at end of file
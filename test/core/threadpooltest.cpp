@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2021-2025 Niels Moseley <asicsforthemasses@gmail.com>
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "lunacore.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(ThreadPoolTest)
+
+BOOST_AUTO_TEST_CASE(check_task_group)
+{
+    std::cout << "--== CHECK THREADPOOL TASKGROUP ==--\n";
+
+    LunaCore::ThreadPool pool(4);
+    BOOST_CHECK(pool.threadCount() == 4);
+
+    const std::size_t N = 1000;
+    std::vector<std::size_t> results(N, 0);
+
+    LunaCore::TaskGroup group(pool);
+    for(std::size_t idx = 0; idx < N; idx++)
+    {
+        group.run([idx, &results]()
+            {
+                results.at(idx) = idx*idx;
+            }
+        );
+    }
+    group.wait();
+
+    for(std::size_t idx = 0; idx < N; idx++)
+    {
+        BOOST_CHECK(results.at(idx) == idx*idx);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_nested_task_groups)
+{
+    std::cout << "--== CHECK THREADPOOL NESTED TASKGROUPS ==--\n";
+
+    // a single worker must not deadlock when tasks wait on sub-tasks
+    LunaCore::ThreadPool pool(1);
+
+    std::atomic<std::size_t> counter{0};
+
+    LunaCore::TaskGroup outer(pool);
+    for(std::size_t idx = 0; idx < 8; idx++)
+    {
+        outer.run([&pool, &counter]()
+            {
+                LunaCore::TaskGroup inner(pool);
+                for(std::size_t sub = 0; sub < 8; sub++)
+                {
+                    inner.run([&counter]() { counter++; });
+                }
+                inner.wait();
+            }
+        );
+    }
+    outer.wait();
+
+    BOOST_CHECK(counter == 64);
+}
+
+BOOST_AUTO_TEST_CASE(check_task_group_exception)
+{
+    std::cout << "--== CHECK THREADPOOL EXCEPTION ==--\n";
+
+    LunaCore::ThreadPool pool(2);
+    LunaCore::TaskGroup group(pool);
+
+    group.run([]() { throw std::runtime_error("task failed"); });
+    BOOST_CHECK_THROW(group.wait(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(check_parallel_for)
+{
+    std::cout << "--== CHECK THREADPOOL PARALLEL FOR ==--\n";
+
+    LunaCore::ThreadPool pool(3);
+
+    const std::size_t N = 10007;
+    std::vector<std::size_t> results(N, 0);
+
+    LunaCore::parallelFor(pool, 0, N, [&results](std::size_t index)
+        {
+            results.at(index) += index + 1;
+        }, 16
+    );
+
+    // every index must be visited exactly once
+    for(std::size_t idx = 0; idx < N; idx++)
+    {
+        BOOST_CHECK(results.at(idx) == idx + 1);
+    }
+
+    // empty and reversed ranges do nothing
+    std::atomic<std::size_t> counter{0};
+    LunaCore::parallelFor(pool, 10, 10, [&counter](std::size_t) { counter++; });
+    LunaCore::parallelFor(pool, 10, 5, [&counter](std::size_t) { counter++; });
+    BOOST_CHECK(counter == 0);
+
+    BOOST_CHECK_THROW(
+        LunaCore::parallelFor(pool, 0, 100, [](std::size_t index)
+            {
+                if (index == 42) throw std::runtime_error("index failed");
+            }
+        ), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(check_global_pool)
+{
+    std::cout << "--== CHECK THREADPOOL GLOBAL POOL ==--\n";
+
+    LunaCore::ThreadPool::setGlobalThreadCount(2);
+    BOOST_CHECK(LunaCore::ThreadPool::globalThreadCount() == 2);
+    BOOST_CHECK(LunaCore::ThreadPool::global().threadCount() == 2);
+
+    std::atomic<std::size_t> sum{0};
+    LunaCore::parallelFor(0, 100, [&sum](std::size_t index) { sum += index; });
+    BOOST_CHECK(sum == 4950);
+
+    LunaCore::ThreadPool::setGlobalThreadCount(3);
+    BOOST_CHECK(LunaCore::ThreadPool::global().threadCount() == 3);
+
+    // the busy pool is not replaced under its own tasks
+    LunaCore::TaskGroup group(LunaCore::ThreadPool::global());
+    std::atomic<std::size_t> threadsInTask{0};
+    group.run([&threadsInTask]()
+        {
+            LunaCore::ThreadPool::setGlobalThreadCount(2);
+            threadsInTask = LunaCore::ThreadPool::global().threadCount();
+        }
+    );
+    group.wait();
+    BOOST_CHECK(threadsInTask == 3);
+
+    // the worker is done with the task shortly after the group
+    while(LunaCore::ThreadPool::global().isBusy())
+    {
+        std::this_thread::yield();
+    }
+    BOOST_CHECK(LunaCore::ThreadPool::global().threadCount() == 2);
+
+    LunaCore::ThreadPool::setGlobalThreadCount(0);
+    BOOST_CHECK(LunaCore::ThreadPool::global().threadCount() == LunaCore::ThreadPool::hardwareThreads());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -99,4 +99,46 @@ BOOST_AUTO_TEST_CASE(can_parse_netlist)
     BOOST_CHECK(parser.m_modCount == 1);
 }
 
+BOOST_AUTO_TEST_CASE(can_parse_netlist_while_tokenizing)
+{
+    std::cout << "--== VERILOG PARSER (streaming) ==--\n";
+
+    std::ifstream verilogfile("test/files/verilog/adder2.v");
+    BOOST_REQUIRE(verilogfile.good());
+
+    std::stringstream src;
+    src << verilogfile.rdbuf();
+
+    CustomParser parser;
+    BOOST_CHECK(parser.execute(std::string_view(src.str())));
+
+    BOOST_CHECK(parser.m_insCount == 24);
+    BOOST_CHECK(parser.m_inputCount == 5);
+    BOOST_CHECK(parser.m_outputCount == 3);
+    BOOST_CHECK(parser.m_wireCount == 21);
+    BOOST_CHECK(parser.m_modCount == 1);
+
+    // the lexer returns views into the source
+    const std::string_view source("module top(a);\n  input \\a[0] ;\nendmodule // end\n");
+    ChipDB::Verilog::Lexer lexer;
+    lexer.begin(source);
+
+    std::vector<ChipDB::Verilog::Lexer::tokenView> tokens;
+    ChipDB::Verilog::Lexer::tokenView tok;
+    while(lexer.next(tok))
+    {
+        tokens.push_back(tok);
+    }
+
+    BOOST_CHECK(!lexer.hasError());
+    BOOST_REQUIRE(tokens.size() == 10);
+    BOOST_CHECK(tokens.at(0).m_tok == ChipDB::Verilog::Lexer::TOK_MODULE);
+    BOOST_CHECK(tokens.at(7).m_tok == ChipDB::Verilog::Lexer::TOK_IDENT);
+    BOOST_CHECK(tokens.at(7).m_value == "a[0]");
+    BOOST_CHECK(tokens.at(7).m_line == 2);
+    BOOST_CHECK(tokens.at(7).m_value.data() >= source.data());
+    BOOST_CHECK(tokens.at(7).m_value.data() < source.data() + source.size());
+    BOOST_CHECK(tokens.at(9).m_tok == ChipDB::Verilog::Lexer::TOK_ENDMODULE);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
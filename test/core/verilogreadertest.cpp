@@ -152,7 +152,7 @@ BOOST_AUTO_TEST_CASE(can_read_multiplier)
             {
                 unconnectedPins++;
                 Logging::logError("Pin with index %d (name is %s) on instance %s is unconnected\n",
-                    pinIndex, checkPin.name().c_str(), ins->name().c_str());
+                    pinIndex, std::string(checkPin.name()).c_str(), ins->name().c_str());
             }
             pinIndex++;
         }